@@ -101,60 +101,73 @@ uint32_t CBitstreamConverter::get_bits( bits_reader_t *br, int nbits )
 //  * version 2.1 of the License, or (at your option) any later version.
 void CBitstreamConverter::nal_bs_init(nal_bitstream *bs, const uint8_t *data, size_t size)
 {
-  bs->data = data;
-  bs->end  = data + size;
-  bs->head = 0;
-  // fill with something other than 0 to detect
-  //  emulation prevention bytes
-  bs->cache = 0xffffffff;
+  bs->data  = data;
+  bs->end   = data + size;
+  bs->head  = 0;
+  bs->zeros = 0;
+  bs->cache = 0;
 }
 
-uint32_t CBitstreamConverter::nal_bs_read(nal_bitstream *bs, int n)
+// tops the cache up to more than 56 bits, or to what is left of the data
+static inline void nal_bs_refill(nal_bitstream *bs)
 {
-  uint32_t res = 0;
-  int shift;
-
-  if (n == 0)
-    return res;
+  int bytes = (64 - bs->head) >> 3;
+  if (!bytes)
+    return;
 
-  // fill up the cache if we need to
-  while (bs->head < n)
+  if (bs->end - bs->data >= 8)
   {
-    uint8_t a_byte;
-    bool check_three_byte;
-
-    check_three_byte = true;
-next_byte:
-    if (bs->data >= bs->end)
+    uint64_t word = (uint64_t)OMX_RB32(bs->data) << 32 | (uint32_t)OMX_RB32(bs->data + 4);
+    int bits = bytes << 3;
+    // without a 03 among the bytes taken none of them can be an emulation prevention byte,
+    // the bytes left behind are set to ff so they can not look like one
+    uint64_t x = (word ^ 0x0303030303030303ULL) | (bits < 64 ? ~0ULL >> bits : 0);
+    if (!((x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL))
     {
-      // we're at the end, can't produce more than head number of bits
-      n = bs->head;
-      break;
+      uint64_t taken = bits < 64 ? word >> (64 - bits) : word;
+      bs->cache |= (taken << (64 - bits)) >> bs->head;
+      bs->head  += bits;
+      bs->data  += bytes;
+      if (!taken)
+        bs->zeros += bytes;
+      else
+        bs->zeros = __builtin_ctzll(taken) >> 3;
+      return;
     }
-    // get the byte, this can be an emulation_prevention_three_byte that we need
-    // to ignore.
-    a_byte = *bs->data++;
-    if (check_three_byte && a_byte == 0x03 && ((bs->cache & 0xffff) == 0))
+  }
+
+  while (bs->head <= 56 && bs->data < bs->end)
+  {
+    uint8_t a_byte = *bs->data++;
+    if (a_byte == 0x03 && bs->zeros >= 2)
     {
-      // next byte goes unconditionally to the cache, even if it's 0x03
-      check_three_byte = false;
-      goto next_byte;
+      // the next byte goes to the cache even if it is another 03
+      bs->zeros = 0;
+      continue;
     }
-    // shift bytes in cache, moving the head bits of the cache left
-    bs->cache = (bs->cache << 8) | a_byte;
+    bs->zeros = a_byte ? 0 : bs->zeros + 1;
+    bs->cache |= (uint64_t)a_byte << (56 - bs->head);
     bs->head += 8;
   }
+}
 
-  // bring the required bits down and truncate
-  if ((shift = bs->head - n) > 0)
-    res = bs->cache >> shift;
-  else
-    res = bs->cache;
+uint32_t CBitstreamConverter::nal_bs_read(nal_bitstream *bs, int n)
+{
+  uint32_t res;
 
-  // mask out required bits
-  if (n < 32)
-    res &= (1 << n) - 1;
-  bs->head = shift;
+  if (bs->head < n)
+  {
+    nal_bs_refill(bs);
+    // we're at the end, can't produce more than head number of bits
+    if (bs->head < n)
+      n = bs->head;
+  }
+  if (n == 0)
+    return 0;
+
+  res = (uint32_t)(bs->cache >> (64 - n));
+  bs->cache <<= n;
+  bs->head -= n;
 
   return res;
 }
@@ -169,164 +182,523 @@ int CBitstreamConverter::nal_bs_read_ue(nal_bitstream *bs)
 {
   int i = 0;
 
+  if (bs->head < 32)
+    nal_bs_refill(bs);
+
+  // the leading zeros, the 1 and as many bits again are all in the cache
+  if (bs->cache)
+  {
+    int zeros = __builtin_clzll(bs->cache);
+    int len = 2 * zeros + 1;
+    if (zeros < 32 && len <= bs->head)
+    {
+      uint64_t code = bs->cache >> (64 - len);
+      bs->cache <<= len;
+      bs->head -= len;
+      return (int)(code - 1);
+    }
+  }
+
   while (nal_bs_read(bs, 1) == 0 && !nal_bs_eos(bs) && i < 32)
     i++;
 
   return ((1 << i) - 1 + nal_bs_read(bs, i));
 }
 
-void CBitstreamConverter::parseh264_sps(uint8_t *sps, uint32_t sps_size, bool *interlaced, int32_t *max_ref_frames)
+// read signed Exp-Golomb code
+int CBitstreamConverter::nal_bs_read_se(nal_bitstream *bs)
+{
+  int code = nal_bs_read_ue(bs);
+  return (code & 1) ? (code + 1) / 2 : -(code / 2);
+}
+
+bool CBitstreamConverter::parseh264_sps_info(const uint8_t *sps, uint32_t sps_size, sps_info_struct *sps_info)
 {
   nal_bitstream bs;
-  sps_info_struct sps_info;
 
+  memset(sps_info, 0, sizeof(*sps_info));
+  sps_info->chroma_format_idc = 1;
   nal_bs_init(&bs, sps, sps_size);
 
-  sps_info.profile_idc  = nal_bs_read(&bs, 8);
+  sps_info->profile_idc  = nal_bs_read(&bs, 8);
   nal_bs_read(&bs, 1);  // constraint_set0_flag
   nal_bs_read(&bs, 1);  // constraint_set1_flag
   nal_bs_read(&bs, 1);  // constraint_set2_flag
   nal_bs_read(&bs, 1);  // constraint_set3_flag
   nal_bs_read(&bs, 4);  // reserved
-  sps_info.level_idc    = nal_bs_read(&bs, 8);
-  sps_info.sps_id       = nal_bs_read_ue(&bs);
-
-  if (sps_info.profile_idc == 100 ||
-      sps_info.profile_idc == 110 ||
-      sps_info.profile_idc == 122 ||
-      sps_info.profile_idc == 244 ||
-      sps_info.profile_idc == 44  ||
-      sps_info.profile_idc == 83  ||
-      sps_info.profile_idc == 86)
-  {
-    sps_info.chroma_format_idc                    = nal_bs_read_ue(&bs);
-    if (sps_info.chroma_format_idc == 3)
-      sps_info.separate_colour_plane_flag         = nal_bs_read(&bs, 1);
-    sps_info.bit_depth_luma_minus8                = nal_bs_read_ue(&bs);
-    sps_info.bit_depth_chroma_minus8              = nal_bs_read_ue(&bs);
-    sps_info.qpprime_y_zero_transform_bypass_flag = nal_bs_read(&bs, 1);
-
-    sps_info.seq_scaling_matrix_present_flag = nal_bs_read (&bs, 1);
-    if (sps_info.seq_scaling_matrix_present_flag)
+  sps_info->level_idc    = nal_bs_read(&bs, 8);
+  sps_info->sps_id       = nal_bs_read_ue(&bs);
+
+  if (sps_info->profile_idc == 100 ||
+      sps_info->profile_idc == 110 ||
+      sps_info->profile_idc == 122 ||
+      sps_info->profile_idc == 244 ||
+      sps_info->profile_idc == 44  ||
+      sps_info->profile_idc == 83  ||
+      sps_info->profile_idc == 86  ||
+      sps_info->profile_idc == 118 ||
+      sps_info->profile_idc == 128)
+  {
+    sps_info->chroma_format_idc                    = nal_bs_read_ue(&bs);
+    if (sps_info->chroma_format_idc == 3)
+      sps_info->separate_colour_plane_flag         = nal_bs_read(&bs, 1);
+    sps_info->bit_depth_luma_minus8                = nal_bs_read_ue(&bs);
+    sps_info->bit_depth_chroma_minus8              = nal_bs_read_ue(&bs);
+    sps_info->qpprime_y_zero_transform_bypass_flag = nal_bs_read(&bs, 1);
+
+    sps_info->seq_scaling_matrix_present_flag = nal_bs_read (&bs, 1);
+    if (sps_info->seq_scaling_matrix_present_flag)
     {
-      /* TODO: unfinished */
+      // only skipped, 6 lists of 16 then 2 or 6 of 64
+      int lists = sps_info->chroma_format_idc != 3 ? 8 : 12;
+      for (int i = 0; i < lists; i++)
+      {
+        if (!nal_bs_read(&bs, 1))
+          continue;
+        int size = i < 6 ? 16 : 64;
+        int last_scale = 8, next_scale = 8;
+        for (int j = 0; j < size; j++)
+        {
+          if (next_scale != 0)
+            next_scale = (last_scale + nal_bs_read_se(&bs) + 256) % 256;
+          last_scale = next_scale == 0 ? last_scale : next_scale;
+        }
+      }
     }
   }
-  sps_info.log2_max_frame_num_minus4 = nal_bs_read_ue(&bs);
-  if (sps_info.log2_max_frame_num_minus4 > 12)
+  sps_info->log2_max_frame_num_minus4 = nal_bs_read_ue(&bs);
+  if (sps_info->log2_max_frame_num_minus4 > 12)
   { // must be between 0 and 12
-    return;
+    return false;
   }
-  sps_info.pic_order_cnt_type = nal_bs_read_ue(&bs);
-  if (sps_info.pic_order_cnt_type == 0)
+  sps_info->pic_order_cnt_type = nal_bs_read_ue(&bs);
+  if (sps_info->pic_order_cnt_type == 0)
   {
-    sps_info.log2_max_pic_order_cnt_lsb_minus4 = nal_bs_read_ue(&bs);
+    sps_info->log2_max_pic_order_cnt_lsb_minus4 = nal_bs_read_ue(&bs);
   }
-  else if (sps_info.pic_order_cnt_type == 1)
-  { // TODO: unfinished
-    /*
-    delta_pic_order_always_zero_flag = gst_nal_bs_read (bs, 1);
-    offset_for_non_ref_pic = gst_nal_bs_read_se (bs);
-    offset_for_top_to_bottom_field = gst_nal_bs_read_se (bs);
-
-    num_ref_frames_in_pic_order_cnt_cycle = gst_nal_bs_read_ue (bs);
-    for( i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; i++ )
-    offset_for_ref_frame[i] = gst_nal_bs_read_se (bs);
-    */
+  else if (sps_info->pic_order_cnt_type == 1)
+  {
+    nal_bs_read(&bs, 1);    // delta_pic_order_always_zero_flag
+    nal_bs_read_se(&bs);    // offset_for_non_ref_pic
+    nal_bs_read_se(&bs);    // offset_for_top_to_bottom_field
+    int cycle = nal_bs_read_ue(&bs); // num_ref_frames_in_pic_order_cnt_cycle
+    if (cycle > 255)
+      return false;
+    for (int i = 0; i < cycle; i++)
+      nal_bs_read_se(&bs);  // offset_for_ref_frame
   }
 
-  sps_info.max_num_ref_frames             = nal_bs_read_ue(&bs);
-  sps_info.gaps_in_frame_num_value_allowed_flag = nal_bs_read(&bs, 1);
-  sps_info.pic_width_in_mbs_minus1        = nal_bs_read_ue(&bs);
-  sps_info.pic_height_in_map_units_minus1 = nal_bs_read_ue(&bs);
+  sps_info->max_num_ref_frames             = nal_bs_read_ue(&bs);
+  sps_info->gaps_in_frame_num_value_allowed_flag = nal_bs_read(&bs, 1);
+  sps_info->pic_width_in_mbs_minus1        = nal_bs_read_ue(&bs);
+  sps_info->pic_height_in_map_units_minus1 = nal_bs_read_ue(&bs);
 
-  sps_info.frame_mbs_only_flag            = nal_bs_read(&bs, 1);
-  if (!sps_info.frame_mbs_only_flag)
-    sps_info.mb_adaptive_frame_field_flag = nal_bs_read(&bs, 1);
+  sps_info->frame_mbs_only_flag            = nal_bs_read(&bs, 1);
+  if (!sps_info->frame_mbs_only_flag)
+    sps_info->mb_adaptive_frame_field_flag = nal_bs_read(&bs, 1);
 
-  sps_info.direct_8x8_inference_flag      = nal_bs_read(&bs, 1);
+  sps_info->direct_8x8_inference_flag      = nal_bs_read(&bs, 1);
 
-  sps_info.frame_cropping_flag            = nal_bs_read(&bs, 1);
-  if (sps_info.frame_cropping_flag)
+  sps_info->frame_cropping_flag            = nal_bs_read(&bs, 1);
+  if (sps_info->frame_cropping_flag)
   {
-    sps_info.frame_crop_left_offset       = nal_bs_read_ue(&bs);
-    sps_info.frame_crop_right_offset      = nal_bs_read_ue(&bs);
-    sps_info.frame_crop_top_offset        = nal_bs_read_ue(&bs);
-    sps_info.frame_crop_bottom_offset     = nal_bs_read_ue(&bs);
+    sps_info->frame_crop_left_offset       = nal_bs_read_ue(&bs);
+    sps_info->frame_crop_right_offset      = nal_bs_read_ue(&bs);
+    sps_info->frame_crop_top_offset        = nal_bs_read_ue(&bs);
+    sps_info->frame_crop_bottom_offset     = nal_bs_read_ue(&bs);
   }
 
+  return !nal_bs_eos(&bs);
+}
+
+void CBitstreamConverter::parseh264_sps(uint8_t *sps, uint32_t sps_size, bool *interlaced, int32_t *max_ref_frames)
+{
+  sps_info_struct sps_info;
+
+  if (!parseh264_sps_info(sps, sps_size, &sps_info))
+    return;
+
   *interlaced = !sps_info.frame_mbs_only_flag;
   *max_ref_frames = sps_info.max_num_ref_frames;
 }
 
-const uint8_t *CBitstreamConverter::avc_find_startcode_internal(const uint8_t *p, const uint8_t *end)
+bool CBitstreamConverter::parseh264_sps_summary(const uint8_t *sps, uint32_t sps_size, h264_sps_summary *summary)
 {
-  const uint8_t *a = p + 4 - ((intptr_t)p & 3);
+  sps_info_struct sps_info;
 
-  for (end -= 3; p < a && p < end; p++)
+  if (!parseh264_sps_info(sps, sps_size, &sps_info))
+    return false;
+
+  // crop offsets count in chroma samples, and in field lines without frame_mbs_only
+  int chroma = sps_info.separate_colour_plane_flag ? 0 : sps_info.chroma_format_idc;
+  int crop_x = chroma == 1 || chroma == 2 ? 2 : 1;
+  int crop_y = (chroma == 1 ? 2 : 1) * (2 - sps_info.frame_mbs_only_flag);
+
+  summary->width  = (sps_info.pic_width_in_mbs_minus1 + 1) * 16 -
+                    crop_x * (sps_info.frame_crop_left_offset + sps_info.frame_crop_right_offset);
+  summary->height = (2 - sps_info.frame_mbs_only_flag) * (sps_info.pic_height_in_map_units_minus1 + 1) * 16 -
+                    crop_y * (sps_info.frame_crop_top_offset + sps_info.frame_crop_bottom_offset);
+  summary->profile_idc    = sps_info.profile_idc;
+  summary->level_idc      = sps_info.level_idc;
+  summary->max_ref_frames = sps_info.max_num_ref_frames;
+  summary->interlaced     = !sps_info.frame_mbs_only_flag;
+  return summary->width > 0 && summary->height > 0;
+}
+
+void CBitstreamConverter::TrackParamSet(const uint8_t *nal, int size, h264_picture_info *info)
+{
+  int nal_type = nal[0] & 0x1f;
+
+  // trailing zero bytes vary with the start codes around the NAL unit
+  while (size > 2 && !nal[size - 1])
+    size--;
+
+  info->param_sets++;
+
+  nal_bitstream bs;
+  nal_bs_init(&bs, nal + 1, size - 1);
+  if (nal_type == 7)
+    nal_bs_read(&bs, 24);    // profile_idc, constraint flags and level_idc
+  int id = nal_bs_read_ue(&bs);
+  if (id < 0 || id >= (nal_type == 7 ? 32 : 256))
+    return;
+
+  std::string &cached = nal_type == 7 ? m_sps_cache[id] : m_pps_cache[id];
+  if (cached.size() == (size_t)size && !memcmp(cached.data(), nal, size))
+  {
+    info->param_sets_redundant++;
+    return;
+  }
+  bool known = !cached.empty();
+  cached.assign((const char *)nal, size);
+
+  h264_sps_summary format;
+  if (nal_type == 8 || !parseh264_sps_summary(nal + 1, size - 1, &format))
   {
-    if (p[0] == 0 && p[1] == 0 && p[2] == 1)
-      return p;
+    if (known)
+      info->param_sets_updated++;
+    return;
   }
 
-  for (end -= 3; p < end; p += 4)
+  if (m_format_valid && (format.width != m_format.width || format.height != m_format.height ||
+                         format.profile_idc != m_format.profile_idc || format.level_idc != m_format.level_idc ||
+                         format.max_ref_frames != m_format.max_ref_frames || format.interlaced != m_format.interlaced))
   {
-    uint32_t x = *(const uint32_t*)p;
-    if ((x - 0x01010101) & (~x) & 0x80808080) // generic
+    info->format_changed = true;
+    info->format = format;
+  }
+  else if (known)
+    info->param_sets_updated++;
+  m_format = format;
+  m_format_valid = true;
+}
+
+void CBitstreamConverter::ResetParamSets(const uint8_t *extradata, int extrasize)
+{
+  h264_picture_info info;
+
+  for (int i = 0; i < 32; i++)
+    m_sps_cache[i].clear();
+  for (int i = 0; i < 256; i++)
+    m_pps_cache[i].clear();
+  m_format_valid = false;
+
+  if (!extradata || extrasize < 7)
+    return;
+
+  memset(&info, 0, sizeof(info));
+  if (extradata[0] == 1)
+  {
+    // avcC, a count of SPS then one of PPS, each unit behind a 16 bit size
+    const uint8_t *p = extradata + 5;
+    const uint8_t *end = extradata + extrasize;
+    int units = *p++ & 0x1f;
+    for (int list = 0; list < 2; list++)
     {
-      if (p[1] == 0)
-      {
-        if (p[0] == 0 && p[2] == 1)
-          return p;
-        if (p[2] == 0 && p[3] == 1)
-          return p+1;
-      }
-      if (p[3] == 0)
+      while (units-- > 0 && end - p >= 2)
       {
-        if (p[2] == 0 && p[4] == 1)
-          return p+2;
-        if (p[4] == 0 && p[5] == 1)
-          return p+3;
+        int size = OMX_RB16(p);
+        p += 2;
+        if (size < 2 || size > end - p)
+          return;
+        TrackParamSet(p, size, &info);
+        p += size;
       }
+      if (p >= end)
+        return;
+      units = *p++;
     }
   }
+  else
+  {
+    startcode_split(extradata, extrasize, m_nal_units);
+    for (size_t i = 0; i < m_nal_units.size(); i++)
+    {
+      int nal_type = m_nal_units[i].data[0] & 0x1f;
+      if (m_nal_units[i].size >= 2 && (nal_type == 7 || nal_type == 8))
+        TrackParamSet(m_nal_units[i].data, m_nal_units[i].size, &info);
+    }
+  }
+}
 
-  for (end += 3; p < end; p++)
+void CBitstreamConverter::SplitNalUnits(const uint8_t *data, int size, int length_size)
+{
+  const uint8_t *p = data;
+  const uint8_t *end = data + size;
+
+  if (!length_size)
   {
-    if (p[0] == 0 && p[1] == 0 && p[2] == 1)
-      return p;
+    startcode_split(data, size, m_nal_units);
+    return;
   }
 
-  return end + 3;
+  m_nal_units.clear();
+  while (end - p >= length_size)
+  {
+    uint32_t nal_size = 0;
+    for (int i = 0; i < length_size; i++)
+      nal_size = (nal_size << 8) | *p++;
+    if (nal_size > (uint32_t)(end - p))
+      break;
+    nal_unit unit = { p, (int)nal_size };
+    m_nal_units.push_back(unit);
+    p += nal_size;
+  }
 }
 
-const uint8_t *CBitstreamConverter::avc_find_startcode(const uint8_t *p, const uint8_t *end)
+bool CBitstreamConverter::parseh264_picture(const uint8_t *data, int size, int length_size, h264_picture_info *info)
 {
-  const uint8_t *out= avc_find_startcode_internal(p, end);
-  if (p<out && out<end && !out[-1])
-    out--;
-  return out;
+  const uint8_t *nal_start, *nal_end;
+
+  info->idr         = false;
+  info->nal_ref_idc = 0;
+  info->slice_type  = -1;
+  info->param_sets  = 0;
+  info->param_sets_redundant = 0;
+  info->param_sets_updated   = 0;
+  info->format_changed       = false;
+
+  SplitNalUnits(data, size, length_size);
+
+  for (size_t unit = 0; unit < m_nal_units.size(); unit++)
+  {
+    nal_start = m_nal_units[unit].data;
+    nal_end   = nal_start + m_nal_units[unit].size;
+
+    if (nal_end - nal_start < 2)
+      continue;
+
+    // only coded slices, 1 is non-IDR and 5 is IDR, past the parameter sets
+    int nal_type = nal_start[0] & 0x1f;
+    if (nal_type == 7 || nal_type == 8)
+      TrackParamSet(nal_start, nal_end - nal_start, info);
+    if (nal_type != 1 && nal_type != 5)
+      continue;
+
+    int nal_ref_idc = (nal_start[0] >> 5) & 3;
+    if (nal_ref_idc > info->nal_ref_idc)
+      info->nal_ref_idc = nal_ref_idc;
+    if (nal_type == 5)
+      info->idr = true;
+
+    if (info->slice_type < 0)
+    {
+      nal_bitstream bs;
+      nal_bs_init(&bs, nal_start + 1, nal_end - nal_start - 1);
+      nal_bs_read_ue(&bs); // first_mb_in_slice
+      info->slice_type = nal_bs_read_ue(&bs) % 5;
+    }
+  }
+
+  return info->slice_type >= 0;
 }
 
-const int CBitstreamConverter::avc_parse_nal_units(AVIOContext *pb, const uint8_t *buf_in, int size)
+int CBitstreamConverter::StripParamSets(uint8_t *data, int size, int length_size, int *kept, int *dropped)
 {
-  const uint8_t *p = buf_in;
-  const uint8_t *end = p + size;
-  const uint8_t *nal_start, *nal_end;
+  *kept = 0;
+  *dropped = 0;
 
-  size = 0;
-  nal_start = avc_find_startcode(p, end);
+  SplitNalUnits(data, size, length_size);
 
-  for (;;) {
-    while (nal_start < end && !*(nal_start++));
-    if (nal_start == end)
-      break;
+  // a unit goes with the size field or start code in front of it, the bytes
+  // from the end of the previous one, so what stays keeps its own framing
+  uint8_t *out = data;
+  const uint8_t *copied = data;
+  const uint8_t *prev_end = data;
+  for (size_t unit = 0; unit < m_nal_units.size(); unit++)
+  {
+    const uint8_t *nal = m_nal_units[unit].data;
+    int nal_size = m_nal_units[unit].size;
+    const uint8_t *start = prev_end;
+    prev_end = nal + nal_size;
+
+    int nal_type = nal_size >= 2 ? nal[0] & 0x1f : 0;
+    if (nal_type != 7 && nal_type != 8)
+      continue;
+    if (!RepeatedParamSet(nal, nal_size))
+    {
+      (*kept)++;
+      continue;
+    }
+
+    (*dropped)++;
+    memmove(out, copied, start - copied);
+    out += start - copied;
+    copied = prev_end;
+  }
+
+  if (!*dropped)
+    return size;
+  memmove(out, copied, data + size - copied);
+  return out - data + (data + size - copied);
+}
+
+bool CBitstreamConverter::RepeatedParamSet(const uint8_t *nal, int size)
+{
+  int nal_type = nal[0] & 0x1f;
+
+  while (size > 2 && !nal[size - 1])
+    size--;
+
+  nal_bitstream bs;
+  nal_bs_init(&bs, nal + 1, size - 1);
+  if (nal_type == 7)
+    nal_bs_read(&bs, 24);
+  int id = nal_bs_read_ue(&bs);
+  if (id < 0 || id >= (nal_type == 7 ? 32 : 256))
+    return false;
+
+  std::string &cached = nal_type == 7 ? m_sps_cache[id] : m_pps_cache[id];
+  if (cached.size() == (size_t)size && !memcmp(cached.data(), nal, size))
+    return true;
+  cached.assign((const char *)nal, size);
+
+  // a PPS is read against its SPS, the same bytes may mean something else now
+  if (nal_type == 7)
+    for (int i = 0; i < 256; i++)
+      m_pps_cache[i].clear();
+  return false;
+}
+
+void CBitstreamConverter::TrackHevcPps(const uint8_t *nal, int size)
+{
+  nal_bitstream bs;
+  nal_bs_init(&bs, nal + 2, size - 2);
+  int id = nal_bs_read_ue(&bs);
+  if (id < 0 || id >= 64)
+    return;
+  nal_bs_read_ue(&bs); // pps_seq_parameter_set_id
+  nal_bs_read(&bs, 2); // dependent_slice_segments_enabled_flag, output_flag_present_flag
+  m_hevc_extra_bits[id] = nal_bs_read(&bs, 3);
+}
+
+void CBitstreamConverter::ResetHevcParamSets(const uint8_t *extradata, int extrasize)
+{
+  memset(m_hevc_extra_bits, 0, sizeof(m_hevc_extra_bits));
+
+  if (!extradata || extrasize < 23)
+    return;
 
-    nal_end = avc_find_startcode(nal_start, end);
-    m_dllAvFormat->avio_wb32(pb, nal_end - nal_start);
-    m_dllAvFormat->avio_write(pb, nal_start, nal_end - nal_start);
-    size += 4 + nal_end - nal_start;
-    nal_start = nal_end;
+  if (extradata[0] == 1)
+  {
+    // hvcC, arrays of units by type, each unit behind a 16 bit size
+    const uint8_t *p = extradata + 22;
+    const uint8_t *end = extradata + extrasize;
+    int arrays = *p++;
+    while (arrays-- > 0 && end - p >= 3)
+    {
+      int nal_type = p[0] & 0x3f;
+      int units = OMX_RB16(p + 1);
+      p += 3;
+      while (units-- > 0 && end - p >= 2)
+      {
+        int size = OMX_RB16(p);
+        p += 2;
+        if (size > end - p)
+          return;
+        if (nal_type == 34 && size >= 3)
+          TrackHevcPps(p, size);
+        p += size;
+      }
+    }
+  }
+  else
+  {
+    startcode_split(extradata, extrasize, m_nal_units);
+    for (size_t i = 0; i < m_nal_units.size(); i++)
+    {
+      if (m_nal_units[i].size >= 3 && ((m_nal_units[i].data[0] >> 1) & 0x3f) == 34)
+        TrackHevcPps(m_nal_units[i].data, m_nal_units[i].size);
+    }
+  }
+}
+
+bool CBitstreamConverter::parsehevc_picture(const uint8_t *data, int size, int length_size, h264_picture_info *info)
+{
+  memset(info, 0, sizeof(*info));
+  info->slice_type = -1;
+
+  SplitNalUnits(data, size, length_size);
+
+  bool picture = false;
+  for (size_t unit = 0; unit < m_nal_units.size(); unit++)
+  {
+    const uint8_t *nal = m_nal_units[unit].data;
+    int nal_size = m_nal_units[unit].size;
+    if (nal_size < 3)
+      continue;
+
+    // VCL units are types 0 to 31, 16 to 23 are random access points (BLA, IDR, CRA)
+    int nal_type = (nal[0] >> 1) & 0x3f;
+    if (nal_type >= 32)
+    {
+      if (nal_type == 33 || nal_type == 34)
+        info->param_sets++;
+      if (nal_type == 34)
+        TrackHevcPps(nal, nal_size);
+      continue;
+    }
+    picture = true;
+    bool irap = nal_type >= 16 && nal_type <= 23;
+    if (irap)
+      info->idr = true;
+    // types up to 14 come in pairs, the even one is not referenced
+    if (nal_type > 14 || (nal_type & 1))
+      info->nal_ref_idc = 1;
+
+    if (info->slice_type >= 0)
+      continue;
+    nal_bitstream bs;
+    nal_bs_init(&bs, nal + 2, nal_size - 2);
+    // only the first segment of a picture is free of an address and never dependent
+    if (!nal_bs_read(&bs, 1)) // first_slice_segment_in_pic_flag
+      continue;
+    if (irap)
+      nal_bs_read(&bs, 1);    // no_output_of_prior_pics_flag
+    int pps_id = nal_bs_read_ue(&bs);
+    if (pps_id < 0 || pps_id >= 64)
+      continue;
+    nal_bs_read(&bs, m_hevc_extra_bits[pps_id]); // slice_reserved_flag
+    // B, P and I to the H.264 numbers
+    static const int slice_types[] = { 1, 0, 2 };
+    int slice_type = nal_bs_read_ue(&bs);
+    if (slice_type >= 0 && slice_type <= 2)
+      info->slice_type = slice_types[slice_type];
+  }
+
+  return picture;
+}
+
+const int CBitstreamConverter::avc_parse_nal_units(AVIOContext *pb, const uint8_t *buf_in, int size)
+{
+  startcode_split(buf_in, size, m_nal_units);
+
+  size = 0;
+  for (size_t i = 0; i < m_nal_units.size(); i++)
+  {
+    m_dllAvFormat->avio_wb32(pb, m_nal_units[i].size);
+    m_dllAvFormat->avio_write(pb, m_nal_units[i].data, m_nal_units[i].size);
+    size += 4 + m_nal_units[i].size;
   }
   return size;
 }
@@ -418,6 +790,10 @@ CBitstreamConverter::CBitstreamConverter()
   m_convertSize       = 0;
   m_inputBuffer       = NULL;
   m_inputSize         = 0;
+  m_annexbBuffer      = NULL;
+  m_annexbCapacity    = 0;
+  m_format_valid      = false;
+  memset(m_hevc_extra_bits, 0, sizeof(m_hevc_extra_bits));
   m_to_annexb         = false;
   m_extradata         = NULL;
   m_extrasize         = 0;
@@ -535,10 +911,12 @@ void CBitstreamConverter::Close(void)
       free(m_sps_pps_context.sps_pps_data);
       m_sps_pps_context.sps_pps_data = NULL;
     }
-    if(m_convertBuffer)
-      free(m_convertBuffer);
+    m_convertBuffer     = NULL;
     m_convertSize       = 0;
   }
+  free(m_annexbBuffer);
+  m_annexbBuffer      = NULL;
+  m_annexbCapacity    = 0;
 
   if (m_convert_bytestream)
   {
@@ -575,7 +953,8 @@ void CBitstreamConverter::Close(void)
 
 bool CBitstreamConverter::Convert(uint8_t *pData, int iSize)
 {
-  if(m_convertBuffer)
+  // the Annex B output buffer is kept for the next packet
+  if(m_convertBuffer && m_convertBuffer != m_annexbBuffer)
     free(m_convertBuffer);
   m_convertBuffer = NULL;
   m_convertSize   = 0;
@@ -765,97 +1144,108 @@ bool CBitstreamConverter::BitstreamConvertInit(void *in_extradata, int in_extras
   return true;
 }
 
+static inline uint32_t BitstreamNalSize(const uint8_t *buf, uint8_t length_size)
+{
+  if (length_size == 1)
+    return buf[0];
+  else if (length_size == 2)
+    return OMX_RB16(buf);
+  else
+    return OMX_RB32(buf);
+}
+
+static inline uint8_t *BitstreamStartCode(uint8_t *out, bool first)
+{
+  if (first)
+  {
+    OMX_WB32(out, 1);
+    return out + 4;
+  }
+  out[0] = 0;
+  out[1] = 0;
+  out[2] = 1;
+  return out + 3;
+}
+
 bool CBitstreamConverter::BitstreamConvert(uint8_t* pData, int iSize, uint8_t **poutbuf, int *poutbuf_size)
 {
   // based on h264_mp4toannexb_bsf.c (ffmpeg)
   // which is Copyright (c) 2007 Benoit Fouet <benoit.fouet@free.fr>
   // and Licensed GPL 2.1 or greater
 
+  // the first pass checks the NAL sizes and adds up the output, the second one writes it
+  const uint8_t length_size = m_sps_pps_context.length_size;
+  const uint8_t *buf_end = pData + iSize;
+  uint8_t  first_idr = m_sps_pps_context.first_idr;
+  uint32_t out_size = 0;
+  uint8_t *buf;
+  uint8_t *out;
 
-  uint8_t *buf = pData;
-  uint32_t buf_size = iSize;
-  uint8_t  unit_type;
-  int32_t  nal_size;
-  uint32_t cumul_size = 0;
-  const uint8_t *buf_end = buf + buf_size;
+  *poutbuf = NULL;
+  *poutbuf_size = 0;
 
+  buf = pData;
   do
   {
-    if (buf + m_sps_pps_context.length_size > buf_end)
-      goto fail;
-
-    if (m_sps_pps_context.length_size == 1)
-      nal_size = buf[0];
-    else if (m_sps_pps_context.length_size == 2)
-      nal_size = buf[0] << 8 | buf[1];
-    else
-      nal_size = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+    if (buf + length_size > buf_end)
+      return false;
 
-    buf += m_sps_pps_context.length_size;
-    unit_type = *buf & 0x1f;
+    uint32_t nal_size = BitstreamNalSize(buf, length_size);
+    buf += length_size;
+    if (nal_size > (uint32_t)(buf_end - buf))
+      return false;
 
-    if (buf + nal_size > buf_end || nal_size < 0)
-      goto fail;
+    uint8_t unit_type = nal_size ? *buf & 0x1f : 0;
 
+    out_size += (out_size ? 3 : 4) + nal_size;
     // prepend only to the first type 5 NAL unit of an IDR picture
-    if (m_sps_pps_context.first_idr && unit_type == 5)
+    if (first_idr && unit_type == 5)
     {
-      BitstreamAllocAndCopy(poutbuf, poutbuf_size,
-        m_sps_pps_context.sps_pps_data, m_sps_pps_context.size, buf, nal_size);
-      m_sps_pps_context.first_idr = 0;
-    }
-    else
-    {
-      BitstreamAllocAndCopy(poutbuf, poutbuf_size, NULL, 0, buf, nal_size);
-      if (!m_sps_pps_context.first_idr && unit_type == 1)
-          m_sps_pps_context.first_idr = 1;
+      out_size += m_sps_pps_context.size;
+      first_idr = 0;
     }
+    else if (!first_idr && unit_type == 1)
+      first_idr = 1;
 
     buf += nal_size;
-    cumul_size += nal_size + m_sps_pps_context.length_size;
-  } while (cumul_size < buf_size);
-
-  return true;
+  } while (buf < buf_end);
 
-fail:
-  free(*poutbuf);
-  *poutbuf = NULL;
-  *poutbuf_size = 0;
-  return false;
-}
-
-void CBitstreamConverter::BitstreamAllocAndCopy( uint8_t **poutbuf, int *poutbuf_size,
-    const uint8_t *sps_pps, uint32_t sps_pps_size, const uint8_t *in, uint32_t in_size)
-{
-  // based on h264_mp4toannexb_bsf.c (ffmpeg)
-  // which is Copyright (c) 2007 Benoit Fouet <benoit.fouet@free.fr>
-  // and Licensed GPL 2.1 or greater
-
-  #define CHD_WB32(p, d) { \
-    ((uint8_t*)(p))[3] = (d); \
-    ((uint8_t*)(p))[2] = (d) >> 8; \
-    ((uint8_t*)(p))[1] = (d) >> 16; \
-    ((uint8_t*)(p))[0] = (d) >> 24; }
-
-  uint32_t offset = *poutbuf_size;
-  uint8_t nal_header_size = offset ? 3 : 4;
-
-  *poutbuf_size += sps_pps_size + in_size + nal_header_size;
-  *poutbuf = (uint8_t*)realloc(*poutbuf, *poutbuf_size);
-  if (sps_pps)
-    memcpy(*poutbuf + offset, sps_pps, sps_pps_size);
-
-  memcpy(*poutbuf + sps_pps_size + nal_header_size + offset, in, in_size);
-  if (!offset)
+  if (out_size > m_annexbCapacity)
   {
-    CHD_WB32(*poutbuf + sps_pps_size, 1);
+    // the old contents are not needed, so no realloc copy
+    free(m_annexbBuffer);
+    m_annexbBuffer = (uint8_t*)malloc(out_size);
+    m_annexbCapacity = m_annexbBuffer ? out_size : 0;
+    if (!m_annexbBuffer)
+      return false;
   }
-  else
+
+  out = m_annexbBuffer;
+  for (buf = pData; buf < buf_end; )
   {
-    (*poutbuf + offset + sps_pps_size)[0] = 0;
-    (*poutbuf + offset + sps_pps_size)[1] = 0;
-    (*poutbuf + offset + sps_pps_size)[2] = 1;
+    uint32_t nal_size = BitstreamNalSize(buf, length_size);
+    bool first = out == m_annexbBuffer;
+    buf += length_size;
+
+    uint8_t unit_type = nal_size ? *buf & 0x1f : 0;
+    if (m_sps_pps_context.first_idr && unit_type == 5)
+    {
+      memcpy(out, m_sps_pps_context.sps_pps_data, m_sps_pps_context.size);
+      out += m_sps_pps_context.size;
+      m_sps_pps_context.first_idr = 0;
+    }
+    else if (!m_sps_pps_context.first_idr && unit_type == 1)
+      m_sps_pps_context.first_idr = 1;
+
+    out = BitstreamStartCode(out, first);
+    memcpy(out, buf, nal_size);
+    out += nal_size;
+    buf += nal_size;
   }
+
+  *poutbuf = m_annexbBuffer;
+  *poutbuf_size = out_size;
+  return true;
 }
 
 
@@ -23,9 +23,11 @@
 #define _BITSTREAMCONVERTER_H_
 
 #include <stdint.h>
+#include <string>
 #include "DllAvUtil.h"
 #include "DllAvFormat.h"
 #include "DllAvCodec.h"
+#include "BitstreamStartCode.h"
 
 typedef struct {
   uint8_t *buffer, *start;
@@ -61,11 +63,14 @@ typedef struct {
   ((uint8_t*)(p))[1] = (d) >> 16; \
   ((uint8_t*)(p))[0] = (d) >> 24; }
 
+// big-endian NAL reader that drops emulation prevention bytes, the next
+// bit is the top one of cache and head counts the bits in it
 typedef struct
 {
   const uint8_t *data;
   const uint8_t *end;
   int head;
+  int zeros;        // zero bytes just before data, 2 makes a following 03 an emulation prevention byte
   uint64_t cache;
 } nal_bitstream;
 
@@ -103,6 +108,32 @@ typedef struct
   int frame_crop_bottom_offset;
 } sps_info_struct;
 
+// the SPS fields a change of which makes the decoder reconfigure its output
+typedef struct
+{
+  int  width;          // after cropping
+  int  height;
+  int  profile_idc;
+  int  level_idc;
+  int  max_ref_frames;
+  bool interlaced;
+} h264_sps_summary;
+
+// slice header fields of one H.264 access unit, enough to tell what a decoder can skip
+typedef struct
+{
+  bool idr;         // has an IDR slice
+  int  nal_ref_idc; // highest of its slices, 0 when no other picture references it
+  int  slice_type;  // of the first slice modulo 5 (P, B, I, SP, SI), -1 without slices
+  // in-band parameter sets, compared with the ones seen before under the same id,
+  // only counted here, OMXPlayerVideo takes the repeats out with StripParamSets
+  int  param_sets;           // SPS and PPS NAL units in the access unit
+  int  param_sets_redundant; // identical to the cached ones
+  int  param_sets_updated;   // new contents that leave the picture format alone
+  bool format_changed;       // an SPS changed the summary below
+  h264_sps_summary format;   // valid when format_changed
+} h264_picture_info;
+
 class CBitstreamConverter
 {
 public:
@@ -123,22 +154,41 @@ public:
   uint8_t *GetExtraData(void);
   int GetExtraSize();
   void parseh264_sps(uint8_t *sps, uint32_t sps_size, bool *interlaced, int32_t *max_ref_frames);
+  // sps starts after the NAL header byte
+  bool parseh264_sps_summary(const uint8_t *sps, uint32_t sps_size, h264_sps_summary *summary);
+  // forgets the in-band parameter sets and takes the ones in avcC or Annex B extradata as current
+  void ResetParamSets(const uint8_t *extradata, int extrasize);
+  // length_size is the NAL size field of avcC packets, 0 for Annex B start codes,
+  // SPS and PPS units on the way are checked against the ones seen before
+  bool parseh264_picture(const uint8_t *data, int size, int length_size, h264_picture_info *info);
+  // forgets the HEVC PPS seen so far and takes the ones in hvcC or Annex B extradata
+  void ResetHevcParamSets(const uint8_t *extradata, int extrasize);
+  // same for HEVC: idr is any random access picture, slice_type comes from the
+  // first slice segment header as its H.264 number, nal_ref_idc is 0 or 1
+  bool parsehevc_picture(const uint8_t *data, int size, int length_size, h264_picture_info *info);
+  // takes the H.264 SPS and PPS units out that repeat byte for byte the last one kept
+  // under their id, moving the rest of the packet down, and returns its new size.
+  // It shares the cache parseh264_picture fills, an instance serves one or the other.
+  int StripParamSets(uint8_t *data, int size, int length_size, int *kept, int *dropped);
 protected:
   // bytestream (Annex B) to bistream conversion support.
   void nal_bs_init(nal_bitstream *bs, const uint8_t *data, size_t size);
   uint32_t nal_bs_read(nal_bitstream *bs, int n);
   bool nal_bs_eos(nal_bitstream *bs);
   int nal_bs_read_ue(nal_bitstream *bs);
-  const uint8_t *avc_find_startcode_internal(const uint8_t *p, const uint8_t *end);
-  const uint8_t *avc_find_startcode(const uint8_t *p, const uint8_t *end);
+  int nal_bs_read_se(nal_bitstream *bs);
+  bool parseh264_sps_info(const uint8_t *sps, uint32_t sps_size, sps_info_struct *sps_info);
+  void TrackParamSet(const uint8_t *nal, int size, h264_picture_info *info);
+  bool RepeatedParamSet(const uint8_t *nal, int size);
+  void TrackHevcPps(const uint8_t *nal, int size);
+  // fills m_nal_units from avcC/hvcC style packets, or Annex B ones when length_size is 0
+  void SplitNalUnits(const uint8_t *data, int size, int length_size);
   const int avc_parse_nal_units(AVIOContext *pb, const uint8_t *buf_in, int size);
   const int avc_parse_nal_units_buf(const uint8_t *buf_in, uint8_t **buf, int *size);
   const int isom_write_avcc(AVIOContext *pb, const uint8_t *data, int len);
   // bitstream to bytestream (Annex B) conversion support.
   bool BitstreamConvertInit(void *in_extradata, int in_extrasize);
   bool BitstreamConvert(uint8_t* pData, int iSize, uint8_t **poutbuf, int *poutbuf_size);
-  void BitstreamAllocAndCopy( uint8_t **poutbuf, int *poutbuf_size,
-    const uint8_t *sps_pps, uint32_t sps_pps_size, const uint8_t *in, uint32_t in_size);
 
   typedef struct omx_bitstream_ctx {
       uint8_t  length_size;
@@ -151,6 +201,9 @@ protected:
   int               m_convertSize;
   uint8_t           *m_inputBuffer;
   int               m_inputSize;
+  // Annex B output, kept between packets and only ever grown
+  uint8_t           *m_annexbBuffer;
+  uint32_t          m_annexbCapacity;
 
   uint32_t          m_sps_pps_size;
   omx_bitstream_ctx m_sps_pps_context;
@@ -161,6 +214,15 @@ protected:
   int               m_extrasize;
   bool              m_convert_3byteTo4byteNALSize;
   bool              m_convert_bytestream;
+  // NAL units of the last Annex B packet, kept to reuse its storage
+  std::vector<nal_unit> m_nal_units;
+  // in-band parameter sets by id, and the format of the last SPS
+  std::string       m_sps_cache[32];
+  std::string       m_pps_cache[256];
+  h264_sps_summary  m_format;
+  bool              m_format_valid;
+  // num_extra_slice_header_bits of the HEVC PPS by id, 0 for the ones not seen
+  uint8_t           m_hevc_extra_bits[64];
   DllAvUtil         *m_dllAvUtil;
   DllAvFormat       *m_dllAvFormat;
   AVCodecID         m_codec;
@@ -0,0 +1,212 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "BitstreamStartCode.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STARTCODE_X86
+#elif defined(__aarch64__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STARTCODE_NEON
+#endif
+
+const uint8_t *startcode_find_c(const uint8_t *p, const uint8_t *end)
+{
+  // based on avc.c (ffmpeg)
+  // which is Copyright (c) 2006 Baptiste Coudurier <baptiste.coudurier@smartjog.com>
+  // and Licensed LGPL 2.1 or greater
+  const uint8_t *a = p + 4 - ((intptr_t)p & 3);
+
+  for (end -= 3; p < a && p < end; p++)
+  {
+    if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+      return p;
+  }
+
+  for (end -= 3; p < end; p += 4)
+  {
+    uint32_t x = *(const uint32_t*)p;
+    if ((x - 0x01010101) & (~x) & 0x80808080) // generic
+    {
+      if (p[1] == 0)
+      {
+        if (p[0] == 0 && p[2] == 1)
+          return p;
+        if (p[2] == 0 && p[3] == 1)
+          return p+1;
+      }
+      if (p[3] == 0)
+      {
+        if (p[2] == 0 && p[4] == 1)
+          return p+2;
+        if (p[4] == 0 && p[5] == 1)
+          return p+3;
+      }
+    }
+  }
+
+  for (end += 3; p < end; p++)
+  {
+    if (p[0] == 0 && p[1] == 0 && p[2] == 1)
+      return p;
+  }
+
+  return end + 3;
+}
+
+// The vector versions compare a block at p, p+1 and p+2 with 0, 0 and 1, the
+// lowest set lane is the first start code. A 01 byte is rare in slice data,
+// so the p+2 compare alone decides most blocks. The last bytes that do not
+// fill a block go through startcode_find_c.
+
+#ifdef STARTCODE_X86
+__attribute__((target("sse2")))
+static const uint8_t *startcode_find_sse2(const uint8_t *p, const uint8_t *end)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one  = _mm_set1_epi8(1);
+
+  for (; end - p >= 16 + 3; p += 16)
+  {
+    unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 2)), one));
+    if (!mask)
+      continue;
+    __m128i zeros = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), zero),
+                                  _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 1)), zero));
+    mask &= _mm_movemask_epi8(zeros);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return startcode_find_c(p, end);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t *startcode_find_avx2(const uint8_t *p, const uint8_t *end)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one  = _mm256_set1_epi8(1);
+
+  for (; end - p >= 32 + 3; p += 32)
+  {
+    unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 2)), one));
+    if (!mask)
+      continue;
+    __m256i zeros = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), zero),
+                                     _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 1)), zero));
+    mask &= _mm256_movemask_epi8(zeros);
+    if (mask)
+      return p + __builtin_ctz(mask);
+  }
+  return startcode_find_sse2(p, end);
+}
+#endif
+
+#ifdef STARTCODE_NEON
+// narrows a byte compare result to 4 bits per lane, so ctz / 4 is the lane
+static inline uint64_t startcode_neon_mask(uint8x16_t m)
+{
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+
+static const uint8_t *startcode_find_neon(const uint8_t *p, const uint8_t *end)
+{
+  const uint8x16_t one = vdupq_n_u8(1);
+
+  for (; end - p >= 16 + 3; p += 16)
+  {
+    uint8x16_t ones = vceqq_u8(vld1q_u8(p + 2), one);
+    if (!startcode_neon_mask(ones))
+      continue;
+    uint8x16_t zeros = vceqq_u8(vorrq_u8(vld1q_u8(p), vld1q_u8(p + 1)), vdupq_n_u8(0));
+    uint64_t mask = startcode_neon_mask(vandq_u8(ones, zeros));
+    if (mask)
+      return p + (__builtin_ctzll(mask) >> 2);
+  }
+  return startcode_find_c(p, end);
+}
+#endif
+
+static startcode_finder startcode_select(const char **name)
+{
+#ifdef STARTCODE_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    *name = "avx2";
+    return startcode_find_avx2;
+  }
+  if (__builtin_cpu_supports("sse2"))
+  {
+    *name = "sse2";
+    return startcode_find_sse2;
+  }
+#elif defined(STARTCODE_NEON)
+  *name = "neon";
+  return startcode_find_neon;
+#endif
+  *name = "c";
+  return startcode_find_c;
+}
+
+static const char       *g_startcode_name;
+static startcode_finder  g_startcode_find = startcode_select(&g_startcode_name);
+
+const uint8_t *startcode_find(const uint8_t *p, const uint8_t *end)
+{
+  return g_startcode_find(p, end);
+}
+
+const char *startcode_find_name(void)
+{
+  return g_startcode_name;
+}
+
+// a 4 byte start code is found as its last 3 bytes, the zero before them goes with it
+static inline const uint8_t *startcode_find_nal(const uint8_t *p, const uint8_t *end)
+{
+  const uint8_t *out = g_startcode_find(p, end);
+  if (p < out && out < end && !out[-1])
+    out--;
+  return out;
+}
+
+void startcode_split(const uint8_t *buf, int size, std::vector<nal_unit> &units)
+{
+  const uint8_t *end = buf + size;
+  const uint8_t *nal_start, *nal_end;
+
+  units.clear();
+  nal_start = startcode_find_nal(buf, end);
+
+  for (;;)
+  {
+    // skip the start code
+    while (nal_start < end && !*(nal_start++));
+    if (nal_start == end)
+      break;
+
+    nal_end = startcode_find_nal(nal_start, end);
+    nal_unit unit = { nal_start, (int)(nal_end - nal_start) };
+    units.push_back(unit);
+    nal_start = nal_end;
+  }
+}
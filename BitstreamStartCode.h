@@ -0,0 +1,51 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _BITSTREAMSTARTCODE_H_
+#define _BITSTREAMSTARTCODE_H_
+
+#include <stdint.h>
+#include <vector>
+
+// Annex B start code search. startcode_find picks the widest implementation
+// the CPU has on first use (AVX2 or SSE2 on x86, NEON on ARM builds with NEON
+// enabled), startcode_find_c is the plain one they are checked against.
+// Both return the first 00 00 01 at or after p, or end when there is none.
+// Like the ffmpeg code they come from, a start code ending on the last byte
+// of the buffer starts no NAL unit and is not reported.
+typedef const uint8_t *(*startcode_finder)(const uint8_t *p, const uint8_t *end);
+
+const uint8_t *startcode_find_c(const uint8_t *p, const uint8_t *end);
+const uint8_t *startcode_find(const uint8_t *p, const uint8_t *end);
+// name of the implementation startcode_find uses, for logs
+const char *startcode_find_name(void);
+
+typedef struct
+{
+  const uint8_t *data; // first byte after the start code
+  int            size;
+} nal_unit;
+
+// NAL units of an Annex B buffer in one pass over it. units is cleared
+// first, so one kept by the caller stops allocating after a few packets.
+void startcode_split(const uint8_t *buf, int size, std::vector<nal_unit> &units);
+
+#endif
@@ -21,9 +21,20 @@
 #include "linux/PlatformDefs.h"
 #include <iostream>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <vector>
 #include "utils/StdString.h"
 
 #include "File.h"
+#include "FileCache.h"
 
 using namespace XFILE;
 using namespace std;
@@ -35,6 +46,56 @@ using namespace std;
 #pragma warning (disable:4244)
 #endif
 
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+// A mapped file that shrinks under us raises SIGBUS on the pages past its new
+// end. The copy out of the mapping is guarded so such a read fails instead.
+// SA_NODEFER leaves the signal unblocked after the jump, so sigsetjmp need not
+// save the mask and the guard costs no system call.
+// volatile, or the store before memcpy is dropped as dead
+static __thread sigjmp_buf * volatile g_sigbus_jump = NULL;
+static struct sigaction g_sigbus_old;
+static pthread_once_t g_sigbus_once = PTHREAD_ONCE_INIT;
+
+static void SigbusHandler(int sig)
+{
+  sigjmp_buf *jump = g_sigbus_jump;
+  if(jump)
+  {
+    g_sigbus_jump = NULL;
+    siglongjmp(*jump, 1);
+  }
+  // not ours, the fault happens again with the handler that was there before
+  sigaction(SIGBUS, &g_sigbus_old, NULL);
+}
+
+static void SigbusInstall(void)
+{
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = SigbusHandler;
+  action.sa_flags = SA_NODEFER;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGBUS, &action, &g_sigbus_old);
+}
+
+static bool CopyMapped(void *dst, const void *src, size_t size)
+{
+  sigjmp_buf jump;
+  if(sigsetjmp(jump, 0))
+    return false;
+
+  g_sigbus_jump = &jump;
+  memcpy(dst, src, size);
+  g_sigbus_jump = NULL;
+  return true;
+}
+
 //*********************************************************************************************
 CFile::CFile()
 {
@@ -42,13 +103,27 @@ CFile::CFile()
   m_flags = 0;
   m_iLength = 0;
   m_bPipe = false;
+  m_fd = -1;
+  m_map = NULL;
+  m_iMapOffset = 0;
+  m_iMapSize = 0;
+  m_iPosition = 0;
+  m_iAdvised = 0;
+  m_iPageSize = sysconf(_SC_PAGESIZE);
+  m_bChanging = false;
+  m_iStatTime = 0;
+  m_iForward = 0;
+  m_iMaxRate = 0;
+  m_iRateStart = 0;
+  m_iRateBytes = 0;
+  m_pCache = NULL;
+  m_iCacheSize = 0;
 }
 
 //*********************************************************************************************
 CFile::~CFile()
 {
-  if(m_pFile && !m_bPipe)
-    fclose(m_pFile);
+  Close();
 }
 
 //*********************************************************************************************
@@ -56,6 +131,24 @@ bool CFile::Open(const CStdString& strFileName, unsigned int flags)
 {
   m_flags = flags;
 
+  if (!OpenSource(strFileName))
+    return false;
+
+  if ((flags & READ_CACHED) && !(flags & READ_NO_CACHE) && m_iCacheSize > 0)
+  {
+    m_pCache = new CFileCache(this, m_iCacheSize);
+    if (!m_pCache->Open(IoControl(IOCTRL_SEEK_POSSIBLE, NULL) != 0))
+    {
+      delete m_pCache;
+      m_pCache = NULL;
+    }
+  }
+
+  return true;
+}
+
+bool CFile::OpenSource(const CStdString& strFileName)
+{
   if (strFileName.compare(0, 5, "pipe:") == 0)
   {
     m_bPipe = true;
@@ -63,17 +156,131 @@ bool CFile::Open(const CStdString& strFileName, unsigned int flags)
     m_iLength = 0;
     return true;
   }
-  m_pFile = fopen64(strFileName.c_str(), "r");
+
+  int fd = open64(strFileName.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  m_iRateStart = CurrentHostCounter();
+  m_iRateBytes = 0;
+
+  struct stat64 st;
+  if(fstat64(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+  {
+    m_fd = fd;
+    m_iLength = st.st_size;
+    m_iPosition = 0;
+    m_iAdvised = 0;
+    m_bChanging = false;
+    m_iStatTime = CurrentHostCounter();
+    pthread_once(&g_sigbus_once, SigbusInstall);
+    posix_fadvise64(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    ReadAhead();
+    return true;
+  }
+
+  // fifos, devices and the like can't be mapped, read them through stdio
+  m_pFile = fdopen(fd, "r");
   if(!m_pFile)
+  {
+    close(fd);
     return false;
+  }
+  setvbuf(m_pFile, NULL, _IOFBF, FILE_PIPE_BUFFER_SIZE);
 
-  fseeko64(m_pFile, 0, SEEK_END);
-  m_iLength = ftello64(m_pFile);
-  fseeko64(m_pFile, 0, SEEK_SET);
+  m_iLength = 0;
+  if(fseeko64(m_pFile, 0, SEEK_END) == 0)
+  {
+    m_iLength = ftello64(m_pFile);
+    fseeko64(m_pFile, 0, SEEK_SET);
+  }
+  if(m_iLength < 0)
+    m_iLength = 0;
 
   return true;
 }
 
+bool CFile::MapWindow(int64_t iPosition)
+{
+  if(m_map && iPosition >= m_iMapOffset && iPosition < m_iMapOffset + (int64_t)m_iMapSize)
+    return true;
+
+  UnmapWindow();
+
+  int64_t offset = iPosition - (iPosition % FILE_MAP_WINDOW);
+  size_t size = FILE_MAP_WINDOW;
+  if(offset + (int64_t)size > m_iLength)
+    size = m_iLength - offset;
+
+  void *map = mmap64(NULL, size, PROT_READ, MAP_SHARED, m_fd, offset);
+  if(map == MAP_FAILED)
+    return false;
+
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  m_map = (uint8_t *)map;
+  m_iMapOffset = offset;
+  m_iMapSize = size;
+  return true;
+}
+
+void CFile::UnmapWindow()
+{
+  if(m_map)
+    munmap(m_map, m_iMapSize);
+  m_map = NULL;
+  m_iMapOffset = 0;
+  m_iMapSize = 0;
+}
+
+// A file still being written grows and is read on past its opening size, one
+// rewritten under us may shrink. Once the size has changed the file is only
+// read with pread, which returns short where a mapping would fault.
+void CFile::UpdateLength()
+{
+  struct stat64 st;
+  m_iStatTime = CurrentHostCounter();
+  if(fstat64(m_fd, &st) != 0 || st.st_size == m_iLength)
+    return;
+
+  m_iLength = st.st_size;
+  m_bChanging = true;
+  UnmapWindow();
+}
+
+void CFile::ReadAhead()
+{
+  // keep the kernel prefetching a window ahead of us, refreshed every half window
+  if(m_iPosition + FILE_READAHEAD_SIZE / 2 < m_iAdvised)
+    return;
+
+  posix_fadvise64(m_fd, m_iPosition, FILE_READAHEAD_SIZE, POSIX_FADV_WILLNEED);
+  m_iAdvised = m_iPosition + FILE_READAHEAD_SIZE;
+
+  // count how much of the window is already resident
+  m_iForward = 0;
+  if(!m_map || m_iPosition < m_iMapOffset || m_iPosition >= m_iMapOffset + (int64_t)m_iMapSize)
+    return;
+
+  int64_t start = m_iPosition - (m_iPosition % m_iPageSize);
+  size_t length = m_iMapOffset + m_iMapSize - start;
+  if(length > FILE_READAHEAD_SIZE)
+    length = FILE_READAHEAD_SIZE;
+
+  std::vector<unsigned char> resident((length + m_iPageSize - 1) / m_iPageSize);
+  if(mincore(m_map + (start - m_iMapOffset), length, &resident[0]) != 0)
+    return;
+
+  size_t pages = 0;
+  while(pages < resident.size() && (resident[pages] & 1))
+    pages++;
+
+  int64_t forward = (int64_t)pages * m_iPageSize - (m_iPosition - start);
+  if(forward > m_iLength - m_iPosition)
+    forward = m_iLength - m_iPosition;
+  m_iForward = forward > 0 ? forward : 0;
+}
+
 bool CFile::OpenForWrite(const CStdString& strFileName, bool bOverWrite)
 {
   return false;
@@ -97,13 +304,70 @@ bool CFile::Exists(const CStdString& strFileName, bool bUseCache /* = true */)
 }
 
 unsigned int CFile::Read(void *lpBuf, int64_t uiBufSize)
+{
+  if (m_pCache)
+    return m_pCache->Read(lpBuf, uiBufSize);
+
+  return ReadSource(lpBuf, uiBufSize);
+}
+
+unsigned int CFile::ReadSource(void *lpBuf, int64_t uiBufSize)
 {
   unsigned int ret = 0;
 
-  if(!m_pFile)
-    return 0;
+  if(m_fd >= 0)
+  {
+    uint8_t *buf = (uint8_t *)lpBuf;
 
-  ret = fread(lpBuf, 1, uiBufSize, m_pFile);
+    // the size is looked at again where the file seems to end, and now and then
+    // to keep GetLength current, a shrink in between is caught by CopyMapped
+    if(m_iPosition + uiBufSize > m_iLength || CurrentHostCounter() - m_iStatTime > FILE_STAT_INTERVAL)
+      UpdateLength();
+    if(uiBufSize > m_iLength - m_iPosition)
+      uiBufSize = m_iLength - m_iPosition;
+
+    while(uiBufSize > 0)
+    {
+      int64_t size;
+
+      if(!m_bChanging && MapWindow(m_iPosition))
+      {
+        size = m_iMapOffset + m_iMapSize - m_iPosition;
+        if(size > uiBufSize)
+          size = uiBufSize;
+        if(!CopyMapped(buf, m_map + (m_iPosition - m_iMapOffset), size))
+        {
+          // the file shrank, what was copied is thrown away and read again
+          UpdateLength();
+          m_bChanging = true;
+          UnmapWindow();
+          if(uiBufSize > m_iLength - m_iPosition)
+            uiBufSize = m_iLength - m_iPosition;
+          continue;
+        }
+      }
+      else
+      {
+        // changing size or out of address space, fall back to plain reads
+        size = pread64(m_fd, buf, uiBufSize, m_iPosition);
+        if(size <= 0)
+          break;
+      }
+
+      buf += size;
+      ret += size;
+      uiBufSize -= size;
+      m_iPosition += size;
+    }
+
+    ReadAhead();
+  }
+  else if(m_pFile)
+  {
+    ret = fread(lpBuf, 1, uiBufSize, m_pFile);
+  }
+
+  m_iRateBytes += ret;
 
   return ret;
 }
@@ -111,6 +375,12 @@ unsigned int CFile::Read(void *lpBuf, int64_t uiBufSize)
 //*********************************************************************************************
 void CFile::Close()
 {
+  delete m_pCache;
+  m_pCache = NULL;
+  UnmapWindow();
+  if(m_fd >= 0)
+    close(m_fd);
+  m_fd = -1;
   if(m_pFile && !m_bPipe)
     fclose(m_pFile);
   m_pFile = NULL;
@@ -119,10 +389,54 @@ void CFile::Close()
 //*********************************************************************************************
 int64_t CFile::Seek(int64_t iFilePosition, int iWhence)
 {
+  if (m_pCache)
+  {
+    switch(iWhence)
+    {
+      case SEEK_SET: return m_pCache->Seek(iFilePosition);
+      case SEEK_CUR: return m_pCache->Seek(m_pCache->GetPosition() + iFilePosition);
+      case SEEK_END: return m_iLength > 0 ? m_pCache->Seek(m_iLength + iFilePosition) : -1;
+      default: return -1;
+    }
+  }
+
+  return SeekSource(iFilePosition, iWhence);
+}
+
+int64_t CFile::SeekSource(int64_t iFilePosition, int iWhence)
+{
+  if(m_fd >= 0)
+  {
+    int64_t iPosition;
+
+    switch(iWhence)
+    {
+      case SEEK_SET: iPosition = iFilePosition; break;
+      case SEEK_CUR: iPosition = m_iPosition + iFilePosition; break;
+      case SEEK_END: UpdateLength(); iPosition = m_iLength + iFilePosition; break;
+      default: return -1;
+    }
+    if(iPosition < 0)
+      return -1;
+
+    m_iPosition = iPosition;
+    m_iAdvised = 0;
+    m_iRateStart = CurrentHostCounter();
+    m_iRateBytes = 0;
+    ReadAhead();
+    return m_iPosition;
+  }
+
   if (!m_pFile)
     return -1;
 
-  return fseeko64(m_pFile, iFilePosition, iWhence);;
+  m_iRateStart = CurrentHostCounter();
+  m_iRateBytes = 0;
+
+  if (fseeko64(m_pFile, iFilePosition, iWhence) != 0)
+    return -1;
+
+  return ftello64(m_pFile);
 }
 
 //*********************************************************************************************
@@ -134,6 +448,17 @@ int64_t CFile::GetLength()
 //*********************************************************************************************
 int64_t CFile::GetPosition()
 {
+  if (m_pCache)
+    return m_pCache->GetPosition();
+
+  return GetPositionSource();
+}
+
+int64_t CFile::GetPositionSource()
+{
+  if (m_fd >= 0)
+    return m_iPosition;
+
   if (!m_pFile)
     return -1;
 
@@ -148,6 +473,9 @@ int CFile::Write(const void* lpBuf, int64_t uiBufSize)
 
 int CFile::IoControl(EIoControl request, void* param)
 {
+  if(request == IOCTRL_SEEK_POSSIBLE && m_fd >= 0)
+    return 1;
+
   if(request == IOCTRL_SEEK_POSSIBLE && m_pFile)
   {
     if (m_bPipe)
@@ -160,11 +488,55 @@ int CFile::IoControl(EIoControl request, void* param)
     }
   }
 
+  if(request == IOCTRL_CACHE_SETRATE && param)
+  {
+    m_iMaxRate = *(unsigned int *)param;
+    if (!m_pCache)
+      return -1;
+
+    m_pCache->SetRate(m_iMaxRate);
+    return 0;
+  }
+
+  if(request == IOCTRL_CACHE_STATUS && param && m_pCache)
+  {
+    m_pCache->GetStatus((SCacheStatus *)param);
+    return 0;
+  }
+
+  if(request == IOCTRL_CACHE_STATUS && param && (m_fd >= 0 || m_pFile))
+  {
+    SCacheStatus *status = (SCacheStatus *)param;
+    int64_t elapsed = CurrentHostCounter() - m_iRateStart;
+
+    status->forward = m_fd >= 0 ? m_iForward : 0;
+    status->maxrate = m_iMaxRate;
+    status->currate = elapsed > 0 ? (unsigned)(m_iRateBytes * 1000000000LL / elapsed) : 0;
+    status->full    = m_fd >= 0 && m_iForward >= FILE_READAHEAD_SIZE / 2;
+    status->underruns = 0;
+    return 0;
+  }
+
   return -1;
 }
 
 bool CFile::IsEOF()
 {
+  if (m_pCache)
+    return m_pCache->IsEOF();
+
+  return IsEOFSource();
+}
+
+bool CFile::IsEOFSource()
+{
+  if (m_fd >= 0)
+  {
+    if (m_iPosition >= m_iLength)
+      UpdateLength();
+    return m_iPosition >= m_iLength;
+  }
+
   if (!m_pFile)
     return -1;
 
@@ -31,6 +31,15 @@
 
 #define FFMPEG_FILE_BUFFER_SIZE   32768
 
+// regular files are read through a mapped window of this size
+#define FILE_MAP_WINDOW           (16 * 1024 * 1024)
+// how far ahead of the read position the kernel is asked to prefetch
+#define FILE_READAHEAD_SIZE       (4 * 1024 * 1024)
+// stdio buffer for pipes and fifos
+#define FILE_PIPE_BUFFER_SIZE     (1024 * 1024)
+// how often the size of a mapped file is checked when reading inside it, in ns
+#define FILE_STAT_INTERVAL        1000000000LL
+
 namespace XFILE
 {
 
@@ -56,6 +65,17 @@ typedef enum {
   IOCTRL_CACHE_SETRATE = 4, /**< unsigned int with with speed limit for caching in bytes per second */
 } EIoControl;
 
+struct SCacheStatus
+{
+  uint64_t forward;  /**< number of bytes cached forward of current position */
+  unsigned maxrate;  /**< maximum number of bytes per second cache is allowed to fill */
+  unsigned currate;  /**< average read rate from source file since last position change */
+  bool     full;     /**< is the cache full */
+  unsigned underruns; /**< number of reads that had to wait for the cache */
+};
+
+class CFileCache;
+
 class CFile
 {
 public:
@@ -71,14 +91,50 @@ public:
   int64_t GetLength();
   void Close();
   static bool Exists(const CStdString& strFileName, bool bUseCache = true);
-  int GetChunkSize() { return 6144 /*FFMPEG_FILE_BUFFER_SIZE*/; };
+  int GetChunkSize() { return m_fd >= 0 ? FFMPEG_FILE_BUFFER_SIZE : 6144; };
   int IoControl(EIoControl request, void* param);
   bool IsEOF();
+  // size of the RAM read-ahead cache used when opened with READ_CACHED
+  void SetCacheSize(unsigned int size) { m_iCacheSize = size; };
 private:
+  friend class CFileCache;
+
+  bool OpenSource(const CStdString& strFileName);
+  unsigned int ReadSource(void* lpBuf, int64_t uiBufSize);
+  int64_t SeekSource(int64_t iFilePosition, int iWhence);
+  int64_t GetPositionSource();
+  bool IsEOFSource();
+  bool MapWindow(int64_t iPosition);
+  void UnmapWindow();
+  void ReadAhead();
+  void UpdateLength();
+
   unsigned int m_flags;
   FILE  *m_pFile;
   int64_t m_iLength;
   bool m_bPipe;
+
+  // mapped backend, used for regular files
+  int m_fd;
+  uint8_t *m_map;
+  int64_t m_iMapOffset;
+  size_t m_iMapSize;
+  int64_t m_iPosition;
+  int64_t m_iAdvised;
+  long m_iPageSize;
+  // the size changed since the file was opened, it is no longer mapped
+  bool m_bChanging;
+  // when UpdateLength last ran
+  int64_t m_iStatTime;
+
+  // read-ahead status
+  uint64_t m_iForward;
+  unsigned int m_iMaxRate;
+  int64_t m_iRateStart;
+  int64_t m_iRateBytes;
+
+  CFileCache *m_pCache;
+  unsigned int m_iCacheSize;
 };
 
 };
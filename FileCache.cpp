@@ -0,0 +1,327 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "linux/PlatformDefs.h"
+#include "utils/StdString.h"
+#include "utils/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "File.h"
+#include "FileCache.h"
+
+using namespace XFILE;
+
+// never sleep longer than this while throttled, so rate changes apply quickly
+#define FILE_CACHE_MAX_DELAY  (100 * 1000000LL)
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+CFileCache::CFileCache(CFile *source, unsigned int size)
+{
+  m_source      = source;
+  m_buffer      = NULL;
+  m_size        = size;
+  m_bAbort      = false;
+  m_begin       = 0;
+  m_end         = 0;
+  m_pos         = 0;
+  m_seek        = false;
+  m_eof         = false;
+  m_seekable    = false;
+  m_generation  = 0;
+  m_maxrate     = 0;
+  m_fill_start  = CurrentHostCounter();
+  m_fill_bytes  = 0;
+  m_underruns   = 0;
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_cond, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&m_lock, NULL);
+}
+
+CFileCache::~CFileCache()
+{
+  Close();
+
+  free(m_buffer);
+
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+void CFileCache::Lock()
+{
+  pthread_mutex_lock(&m_lock);
+}
+
+void CFileCache::UnLock()
+{
+  pthread_mutex_unlock(&m_lock);
+}
+
+bool CFileCache::Open(bool seekable)
+{
+  if(!m_buffer)
+    m_buffer = (uint8_t *)malloc(m_size);
+
+  if(!m_buffer)
+  {
+    CLog::Log(LOGERROR, "CFileCache::Open - failed to allocate %u bytes", m_size);
+    return false;
+  }
+
+  m_seekable = seekable;
+  m_bAbort   = false;
+
+  Create();
+
+  return true;
+}
+
+void CFileCache::Close()
+{
+  if(ThreadHandle())
+  {
+    Lock();
+    m_bAbort = true;
+    pthread_cond_broadcast(&m_cond);
+    UnLock();
+
+    StopThread();
+  }
+}
+
+unsigned int CFileCache::GetFree()
+{
+  // drop data that fell out of the back buffer
+  int64_t back = m_size / 4;
+  if(m_pos - m_begin > back)
+    m_begin = m_pos - back;
+
+  return m_size - (unsigned int)(m_end - m_begin);
+}
+
+int64_t CFileCache::GetThrottleDelay()
+{
+  // only throttle once enough is cached to ride out a stall
+  if(!m_maxrate || m_end - m_pos < m_size / 4)
+    return 0;
+
+  int64_t elapsed  = CurrentHostCounter() - m_fill_start;
+  int64_t expected = m_fill_bytes * 1000000000LL / m_maxrate;
+
+  return expected > elapsed ? expected - elapsed : 0;
+}
+
+void CFileCache::Process()
+{
+  while(true)
+  {
+    Lock();
+    while(!(m_bStop || m_bAbort))
+    {
+      if(m_eof || GetFree() == 0)
+      {
+        pthread_cond_wait(&m_cond, &m_lock);
+        continue;
+      }
+
+      int64_t delay = m_seek ? 0 : GetThrottleDelay();
+      if(delay <= 0)
+        break;
+
+      if(delay > FILE_CACHE_MAX_DELAY)
+        delay = FILE_CACHE_MAX_DELAY;
+
+      struct timespec timeout;
+      clock_gettime(CLOCK_MONOTONIC, &timeout);
+      timeout.tv_sec  += (timeout.tv_nsec + delay) / 1000000000LL;
+      timeout.tv_nsec  = (timeout.tv_nsec + delay) % 1000000000LL;
+      pthread_cond_timedwait(&m_cond, &m_lock, &timeout);
+    }
+
+    if(m_bStop || m_bAbort)
+    {
+      UnLock();
+      break;
+    }
+
+    bool         seek       = m_seek;
+    int64_t      pos        = m_end;
+    unsigned int generation = m_generation;
+    unsigned int index      = pos % m_size;
+    unsigned int size       = GetFree();
+    m_seek = false;
+
+    if(size > m_size - index)
+      size = m_size - index;
+    if(size > FILE_CACHE_CHUNK_SIZE)
+      size = FILE_CACHE_CHUNK_SIZE;
+    UnLock();
+
+    // the region past m_end is only ever touched by this thread, a seek
+    // meanwhile bumps the generation and the data is thrown away
+    int64_t ret = 0;
+    if(!seek || m_source->SeekSource(pos, SEEK_SET) == pos)
+      ret = m_source->ReadSource(m_buffer + index, size);
+    else
+      CLog::Log(LOGERROR, "CFileCache::Process - seek to %lld failed", (long long)pos);
+
+    Lock();
+    if(generation == m_generation)
+    {
+      if(ret > 0)
+      {
+        m_end        += ret;
+        m_fill_bytes += ret;
+      }
+      else
+      {
+        m_eof = true;
+      }
+      pthread_cond_broadcast(&m_cond);
+    }
+    UnLock();
+  }
+}
+
+unsigned int CFileCache::Read(void *lpBuf, int64_t uiBufSize)
+{
+  uint8_t *buf = (uint8_t *)lpBuf;
+  bool waited  = false;
+
+  Lock();
+  while(m_pos >= m_end && !m_eof && !m_bAbort)
+  {
+    // an empty cache right after a seek is expected, anything else is an underrun
+    if(!waited && m_end != m_begin)
+      m_underruns++;
+    waited = true;
+    pthread_cond_wait(&m_cond, &m_lock);
+  }
+
+  int64_t available = m_end - m_pos;
+  if(available < 0)
+    available = 0;
+  if(uiBufSize > available)
+    uiBufSize = available;
+
+  unsigned int index = m_pos % m_size;
+  unsigned int first = uiBufSize;
+  if(first > m_size - index)
+    first = m_size - index;
+
+  memcpy(buf, m_buffer + index, first);
+  memcpy(buf + first, m_buffer, uiBufSize - first);
+  m_pos += uiBufSize;
+
+  pthread_cond_broadcast(&m_cond);
+  UnLock();
+
+  return uiBufSize;
+}
+
+int64_t CFileCache::Seek(int64_t iFilePosition)
+{
+  if(iFilePosition < 0)
+    return -1;
+
+  Lock();
+  if(iFilePosition >= m_begin && iFilePosition <= m_end)
+  {
+    m_pos = iFilePosition;
+  }
+  else if(!m_seekable)
+  {
+    UnLock();
+    return -1;
+  }
+  else
+  {
+    m_begin       = iFilePosition;
+    m_end         = iFilePosition;
+    m_pos         = iFilePosition;
+    m_seek        = true;
+    m_eof         = false;
+    m_fill_start  = CurrentHostCounter();
+    m_fill_bytes  = 0;
+    m_generation++;
+  }
+  pthread_cond_broadcast(&m_cond);
+  UnLock();
+
+  return iFilePosition;
+}
+
+int64_t CFileCache::GetPosition()
+{
+  int64_t pos;
+
+  Lock();
+  pos = m_pos;
+  UnLock();
+
+  return pos;
+}
+
+bool CFileCache::IsEOF()
+{
+  bool eof;
+
+  Lock();
+  eof = m_eof && m_pos >= m_end;
+  UnLock();
+
+  return eof;
+}
+
+void CFileCache::SetRate(unsigned int rate)
+{
+  Lock();
+  m_maxrate = rate;
+  pthread_cond_broadcast(&m_cond);
+  UnLock();
+}
+
+void CFileCache::GetStatus(SCacheStatus *status)
+{
+  Lock();
+  int64_t elapsed = CurrentHostCounter() - m_fill_start;
+
+  status->forward   = m_end > m_pos ? m_end - m_pos : 0;
+  status->maxrate   = m_maxrate;
+  status->currate   = elapsed > 0 ? (unsigned)(m_fill_bytes * 1000000000LL / elapsed) : 0;
+  status->full      = GetFree() == 0;
+  status->underruns = m_underruns;
+  UnLock();
+}
@@ -0,0 +1,86 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _FILE_CACHE_H_
+#define _FILE_CACHE_H_
+
+#include "OMXThread.h"
+
+#include <pthread.h>
+#include <stdint.h>
+
+// largest single read from the source file
+#define FILE_CACHE_CHUNK_SIZE   (256 * 1024)
+
+namespace XFILE
+{
+
+class CFile;
+struct SCacheStatus;
+
+// Fills a RAM ring from the source file on its own thread, so that storage
+// stalls shorter than the ring are not seen by the demuxer. A quarter of
+// the ring is kept behind the read position for short backward seeks.
+class CFileCache : public OMXThread
+{
+protected:
+  CFile             *m_source;
+  uint8_t           *m_buffer;
+  unsigned int      m_size;
+  pthread_mutex_t   m_lock;
+  pthread_cond_t    m_cond;
+  bool              m_bAbort;
+
+  // absolute file positions, cached data is [m_begin, m_end)
+  int64_t           m_begin;
+  int64_t           m_end;
+  int64_t           m_pos;
+  bool              m_seek;
+  bool              m_eof;
+  bool              m_seekable;
+  unsigned int      m_generation;
+
+  // throttling and statistics
+  unsigned int      m_maxrate;
+  int64_t           m_fill_start;
+  int64_t           m_fill_bytes;
+  unsigned int      m_underruns;
+
+  void Lock();
+  void UnLock();
+  unsigned int GetFree();
+  int64_t GetThrottleDelay();
+public:
+  CFileCache(CFile *source, unsigned int size);
+  virtual ~CFileCache();
+  bool Open(bool seekable);
+  void Close();
+  void Process();
+  unsigned int Read(void *lpBuf, int64_t uiBufSize);
+  int64_t Seek(int64_t iFilePosition);
+  int64_t GetPosition();
+  bool IsEOF();
+  void SetRate(unsigned int rate);
+  void GetStatus(SCacheStatus *status);
+};
+
+};
+#endif
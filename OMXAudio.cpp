@@ -25,6 +25,7 @@
 #endif
 
 #include "OMXAudio.h"
+#include "OMXReader.h"
 #include "utils/log.h"
 
 #define CLASSNAME "COMXAudio"
@@ -561,7 +562,8 @@ bool COMXAudio::Initialize(OMXClock *clock, const OMXAudioConfig &config, uint64
     }
   }
 
-  omx_err = m_omx_decoder.AllocInputBuffers();
+  // passthrough and hw decoded packets can be handed over by pointer with direct input
+  omx_err = m_omx_decoder.AllocInputBuffers(m_config.direct_input);
   if(omx_err != OMX_ErrorNone) 
   {
     CLog::Log(LOGERROR, "COMXAudio::Initialize - Error alloc buffers 0x%08x", omx_err);
@@ -585,7 +587,7 @@ bool COMXAudio::Initialize(OMXClock *clock, const OMXAudioConfig &config, uint64
     }
 
     omx_buffer->nOffset = 0;
-    omx_buffer->nFilledLen  = std::min(sizeof(m_wave_header), omx_buffer->nAllocLen);
+    omx_buffer->nFilledLen  = std::min((OMX_U32)sizeof(m_wave_header), omx_buffer->nAllocLen);
 
     memset((unsigned char *)omx_buffer->pBuffer, 0x0, omx_buffer->nAllocLen);
     memcpy((unsigned char *)omx_buffer->pBuffer, &m_wave_header, omx_buffer->nFilledLen);
@@ -846,7 +848,7 @@ unsigned int COMXAudio::AddPackets(const void* data, unsigned int len)
 }
 
 //***********************************************************************************************
-unsigned int COMXAudio::AddPackets(const void* data, unsigned int len, double dts, double pts, unsigned int frame_size)
+unsigned int COMXAudio::AddPackets(const void* data, unsigned int len, double dts, double pts, unsigned int frame_size, AVBufferRef *ref)
 {
   CSingleLock lock (m_critSection);
 
@@ -919,7 +921,17 @@ unsigned int COMXAudio::AddPackets(const void* data, unsigned int len, double dt
     {
        uint8_t *dst = omx_buffer->pBuffer;
        uint8_t *src = demuxer_content + demuxer_samples_sent * pitch;
-       memcpy(dst, src, omx_buffer->nFilledLen);
+
+       // encoded packets that fit one buffer are submitted in place
+       AVBufferRef *lent = NULL;
+       if(ref && samples == demuxer_samples && (m_config.passthrough || m_config.hwdecode))
+         lent = av_buffer_ref(ref);
+       if(!lent || !m_omx_decoder.LendInputBuffer(omx_buffer, src, omx_buffer->nFilledLen, OMXReader::UnrefPacketData, lent))
+       {
+         if(lent)
+           av_buffer_unref(&lent);
+         memcpy(dst, src, omx_buffer->nFilledLen);
+       }
     }
 
     uint64_t val  = (uint64_t)(pts == DVD_NOPTS_VALUE) ? 0 : pts;
@@ -1055,6 +1067,12 @@ void COMXAudio::UpdateAttenuation()
 }
 
 //***********************************************************************************************
+void COMXAudio::SetWakeups(OMXWakeup *space, OMXWakeup *eos)
+{
+  m_omx_decoder.SetInputWakeup(space);
+  m_omx_decoder.SetEOSWakeup(eos);
+}
+
 unsigned int COMXAudio::GetSpace()
 {
   int free = m_omx_decoder.GetInputBufferSpace();
@@ -51,6 +51,7 @@ public:
   bool boostOnDownmix;
   bool passthrough;
   bool hwdecode;
+  bool direct_input;
   bool is_live;
   float queue_size;
   float fifo_size;
@@ -62,6 +63,7 @@ public:
     boostOnDownmix = true;
     passthrough = false;
     hwdecode = false;
+    direct_input = false;
     is_live = false;
     queue_size = 3.0f;
     fifo_size = 2.0f;
@@ -92,8 +94,10 @@ public:
   bool PortSettingsChanged();
 
   unsigned int AddPackets(const void* data, unsigned int len);
-  unsigned int AddPackets(const void* data, unsigned int len, double dts, double pts, unsigned int frame_size);
+  unsigned int AddPackets(const void* data, unsigned int len, double dts, double pts, unsigned int frame_size, AVBufferRef *ref = NULL);
   unsigned int GetSpace();
+  // lets a player sleep until input space frees up or end of stream is reached
+  void SetWakeups(OMXWakeup *space, OMXWakeup *eos);
   bool Deinitialize();
 
   void SetVolume(float nVolume);
@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+
+#include "OMXBufferList.h"
+
+OMXBufferList::OMXBufferList()
+{
+  m_cells = NULL;
+  m_mask  = 0;
+  m_contended.store(0, std::memory_order_relaxed);
+  m_empty.store(0, std::memory_order_relaxed);
+  m_waits.store(0, std::memory_order_relaxed);
+  m_wait_us.store(0, std::memory_order_relaxed);
+  Reset(0);
+}
+
+OMXBufferList::~OMXBufferList()
+{
+  delete [] m_cells;
+}
+
+void OMXBufferList::Reset(unsigned int capacity)
+{
+  size_t size = 2;
+  while(size < capacity)
+    size <<= 1;
+
+  if(size != m_mask + 1)
+  {
+    delete [] m_cells;
+    m_cells = new Cell[size];
+    m_mask  = size - 1;
+  }
+
+  // a cell is free for the push at position i while its sequence is i
+  for(size_t i = 0; i < size; i++)
+  {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    m_cells[i].buffer = NULL;
+  }
+
+  m_enqueue.store(0, std::memory_order_relaxed);
+  m_dequeue.store(0, std::memory_order_relaxed);
+  m_size.store(0, std::memory_order_seq_cst);
+}
+
+bool OMXBufferList::Push(OMX_BUFFERHEADERTYPE *buffer)
+{
+  size_t pos = m_enqueue.load(std::memory_order_relaxed);
+  Cell *cell;
+
+  for(;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    intptr_t diff = (intptr_t)cell->sequence.load(std::memory_order_acquire) - (intptr_t)pos;
+
+    if(diff == 0)
+    {
+      if(m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+      m_contended.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if(diff < 0)
+    {
+      // full, more buffers came back than were handed out
+      if((intptr_t)(pos - m_dequeue.load(std::memory_order_acquire)) > (intptr_t)m_mask)
+        return false;
+      // otherwise the pop a lap behind has not released its cell yet
+      m_contended.fetch_add(1, std::memory_order_relaxed);
+      pos = m_enqueue.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      pos = m_enqueue.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->buffer = buffer;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  m_size.fetch_add(1, std::memory_order_seq_cst);
+  return true;
+}
+
+OMX_BUFFERHEADERTYPE *OMXBufferList::Pop()
+{
+  size_t pos = m_dequeue.load(std::memory_order_relaxed);
+  Cell *cell;
+
+  for(;;)
+  {
+    cell = &m_cells[pos & m_mask];
+    intptr_t diff = (intptr_t)cell->sequence.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+
+    if(diff == 0)
+    {
+      if(m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+      m_contended.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if(diff < 0)
+    {
+      return NULL;
+    }
+    else
+    {
+      pos = m_dequeue.load(std::memory_order_relaxed);
+    }
+  }
+
+  OMX_BUFFERHEADERTYPE *buffer = cell->buffer;
+  // hand the cell to the push one lap ahead
+  cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+  m_size.fetch_sub(1, std::memory_order_seq_cst);
+  return buffer;
+}
+
+void OMXBufferList::AddMiss()
+{
+  m_empty.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OMXBufferList::AddWait(uint64_t wait_us)
+{
+  m_waits.fetch_add(1, std::memory_order_relaxed);
+  m_wait_us.fetch_add(wait_us, std::memory_order_relaxed);
+}
+
+void OMXBufferList::GetStats(OMXBufferListStats &stats) const
+{
+  stats.contended = m_contended.load(std::memory_order_relaxed);
+  stats.empty     = m_empty.load(std::memory_order_relaxed);
+  stats.waits     = m_waits.load(std::memory_order_relaxed);
+  stats.wait_us   = m_wait_us.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+#ifndef _OMX_BUFFERLIST_H_
+#define _OMX_BUFFERLIST_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#include "DllOMX.h"
+
+typedef struct OMXBufferListStats
+{
+  unsigned int  contended;  // push/pop retries lost to another thread
+  unsigned int  empty;      // gets that found no free buffer
+  unsigned int  waits;      // gets that had to sleep
+  uint64_t      wait_us;    // total time spent sleeping
+} OMXBufferListStats;
+
+// Bounded lock-free free list of buffer headers, safe for any number of
+// producers and consumers. The OMX callbacks return buffers to it and the
+// decoders take them out without locking; sleeping on an empty list is
+// left to the owner.
+class OMXBufferList
+{
+public:
+  OMXBufferList();
+  ~OMXBufferList();
+  // drops everything queued, not safe against concurrent Push/Pop
+  void Reset(unsigned int capacity);
+  bool Push(OMX_BUFFERHEADERTYPE *buffer);
+  OMX_BUFFERHEADERTYPE *Pop();
+  void Clear() { while(Pop()); };
+  unsigned int Size() const { return m_size.load(std::memory_order_seq_cst); };
+  bool Empty() const { return Size() == 0; };
+  // counters kept for the owner, they survive Reset
+  void AddMiss();
+  void AddWait(uint64_t wait_us);
+  void GetStats(OMXBufferListStats &stats) const;
+private:
+  OMXBufferList(const OMXBufferList&) = delete;
+  OMXBufferList& operator=(const OMXBufferList&) = delete;
+
+  struct Cell
+  {
+    std::atomic<size_t>   sequence;
+    OMX_BUFFERHEADERTYPE  *buffer;
+  };
+
+  Cell                        *m_cells;
+  size_t                      m_mask;
+  std::atomic<size_t>         m_enqueue;
+  std::atomic<size_t>         m_dequeue;
+  std::atomic<unsigned int>   m_size;
+  std::atomic<unsigned int>   m_contended;
+  std::atomic<unsigned int>   m_empty;
+  std::atomic<unsigned int>   m_waits;
+  std::atomic<uint64_t>       m_wait_us;
+};
+#endif
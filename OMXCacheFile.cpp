@@ -0,0 +1,178 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXCacheFile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "utils/log.h"
+
+static bool MakeDir(const std::string &dir)
+{
+  return mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+OMXCacheFile::OMXCacheFile()
+{
+  m_size  = 0;
+  m_mtime = 0;
+}
+
+bool OMXCacheFile::Open(const std::string &filename, const char *dir, const char *magic)
+{
+  m_path.clear();
+
+  struct stat st;
+  if(stat(filename.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    return false;
+
+  std::string path;
+  const char *cache = getenv("XDG_CACHE_HOME");
+  const char *home  = getenv("HOME");
+
+  if(cache && *cache)
+    path = cache;
+  else if(home && *home)
+    path = std::string(home) + "/.cache";
+  else
+    return false;
+
+  path += "/omxplayer";
+  if(!MakeDir(path))
+    return false;
+  path += "/";
+  path += dir;
+  if(!MakeDir(path))
+    return false;
+
+  char *real = realpath(filename.c_str(), NULL);
+  m_filename = real ? real : filename;
+  free(real);
+
+  m_magic = magic;
+  m_size  = st.st_size;
+  m_mtime = st.st_mtime;
+
+  // FNV-1a over the key, the full key is checked again when reading
+  char key[64];
+  snprintf(key, sizeof(key), "\n%lld\n%lld", (long long)m_size, (long long)m_mtime);
+  std::string id = m_filename + key;
+  uint64_t hash = 14695981039346656037ULL;
+  for(size_t i = 0; i < id.size(); i++)
+  {
+    hash ^= (unsigned char)id[i];
+    hash *= 1099511628211ULL;
+  }
+
+  snprintf(key, sizeof(key), "/%016llx", (unsigned long long)hash);
+  m_path = path + key;
+
+  return true;
+}
+
+FILE *OMXCacheFile::OpenRead()
+{
+  if(m_path.empty())
+    return NULL;
+
+  FILE *fp = fopen(m_path.c_str(), "rb");
+  if(!fp)
+    return NULL;
+
+  std::string magic(m_magic.size(), '\0');
+  int64_t size, mtime;
+  uint32_t length;
+
+  if(fread(&magic[0], 1, magic.size(), fp) == magic.size() && magic == m_magic &&
+     fread(&size, sizeof(size), 1, fp) == 1 && size == m_size &&
+     fread(&mtime, sizeof(mtime), 1, fp) == 1 && mtime == m_mtime &&
+     fread(&length, sizeof(length), 1, fp) == 1 && length == m_filename.size())
+  {
+    std::string filename(length, '\0');
+    if(fread(&filename[0], 1, length, fp) == length && filename == m_filename)
+      return fp;
+  }
+
+  fclose(fp);
+  return NULL;
+}
+
+FILE *OMXCacheFile::OpenWrite()
+{
+  if(m_path.empty())
+    return NULL;
+
+  // written to a temporary and renamed, so a concurrent player never sees half an entry
+  std::string tmp = m_path + ".XXXXXX";
+  int fd = mkstemp(&tmp[0]);
+  if(fd < 0)
+    return NULL;
+
+  FILE *fp = fdopen(fd, "wb");
+  if(!fp)
+  {
+    close(fd);
+    unlink(tmp.c_str());
+    return NULL;
+  }
+  m_tmp = tmp;
+
+  uint32_t length = m_filename.size();
+
+  if(fwrite(m_magic.c_str(), 1, m_magic.size(), fp) == m_magic.size() &&
+     fwrite(&m_size, sizeof(m_size), 1, fp) == 1 &&
+     fwrite(&m_mtime, sizeof(m_mtime), 1, fp) == 1 &&
+     fwrite(&length, sizeof(length), 1, fp) == 1 &&
+     fwrite(m_filename.c_str(), 1, length, fp) == length)
+    return fp;
+
+  CloseWrite(fp, false);
+  return NULL;
+}
+
+bool OMXCacheFile::CloseWrite(FILE *fp, bool ok)
+{
+  if(fclose(fp) != 0)
+    ok = false;
+
+  if(ok && rename(m_tmp.c_str(), m_path.c_str()) != 0)
+    ok = false;
+
+  if(!ok)
+  {
+    CLog::Log(LOGWARNING, "OMXCacheFile::CloseWrite - failed to write %s", m_path.c_str());
+    unlink(m_tmp.c_str());
+  }
+  m_tmp.clear();
+
+  return ok;
+}
@@ -0,0 +1,52 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_CACHEFILE_H_
+#define _OMX_CACHEFILE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// Per media file data kept in $XDG_CACHE_HOME/omxplayer/<dir>. Entries are
+// keyed by the real path, size and modification time of the media file, so
+// a changed file never picks up stale data.
+class OMXCacheFile
+{
+public:
+  OMXCacheFile();
+  bool Open(const std::string &filename, const char *dir, const char *magic);
+  // returns the entry positioned after the header, or NULL if there is no valid one
+  FILE *OpenRead();
+  FILE *OpenWrite();
+  // closes a file from OpenWrite and replaces the entry when ok is set
+  bool CloseWrite(FILE *fp, bool ok);
+  const std::string &GetPath() { return m_path; };
+private:
+  std::string m_path;
+  // unique per writer, two players saving the same entry don't mix their data
+  std::string m_tmp;
+  std::string m_filename;
+  std::string m_magic;
+  int64_t     m_size;
+  int64_t     m_mtime;
+};
+#endif
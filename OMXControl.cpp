@@ -319,8 +319,8 @@ OMXControlResult OMXControl::handle_event(DBusMessage *m)
       }
       else if (strcmp(property, "Position")==0)
       {
-        // Returns the current position in microseconds
-        int64_t pos = clock->OMXMediaTime();
+        // Returns the current position in microseconds, within the current file
+        int64_t pos = clock->OMXMediaTime() - reader->GetTimeOffset();
         dbus_respond_int64(m, pos);
         return KeyConfig::ACTION_BLANK;
       }
@@ -709,8 +709,8 @@ OMXControlResult OMXControl::handle_event(DBusMessage *m)
   }
   else if (dbus_message_is_method_call(m, DBUS_INTERFACE_PROPERTIES, "Position"))
   {
-    // Returns the current position in microseconds
-    int64_t pos = clock->OMXMediaTime();
+    // Returns the current position in microseconds, within the current file
+    int64_t pos = clock->OMXMediaTime() - reader->GetTimeOffset();
     dbus_respond_int64(m, pos);
     deprecatedMessage();
     return KeyConfig::ACTION_BLANK;
@@ -1061,6 +1061,33 @@ OMXControlResult OMXControl::handle_event(DBusMessage *m)
 
     return KeyConfig::ACTION_BLANK;
   }
+  else if (dbus_message_is_method_call(m, OMXPLAYER_DBUS_INTERFACE_PLAYER, "GopStats"))
+  {
+    int count = reader->VideoStreamCount();
+    char** values = new char*[count];
+
+    for (int i=0; i < count; i++)
+    {
+       OMXGopStats gop = {};
+       reader->GetGopStats(i, &gop);
+       asprintf(&values[i], "%d:%u:%.1f:%.3f:%.3f:%.0f:%.0f", i, gop.gops,
+                                              gop.gops ? (double)gop.frames / gop.gops : 0.0,
+                                              gop.gops ? gop.interval / gop.gops : 0.0, gop.interval_max,
+                                              gop.interval > 0 ? gop.bytes * 8 / gop.interval / 1000.0 : 0.0,
+                                              gop.bitrate_max / 1000.0);
+    }
+
+    dbus_respond_array(m, (const char**)values, count);
+
+    // Cleanup
+    for (int i=0; i < count; i++)
+    {
+      free(values[i]);
+    }
+    delete[] values;
+
+    return KeyConfig::ACTION_BLANK;
+  }
   else if (dbus_message_is_method_call(m, OMXPLAYER_DBUS_INTERFACE_PLAYER, "SelectSubtitle"))
   {
     DBusError error;
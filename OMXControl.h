@@ -39,6 +39,8 @@ public:
   ~OMXControl();
   int init(OMXClock *m_av_clock, OMXPlayerAudio *m_player_audio, OMXPlayerSubtitles *m_player_subtitles, OMXReader *m_omx_reader, std::string& dbus_name);
   OMXControlResult getEvent();
+  // the file being shown changed, e.g. to the next playlist entry
+  void SetReader(OMXReader *m_omx_reader) { reader = m_omx_reader; };
   void dispatch();
 private:
   int dbus_connect(std::string& dbus_name);
@@ -48,7 +48,7 @@
 static void add_timespecs(struct timespec &time, long millisecs)
 {
    long long nsec = time.tv_nsec + (long long)millisecs * 1000000;
-   while (nsec > 1000000000)
+   while (nsec >= 1000000000)
    {
       time.tv_sec += 1;
       nsec -= 1000000000;
@@ -56,6 +56,19 @@ static void add_timespecs(struct timespec &time, long millisecs)
    time.tv_nsec = nsec;
 }
 
+static OMX_ERRORTYPE SetupTunnel(DllOMX *dll, OMX_HANDLETYPE hOutput, OMX_U32 nPortOutput, OMX_HANDLETYPE hInput, OMX_U32 nPortInput)
+{
+#ifdef TARGET_LINUX
+  // software components are not known to the IL core, tunnel them directly
+  if (OMXALSA_GetSoftComponents() != OMXALSA_SOFT_OFF)
+    return OMXALSA_SetupTunnel(hOutput, nPortOutput, hInput, nPortInput);
+#endif
+  return dll->OMX_SetupTunnel(hOutput, nPortOutput, hInput, nPortInput);
+}
+
+std::atomic<uint64_t> COMXCoreComponent::m_input_bytes_copied(0);
+std::atomic<uint64_t> COMXCoreComponent::m_input_bytes_direct(0);
+
 
 COMXCoreTunel::COMXCoreTunel()
 {
@@ -130,7 +143,7 @@ OMX_ERRORTYPE COMXCoreTunel::Deestablish(bool noWait)
 
   if(m_src_component->GetComponent())
   {
-    omx_err = m_DllOMX->OMX_SetupTunnel(m_src_component->GetComponent(), m_src_port, NULL, 0);
+    omx_err = SetupTunnel(m_DllOMX, m_src_component->GetComponent(), m_src_port, NULL, 0);
     if(omx_err != OMX_ErrorNone)
     {
       CLog::Log(LOGERROR, "COMXCoreTunel::Deestablish - could not unset tunnel on comp src %s port %d omx_err(0x%08x)\n",
@@ -140,7 +153,7 @@ OMX_ERRORTYPE COMXCoreTunel::Deestablish(bool noWait)
 
   if(m_dst_component->GetComponent())
   {
-    omx_err = m_DllOMX->OMX_SetupTunnel(m_dst_component->GetComponent(), m_dst_port, NULL, 0);
+    omx_err = SetupTunnel(m_DllOMX, m_dst_component->GetComponent(), m_dst_port, NULL, 0);
     if(omx_err != OMX_ErrorNone)
     {
       CLog::Log(LOGERROR, "COMXCoreTunel::Deestablish - could not unset tunnel on comp dst %s port %d omx_err(0x%08x)\n",
@@ -219,7 +232,7 @@ OMX_ERRORTYPE COMXCoreTunel::Establish(bool enable_ports /* = true */, bool disa
 
   if(m_src_component->GetComponent() && m_dst_component->GetComponent())
   {
-    omx_err = m_DllOMX->OMX_SetupTunnel(m_src_component->GetComponent(), m_src_port, m_dst_component->GetComponent(), m_dst_port);
+    omx_err = SetupTunnel(m_DllOMX, m_src_component->GetComponent(), m_src_port, m_dst_component->GetComponent(), m_dst_port);
     if(omx_err != OMX_ErrorNone) 
     {
       CLog::Log(LOGERROR, "COMXCoreTunel::Establish - could not setup tunnel src %s port %d dst %s port %d omx_err(0x%08x)\n", 
@@ -312,19 +325,33 @@ COMXCoreComponent::COMXCoreComponent()
 
   m_exit = false;
 
+  m_input_wakeup        = NULL;
+  m_eos_wakeup          = NULL;
+
   m_omx_input_use_buffers  = false;
+  m_omx_input_lend         = false;
   m_omx_output_use_buffers = false;
 
-  m_omx_events.clear();
+  ClearEvents();
+  m_omx_event_sequence = 0;
+  m_omx_event_waiters  = 0;
   m_ignore_error = OMX_ErrorNone;
 
   pthread_mutex_init(&m_omx_input_mutex, NULL);
   pthread_mutex_init(&m_omx_output_mutex, NULL);
   pthread_mutex_init(&m_omx_event_mutex, NULL);
   pthread_mutex_init(&m_omx_eos_mutex, NULL);
-  pthread_cond_init(&m_input_buffer_cond, NULL);
-  pthread_cond_init(&m_output_buffer_cond, NULL);
-  pthread_cond_init(&m_omx_event_cond, NULL);
+  m_input_waiters  = 0;
+  m_output_waiters = 0;
+
+  // waits time out on the monotonic clock, unaffected by wall clock changes
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_input_buffer_cond, &attr);
+  pthread_cond_init(&m_output_buffer_cond, &attr);
+  pthread_cond_init(&m_omx_event_cond, &attr);
+  pthread_condattr_destroy(&attr);
 
   m_DllOMX = DllOMX::GetDllOMX();
 }
@@ -364,8 +391,26 @@ OMX_ERRORTYPE COMXCoreComponent::EmptyThisBuffer(OMX_BUFFERHEADERTYPE *omx_buffe
   if(!m_handle || !omx_buffer)
     return OMX_ErrorUndefined;
 
+  size_t index = (size_t)omx_buffer->pAppPrivate;
+  bool lent = index < m_omx_input_lent.size() && m_omx_input_lent[index].opaque.load(std::memory_order_relaxed);
+  OMX_U32 filled = omx_buffer->nFilledLen;
+
   omx_err = OMX_EmptyThisBuffer(m_handle, omx_buffer);
-  if (omx_err != OMX_ErrorNone)
+  if (omx_err != OMX_ErrorNone && lent)
+  {
+    // the component wants the memory it registered, copy into it from now on
+    CLog::Log(LOGWARNING, "COMXCoreComponent::EmptyThisBuffer component(%s) - refused a lent buffer (0x%x), copying from now on\n",
+        m_componentName.c_str(), omx_err);
+    m_omx_input_lend = false;
+    memcpy(m_omx_input_lent[index].payload + omx_buffer->nOffset, omx_buffer->pBuffer + omx_buffer->nOffset, filled);
+    ReleaseLentBuffer(omx_buffer);
+    lent = false;
+    omx_err = OMX_EmptyThisBuffer(m_handle, omx_buffer);
+  }
+
+  if (omx_err == OMX_ErrorNone)
+    (lent ? m_input_bytes_direct : m_input_bytes_copied).fetch_add(filled, std::memory_order_relaxed);
+  else
   {
     CLog::Log(LOGERROR, "COMXCoreComponent::EmptyThisBuffer component(%s) - failed with result(0x%x)\n", 
         m_componentName.c_str(), omx_err);
@@ -374,6 +419,42 @@ OMX_ERRORTYPE COMXCoreComponent::EmptyThisBuffer(OMX_BUFFERHEADERTYPE *omx_buffe
   return omx_err;
 }
 
+bool COMXCoreComponent::LendInputBuffer(OMX_BUFFERHEADERTYPE *omx_buffer, OMX_U8 *data, OMX_U32 size, void (*release)(void *), void *opaque)
+{
+  if(!omx_buffer || !data || !release || !opaque || !m_omx_input_lend.load(std::memory_order_relaxed))
+    return false;
+
+  size_t index = (size_t)omx_buffer->pAppPrivate;
+  if(index >= m_omx_input_lent.size() || size > omx_buffer->nAllocLen)
+    return false;
+
+  // the firmware transfers from pBuffer, it only has to keep the port alignment
+  if(m_input_alignment > 1 && ((uintptr_t)data % m_input_alignment) != 0)
+    return false;
+
+  omx_lent_buffer &lent = m_omx_input_lent[index];
+  lent.release = release;
+  omx_buffer->pBuffer = data;
+  lent.opaque.store(opaque, std::memory_order_release);
+  return true;
+}
+
+void COMXCoreComponent::ReleaseLentBuffer(OMX_BUFFERHEADERTYPE *buffer)
+{
+  size_t index = (size_t)buffer->pAppPrivate;
+  if(index >= m_omx_input_lent.size())
+    return;
+
+  // the callback and FreeInputBuffers may race here, only one of them gets the data back
+  omx_lent_buffer &lent = m_omx_input_lent[index];
+  void *opaque = lent.opaque.exchange(NULL, std::memory_order_acq_rel);
+  if(!opaque)
+    return;
+
+  buffer->pBuffer = lent.payload;
+  lent.release(opaque);
+}
+
 OMX_ERRORTYPE COMXCoreComponent::FillThisBuffer(OMX_BUFFERHEADERTYPE *omx_buffer)
 {
   OMX_ERRORTYPE omx_err = OMX_ErrorNone;
@@ -462,120 +543,139 @@ void COMXCoreComponent::FlushOutput()
 }
 
 // timeout in milliseconds
-OMX_BUFFERHEADERTYPE *COMXCoreComponent::GetInputBuffer(long timeout /*=200*/)
+OMX_BUFFERHEADERTYPE *COMXCoreComponent::WaitForBuffer(bool input, long timeout)
 {
-  OMX_BUFFERHEADERTYPE *omx_input_buffer = NULL;
+  OMXBufferList &list       = input ? m_omx_input_avaliable : m_omx_output_available;
+  pthread_mutex_t &mutex    = input ? m_omx_input_mutex : m_omx_output_mutex;
+  pthread_cond_t &cond      = input ? m_input_buffer_cond : m_output_buffer_cond;
+  std::atomic<int> &waiters = input ? m_input_waiters : m_output_waiters;
+  const bool &flush         = input ? m_flush_input : m_flush_output;
 
-  if(!m_handle)
+  if (flush || m_resource_error)
     return NULL;
 
-  pthread_mutex_lock(&m_omx_input_mutex);
-  struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
-  add_timespecs(endtime, timeout);
-  while (!m_flush_input)
-  {
-    if (m_resource_error)
-      break;
-    if(!m_omx_input_avaliable.empty())
-    {
-      omx_input_buffer = m_omx_input_avaliable.front();
-      m_omx_input_avaliable.pop();
-      break;
-    }
-
-    int retcode = pthread_cond_timedwait(&m_input_buffer_cond, &m_omx_input_mutex, &endtime);
-    if (retcode != 0) {
-      if (timeout != 0)
-        CLog::Log(LOGERROR, "COMXCoreComponent::GetInputBuffer %s wait event timeout\n", m_componentName.c_str());
-      break;
-    }
-  }
-  pthread_mutex_unlock(&m_omx_input_mutex);
-  return omx_input_buffer;
-}
+  OMX_BUFFERHEADERTYPE *buffer = list.Pop();
+  if (buffer)
+    return buffer;
 
-OMX_BUFFERHEADERTYPE *COMXCoreComponent::GetOutputBuffer(long timeout /*=200*/)
-{
-  OMX_BUFFERHEADERTYPE *omx_output_buffer = NULL;
-  if(!m_handle)
+  list.AddMiss();
+  if (timeout == 0)
     return NULL;
 
-  pthread_mutex_lock(&m_omx_output_mutex);
-  struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
+  struct timespec starttime, endtime;
+  clock_gettime(CLOCK_MONOTONIC, &starttime);
+  endtime = starttime;
   add_timespecs(endtime, timeout);
-  while (!m_flush_output)
+
+  pthread_mutex_lock(&mutex);
+  // pairs with the fence in ReturnBuffer: either we see its buffer or it sees us waiting
+  waiters.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!flush)
   {
     if (m_resource_error)
       break;
-    if(!m_omx_output_available.empty())
-    {
-      omx_output_buffer = m_omx_output_available.front();
-      m_omx_output_available.pop();
+    buffer = list.Pop();
+    if (buffer)
       break;
-    }
 
-    int retcode = pthread_cond_timedwait(&m_output_buffer_cond, &m_omx_output_mutex, &endtime);
+    int retcode = pthread_cond_timedwait(&cond, &mutex, &endtime);
     if (retcode != 0) {
-      if (timeout != 0)
-        CLog::Log(LOGERROR, "COMXCoreComponent::GetOutputBuffer %s wait event timeout\n", m_componentName.c_str());
+      CLog::Log(LOGERROR, "COMXCoreComponent::Get%sBuffer %s wait event timeout\n", input ? "Input" : "Output", m_componentName.c_str());
       break;
     }
   }
-  pthread_mutex_unlock(&m_omx_output_mutex);
+  waiters.fetch_sub(1, std::memory_order_relaxed);
+  pthread_mutex_unlock(&mutex);
 
-  return omx_output_buffer;
-}
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  list.AddWait((now.tv_sec - starttime.tv_sec) * 1000000LL + (now.tv_nsec - starttime.tv_nsec) / 1000);
 
+  return buffer;
+}
 
-OMX_ERRORTYPE COMXCoreComponent::WaitForInputDone(long timeout /*=200*/)
+OMX_ERRORTYPE COMXCoreComponent::WaitForBuffersDone(bool input, long timeout)
 {
+  OMXBufferList &list       = input ? m_omx_input_avaliable : m_omx_output_available;
+  pthread_mutex_t &mutex    = input ? m_omx_input_mutex : m_omx_output_mutex;
+  pthread_cond_t &cond      = input ? m_input_buffer_cond : m_output_buffer_cond;
+  std::atomic<int> &waiters = input ? m_input_waiters : m_output_waiters;
+  const unsigned int &count = input ? m_input_buffer_count : m_output_buffer_count;
   OMX_ERRORTYPE omx_err = OMX_ErrorNone;
 
-  pthread_mutex_lock(&m_omx_input_mutex);
+  if (list.Size() == count)
+    return OMX_ErrorNone;
+
   struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
+  clock_gettime(CLOCK_MONOTONIC, &endtime);
   add_timespecs(endtime, timeout);
-  while (m_input_buffer_count != m_omx_input_avaliable.size())
+
+  pthread_mutex_lock(&mutex);
+  waiters.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (count != list.Size())
   {
     if (m_resource_error)
       break;
-    int retcode = pthread_cond_timedwait(&m_input_buffer_cond, &m_omx_input_mutex, &endtime);
+    int retcode = pthread_cond_timedwait(&cond, &mutex, &endtime);
     if (retcode != 0) {
       if (timeout != 0)
-        CLog::Log(LOGERROR, "COMXCoreComponent::WaitForInputDone %s wait event timeout\n", m_componentName.c_str());
+        CLog::Log(LOGERROR, "COMXCoreComponent::WaitFor%sDone %s wait event timeout\n", input ? "Input" : "Output", m_componentName.c_str());
       omx_err = OMX_ErrorTimeout;
       break;
     }
   }
-  pthread_mutex_unlock(&m_omx_input_mutex);
+  waiters.fetch_sub(1, std::memory_order_relaxed);
+  pthread_mutex_unlock(&mutex);
   return omx_err;
 }
 
+void COMXCoreComponent::ReturnBuffer(bool input, OMX_BUFFERHEADERTYPE *buffer)
+{
+  OMXBufferList &list       = input ? m_omx_input_avaliable : m_omx_output_available;
+  pthread_mutex_t &mutex    = input ? m_omx_input_mutex : m_omx_output_mutex;
+  pthread_cond_t &cond      = input ? m_input_buffer_cond : m_output_buffer_cond;
+  std::atomic<int> &waiters = input ? m_input_waiters : m_output_waiters;
 
-OMX_ERRORTYPE COMXCoreComponent::WaitForOutputDone(long timeout /*=200*/)
+  if (!list.Push(buffer))
+    CLog::Log(LOGERROR, "COMXCoreComponent::ReturnBuffer %s more %s buffers returned than allocated (%p)\n", m_componentName.c_str(), input ? "input" : "output", buffer);
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed) == 0)
+    return;
+
+  // this allows (all) blocked tasks to be awoken
+  pthread_mutex_lock(&mutex);
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+OMX_BUFFERHEADERTYPE *COMXCoreComponent::GetInputBuffer(long timeout /*=200*/)
 {
-  OMX_ERRORTYPE omx_err = OMX_ErrorNone;
+  if(!m_handle)
+    return NULL;
 
-  pthread_mutex_lock(&m_omx_output_mutex);
-  struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
-  add_timespecs(endtime, timeout);
-  while (m_output_buffer_count != m_omx_output_available.size())
-  {
-    if (m_resource_error)
-      break;
-    int retcode = pthread_cond_timedwait(&m_output_buffer_cond, &m_omx_output_mutex, &endtime);
-    if (retcode != 0) {
-      if (timeout != 0)
-        CLog::Log(LOGERROR, "COMXCoreComponent::WaitForOutputDone %s wait event timeout\n", m_componentName.c_str());
-      omx_err = OMX_ErrorTimeout;
-      break;
-    }
-  }
-  pthread_mutex_unlock(&m_omx_output_mutex);
-  return omx_err;
+  return WaitForBuffer(true, timeout);
+}
+
+OMX_BUFFERHEADERTYPE *COMXCoreComponent::GetOutputBuffer(long timeout /*=200*/)
+{
+  if(!m_handle)
+    return NULL;
+
+  return WaitForBuffer(false, timeout);
+}
+
+OMX_ERRORTYPE COMXCoreComponent::WaitForInputDone(long timeout /*=200*/)
+{
+  return WaitForBuffersDone(true, timeout);
+}
+
+
+OMX_ERRORTYPE COMXCoreComponent::WaitForOutputDone(long timeout /*=200*/)
+{
+  return WaitForBuffersDone(false, timeout);
 }
 
 
@@ -584,6 +684,13 @@ OMX_ERRORTYPE COMXCoreComponent::AllocInputBuffers(bool use_buffers /* = false *
   OMX_ERRORTYPE omx_err = OMX_ErrorNone;
 
   m_omx_input_use_buffers = use_buffers; 
+  // Pointing a header registered with OMX_UseBuffer at other memory is outside
+  // the IL spec. Broadcom's IL client transfers from pBuffer on every
+  // EmptyThisBuffer, so only its components are lent to, and EmptyThisBuffer
+  // stops lending to one that refuses a lent buffer.
+  m_omx_input_lend = use_buffers && m_componentName.compare(0, 13, "OMX.broadcom.") == 0;
+  if(use_buffers && !m_omx_input_lend)
+    CLog::Log(LOGDEBUG, "COMXCoreComponent::AllocInputBuffers component(%s) - not a Broadcom component, input is copied\n", m_componentName.c_str());
 
   if(!m_handle)
     return OMX_ErrorUndefined;
@@ -616,6 +723,10 @@ OMX_ERRORTYPE COMXCoreComponent::AllocInputBuffers(bool use_buffers /* = false *
             m_componentName.c_str(), GetInputPort(), portFormat.nBufferCountMin,
             portFormat.nBufferCountActual, portFormat.nBufferSize, portFormat.nBufferAlignment);
 
+  m_omx_input_avaliable.Reset(portFormat.nBufferCountActual);
+  if(m_omx_input_use_buffers)
+    std::vector<omx_lent_buffer>(portFormat.nBufferCountActual).swap(m_omx_input_lent);
+
   for (size_t i = 0; i < portFormat.nBufferCountActual; i++)
   {
     OMX_BUFFERHEADERTYPE *buffer = NULL;
@@ -644,8 +755,14 @@ OMX_ERRORTYPE COMXCoreComponent::AllocInputBuffers(bool use_buffers /* = false *
     buffer->nFilledLen      = 0;
     buffer->nOffset         = 0;
     buffer->pAppPrivate     = (void*)i;  
+    if(m_omx_input_use_buffers)
+    {
+      m_omx_input_lent[i].payload = data;
+      m_omx_input_lent[i].release = NULL;
+      m_omx_input_lent[i].opaque  = NULL;
+    }
     m_omx_input_buffers.push_back(buffer);
-    m_omx_input_avaliable.push(buffer);
+    m_omx_input_avaliable.Push(buffer);
   }
 
   omx_err = WaitForCommand(OMX_CommandPortEnable, m_input_port);
@@ -697,6 +814,8 @@ OMX_ERRORTYPE COMXCoreComponent::AllocOutputBuffers(bool use_buffers /* = false
             m_componentName.c_str(), m_output_port, portFormat.nBufferCountMin,
             portFormat.nBufferCountActual, portFormat.nBufferSize, portFormat.nBufferAlignment);
 
+  m_omx_output_available.Reset(portFormat.nBufferCountActual);
+
   for (size_t i = 0; i < portFormat.nBufferCountActual; i++)
   {
     OMX_BUFFERHEADERTYPE *buffer = NULL;
@@ -726,7 +845,7 @@ OMX_ERRORTYPE COMXCoreComponent::AllocOutputBuffers(bool use_buffers /* = false
     buffer->nOffset          = 0;
     buffer->pAppPrivate      = (void*)i;
     m_omx_output_buffers.push_back(buffer);
-    m_omx_output_available.push(buffer);
+    m_omx_output_available.Push(buffer);
   }
 
   omx_err = WaitForCommand(OMX_CommandPortEnable, m_output_port);
@@ -760,7 +879,8 @@ OMX_ERRORTYPE COMXCoreComponent::FreeInputBuffers()
 
   for (size_t i = 0; i < m_omx_input_buffers.size(); i++)
   {
-    uint8_t *buf = m_omx_input_buffers[i]->pBuffer;
+    ReleaseLentBuffer(m_omx_input_buffers[i]);
+    uint8_t *buf = i < m_omx_input_lent.size() ? m_omx_input_lent[i].payload : m_omx_input_buffers[i]->pBuffer;
 
     omx_err = OMX_FreeBuffer(m_handle, m_input_port, m_omx_input_buffers[i]);
 
@@ -783,12 +903,11 @@ OMX_ERRORTYPE COMXCoreComponent::FreeInputBuffers()
   WaitForInputDone(1000);
 
   pthread_mutex_lock(&m_omx_input_mutex);
-  assert(m_omx_input_buffers.size() == m_omx_input_avaliable.size());
+  assert(m_omx_input_buffers.size() == m_omx_input_avaliable.Size());
 
   m_omx_input_buffers.clear();
-
-  while (!m_omx_input_avaliable.empty())
-    m_omx_input_avaliable.pop();
+  m_omx_input_avaliable.Clear();
+  std::vector<omx_lent_buffer>().swap(m_omx_input_lent);
 
   m_input_alignment     = 0;
   m_input_buffer_size   = 0;
@@ -841,12 +960,10 @@ OMX_ERRORTYPE COMXCoreComponent::FreeOutputBuffers()
   WaitForOutputDone(1000);
 
   pthread_mutex_lock(&m_omx_output_mutex);
-  assert(m_omx_output_buffers.size() == m_omx_output_available.size());
+  assert(m_omx_output_buffers.size() == m_omx_output_available.Size());
 
   m_omx_output_buffers.clear();
-
-  while (!m_omx_output_available.empty())
-    m_omx_output_available.pop();
+  m_omx_output_available.Clear();
 
   m_output_alignment    = 0;
   m_output_buffer_size  = 0;
@@ -910,19 +1027,46 @@ OMX_ERRORTYPE COMXCoreComponent::DisableAllPorts()
   return OMX_ErrorNone;
 }
 
-void COMXCoreComponent::RemoveEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2)
+omx_event *COMXCoreComponent::FirstEvent(OMX_EVENTTYPE eEvent, bool match_data, OMX_U32 nData1, OMX_U32 nData2)
 {
-  for (std::vector<omx_event>::iterator it = m_omx_events.begin(); it != m_omx_events.end(); ) 
-  {
-    omx_event event = *it;
+  std::vector<omx_event> &events = m_omx_events[EventSlot(eEvent)];
 
-    if(event.eEvent == eEvent && event.nData1 == nData1 && event.nData2 == nData2) 
-    {
-      it = m_omx_events.erase(it);
-      continue;
-    }
-    ++it;
+  for (std::vector<omx_event>::iterator it = events.begin(); it != events.end(); it++)
+  {
+    if(it->eEvent == eEvent && (!match_data || (it->nData1 == nData1 && it->nData2 == nData2)))
+      return &(*it);
   }
+
+  return NULL;
+}
+
+void COMXCoreComponent::EraseEvent(omx_event *event)
+{
+  unsigned int slot = EventSlot(event->eEvent);
+  std::vector<omx_event> &events = m_omx_events[slot];
+
+#ifdef OMX_DEBUG_EVENTS
+  CLog::Log(LOGDEBUG, "COMXCoreComponent::EraseEvent %s remove event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
+      m_componentName.c_str(), (int)event->eEvent, (int)event->nData1, (int)event->nData2);
+#endif
+
+  events.erase(events.begin() + (event - &events[0]));
+  if(events.empty())
+    m_omx_events_pending.fetch_and(~(1u << slot), std::memory_order_release);
+}
+
+void COMXCoreComponent::RemoveEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2)
+{
+  omx_event *event;
+  while ((event = FirstEvent(eEvent, true, nData1, nData2)) != NULL)
+    EraseEvent(event);
+}
+
+void COMXCoreComponent::ClearEvents()
+{
+  for (int i = 0; i < OMX_EVENT_SLOTS; i++)
+    m_omx_events[i].clear();
+  m_omx_events_pending = 0;
 }
 
 OMX_ERRORTYPE COMXCoreComponent::AddEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2)
@@ -933,11 +1077,16 @@ OMX_ERRORTYPE COMXCoreComponent::AddEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1,
   event.nData1      = nData1;
   event.nData2      = nData2;
 
+  unsigned int slot = EventSlot(eEvent);
+
   pthread_mutex_lock(&m_omx_event_mutex);
   RemoveEvent(eEvent, nData1, nData2);
-  m_omx_events.push_back(event);
+  event.sequence = m_omx_event_sequence++;
+  m_omx_events[slot].push_back(event);
+  m_omx_events_pending.fetch_or(1u << slot, std::memory_order_release);
   // this allows (all) blocked tasks to be awoken
-  pthread_cond_broadcast(&m_omx_event_cond);
+  if (m_omx_event_waiters)
+    pthread_cond_broadcast(&m_omx_event_cond);
   pthread_mutex_unlock(&m_omx_event_mutex);
 
 #ifdef OMX_DEBUG_EVENTS
@@ -956,54 +1105,42 @@ OMX_ERRORTYPE COMXCoreComponent::WaitForEvent(OMX_EVENTTYPE eventType, long time
       m_componentName.c_str(), (int)eventType);
 #endif
 
+  // polling for an event that has not arrived only costs an atomic load
+  unsigned int wanted = (1u << EventSlot(eventType)) | (1u << EventSlot(OMX_EventError));
+  if (timeout == 0 && !m_resource_error && !(m_omx_events_pending.load(std::memory_order_acquire) & wanted))
+    return OMX_ErrorTimeout;
+
   pthread_mutex_lock(&m_omx_event_mutex);
   struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
+  clock_gettime(CLOCK_MONOTONIC, &endtime);
   add_timespecs(endtime, timeout);
   while(true) 
   {
-    for (std::vector<omx_event>::iterator it = m_omx_events.begin(); it != m_omx_events.end(); it++) 
-    {
-      omx_event event = *it;
-
-#ifdef OMX_DEBUG_EVENTS
-      CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForEvent %s inlist event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
-
-
-      if(event.eEvent == OMX_EventError && event.nData1 == (OMX_U32)OMX_ErrorSameState && event.nData2 == 1)
-      {
-#ifdef OMX_DEBUG_EVENTS
-        CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForEvent %s remove event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
-        return OMX_ErrorNone;
-      }
-      else if(event.eEvent == OMX_EventError) 
-      {
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
-        return (OMX_ERRORTYPE)event.nData1;
-      }
-      else if(event.eEvent == eventType) 
-      {
-#ifdef OMX_DEBUG_EVENTS
-        CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForEvent %s remove event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
+    omx_event *error = FirstEvent(OMX_EventError);
+    omx_event *event = FirstEvent(eventType);
 
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
+    // whichever arrived first is reported
+    if(error && (!event || (int)(error->sequence - event->sequence) < 0))
+    {
+      omx_event found = *error;
+      EraseEvent(error);
+      pthread_mutex_unlock(&m_omx_event_mutex);
+      if(found.nData1 == (OMX_U32)OMX_ErrorSameState && found.nData2 == 1)
         return OMX_ErrorNone;
-      }
+      return (OMX_ERRORTYPE)found.nData1;
+    }
+    else if(event)
+    {
+      EraseEvent(event);
+      pthread_mutex_unlock(&m_omx_event_mutex);
+      return OMX_ErrorNone;
     }
 
     if (m_resource_error)
       break;
+    m_omx_event_waiters++;
     int retcode = pthread_cond_timedwait(&m_omx_event_cond, &m_omx_event_mutex, &endtime);
+    m_omx_event_waiters--;
     if (retcode != 0) 
     {
       if (timeout > 0)
@@ -1027,52 +1164,35 @@ OMX_ERRORTYPE COMXCoreComponent::WaitForCommand(OMX_U32 command, OMX_U32 nData2,
 
   pthread_mutex_lock(&m_omx_event_mutex);
   struct timespec endtime;
-  clock_gettime(CLOCK_REALTIME, &endtime);
+  clock_gettime(CLOCK_MONOTONIC, &endtime);
   add_timespecs(endtime, timeout);
   while(true) 
   {
-    for (std::vector<omx_event>::iterator it = m_omx_events.begin(); it != m_omx_events.end(); it++) 
-    {
-      omx_event event = *it;
-
-#ifdef OMX_DEBUG_EVENTS
-      CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForCommand %s inlist event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
-      if(event.eEvent == OMX_EventError && event.nData1 == (OMX_U32)OMX_ErrorSameState && event.nData2 == 1)
-      {
-#ifdef OMX_DEBUG_EVENTS
-        CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForCommand %s remove event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
+    omx_event *error = FirstEvent(OMX_EventError);
+    omx_event *event = FirstEvent(OMX_EventCmdComplete, true, command, nData2);
 
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
-        return OMX_ErrorNone;
-      } 
-      else if(event.eEvent == OMX_EventError) 
-      {
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
-        return (OMX_ERRORTYPE)event.nData1;
-      } 
-      else if(event.eEvent == OMX_EventCmdComplete && event.nData1 == command && event.nData2 == nData2) 
-      {
-
-#ifdef OMX_DEBUG_EVENTS
-        CLog::Log(LOGDEBUG, "COMXCoreComponent::WaitForCommand %s remove event event.eEvent 0x%08x event.nData1 0x%08x event.nData2 %d\n",
-          m_componentName.c_str(), (int)event.eEvent, (int)event.nData1, (int)event.nData2);
-#endif
-
-        m_omx_events.erase(it);
-        pthread_mutex_unlock(&m_omx_event_mutex);
+    // whichever arrived first is reported
+    if(error && (!event || (int)(error->sequence - event->sequence) < 0))
+    {
+      omx_event found = *error;
+      EraseEvent(error);
+      pthread_mutex_unlock(&m_omx_event_mutex);
+      if(found.nData1 == (OMX_U32)OMX_ErrorSameState && found.nData2 == 1)
         return OMX_ErrorNone;
-      }
+      return (OMX_ERRORTYPE)found.nData1;
+    }
+    else if(event)
+    {
+      EraseEvent(event);
+      pthread_mutex_unlock(&m_omx_event_mutex);
+      return OMX_ErrorNone;
     }
 
     if (m_resource_error)
       break;
+    m_omx_event_waiters++;
     int retcode = pthread_cond_timedwait(&m_omx_event_cond, &m_omx_event_mutex, &endtime);
+    m_omx_event_waiters--;
     if (retcode != 0) {
       CLog::Log(LOGERROR, "COMXCoreComponent::WaitForCommand %s wait timeout event.eEvent 0x%08x event.command 0x%08x event.nData2 %d\n", 
         m_componentName.c_str(), (int)OMX_EventCmdComplete, (int)command, (int)nData2);
@@ -1341,6 +1461,8 @@ if (m_callbacks.FillBufferDone == &COMXCoreComponent::DecoderFillBufferDoneCallb
             CLASSNAME, __func__, m_componentName.c_str(), m_output_port, portFormat.nBufferCountMin,
             portFormat.nBufferCountActual, portFormat.nBufferSize, portFormat.nBufferAlignment);
 
+  m_omx_output_available.Reset(portFormat.nBufferCountActual);
+
   for (size_t i = 0; i < portFormat.nBufferCountActual; i++)
   {
     omx_err = OMX_UseEGLImage(m_handle, ppBufferHdr, nPortIndex, pAppPrivate, eglImage);
@@ -1357,7 +1479,7 @@ if (m_callbacks.FillBufferDone == &COMXCoreComponent::DecoderFillBufferDoneCallb
     buffer->nOffset          = 0;
     buffer->pAppPrivate      = (void*)i;
     m_omx_output_buffers.push_back(buffer);
-    m_omx_output_available.push(buffer);
+    m_omx_output_available.Push(buffer);
   }
 
   omx_err = WaitForCommand(OMX_CommandPortEnable, m_output_port);
@@ -1409,9 +1531,12 @@ bool COMXCoreComponent::Initialize( const std::string &component_name, OMX_INDEX
   m_exit = false;
 
   m_omx_input_use_buffers  = false;
+  m_omx_input_lend         = false;
   m_omx_output_use_buffers = false;
 
-  m_omx_events.clear();
+  pthread_mutex_lock(&m_omx_event_mutex);
+  ClearEvents();
+  pthread_mutex_unlock(&m_omx_event_mutex);
   m_ignore_error = OMX_ErrorNone;
 
   m_componentName = component_name;
@@ -1431,7 +1556,8 @@ bool COMXCoreComponent::Initialize( const std::string &component_name, OMX_INDEX
   if(!m_handle)
   {
 #ifdef TARGET_LINUX
-    if (strncmp("OMX.alsa.", component_name.c_str(), 9) == 0)
+    if (strncmp("OMX.alsa.", component_name.c_str(), 9) == 0 ||
+        OMXALSA_GetSoftComponents() != OMXALSA_SOFT_OFF)
       omx_err = OMXALSA_GetHandle(&m_handle, (char*) component_name.c_str(), this, &m_callbacks);
     else
 #endif
@@ -1509,10 +1635,16 @@ bool COMXCoreComponent::Deinitialize()
 
     TransitionToStateLoaded();
 
-    CLog::Log(LOGDEBUG, "COMXCoreComponent::Deinitialize : %s handle %p\n",
-        m_componentName.c_str(), m_handle);
+    OMXBufferListStats in, out;
+    m_omx_input_avaliable.GetStats(in);
+    m_omx_output_available.GetStats(out);
+    CLog::Log(LOGDEBUG, "COMXCoreComponent::Deinitialize : %s handle %p - input buffers contended %u empty %u waits %u (%.1f ms), output buffers contended %u empty %u waits %u (%.1f ms)\n",
+        m_componentName.c_str(), m_handle,
+        in.contended, in.empty, in.waits, in.wait_us / 1000.0,
+        out.contended, out.empty, out.waits, out.wait_us / 1000.0);
 #ifdef TARGET_LINUX
-    if (strncmp("OMX.alsa.", m_componentName.c_str(), 9) == 0)
+    if (strncmp("OMX.alsa.", m_componentName.c_str(), 9) == 0 ||
+        OMXALSA_GetSoftComponents() != OMXALSA_SOFT_OFF)
       omx_err = OMXALSA_FreeHandle(m_handle);
     else
 #endif
@@ -1582,15 +1714,13 @@ OMX_ERRORTYPE COMXCoreComponent::DecoderEmptyBufferDone(OMX_HANDLETYPE hComponen
     return OMX_ErrorNone;
 
   #if defined(OMX_DEBUG_EVENTHANDLER)
-  CLog::Log(LOGDEBUG, "COMXCoreComponent::DecoderEmptyBufferDone component(%s) %p %d/%d\n", m_componentName.c_str(), pBuffer, m_omx_input_avaliable.size(), m_input_buffer_count);
+  CLog::Log(LOGDEBUG, "COMXCoreComponent::DecoderEmptyBufferDone component(%s) %p %d/%d\n", m_componentName.c_str(), pBuffer, m_omx_input_avaliable.Size(), m_input_buffer_count);
   #endif
-  pthread_mutex_lock(&m_omx_input_mutex);
-  m_omx_input_avaliable.push(pBuffer);
+  ReleaseLentBuffer(pBuffer);
+  ReturnBuffer(true, pBuffer);
 
-  // this allows (all) blocked tasks to be awoken
-  pthread_cond_broadcast(&m_input_buffer_cond);
-
-  pthread_mutex_unlock(&m_omx_input_mutex);
+  if(m_input_wakeup)
+    m_input_wakeup->Signal();
 
   return OMX_ErrorNone;
 }
@@ -1601,15 +1731,9 @@ OMX_ERRORTYPE COMXCoreComponent::DecoderFillBufferDone(OMX_HANDLETYPE hComponent
     return OMX_ErrorNone;
 
   #if defined(OMX_DEBUG_EVENTHANDLER)
-  CLog::Log(LOGDEBUG, "COMXCoreComponent::DecoderFillBufferDone component(%s) %p %d/%d\n", m_componentName.c_str(), pBuffer, m_omx_output_available.size(), m_output_buffer_count);
+  CLog::Log(LOGDEBUG, "COMXCoreComponent::DecoderFillBufferDone component(%s) %p %d/%d\n", m_componentName.c_str(), pBuffer, m_omx_output_available.Size(), m_output_buffer_count);
   #endif
-  pthread_mutex_lock(&m_omx_output_mutex);
-  m_omx_output_available.push(pBuffer);
-
-  // this allows (all) blocked tasks to be awoken
-  pthread_cond_broadcast(&m_output_buffer_cond);
-
-  pthread_mutex_unlock(&m_omx_output_mutex);
+  ReturnBuffer(false, pBuffer);
 
   return OMX_ErrorNone;
 }
@@ -1719,6 +1843,8 @@ OMX_ERRORTYPE COMXCoreComponent::DecoderEventHandler(
         pthread_mutex_lock(&m_omx_eos_mutex);
         m_eos = true;
         pthread_mutex_unlock(&m_omx_eos_mutex);
+        if(m_eos_wakeup)
+          m_eos_wakeup->Signal();
       }
     break;
     case OMX_EventPortSettingsChanged:
@@ -1800,6 +1926,12 @@ COMXCore::~COMXCore()
 
 bool COMXCore::Initialize()
 {
+#ifdef TARGET_LINUX
+  // software components do not need the VideoCore IL library
+  if (OMXALSA_GetSoftComponents() != OMXALSA_SOFT_OFF)
+    return true;
+#endif
+
   if(!m_DllOMX->Load())
     return false;
 
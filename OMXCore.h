@@ -22,7 +22,7 @@
 #if defined(HAVE_OMXLIB)
 
 #include <string>
-#include <queue>
+#include <atomic>
 
 // TODO: should this be in configure
 #ifndef OMX_SKIP64BIT
@@ -30,6 +30,8 @@
 #endif
 
 #include "DllOMX.h"
+#include "OMXWakeup.h"
+#include "OMXBufferList.h"
 
 #include <semaphore.h>
 
@@ -50,10 +52,14 @@
 
 #define OMX_MAX_PORTS 10
 
+// event types below this get their own mailbox slot, the rest share the last one
+#define OMX_EVENT_SLOTS 16
+
 typedef struct omx_event {
   OMX_EVENTTYPE eEvent;
   OMX_U32 nData1;
   OMX_U32 nData2;
+  unsigned int sequence; // arrival order across slots
 } omx_event;
 
 class COMXCore;
@@ -93,6 +99,7 @@ public:
 
   OMX_ERRORTYPE DisableAllPorts();
   void          RemoveEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2);
+  void          ClearEvents();
   OMX_ERRORTYPE AddEvent(OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2);
   OMX_ERRORTYPE WaitForEvent(OMX_EVENTTYPE event, long timeout = 300);
   OMX_ERRORTYPE WaitForCommand(OMX_U32 command, OMX_U32 nData2, long timeout = 2000);
@@ -131,13 +138,21 @@ public:
 
   OMX_ERRORTYPE EmptyThisBuffer(OMX_BUFFERHEADERTYPE *omx_buffer);
   OMX_ERRORTYPE FillThisBuffer(OMX_BUFFERHEADERTYPE *omx_buffer);
+  // points an input buffer at caller owned data instead of copying into it, only possible
+  // when the port was set up with use_buffers. release(opaque) runs once the buffer is back
+  bool LendInputBuffer(OMX_BUFFERHEADERTYPE *omx_buffer, OMX_U8 *data, OMX_U32 size, void (*release)(void *), void *opaque);
   OMX_ERRORTYPE FreeOutputBuffer(OMX_BUFFERHEADERTYPE *omx_buffer);
 
   unsigned int GetInputBufferSize() const { return m_input_buffer_count * m_input_buffer_size; }
   unsigned int GetOutputBufferSize() const { return m_output_buffer_count * m_output_buffer_size; }
 
-  unsigned int GetInputBufferSpace() const { return m_omx_input_avaliable.size() * m_input_buffer_size; }
-  unsigned int GetOutputBufferSpace() const { return m_omx_output_available.size() * m_output_buffer_size; }
+  unsigned int GetInputBufferSpace() const { return m_omx_input_avaliable.Size() * m_input_buffer_size; }
+  unsigned int GetOutputBufferSpace() const { return m_omx_output_available.Size() * m_output_buffer_size; }
+  void GetInputBufferStats(OMXBufferListStats &stats) const { m_omx_input_avaliable.GetStats(stats); }
+  void GetOutputBufferStats(OMXBufferListStats &stats) const { m_omx_output_available.GetStats(stats); }
+  // bytes submitted to input ports across all components, copied in or lent by pointer
+  static uint64_t GetInputBytesCopied() { return m_input_bytes_copied.load(std::memory_order_relaxed); }
+  static uint64_t GetInputBytesDirect() { return m_input_bytes_direct.load(std::memory_order_relaxed); }
 
   void FlushAll();
   void FlushInput();
@@ -159,31 +174,62 @@ public:
   bool BadState() const { return m_resource_error; }
   void ResetEos();
   void IgnoreNextError(OMX_S32 error) { m_ignore_error = error; }
+  // signalled when an input buffer comes back and when end of stream is reached
+  void SetInputWakeup(OMXWakeup *wakeup) { m_input_wakeup = wakeup; }
+  void SetEOSWakeup(OMXWakeup *wakeup) { m_eos_wakeup = wakeup; }
 
 private:
+  static unsigned int EventSlot(OMX_EVENTTYPE eEvent) { return (unsigned int)eEvent < OMX_EVENT_SLOTS - 1 ? (unsigned int)eEvent : OMX_EVENT_SLOTS - 1; }
+  omx_event    *FirstEvent(OMX_EVENTTYPE eEvent, bool match_data = false, OMX_U32 nData1 = 0, OMX_U32 nData2 = 0);
+  void          EraseEvent(omx_event *event);
+  // lock-free on the fast path, only a get that finds the list empty takes the mutex to sleep
+  OMX_BUFFERHEADERTYPE *WaitForBuffer(bool input, long timeout);
+  OMX_ERRORTYPE WaitForBuffersDone(bool input, long timeout);
+  void          ReturnBuffer(bool input, OMX_BUFFERHEADERTYPE *buffer);
+  void          ReleaseLentBuffer(OMX_BUFFERHEADERTYPE *buffer);
+
+  struct omx_lent_buffer
+  {
+    OMX_U8             *payload; // the data registered with OMX_UseBuffer
+    void              (*release)(void *);
+    std::atomic<void *> opaque;  // set while the buffer points at lent data
+  };
+
   OMX_HANDLETYPE m_handle;
   unsigned int   m_input_port;
   unsigned int   m_output_port;
   std::string    m_componentName;
   pthread_mutex_t   m_omx_event_mutex;
   pthread_mutex_t   m_omx_eos_mutex;
-  std::vector<omx_event> m_omx_events;
+  // pending events by type, each slot in arrival order
+  std::vector<omx_event> m_omx_events[OMX_EVENT_SLOTS];
+  // bit per non-empty slot, lets a poll for an event skip the mutex
+  std::atomic<unsigned int> m_omx_events_pending;
+  unsigned int  m_omx_event_sequence;
+  int           m_omx_event_waiters;
   OMX_S32 m_ignore_error;
 
   OMX_CALLBACKTYPE  m_callbacks;
 
-  // OMXCore input buffers (demuxer packets)
+  // OMXCore input buffers (demuxer packets), the mutex only guards sleeping on an empty list
   pthread_mutex_t   m_omx_input_mutex;
-  std::queue<OMX_BUFFERHEADERTYPE*> m_omx_input_avaliable;
+  OMXBufferList     m_omx_input_avaliable;
+  std::atomic<int>  m_input_waiters;
   std::vector<OMX_BUFFERHEADERTYPE*> m_omx_input_buffers;
   unsigned int  m_input_alignment;
   unsigned int  m_input_buffer_size;
   unsigned int  m_input_buffer_count;
   bool          m_omx_input_use_buffers;
+  // LendInputBuffer may repoint headers, see AllocInputBuffers
+  std::atomic<bool> m_omx_input_lend;
+  std::vector<omx_lent_buffer> m_omx_input_lent;
+  static std::atomic<uint64_t> m_input_bytes_copied;
+  static std::atomic<uint64_t> m_input_bytes_direct;
 
   // OMXCore output buffers (video frames)
   pthread_mutex_t   m_omx_output_mutex;
-  std::queue<OMX_BUFFERHEADERTYPE*> m_omx_output_available;
+  OMXBufferList     m_omx_output_available;
+  std::atomic<int>  m_output_waiters;
   std::vector<OMX_BUFFERHEADERTYPE*> m_omx_output_buffers;
   unsigned int  m_output_alignment;
   unsigned int  m_output_buffer_size;
@@ -199,6 +245,8 @@ private:
   bool          m_flush_input;
   bool          m_flush_output;
   bool          m_resource_error;
+  OMXWakeup     *m_input_wakeup;
+  OMXWakeup     *m_eos_wakeup;
 };
 
 class COMXCore
@@ -0,0 +1,184 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXPacketPool.h"
+#include "OMXReader.h"
+
+#include <stdlib.h>
+
+OMXPacketPool &OMXPacketPool::Get()
+{
+  static OMXPacketPool pool;
+  return pool;
+}
+
+OMXPacketPool::OMXPacketPool()
+{
+  m_hits    = 0;
+  m_misses  = 0;
+
+  pthread_mutex_init(&m_header_lock, NULL);
+  for(int i = 0; i < OMX_PACKET_POOL_CLASSES; i++)
+    pthread_mutex_init(&m_data_lock[i], NULL);
+}
+
+OMXPacketPool::~OMXPacketPool()
+{
+  Clear();
+
+  pthread_mutex_destroy(&m_header_lock);
+  for(int i = 0; i < OMX_PACKET_POOL_CLASSES; i++)
+    pthread_mutex_destroy(&m_data_lock[i]);
+}
+
+int OMXPacketPool::SizeClass(unsigned int size)
+{
+  for(int i = 0; i < OMX_PACKET_POOL_CLASSES; i++)
+  {
+    if(size <= (1u << (OMX_PACKET_POOL_MIN_SHIFT + i)))
+      return i;
+  }
+  return -1;
+}
+
+OMXPacket *OMXPacketPool::AllocHeader()
+{
+  OMXPacket *pkt = NULL;
+
+  pthread_mutex_lock(&m_header_lock);
+  if(!m_headers.empty())
+  {
+    pkt = m_headers.back();
+    m_headers.pop_back();
+  }
+  pthread_mutex_unlock(&m_header_lock);
+
+  if(pkt)
+  {
+    m_hits++;
+    return pkt;
+  }
+
+  m_misses++;
+  return (OMXPacket *)malloc(sizeof(OMXPacket));
+}
+
+void OMXPacketPool::FreeHeader(OMXPacket *pkt)
+{
+  if(!pkt)
+    return;
+
+  pthread_mutex_lock(&m_header_lock);
+  if(m_headers.size() < OMX_PACKET_POOL_MAX_HEADERS)
+  {
+    m_headers.push_back(pkt);
+    pkt = NULL;
+  }
+  pthread_mutex_unlock(&m_header_lock);
+
+  if(pkt)
+    free(pkt);
+}
+
+uint8_t *OMXPacketPool::AllocData(unsigned int size, unsigned int *capacity)
+{
+  uint8_t *data = NULL;
+  int cls = SizeClass(size);
+
+  // too big to be pooled, these are rare enough to go to the heap
+  if(cls < 0)
+  {
+    m_misses++;
+    *capacity = size;
+    return (uint8_t *)malloc(size);
+  }
+
+  pthread_mutex_lock(&m_data_lock[cls]);
+  if(!m_data[cls].empty())
+  {
+    data = m_data[cls].back();
+    m_data[cls].pop_back();
+  }
+  pthread_mutex_unlock(&m_data_lock[cls]);
+
+  *capacity = 1u << (OMX_PACKET_POOL_MIN_SHIFT + cls);
+
+  if(data)
+  {
+    m_hits++;
+    return data;
+  }
+
+  m_misses++;
+  return (uint8_t *)malloc(*capacity);
+}
+
+void OMXPacketPool::FreeData(uint8_t *data, unsigned int capacity)
+{
+  if(!data)
+    return;
+
+  int cls = SizeClass(capacity);
+  if(cls < 0 || capacity != (1u << (OMX_PACKET_POOL_MIN_SHIFT + cls)))
+  {
+    free(data);
+    return;
+  }
+
+  unsigned int max_free = OMX_PACKET_POOL_CLASS_BYTES / capacity;
+  if(max_free < OMX_PACKET_POOL_MIN_FREE)
+    max_free = OMX_PACKET_POOL_MIN_FREE;
+
+  pthread_mutex_lock(&m_data_lock[cls]);
+  if(m_data[cls].size() < max_free)
+  {
+    m_data[cls].push_back(data);
+    data = NULL;
+  }
+  pthread_mutex_unlock(&m_data_lock[cls]);
+
+  if(data)
+    free(data);
+}
+
+void OMXPacketPool::Clear()
+{
+  pthread_mutex_lock(&m_header_lock);
+  for(size_t i = 0; i < m_headers.size(); i++)
+    free(m_headers[i]);
+  m_headers.clear();
+  pthread_mutex_unlock(&m_header_lock);
+
+  for(int cls = 0; cls < OMX_PACKET_POOL_CLASSES; cls++)
+  {
+    pthread_mutex_lock(&m_data_lock[cls]);
+    for(size_t i = 0; i < m_data[cls].size(); i++)
+      free(m_data[cls][i]);
+    m_data[cls].clear();
+    pthread_mutex_unlock(&m_data_lock[cls]);
+  }
+}
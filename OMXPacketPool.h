@@ -0,0 +1,70 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_PACKETPOOL_H_
+#define _OMX_PACKETPOOL_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+#include <atomic>
+
+// payload slabs are power of two sized, from 1 KiB up to 4 MiB
+#define OMX_PACKET_POOL_MIN_SHIFT   10
+#define OMX_PACKET_POOL_CLASSES     13
+
+// upper bound for the memory kept on each free list
+#define OMX_PACKET_POOL_CLASS_BYTES (8 * 1024 * 1024)
+#define OMX_PACKET_POOL_MIN_FREE    4
+#define OMX_PACKET_POOL_MAX_HEADERS 1024
+
+struct OMXPacket;
+
+class OMXPacketPool
+{
+public:
+  static OMXPacketPool &Get();
+
+  OMXPacket *AllocHeader();
+  void FreeHeader(OMXPacket *pkt);
+  // returns a slab of at least size bytes, capacity receives the real size
+  uint8_t *AllocData(unsigned int size, unsigned int *capacity);
+  void FreeData(uint8_t *data, unsigned int capacity);
+
+  void Clear();
+  unsigned int GetHits() { return m_hits; };
+  unsigned int GetMisses() { return m_misses; };
+private:
+  OMXPacketPool();
+  ~OMXPacketPool();
+  OMXPacketPool(const OMXPacketPool&) = delete;
+  OMXPacketPool& operator=(const OMXPacketPool&) = delete;
+
+  static int SizeClass(unsigned int size);
+
+  pthread_mutex_t               m_header_lock;
+  std::vector<OMXPacket *>      m_headers;
+  pthread_mutex_t               m_data_lock[OMX_PACKET_POOL_CLASSES];
+  std::vector<uint8_t *>        m_data[OMX_PACKET_POOL_CLASSES];
+  std::atomic<unsigned int>     m_hits;
+  std::atomic<unsigned int>     m_misses;
+};
+#endif
@@ -0,0 +1,130 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXPacketQueue.h"
+
+#define OMX_PACKET_QUEUE_MASK   (OMX_PACKET_QUEUE_SLOTS - 1)
+
+static inline int64_t PacketDuration(OMXPacket *pkt)
+{
+  double duration = OMXPacketDuration(pkt);
+  return duration > 0 ? (int64_t)duration : 0;
+}
+
+OMXPacketQueue::OMXPacketQueue()
+{
+  m_head            = 0;
+  m_tail            = 0;
+  m_cached_size     = 0;
+  m_cached_duration = 0;
+  m_waiting         = false;
+  m_abort           = false;
+  m_pop_wakeup      = NULL;
+
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_cond, NULL);
+}
+
+OMXPacketQueue::~OMXPacketQueue()
+{
+  OMXPacket *pkt;
+  while(Pop(&pkt))
+    OMXPacketFree(pkt);
+
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+bool OMXPacketQueue::Push(OMXPacket *pkt)
+{
+  unsigned int tail = m_tail.load(std::memory_order_relaxed);
+  unsigned int used = tail - m_head.load(std::memory_order_acquire);
+
+  if(used >= (pkt ? OMX_PACKET_QUEUE_SLOTS - 1 : OMX_PACKET_QUEUE_SLOTS))
+    return false;
+
+  m_slots[tail & OMX_PACKET_QUEUE_MASK] = pkt;
+  if(pkt)
+  {
+    m_cached_size.fetch_add(OMXPacketSize(pkt), std::memory_order_relaxed);
+    m_cached_duration.fetch_add(PacketDuration(pkt), std::memory_order_relaxed);
+  }
+
+  // pairs with the consumer publishing m_waiting before it checks the ring again
+  m_tail.store(tail + 1, std::memory_order_seq_cst);
+  if(m_waiting.load(std::memory_order_seq_cst))
+  {
+    pthread_mutex_lock(&m_lock);
+    pthread_cond_signal(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+  }
+
+  return true;
+}
+
+bool OMXPacketQueue::Pop(OMXPacket **pkt)
+{
+  unsigned int head = m_head.load(std::memory_order_relaxed);
+
+  if(head == m_tail.load(std::memory_order_acquire))
+    return false;
+
+  *pkt = m_slots[head & OMX_PACKET_QUEUE_MASK];
+  if(*pkt)
+  {
+    m_cached_size.fetch_sub(OMXPacketSize(*pkt), std::memory_order_relaxed);
+    m_cached_duration.fetch_sub(PacketDuration(*pkt), std::memory_order_relaxed);
+  }
+
+  m_head.store(head + 1, std::memory_order_release);
+  if(m_pop_wakeup)
+    m_pop_wakeup->Signal();
+  return true;
+}
+
+bool OMXPacketQueue::Wait()
+{
+  if(!Empty() || m_abort)
+    return !Empty();
+
+  pthread_mutex_lock(&m_lock);
+  m_waiting.store(true, std::memory_order_seq_cst);
+  while(m_head.load(std::memory_order_seq_cst) == m_tail.load(std::memory_order_seq_cst) && !m_abort)
+    pthread_cond_wait(&m_cond, &m_lock);
+  m_waiting.store(false, std::memory_order_relaxed);
+  pthread_mutex_unlock(&m_lock);
+
+  return !Empty();
+}
+
+void OMXPacketQueue::SetAbort(bool abort)
+{
+  pthread_mutex_lock(&m_lock);
+  m_abort = abort;
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+}
@@ -0,0 +1,79 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_PACKETQUEUE_H_
+#define _OMX_PACKETQUEUE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "OMXWakeup.h"
+
+// ring slots, must be a power of two; one is kept free for the end of stream marker
+#define OMX_PACKET_QUEUE_SLOTS  8192
+
+struct OMXPacket;
+
+// what the queue needs to know about a packet, OMXReader.cpp defines these
+// so the queue does not depend on the demuxer headers
+int OMXPacketSize(const OMXPacket *pkt);
+double OMXPacketDuration(const OMXPacket *pkt);
+void OMXPacketFree(OMXPacket *pkt);
+
+// Bounded single producer / single consumer packet ring between the main
+// loop and a player thread. Handing over a packet costs a few atomic
+// operations; the mutex is only touched when the consumer runs dry.
+// A NULL packet is queued as end of stream marker.
+class OMXPacketQueue
+{
+public:
+  OMXPacketQueue();
+  ~OMXPacketQueue();
+  // producer side, fails when the ring is full
+  bool Push(OMXPacket *pkt);
+  // consumer side, only one thread at a time may pop
+  bool Pop(OMXPacket **pkt);
+  // blocks the consumer until a packet is queued or the queue is aborted
+  bool Wait();
+  void SetAbort(bool abort);
+  // signalled whenever the consumer frees a slot
+  void SetPopWakeup(OMXWakeup *wakeup) { m_pop_wakeup = wakeup; };
+  bool Empty() { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); };
+  unsigned int GetCachedSize() { return m_cached_size.load(std::memory_order_relaxed); };
+  // summed packet durations in DVD_TIME_BASE
+  double GetCachedDuration() { return (double)m_cached_duration.load(std::memory_order_relaxed); };
+private:
+  OMXPacketQueue(const OMXPacketQueue&) = delete;
+  OMXPacketQueue& operator=(const OMXPacketQueue&) = delete;
+
+  OMXPacket                   *m_slots[OMX_PACKET_QUEUE_SLOTS];
+  std::atomic<unsigned int>   m_head;
+  std::atomic<unsigned int>   m_tail;
+  std::atomic<unsigned int>   m_cached_size;
+  std::atomic<int64_t>        m_cached_duration;
+  std::atomic<bool>           m_waiting;
+  std::atomic<bool>           m_abort;
+  OMXWakeup                   *m_pop_wakeup;
+  pthread_mutex_t             m_lock;
+  pthread_cond_t              m_cond;
+};
+#endif
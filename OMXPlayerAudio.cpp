@@ -39,19 +39,19 @@ OMXPlayerAudio::OMXPlayerAudio()
   m_pStream       = NULL;
   m_av_clock      = NULL;
   m_omx_reader    = NULL;
+  m_next_reader   = NULL;
   m_decoder       = NULL;
   m_flush         = false;
   m_flush_requested = false;
-  m_cached_size   = 0;
+  m_eos_wakeup    = NULL;
   m_pAudioCodec   = NULL;
   m_player_error  = true;
   m_CurrentVolume = 0.0f;
   m_amplification = 0;
   m_mute          = false;
+  m_start_pts     = DVD_NOPTS_VALUE;
 
-  pthread_cond_init(&m_packet_cond, NULL);
   pthread_cond_init(&m_audio_cond, NULL);
-  pthread_mutex_init(&m_lock, NULL);
   pthread_mutex_init(&m_lock_decoder, NULL);
 }
 
@@ -60,23 +60,9 @@ OMXPlayerAudio::~OMXPlayerAudio()
   Close();
 
   pthread_cond_destroy(&m_audio_cond);
-  pthread_cond_destroy(&m_packet_cond);
-  pthread_mutex_destroy(&m_lock);
   pthread_mutex_destroy(&m_lock_decoder);
 }
 
-void OMXPlayerAudio::Lock()
-{
-  if(m_config.use_thread)
-    pthread_mutex_lock(&m_lock);
-}
-
-void OMXPlayerAudio::UnLock()
-{
-  if(m_config.use_thread)
-    pthread_mutex_unlock(&m_lock);
-}
-
 void OMXPlayerAudio::LockDecoder()
 {
   if(m_config.use_thread)
@@ -102,13 +88,16 @@ bool OMXPlayerAudio::Open(OMXClock *av_clock, const OMXAudioConfig &config, OMXR
   m_config      = config;
   m_av_clock    = av_clock;
   m_omx_reader  = omx_reader;
+  m_next_reader = NULL;
   m_passthrough = false;
   m_hw_decode   = false;
   m_iCurrentPts = DVD_NOPTS_VALUE;
+  m_start_pts   = DVD_NOPTS_VALUE;
   m_bAbort      = false;
+  m_packets.SetAbort(false);
   m_flush       = false;
   m_flush_requested = false;
-  m_cached_size = 0;
+  m_hints_id    = 0;
   m_pAudioCodec = NULL;
 
   m_player_error = OpenAudioCodec();
@@ -141,9 +130,7 @@ bool OMXPlayerAudio::Close()
 
   if(ThreadHandle())
   {
-    Lock();
-    pthread_cond_broadcast(&m_packet_cond);
-    UnLock();
+    m_packets.SetAbort(true);
 
     StopThread();
   }
@@ -173,45 +160,71 @@ bool OMXPlayerAudio::Decode(OMXPacket *pkt)
   if(!m_decoder || !m_pAudioCodec)
     return true;
 
+  if(pkt->discontinuity)
+  {
+    OMXReader *reader = m_next_reader.exchange(NULL);
+    if(reader)
+      m_omx_reader = reader;
+  }
+
   if(!m_omx_reader->IsActive(OMXSTREAM_AUDIO, pkt->stream_index))
     return true; 
 
-  int channels = pkt->hints.channels;
+  /* the stream parameters only need comparing when the reader saw them change */
+  if(pkt->hints_id != m_hints_id)
+  {
+    COMXStreamInfo hints;
+    if(!m_omx_reader->GetPacketHints(pkt->hints_id, hints))
+      hints = m_config.hints;
 
-  unsigned int old_bitrate = m_config.hints.bitrate;
-  unsigned int new_bitrate = pkt->hints.bitrate;
+    m_hints_id = pkt->hints_id;
 
-  /* only check bitrate changes on AV_CODEC_ID_DTS, AV_CODEC_ID_AC3, AV_CODEC_ID_EAC3 */
-  if(m_config.hints.codec != AV_CODEC_ID_DTS && m_config.hints.codec != AV_CODEC_ID_AC3 && m_config.hints.codec != AV_CODEC_ID_EAC3)
-  {
-    new_bitrate = old_bitrate = 0;
-  }
+    int channels = hints.channels;
 
-  // for passthrough we only care about the codec and the samplerate
-  bool minor_change = channels                 != m_config.hints.channels ||
-                      pkt->hints.bitspersample != m_config.hints.bitspersample ||
-                      old_bitrate              != new_bitrate;
+    unsigned int old_bitrate = m_config.hints.bitrate;
+    unsigned int new_bitrate = hints.bitrate;
 
-  if(pkt->hints.codec          != m_config.hints.codec ||
-     pkt->hints.samplerate     != m_config.hints.samplerate ||
-     (!m_passthrough && minor_change))
-  {
-    printf("C : %d %d %d %d %d\n", m_config.hints.codec, m_config.hints.channels, m_config.hints.samplerate, m_config.hints.bitrate, m_config.hints.bitspersample);
-    printf("N : %d %d %d %d %d\n", pkt->hints.codec, channels, pkt->hints.samplerate, pkt->hints.bitrate, pkt->hints.bitspersample);
+    /* only check bitrate changes on AV_CODEC_ID_DTS, AV_CODEC_ID_AC3, AV_CODEC_ID_EAC3 */
+    if(m_config.hints.codec != AV_CODEC_ID_DTS && m_config.hints.codec != AV_CODEC_ID_AC3 && m_config.hints.codec != AV_CODEC_ID_EAC3)
+    {
+      new_bitrate = old_bitrate = 0;
+    }
 
+    // for passthrough we only care about the codec and the samplerate
+    bool minor_change = channels                 != m_config.hints.channels ||
+                        hints.bitspersample      != m_config.hints.bitspersample ||
+                        old_bitrate              != new_bitrate;
 
-    CloseDecoder();
-    CloseAudioCodec();
+    if(hints.codec          != m_config.hints.codec ||
+       hints.samplerate     != m_config.hints.samplerate ||
+       (!m_passthrough && minor_change))
+    {
+      printf("C : %d %d %d %d %d\n", m_config.hints.codec, m_config.hints.channels, m_config.hints.samplerate, m_config.hints.bitrate, m_config.hints.bitspersample);
+      printf("N : %d %d %d %d %d\n", hints.codec, channels, hints.samplerate, hints.bitrate, hints.bitspersample);
 
-    m_config.hints = pkt->hints;
 
-    m_player_error = OpenAudioCodec();
-    if(!m_player_error)
-      return false;
+      CloseDecoder();
+      CloseAudioCodec();
 
-    m_player_error = OpenDecoder();
-    if(!m_player_error)
-      return false;
+      m_config.hints = hints;
+
+      m_player_error = OpenAudioCodec();
+      if(!m_player_error)
+        return false;
+
+      m_player_error = OpenDecoder();
+      if(!m_player_error)
+        return false;
+    }
+  }
+
+  // after an accurate seek the audio starts where the picture does
+  if(m_start_pts != DVD_NOPTS_VALUE && pkt->pts != DVD_NOPTS_VALUE)
+  {
+    double end = pkt->pts + (pkt->duration != DVD_NOPTS_VALUE ? pkt->duration : 0);
+    if(end <= m_start_pts || (pkt->duration == DVD_NOPTS_VALUE && pkt->pts < m_start_pts))
+      return true;
+    m_start_pts = DVD_NOPTS_VALUE;
   }
 
   CLog::Log(LOGINFO, "CDVDPlayerAudio::Decode dts:%.0f pts:%.0f size:%d", pkt->dts, pkt->pts, pkt->size);
@@ -245,11 +258,8 @@ bool OMXPlayerAudio::Decode(OMXPacket *pkt)
       if(decoded_size <=0)
         continue;
 
-      while((int) m_decoder->GetSpace() < decoded_size)
-      {
-        OMXClock::OMXSleep(10);
-        if(m_flush_requested) return true;
-      }
+      if(!WaitForSpace(decoded_size))
+        return true;
 
       int ret = 0;
 
@@ -262,64 +272,58 @@ bool OMXPlayerAudio::Decode(OMXPacket *pkt)
   }
   else
   {
-    while((int) m_decoder->GetSpace() < pkt->size)
-    {
-      OMXClock::OMXSleep(10);
-      if(m_flush_requested) return true;
-    }
+    if(!WaitForSpace(pkt->size))
+      return true;
 
-    m_decoder->AddPackets(pkt->data, pkt->size, pkt->dts, pkt->pts, 0);
+    m_decoder->AddPackets(pkt->data, pkt->size, pkt->dts, pkt->pts, 0, pkt->buf);
   }
 
   return true;
 }
 
+bool OMXPlayerAudio::WaitForSpace(unsigned int size)
+{
+  while(true)
+  {
+    // the decoder signals every returned input buffer, Flush signals too
+    unsigned int sequence = m_space_wakeup.Sequence();
+    if(m_decoder->GetSpace() >= size)
+      return true;
+    if(m_flush_requested)
+      return false;
+    m_space_wakeup.Wait(sequence, 100);
+  }
+}
+
 void OMXPlayerAudio::Process()
 {
   OMXPacket *omx_pkt = NULL;
 
   while(true)
   {
-    Lock();
-    if(!(m_bStop || m_bAbort) && m_packets.empty())
-      pthread_cond_wait(&m_packet_cond, &m_lock);
+    // only blocks when the queue ran dry, the handover itself takes no lock
+    m_packets.Wait();
 
     if (m_bStop || m_bAbort)
-    {
-      UnLock();
       break;
-    }
 
-    if(m_flush && omx_pkt)
+    // packets are popped under the decoder lock so Flush can drain the queue,
+    // anything still held from before a flush is stale
+    LockDecoder();
+    if(m_flush)
     {
       OMXReader::FreePacket(omx_pkt);
       omx_pkt = NULL;
       m_flush = false;
     }
-    else if(!omx_pkt && !m_packets.empty())
-    {
-      omx_pkt = m_packets.front();
-      if (omx_pkt)
-      {
-        m_cached_size -= omx_pkt->size;
-      }
-      else
-      {
-        assert(m_cached_size == 0);
-        SubmitEOSInternal();
-      }
-      m_packets.pop_front();
-    }
-    UnLock();
-    
-    LockDecoder();
-    if(m_flush && omx_pkt)
+
+    if(!omx_pkt && m_packets.Pop(&omx_pkt) && !omx_pkt)
     {
-      OMXReader::FreePacket(omx_pkt);
-      omx_pkt = NULL;
-      m_flush = false;
+      assert(m_packets.GetCachedSize() == 0);
+      SubmitEOSInternal();
     }
-    else if(omx_pkt && Decode(omx_pkt))
+
+    if(omx_pkt && Decode(omx_pkt))
     {
       OMXReader::FreePacket(omx_pkt);
       omx_pkt = NULL;
@@ -334,24 +338,31 @@ void OMXPlayerAudio::Process()
 void OMXPlayerAudio::Flush()
 {
   m_flush_requested = true;
-  Lock();
+  m_space_wakeup.Signal();
   LockDecoder();
   if(m_pAudioCodec)
     m_pAudioCodec->Reset();
   m_flush_requested = false;
   m_flush = true;
-  while (!m_packets.empty())
-  {
-    OMXPacket *pkt = m_packets.front(); 
-    m_packets.pop_front();
+  OMXPacket *pkt;
+  while (m_packets.Pop(&pkt))
     OMXReader::FreePacket(pkt);
-  }
+  // whatever comes after a flush is read by the new reader
+  OMXReader *reader = m_next_reader.exchange(NULL);
+  if(reader)
+    m_omx_reader = reader;
   m_iCurrentPts = DVD_NOPTS_VALUE;
-  m_cached_size = 0;
+  m_start_pts = DVD_NOPTS_VALUE;
   if(m_decoder)
     m_decoder->Flush();
   UnLockDecoder();
-  UnLock();
+}
+
+void OMXPlayerAudio::SetStartPts(double pts)
+{
+  LockDecoder();
+  m_start_pts = pts;
+  UnLockDecoder();
 }
 
 bool OMXPlayerAudio::AddPacket(OMXPacket *pkt)
@@ -364,15 +375,8 @@ bool OMXPlayerAudio::AddPacket(OMXPacket *pkt)
   if(m_bStop || m_bAbort)
     return ret;
 
-  if((m_cached_size + pkt->size) < m_config.queue_size * 1024 * 1024)
-  {
-    Lock();
-    m_cached_size += pkt->size;
-    m_packets.push_back(pkt);
-    UnLock();
-    ret = true;
-    pthread_cond_broadcast(&m_packet_cond);
-  }
+  if((m_packets.GetCachedSize() + pkt->size) < m_config.queue_size * 1024 * 1024)
+    ret = m_packets.Push(pkt);
 
   return ret;
 }
@@ -462,6 +466,7 @@ bool OMXPlayerAudio::OpenDecoder()
   m_decoder->SetVolume(m_CurrentVolume);
   m_decoder->SetMute(m_mute);
   m_decoder->SetDynamicRangeCompression(m_amplification);
+  m_decoder->SetWakeups(&m_space_wakeup, m_eos_wakeup);
 
   return true;
 }
@@ -500,10 +505,7 @@ double OMXPlayerAudio::GetCacheTotal()
 
 void OMXPlayerAudio::SubmitEOS()
 {
-  Lock();
-  m_packets.push_back(nullptr);
-  UnLock();
-  pthread_cond_broadcast(&m_packet_cond);
+  m_packets.Push(nullptr);
 }
 
 void OMXPlayerAudio::SubmitEOSInternal()
@@ -514,6 +516,6 @@ void OMXPlayerAudio::SubmitEOSInternal()
 
 bool OMXPlayerAudio::IsEOS()
 {
-  return m_packets.empty() && (!m_decoder || m_decoder->IsEOS());
+  return m_packets.Empty() && (!m_decoder || m_decoder->IsEOS());
 }
 
@@ -34,8 +34,9 @@
 #include "OMXAudio.h"
 #include "OMXAudioCodecOMX.h"
 #include "OMXThread.h"
+#include "OMXPacketQueue.h"
+#include "OMXWakeup.h"
 
-#include <deque>
 #include <string>
 #include <atomic>
 #include <sys/types.h>
@@ -47,19 +48,21 @@ class OMXPlayerAudio : public OMXThread
 protected:
   AVStream                  *m_pStream;
   int                       m_stream_id;
-  std::deque<OMXPacket *>   m_packets;
+  OMXPacketQueue            m_packets;
+  OMXWakeup                 m_space_wakeup;
+  OMXWakeup                 *m_eos_wakeup;
   DllAvUtil                 m_dllAvUtil;
   DllAvCodec                m_dllAvCodec;
   DllAvFormat               m_dllAvFormat;
   bool                      m_open;
   COMXStreamInfo            m_hints;
   double                    m_iCurrentPts;
-  pthread_cond_t            m_packet_cond;
+  double                    m_start_pts;
   pthread_cond_t            m_audio_cond;
-  pthread_mutex_t           m_lock;
   pthread_mutex_t           m_lock_decoder;
   OMXClock                  *m_av_clock;
   OMXReader                 *m_omx_reader;
+  std::atomic<OMXReader *>  m_next_reader;
   COMXAudio                 *m_decoder;
   std::string               m_codec_name;
   std::string               m_device;
@@ -69,16 +72,14 @@ protected:
   bool                      m_bAbort;
   bool                      m_flush;
   std::atomic<bool>         m_flush_requested;
-  unsigned int              m_cached_size;
   OMXAudioConfig            m_config;
+  unsigned int              m_hints_id;
   COMXAudioCodecOMX         *m_pAudioCodec;
   float                     m_CurrentVolume;
   long                      m_amplification;
   bool                      m_mute;
   bool   m_player_error;
 
-  void Lock();
-  void UnLock();
   void LockDecoder();
   void UnLockDecoder();
 private:
@@ -88,8 +89,15 @@ public:
   bool Open(OMXClock *av_clock, const OMXAudioConfig &config, OMXReader *omx_reader);
   bool Close();
   bool Decode(OMXPacket *pkt);
+  bool WaitForSpace(unsigned int size);
   void Process();
   void Flush();
+  // packets ending before pts are dropped, until the next flush
+  void SetStartPts(double pts);
+  // packets from the packet flagged as a discontinuity on belong to reader
+  void SetReader(OMXReader *reader) { m_next_reader = reader; };
+  // the previous reader is still in use until the switch
+  bool IsSwitchingReader() { return m_next_reader != NULL; };
   bool AddPacket(OMXPacket *pkt);
   bool OpenAudioCodec();
   void CloseAudioCodec();      
@@ -100,12 +108,16 @@ public:
   double GetCacheTime();
   double GetCacheTotal();
   double GetCurrentPTS() { return m_iCurrentPts; };
+  // signalled when a queued packet is taken or the decoder reaches end of stream,
+  // set before Open
+  void SetWakeup(OMXWakeup *wakeup) { m_eos_wakeup = wakeup; m_packets.SetPopWakeup(wakeup); };
   void SubmitEOS();
   void SubmitEOSInternal();
   bool IsEOS();
-  unsigned int GetCached() { return m_cached_size; };
+  unsigned int GetCached() { return m_packets.GetCachedSize(); };
+  double GetCachedDuration() { return m_packets.GetCachedDuration(); };
   unsigned int GetMaxCached() { return m_config.queue_size * 1024 * 1024; };
-  unsigned int GetLevel() { return m_config.queue_size ? 100.0f * m_cached_size / (m_config.queue_size * 1024.0f * 1024.0f) : 0; };
+  unsigned int GetLevel() { return m_config.queue_size ? 100.0f * m_packets.GetCachedSize() / (m_config.queue_size * 1024.0f * 1024.0f) : 0; };
   void SetVolume(float fVolume)                          { m_CurrentVolume = fVolume; if(m_decoder) m_decoder->SetVolume(fVolume); }
   float GetVolume()                                      { return m_CurrentVolume; }
   void SetMute(bool bOnOff)                              { m_mute = bOnOff; if(m_decoder) m_decoder->SetMute(bOnOff); }
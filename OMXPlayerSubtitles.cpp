@@ -545,7 +545,9 @@ vector<string> OMXPlayerSubtitles::GetTextLines(OMXPacket *pkt)
 {
   assert(pkt);
 
-  m_subtitle_codec.Open(pkt->hints);
+  COMXStreamInfo hints;
+  hints.codec = pkt->codec_id;
+  m_subtitle_codec.Open(hints);
 
   auto result = m_subtitle_codec.Decode(pkt->data, pkt->size, 0, 0);
   assert(result == OC_OVERLAY);
@@ -580,9 +582,9 @@ bool OMXPlayerSubtitles::AddPacket(OMXPacket *pkt, size_t stream_index) BOOST_NO
     OMXReader::FreePacket(pkt);
   };
 
-  if(pkt->hints.codec != AV_CODEC_ID_SUBRIP && 
-     pkt->hints.codec != AV_CODEC_ID_SSA &&
-     pkt->hints.codec != AV_CODEC_ID_ASS)
+  if(pkt->codec_id != AV_CODEC_ID_SUBRIP && 
+     pkt->codec_id != AV_CODEC_ID_SSA &&
+     pkt->codec_id != AV_CODEC_ID_ASS)
   {
     return true;
   }
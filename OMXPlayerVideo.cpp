@@ -33,6 +33,10 @@
 
 #include "linux/XMemUtils.h"
 
+// a late packet that no other picture references is dropped once it is a frame behind,
+// this far behind everything up to the next keyframe goes
+#define DROP_GOP_LATE DVD_MSEC_TO_TIME(500)
+
 OMXPlayerVideo::OMXPlayerVideo()
 {
   m_open          = false;
@@ -43,13 +47,21 @@ OMXPlayerVideo::OMXPlayerVideo()
   m_fps           = 25.0f;
   m_flush         = false;
   m_flush_requested = false;
-  m_cached_size   = 0;
+  m_eos_wakeup    = NULL;
   m_iVideoDelay   = 0;
   m_iCurrentPts   = 0;
+  m_start_pts     = DVD_NOPTS_VALUE;
+  m_skip_to_keyframe = false;
+  for(int i = 0; i < VIDEO_DROP_REASONS; i++)
+    m_dropped[i] = 0;
+  m_format_change_time   = 0;
+  m_format_change_port   = 0;
+  m_format_latency_count = 0;
+  m_format_latency_total = 0;
+  m_format_latency_max   = 0;
+  m_param_sets_dropped   = 0;
 
-  pthread_cond_init(&m_packet_cond, NULL);
   pthread_cond_init(&m_picture_cond, NULL);
-  pthread_mutex_init(&m_lock, NULL);
   pthread_mutex_init(&m_lock_decoder, NULL);
 }
 
@@ -57,24 +69,10 @@ OMXPlayerVideo::~OMXPlayerVideo()
 {
   Close();
 
-  pthread_cond_destroy(&m_packet_cond);
   pthread_cond_destroy(&m_picture_cond);
-  pthread_mutex_destroy(&m_lock);
   pthread_mutex_destroy(&m_lock_decoder);
 }
 
-void OMXPlayerVideo::Lock()
-{
-  if(m_config.use_thread)
-    pthread_mutex_lock(&m_lock);
-}
-
-void OMXPlayerVideo::UnLock()
-{
-  if(m_config.use_thread)
-    pthread_mutex_unlock(&m_lock);
-}
-
 void OMXPlayerVideo::LockDecoder()
 {
   if(m_config.use_thread)
@@ -103,9 +101,20 @@ bool OMXPlayerVideo::Open(OMXClock *av_clock, const OMXVideoConfig &config)
   m_frametime   = 0;
   m_iCurrentPts = DVD_NOPTS_VALUE;
   m_bAbort      = false;
+  m_packets.SetAbort(false);
   m_flush       = false;
-  m_cached_size = 0;
   m_iVideoDelay = 0;
+  m_start_pts   = DVD_NOPTS_VALUE;
+  m_skip_to_keyframe = false;
+  for(int i = 0; i < VIDEO_DROP_REASONS; i++)
+    m_dropped[i] = 0;
+  m_format_change_time   = 0;
+  m_format_change_port   = 0;
+  m_format_latency_count = 0;
+  m_format_latency_total = 0;
+  m_format_latency_max   = 0;
+  m_param_sets_dropped   = 0;
+  m_param_sets.ResetParamSets(NULL, 0);
 
   if(!OpenDecoder())
   {
@@ -133,9 +142,9 @@ bool OMXPlayerVideo::Reset()
   m_iCurrentPts       = DVD_NOPTS_VALUE;
   m_frametime         = 0;
   m_bAbort            = false;
+  m_packets.SetAbort(false);
   m_flush             = false;
   m_flush_requested   = false;
-  m_cached_size       = 0;
   m_iVideoDelay       = 0;
 
   // Keep consistency with old Close/Open logic by continuing to return a bool
@@ -153,9 +162,7 @@ bool OMXPlayerVideo::Close()
 
   if(ThreadHandle())
   {
-    Lock();
-    pthread_cond_broadcast(&m_packet_cond);
-    UnLock();
+    m_packets.SetAbort(true);
 
     StopThread();
   }
@@ -211,63 +218,162 @@ bool OMXPlayerVideo::Decode(OMXPacket *pkt)
   if(pts != DVD_NOPTS_VALUE)
     m_iCurrentPts = pts;
 
-  while((int) m_decoder->GetFreeSpace() < pkt->size)
+  if(pkt->discontinuity)
+    m_decoder->SetDiscontinuity();
+
+  // the reader has parsed the slice headers, frame_type is known once it found a picture
+  if(m_config.hints.codec == AV_CODEC_ID_H264)
   {
-    OMXClock::OMXSleep(10);
-    if(m_flush_requested) return true;
+    TrackFormatChange(pkt);
+    if(pkt->param_sets && !StripParamSets(pkt))
+      return true;
+    if(pkt->frame_type != OMX_FRAME_UNKNOWN && DropLate(pkt, pts != DVD_NOPTS_VALUE ? pts : dts))
+      return true;
   }
 
+  if(!WaitForSpace(pkt->size))
+    return true;
+
   CLog::Log(LOGINFO, "CDVDPlayerVideo::Decode dts:%.0f pts:%.0f cur:%.0f, size:%d", pkt->dts, pkt->pts, m_iCurrentPts, pkt->size);
-  m_decoder->Decode(pkt->data, pkt->size, dts, pts);
+  m_decoder->Decode(pkt->data, pkt->size, dts, pts, pkt->buf);
+
+  // the target has been reached, as in the decoder
+  if(m_start_pts != DVD_NOPTS_VALUE && pts != DVD_NOPTS_VALUE && pts >= m_start_pts)
+    m_start_pts = DVD_NOPTS_VALUE;
+
+  if(m_format_change_time && m_decoder->GetPortSettingsCount() != m_format_change_port)
+  {
+    int64_t latency = m_av_clock->GetAbsoluteClock() - m_format_change_time;
+    m_format_latency_count++;
+    m_format_latency_total += latency;
+    if(latency > m_format_latency_max)
+      m_format_latency_max = latency;
+    m_format_change_time = 0;
+  }
   return true;
 }
 
+void OMXPlayerVideo::TrackFormatChange(OMXPacket *pkt)
+{
+  if(!pkt->format_changed)
+    return;
+
+  // the latency runs from the first of several changes the decoder may take in one go
+  if(!m_format_change_time)
+  {
+    m_format_change_time = m_av_clock->GetAbsoluteClock();
+    m_format_change_port = m_decoder->GetPortSettingsCount();
+  }
+}
+
+bool OMXPlayerVideo::StripParamSets(OMXPacket *pkt)
+{
+  // the decoder parses every SPS and PPS again, the ones it has until a flush can go
+  if(pkt->format_changed)
+    m_param_sets.ResetParamSets(NULL, 0);
+
+  // a demuxer buffer someone else holds a reference to is left as it is
+  if(pkt->buf && !av_buffer_is_writable(pkt->buf))
+    return true;
+
+  const uint8_t *extradata = (const uint8_t *)m_config.hints.extradata;
+  int length_size = 0;
+  if(extradata && m_config.hints.extrasize >= 7 && extradata[0] == 1)
+    length_size = (extradata[4] & 3) + 1;
+
+  int kept, dropped;
+  pkt->size = m_param_sets.StripParamSets(pkt->data, pkt->size, length_size, &kept, &dropped);
+  m_param_sets_dropped += dropped;
+  // with only repeats gone the picture may be dropped like any other
+  pkt->param_sets = kept > 0;
+  return pkt->size > 0;
+}
+
+bool OMXPlayerVideo::DropLate(OMXPacket *pkt, double pts)
+{
+  // parameter sets are needed by the pictures that follow
+  if(pkt->param_sets)
+    return false;
+
+  // ahead of an accurate seek target the decoder needs every picture as reference,
+  // however late the clock started at the target makes them look
+  if(m_start_pts != DVD_NOPTS_VALUE && pts != DVD_NOPTS_VALUE && pts < m_start_pts)
+    return false;
+
+  // keyframes are the ones the reader indexes and hops to
+  if(m_skip_to_keyframe)
+  {
+    if(!pkt->keyframe)
+    {
+      m_dropped[VIDEO_DROP_GOP]++;
+      return true;
+    }
+    m_skip_to_keyframe = false;
+  }
+
+  // lateness only means something while the clock runs at normal speed
+  if(pts == DVD_NOPTS_VALUE || m_av_clock->OMXIsPaused() || m_av_clock->OMXPlaySpeed() != DVD_PLAYSPEED_NORMAL)
+    return false;
+
+  double late = m_av_clock->OMXMediaTime() - pts;
+  if(late > DROP_GOP_LATE && !pkt->keyframe)
+  {
+    CLog::Log(LOGINFO, "OMXPlayerVideo::DropLate %.0fms behind, skipping to the next keyframe", late / 1000.0);
+    m_skip_to_keyframe = true;
+    m_dropped[VIDEO_DROP_GOP]++;
+    return true;
+  }
+  if(late > m_frametime && !pkt->reference)
+  {
+    m_dropped[VIDEO_DROP_NONREF]++;
+    return true;
+  }
+  return false;
+}
+
+bool OMXPlayerVideo::WaitForSpace(unsigned int size)
+{
+  while(true)
+  {
+    // the decoder signals every returned input buffer, Flush signals too
+    unsigned int sequence = m_space_wakeup.Sequence();
+    if(m_decoder->GetFreeSpace() >= size)
+      return true;
+    if(m_flush_requested)
+      return false;
+    m_space_wakeup.Wait(sequence, 100);
+  }
+}
+
 void OMXPlayerVideo::Process()
 {
   OMXPacket *omx_pkt = NULL;
 
   while(true)
   {
-    Lock();
-    if(!(m_bStop || m_bAbort) && m_packets.empty())
-      pthread_cond_wait(&m_packet_cond, &m_lock);
+    // only blocks when the queue ran dry, the handover itself takes no lock
+    m_packets.Wait();
 
     if (m_bStop || m_bAbort)
-    {
-      UnLock();
       break;
-    }
 
-    if(m_flush && omx_pkt)
+    // packets are popped under the decoder lock so Flush can drain the queue,
+    // anything still held from before a flush is stale
+    LockDecoder();
+    if(m_flush)
     {
       OMXReader::FreePacket(omx_pkt);
       omx_pkt = NULL;
       m_flush = false;
     }
-    else if(!omx_pkt && !m_packets.empty())
-    {
-      omx_pkt = m_packets.front();
-      if (omx_pkt)
-      {
-        m_cached_size -= omx_pkt->size;
-      }
-      else
-      {
-        assert(m_cached_size == 0);
-        SubmitEOSInternal();
-      }
-      m_packets.pop_front();
-    }
-    UnLock();
 
-    LockDecoder();
-    if(m_flush && omx_pkt)
+    if(!omx_pkt && m_packets.Pop(&omx_pkt) && !omx_pkt)
     {
-      OMXReader::FreePacket(omx_pkt);
-      omx_pkt = NULL;
-      m_flush = false;
+      assert(m_packets.GetCachedSize() == 0);
+      SubmitEOSInternal();
     }
-    else if(omx_pkt && Decode(omx_pkt))
+
+    if(omx_pkt && Decode(omx_pkt))
     {
       OMXReader::FreePacket(omx_pkt);
       omx_pkt = NULL;
@@ -282,22 +388,30 @@ void OMXPlayerVideo::Process()
 void OMXPlayerVideo::Flush()
 {
   m_flush_requested = true;
-  Lock();
+  m_space_wakeup.Signal();
   LockDecoder();
   m_flush_requested = false;
   m_flush = true;
-  while (!m_packets.empty())
-  {
-    OMXPacket *pkt = m_packets.front(); 
-    m_packets.pop_front();
+  OMXPacket *pkt;
+  while (m_packets.Pop(&pkt))
     OMXReader::FreePacket(pkt);
-  }
   m_iCurrentPts = DVD_NOPTS_VALUE;
-  m_cached_size = 0;
+  m_start_pts = DVD_NOPTS_VALUE;
+  m_skip_to_keyframe = false;
+  m_format_change_time = 0;
+  m_param_sets.ResetParamSets(NULL, 0);
   if(m_decoder)
     m_decoder->Reset();
   UnLockDecoder();
-  UnLock();
+}
+
+void OMXPlayerVideo::SetStartPts(double pts)
+{
+  LockDecoder();
+  m_start_pts = pts;
+  if(m_decoder)
+    m_decoder->SetStartPts(pts);
+  UnLockDecoder();
 }
 
 bool OMXPlayerVideo::AddPacket(OMXPacket *pkt)
@@ -310,15 +424,8 @@ bool OMXPlayerVideo::AddPacket(OMXPacket *pkt)
   if(m_bStop || m_bAbort)
     return ret;
 
-  if((m_cached_size + pkt->size) < m_config.queue_size * 1024 * 1024)
-  {
-    Lock();
-    m_cached_size += pkt->size;
-    m_packets.push_back(pkt);
-    UnLock();
-    ret = true;
-    pthread_cond_broadcast(&m_packet_cond);
-  }
+  if((m_packets.GetCachedSize() + pkt->size) < m_config.queue_size * 1024 * 1024)
+    ret = m_packets.Push(pkt);
 
   return ret;
 }
@@ -339,6 +446,8 @@ bool OMXPlayerVideo::OpenDecoder()
 
   m_frametime = (double)DVD_TIME_BASE / m_fps;
 
+  m_format_change_time = 0;
+
   m_decoder = new COMXVideo();
   if(!m_decoder->Open(m_av_clock, m_config))
   {
@@ -351,6 +460,8 @@ bool OMXPlayerVideo::OpenDecoder()
         m_decoder->GetDecoderName().c_str() , m_config.hints.width, m_config.hints.height, m_config.hints.profile, m_fps);
   }
 
+  m_decoder->SetWakeups(&m_space_wakeup, m_eos_wakeup);
+
   return true;
 }
 
@@ -380,10 +491,7 @@ int  OMXPlayerVideo::GetDecoderFreeSpace()
 
 void OMXPlayerVideo::SubmitEOS()
 {
-  Lock();
-  m_packets.push_back(nullptr);
-  UnLock();
-  pthread_cond_broadcast(&m_packet_cond);
+  m_packets.Push(nullptr);
 }
 
 void OMXPlayerVideo::SubmitEOSInternal()
@@ -396,6 +504,6 @@ bool OMXPlayerVideo::IsEOS()
 {
   if(!m_decoder)
     return false;
-  return m_packets.empty() && (!m_decoder || m_decoder->IsEOS());
+  return m_packets.Empty() && (!m_decoder || m_decoder->IsEOS());
 }
 
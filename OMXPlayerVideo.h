@@ -31,8 +31,10 @@
 #include "OMXStreamInfo.h"
 #include "OMXVideo.h"
 #include "OMXThread.h"
+#include "OMXPacketQueue.h"
+#include "OMXWakeup.h"
+#include "BitstreamConverter.h"
 
-#include <deque>
 #include <sys/types.h>
 
 #include <string>
@@ -40,20 +42,30 @@
 
 using namespace std;
 
+// why pictures were dropped before reaching the decoder
+enum EVideoDropReason
+{
+  VIDEO_DROP_NONREF = 0, // late and not referenced by other pictures
+  VIDEO_DROP_GOP,        // far behind, skipping to the next keyframe
+  VIDEO_DROP_REASONS
+};
+
 class OMXPlayerVideo : public OMXThread
 {
 protected:
   AVStream                  *m_pStream;
   int                       m_stream_id;
-  std::deque<OMXPacket *>   m_packets;
+  OMXPacketQueue            m_packets;
+  OMXWakeup                 m_space_wakeup;
+  OMXWakeup                 *m_eos_wakeup;
   DllAvUtil                 m_dllAvUtil;
   DllAvCodec                m_dllAvCodec;
   DllAvFormat               m_dllAvFormat;
   bool                      m_open;
   double                    m_iCurrentPts;
-  pthread_cond_t            m_packet_cond;
+  // pictures before it only feed the decoder's references, see SetStartPts
+  double                    m_start_pts;
   pthread_cond_t            m_picture_cond;
-  pthread_mutex_t           m_lock;
   pthread_mutex_t           m_lock_decoder;
   OMXClock                  *m_av_clock;
   COMXVideo                 *m_decoder;
@@ -63,12 +75,23 @@ protected:
   bool                      m_bAbort;
   bool                      m_flush;
   std::atomic<bool>         m_flush_requested;
-  unsigned int              m_cached_size;
   double                    m_iVideoDelay;
   OMXVideoConfig            m_config;
+  bool                      m_skip_to_keyframe;
+  std::atomic<unsigned int> m_dropped[VIDEO_DROP_REASONS];
+  // a format change seen in the stream and not yet reported by the decoder
+  int64_t                   m_format_change_time;
+  unsigned int              m_format_change_port;
+  std::atomic<unsigned int> m_format_latency_count;
+  std::atomic<int64_t>      m_format_latency_total;
+  std::atomic<int64_t>      m_format_latency_max;
+  // in-band SPS and PPS the decoder was given since the last flush
+  CBitstreamConverter       m_param_sets;
+  std::atomic<unsigned int> m_param_sets_dropped;
 
-  void Lock();
-  void UnLock();
+  void TrackFormatChange(OMXPacket *pkt);
+  bool StripParamSets(OMXPacket *pkt);
+  bool DropLate(OMXPacket *pkt, double pts);
   void LockDecoder();
   void UnLockDecoder();
 private:
@@ -79,8 +102,11 @@ public:
   bool Close();
   bool Reset();
   bool Decode(OMXPacket *pkt);
+  bool WaitForSpace(unsigned int size);
   void Process();
   void Flush();
+  // pictures before pts are decoded but not shown, until the next flush
+  void SetStartPts(double pts);
   bool AddPacket(OMXPacket *pkt);
   bool OpenDecoder();
   bool CloseDecoder();
@@ -88,9 +114,20 @@ public:
   int  GetDecoderFreeSpace();
   double GetCurrentPTS() { return m_iCurrentPts; };
   double GetFPS() { return m_fps; };
-  unsigned int GetCached() { return m_cached_size; };
+  unsigned int GetDropped(EVideoDropReason reason) { return m_dropped[reason]; };
+  // from spotting a format change in the stream to the decoder reporting it, in us
+  unsigned int GetFormatLatencyCount() { return m_format_latency_count; };
+  double GetFormatLatencyAvg() { return m_format_latency_count ? (double)m_format_latency_total / m_format_latency_count : 0.0; };
+  double GetFormatLatencyMax() { return m_format_latency_max; };
+  // repeated SPS and PPS kept from the decoder
+  unsigned int GetParamSetsDropped() { return m_param_sets_dropped; };
+  unsigned int GetCached() { return m_packets.GetCachedSize(); };
+  double GetCachedDuration() { return m_packets.GetCachedDuration(); };
   unsigned int GetMaxCached() { return m_config.queue_size * 1024 * 1024; };
-  unsigned int GetLevel() { return m_config.queue_size ? 100.0f * m_cached_size / (m_config.queue_size * 1024.0f * 1024.0f) : 0; };
+  unsigned int GetLevel() { return m_config.queue_size ? 100.0f * m_packets.GetCachedSize() / (m_config.queue_size * 1024.0f * 1024.0f) : 0; };
+  // signalled when a queued packet is taken or the decoder reaches end of stream,
+  // set before Open
+  void SetWakeup(OMXWakeup *wakeup) { m_eos_wakeup = wakeup; m_packets.SetPopWakeup(wakeup); };
   void SubmitEOS();
   void SubmitEOSInternal();
   bool IsEOS();
@@ -0,0 +1,173 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXPlaylist.h"
+
+#include <stdio.h>
+#include <fstream>
+
+#include "utils/log.h"
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+OMXPlaylist::OMXPlaylist()
+{
+  m_next        = 0;
+  m_wrap        = false;
+  m_reader      = NULL;
+  m_opened      = false;
+  m_open_time   = 0;
+  m_dump_format = false;
+  m_live        = false;
+  m_timeout     = 0.0f;
+}
+
+OMXPlaylist::~OMXPlaylist()
+{
+  Abort();
+}
+
+bool OMXPlaylist::Load(const std::string &path)
+{
+  std::ifstream file(path.c_str());
+  if(!file)
+    return false;
+
+  std::string line;
+  while(std::getline(file, line))
+  {
+    size_t start = line.find_first_not_of(" \t\r");
+    if(start == std::string::npos || line[start] == '#')
+      continue;
+    size_t end = line.find_last_not_of(" \t\r");
+    m_entries.push_back(line.substr(start, end - start + 1));
+  }
+
+  return !m_entries.empty();
+}
+
+void OMXPlaylist::SetOpenOptions(bool dump_format, bool live, float timeout, const std::string &cookie,
+                                 const std::string &user_agent, const std::string &lavfdopts, const std::string &avdict)
+{
+  m_dump_format = dump_format;
+  m_live        = live;
+  m_timeout     = timeout;
+  m_cookie      = cookie;
+  m_user_agent  = user_agent;
+  m_lavfdopts   = lavfdopts;
+  m_avdict      = avdict;
+}
+
+std::string OMXPlaylist::First()
+{
+  if(m_entries.empty())
+    return "";
+
+  m_next = 1;
+  if(m_next == m_entries.size() && m_wrap)
+    m_next = 0;
+
+  return m_entries[0];
+}
+
+bool OMXPlaylist::HasNext()
+{
+  return m_next < m_entries.size();
+}
+
+bool OMXPlaylist::Preopen(OMXReader *reader)
+{
+  if(!reader || m_reader || !HasNext())
+    return false;
+
+  m_reader  = reader;
+  m_opened  = false;
+  m_filename.clear();
+
+  Create();
+
+  return true;
+}
+
+void OMXPlaylist::Process()
+{
+  int64_t start = CurrentHostCounter();
+
+  // entries that fail to open are skipped, each one is tried once
+  for(unsigned int tries = 0; tries < m_entries.size() && HasNext() && !m_bStop; tries++)
+  {
+    std::string filename = m_entries[m_next];
+
+    m_next++;
+    if(m_next == m_entries.size() && m_wrap)
+      m_next = 0;
+
+    if(m_reader->Open(filename, m_dump_format, m_live, m_timeout, m_cookie, m_user_agent, m_lavfdopts, m_avdict))
+    {
+      m_filename  = filename;
+      m_opened    = true;
+      break;
+    }
+
+    CLog::Log(LOGERROR, "OMXPlaylist::Process - skipping %s, it could not be opened", filename.c_str());
+  }
+
+  m_open_time = CurrentHostCounter() - start;
+}
+
+OMXReader *OMXPlaylist::Take(std::string &filename)
+{
+  if(!m_reader)
+    return NULL;
+
+  StopThread();
+
+  OMXReader *reader = m_opened ? m_reader : NULL;
+  filename  = m_filename;
+  m_reader  = NULL;
+  m_opened  = false;
+
+  return reader;
+}
+
+void OMXPlaylist::Abort()
+{
+  if(!m_reader)
+    return;
+
+  StopThread();
+
+  if(m_opened)
+    m_reader->Close();
+  m_reader  = NULL;
+  m_opened  = false;
+}
@@ -0,0 +1,78 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_PLAYLIST_H_
+#define _OMX_PLAYLIST_H_
+
+#include "OMXReader.h"
+#include "OMXThread.h"
+
+#include <string>
+#include <vector>
+
+// Files played back to back. While one plays, the entry after it is opened
+// and probed into a spare reader on a thread of its own, so switching to it
+// does not wait for the demuxer.
+class OMXPlaylist : public OMXThread
+{
+protected:
+  std::vector<std::string>  m_entries;
+  unsigned int              m_next;
+  bool                      m_wrap;
+  OMXReader                 *m_reader;
+  std::string               m_filename;
+  bool                      m_opened;
+  int64_t                   m_open_time;
+
+  // passed on to OMXReader::Open
+  bool                      m_dump_format;
+  bool                      m_live;
+  float                     m_timeout;
+  std::string               m_cookie;
+  std::string               m_user_agent;
+  std::string               m_lavfdopts;
+  std::string               m_avdict;
+public:
+  OMXPlaylist();
+  ~OMXPlaylist();
+  // one file or URL per line, blank lines and lines starting with # are skipped
+  bool Load(const std::string &path);
+  void Add(const std::string &filename) { m_entries.push_back(filename); };
+  unsigned int Size() { return m_entries.size(); };
+  // start over with the first entry after the last one
+  void SetWrap(bool wrap) { m_wrap = wrap; };
+  void SetOpenOptions(bool dump_format, bool live, float timeout, const std::string &cookie,
+                      const std::string &user_agent, const std::string &lavfdopts, const std::string &avdict);
+  // the entry playback starts with, the one after it is the next to preopen
+  std::string First();
+  bool HasNext();
+  // starts opening the next entry into reader
+  bool Preopen(OMXReader *reader);
+  bool IsPreopening() { return m_reader != NULL; };
+  // waits for the preopen to finish, NULL when no entry could be opened
+  OMXReader *Take(std::string &filename);
+  // discards a preopened reader that was not taken
+  void Abort();
+  void Process();
+  // how long the last preopen took in seconds
+  double GetOpenTime() { return m_open_time * 1e-9; };
+};
+#endif
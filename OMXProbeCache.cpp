@@ -0,0 +1,271 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXProbeCache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "DllAvUtil.h"
+#include "DllAvFormat.h"
+#include "DllAvCodec.h"
+#include "utils/log.h"
+
+// codec ids and parameters are only meaningful for the libavformat that wrote them
+#define OMX_PROBE_CACHE_MAGIC   "OMXPRB01" LIBAVFORMAT_IDENT
+
+OMXProbeCache::OMXProbeCache()
+{
+  m_loaded  = false;
+  m_applied = false;
+}
+
+bool OMXProbeCache::Open(const std::string &filename)
+{
+  Close();
+
+  if(!m_cache.Open(filename, "probe", OMX_PROBE_CACHE_MAGIC))
+    return false;
+
+  m_loaded = Load();
+  return true;
+}
+
+void OMXProbeCache::Close()
+{
+  m_format.clear();
+  m_streams.clear();
+  m_extradata.clear();
+  m_cache   = OMXCacheFile();
+  m_loaded  = false;
+  m_applied = false;
+}
+
+const char *OMXProbeCache::GetFormatName()
+{
+  return m_loaded ? m_format.c_str() : NULL;
+}
+
+bool OMXProbeCache::Load()
+{
+  FILE *fp = m_cache.OpenRead();
+  if(!fp)
+    return false;
+
+  bool ret = false;
+  uint32_t length, count;
+
+  if(fread(&length, sizeof(length), 1, fp) == 1 && length > 0 && length < 256)
+  {
+    m_format.resize(length);
+    if(fread(&m_format[0], 1, length, fp) == length && fread(&count, sizeof(count), 1, fp) == 1 && count < 256)
+    {
+      m_streams.resize(count);
+      m_extradata.resize(count);
+
+      ret = true;
+      for(uint32_t i = 0; ret && i < count; i++)
+      {
+        ret = fread(&m_streams[i], sizeof(OMXProbeStream), 1, fp) == 1 && m_streams[i].extradata_size < (1 << 20);
+        if(ret && m_streams[i].extradata_size)
+        {
+          m_extradata[i].resize(m_streams[i].extradata_size);
+          ret = fread(&m_extradata[i][0], 1, m_streams[i].extradata_size, fp) == m_streams[i].extradata_size;
+        }
+      }
+    }
+  }
+
+  fclose(fp);
+
+  if(!ret)
+  {
+    m_format.clear();
+    m_streams.clear();
+    m_extradata.clear();
+  }
+
+  return ret;
+}
+
+bool OMXProbeCache::Apply(AVFormatContext *ctx)
+{
+  if(!m_loaded || !ctx || m_format != ctx->iformat->name || ctx->nb_streams != m_streams.size())
+    return false;
+
+  // only trust the cache if the demuxer agrees on what it has seen so far
+  for(unsigned int i = 0; i < ctx->nb_streams; i++)
+  {
+    AVStream *st = ctx->streams[i];
+    const OMXProbeStream &c = m_streams[i];
+
+    if(st->id != c.id)
+      return false;
+    if(st->codecpar->codec_type != AVMEDIA_TYPE_UNKNOWN && st->codecpar->codec_type != c.codec_type)
+      return false;
+    if(st->codecpar->codec_id != AV_CODEC_ID_NONE && st->codecpar->codec_id != c.codec_id)
+      return false;
+  }
+
+  for(unsigned int i = 0; i < ctx->nb_streams; i++)
+  {
+    AVStream *st = ctx->streams[i];
+    AVCodecParameters *par = st->codecpar;
+    const OMXProbeStream &c = m_streams[i];
+
+    par->codec_type = (AVMediaType)c.codec_type;
+    par->codec_id   = (AVCodecID)c.codec_id;
+
+    if(!par->codec_tag)
+      par->codec_tag = c.codec_tag;
+    if(par->format < 0)
+      par->format = c.format;
+    if(!par->bit_rate)
+      par->bit_rate = c.bit_rate;
+    if(!par->bits_per_coded_sample)
+      par->bits_per_coded_sample = c.bits_per_coded_sample;
+    if(par->profile == FF_PROFILE_UNKNOWN)
+      par->profile = c.profile;
+    if(par->level == FF_LEVEL_UNKNOWN)
+      par->level = c.level;
+    if(!par->width || !par->height)
+    {
+      par->width  = c.width;
+      par->height = c.height;
+    }
+    if(!par->sample_aspect_ratio.num)
+      par->sample_aspect_ratio = av_make_q(c.sample_aspect_num, c.sample_aspect_den);
+    if(!par->channel_layout)
+      par->channel_layout = c.channel_layout;
+    if(!par->channels)
+      par->channels = c.channels;
+    if(!par->sample_rate)
+      par->sample_rate = c.sample_rate;
+    if(!par->block_align)
+      par->block_align = c.block_align;
+    if(!par->frame_size)
+      par->frame_size = c.frame_size;
+
+    if(!par->extradata_size && !m_extradata[i].empty())
+    {
+      par->extradata = (uint8_t *)av_mallocz(m_extradata[i].size() + AV_INPUT_BUFFER_PADDING_SIZE);
+      if(par->extradata)
+      {
+        memcpy(par->extradata, &m_extradata[i][0], m_extradata[i].size());
+        par->extradata_size = m_extradata[i].size();
+      }
+    }
+
+    if(!st->r_frame_rate.num)
+      st->r_frame_rate = av_make_q(c.r_frame_rate_num, c.r_frame_rate_den);
+    if(!st->avg_frame_rate.num)
+      st->avg_frame_rate = av_make_q(c.avg_frame_rate_num, c.avg_frame_rate_den);
+  }
+
+  // with the parameters known, analysis only has to find the first timestamps
+  if(!ctx->max_analyze_duration || ctx->max_analyze_duration > OMX_PROBE_CACHE_ANALYZE_DURATION)
+    ctx->max_analyze_duration = OMX_PROBE_CACHE_ANALYZE_DURATION;
+  ctx->fps_probe_size = 0;
+
+  m_applied = true;
+  return true;
+}
+
+void OMXProbeCache::Finish(AVFormatContext *ctx)
+{
+  if(!m_applied || !ctx || ctx->nb_streams != m_streams.size())
+    return;
+
+  // the frame rate guess needs more frames than we let it see
+  for(unsigned int i = 0; i < ctx->nb_streams; i++)
+  {
+    AVStream *st = ctx->streams[i];
+    const OMXProbeStream &c = m_streams[i];
+
+    if(st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO)
+      continue;
+
+    if(c.r_frame_rate_num && c.r_frame_rate_den)
+      st->r_frame_rate = av_make_q(c.r_frame_rate_num, c.r_frame_rate_den);
+    if(!st->avg_frame_rate.num)
+      st->avg_frame_rate = av_make_q(c.avg_frame_rate_num, c.avg_frame_rate_den);
+  }
+}
+
+bool OMXProbeCache::Store(AVFormatContext *ctx)
+{
+  if(m_applied || !ctx)
+    return false;
+
+  FILE *fp = m_cache.OpenWrite();
+  if(!fp)
+    return false;
+
+  uint32_t length = strlen(ctx->iformat->name);
+  uint32_t count  = ctx->nb_streams;
+
+  bool ret = fwrite(&length, sizeof(length), 1, fp) == 1 &&
+             fwrite(ctx->iformat->name, 1, length, fp) == length &&
+             fwrite(&count, sizeof(count), 1, fp) == 1;
+
+  for(unsigned int i = 0; ret && i < ctx->nb_streams; i++)
+  {
+    AVStream *st = ctx->streams[i];
+    AVCodecParameters *par = st->codecpar;
+    OMXProbeStream c;
+
+    memset(&c, 0, sizeof(c));
+    c.id                    = st->id;
+    c.codec_type            = par->codec_type;
+    c.codec_id              = par->codec_id;
+    c.codec_tag             = par->codec_tag;
+    c.format                = par->format;
+    c.bit_rate              = par->bit_rate;
+    c.bits_per_coded_sample = par->bits_per_coded_sample;
+    c.profile               = par->profile;
+    c.level                 = par->level;
+    c.width                 = par->width;
+    c.height                = par->height;
+    c.sample_aspect_num     = par->sample_aspect_ratio.num;
+    c.sample_aspect_den     = par->sample_aspect_ratio.den;
+    c.channel_layout        = par->channel_layout;
+    c.channels              = par->channels;
+    c.sample_rate           = par->sample_rate;
+    c.block_align           = par->block_align;
+    c.frame_size            = par->frame_size;
+    c.r_frame_rate_num      = st->r_frame_rate.num;
+    c.r_frame_rate_den      = st->r_frame_rate.den;
+    c.avg_frame_rate_num    = st->avg_frame_rate.num;
+    c.avg_frame_rate_den    = st->avg_frame_rate.den;
+    c.extradata_size        = par->extradata ? par->extradata_size : 0;
+
+    ret = fwrite(&c, sizeof(c), 1, fp) == 1 &&
+          (!c.extradata_size || fwrite(par->extradata, 1, c.extradata_size, fp) == c.extradata_size);
+  }
+
+  return m_cache.CloseWrite(fp, ret);
+}
@@ -0,0 +1,89 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_PROBECACHE_H_
+#define _OMX_PROBECACHE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "OMXCacheFile.h"
+
+// stream analysis is cut down to this when the layout came from the cache
+#define OMX_PROBE_CACHE_ANALYZE_DURATION  500000
+
+struct AVFormatContext;
+
+typedef struct OMXProbeStream
+{
+  int32_t   id;
+  int32_t   codec_type;
+  int32_t   codec_id;
+  uint32_t  codec_tag;
+  int32_t   format;
+  int64_t   bit_rate;
+  int32_t   bits_per_coded_sample;
+  int32_t   profile;
+  int32_t   level;
+  int32_t   width;
+  int32_t   height;
+  int32_t   sample_aspect_num;
+  int32_t   sample_aspect_den;
+  uint64_t  channel_layout;
+  int32_t   channels;
+  int32_t   sample_rate;
+  int32_t   block_align;
+  int32_t   frame_size;
+  int32_t   r_frame_rate_num;
+  int32_t   r_frame_rate_den;
+  int32_t   avg_frame_rate_num;
+  int32_t   avg_frame_rate_den;
+  uint32_t  extradata_size;
+} OMXProbeStream;
+
+// Remembers the container format and codec parameters of local files, so
+// reopening one skips format probing and most of avformat_find_stream_info.
+class OMXProbeCache
+{
+public:
+  OMXProbeCache();
+  bool Open(const std::string &filename);
+  void Close();
+  // container format of the cached file, NULL if nothing is cached
+  const char *GetFormatName();
+  // fills in codec parameters when the demuxer found the cached layout,
+  // call before avformat_find_stream_info
+  bool Apply(AVFormatContext *ctx);
+  // restores what the shortened analysis could not determine
+  void Finish(AVFormatContext *ctx);
+  bool Store(AVFormatContext *ctx);
+protected:
+  bool Load();
+
+  OMXCacheFile                          m_cache;
+  std::string                           m_format;
+  std::vector<OMXProbeStream>           m_streams;
+  std::vector<std::vector<uint8_t> >    m_extradata;
+  bool                                  m_loaded;
+  bool                                  m_applied;
+};
+#endif
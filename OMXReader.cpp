@@ -27,9 +27,12 @@
 
 #include "OMXReader.h"
 #include "OMXClock.h"
+#include "OMXPacketPool.h"
+#include "OMXPacketQueue.h"
 
 #include <stdio.h>
 #include <unistd.h>
+#include <atomic>
 
 #include "linux/XMemUtils.h"
 
@@ -39,9 +42,15 @@
 
 static bool g_abort = false;
 
-static int64_t timeout_start;
+// every entry point resets these before reading, keeping them per thread lets
+// a file be opened in the background while another one is read
+static __thread int64_t timeout_start;
 static int64_t timeout_default_duration;
-static int64_t timeout_duration;
+static __thread int64_t timeout_duration;
+
+// hint ids of different readers and files never overlap
+#define HINTS_PER_FILE 0x10000
+static std::atomic<unsigned int> g_hints_generation(0);
 
 static int64_t CurrentHostCounter(void)
 {
@@ -64,16 +73,42 @@ OMXReader::OMXReader()
   m_bAVI        = false;
   g_abort       = false;
   m_pFile       = NULL;
+  m_cache_size  = 0;
+  m_discard_count   = 0;
+  m_discard_rate    = 0;
+  m_discard_unknown = 0;
+  m_seek_index_stream = -1;
   m_ioContext   = NULL;
   m_pFormatContext = NULL;
   m_eof           = false;
   m_chapter_count = 0;
   m_iCurrentPts   = DVD_NOPTS_VALUE;
+  m_time_offset  = 0.0;
+  m_keyframe_hop  = false;
+  m_param_set_stream = -1;
+  m_param_set_hints  = 0;
+  for(int i = 0; i < PARAM_SET_EVENTS; i++)
+    m_param_sets[i] = 0;
+  m_loop          = false;
+  m_loop_from     = 0;
+  m_loop_end      = DVD_NOPTS_VALUE;
+  m_loop_rebase   = false;
+  m_loop_discontinuity = false;
+  m_loop_count    = 0;
+  m_loop_cache_wraps = 0;
+  m_loop_cache_state = LOOP_CACHE_DISABLED;
+  m_loop_resume   = AV_NOPTS_VALUE;
+  ClearLoopCache();
+  ResetHop();
 
   for(int i = 0; i < MAX_STREAMS; i++)
     m_streams[i].extradata = NULL;
 
+  pthread_mutex_init(&m_hints_lock, NULL);
+  pthread_mutex_init(&m_gop_lock, NULL);
+
   ClearStreams();
+  RestartGops(true);
 
   pthread_mutex_init(&m_lock, NULL);
 }
@@ -82,6 +117,8 @@ OMXReader::~OMXReader()
 {
   Close();
 
+  pthread_mutex_destroy(&m_hints_lock);
+  pthread_mutex_destroy(&m_gop_lock);
   pthread_mutex_destroy(&m_lock);
 }
 
@@ -146,6 +183,8 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
   if (!m_dllAvUtil.Load() || !m_dllAvCodec.Load() || !m_dllAvFormat.Load())
     return false;
 
+  int64_t open_start = CurrentHostCounter();
+  int64_t open_input = open_start;
   timeout_default_duration = (int64_t) (timeout * 1e9);
   m_iCurrentPts = DVD_NOPTS_VALUE;
   m_filename    = filename; 
@@ -249,6 +288,9 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
   else
   {
     m_pFile = new CFile();
+    m_pFile->SetCacheSize(m_cache_size);
+    if (m_cache_size)
+      flags |= READ_CACHED;
 
     if (!m_pFile->Open(m_filename, flags))
     {
@@ -259,14 +301,19 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
 
     buffer = (unsigned char*)m_dllAvUtil.av_malloc(FFMPEG_FILE_BUFFER_SIZE);
     m_ioContext = m_dllAvFormat.avio_alloc_context(buffer, FFMPEG_FILE_BUFFER_SIZE, 0, m_pFile, dvd_file_read, NULL, dvd_file_seek);
-    m_ioContext->max_packet_size = 6144;
+    m_ioContext->max_packet_size = m_pFile->GetChunkSize();
     if(m_ioContext->max_packet_size)
       m_ioContext->max_packet_size *= FFMPEG_FILE_BUFFER_SIZE / m_ioContext->max_packet_size;
 
     if(m_pFile->IoControl(IOCTRL_SEEK_POSSIBLE, NULL) == 0)
       m_ioContext->seekable = 0;
 
-    m_dllAvFormat.av_probe_input_buffer(m_ioContext, &iformat, m_filename.c_str(), NULL, 0, 0);
+    // a file we have seen before needs no probing
+    if(m_probe_cache.Open(m_filename) && m_probe_cache.GetFormatName())
+      iformat = m_dllAvFormat.av_find_input_format(m_probe_cache.GetFormatName());
+
+    if(!iformat)
+      m_dllAvFormat.av_probe_input_buffer(m_ioContext, &iformat, m_filename.c_str(), NULL, 0, 0);
 
     if(!iformat)
     {
@@ -276,6 +323,7 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
     }
 
     m_pFormatContext->pb = m_ioContext;
+    open_input = CurrentHostCounter();
     result = m_dllAvFormat.avformat_open_input(&m_pFormatContext, m_filename.c_str(), iformat, &d);
     av_dict_free(&d);
     if(result < 0)
@@ -285,6 +333,8 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
     }
   }
 
+  int64_t open_info = CurrentHostCounter();
+
   m_bMatroska = strncmp(m_pFormatContext->iformat->name, "matroska", 8) == 0; // for "matroska.webm"
   m_bAVI = strcmp(m_pFormatContext->iformat->name, "avi") == 0;
 
@@ -298,6 +348,8 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
   if (live)
     m_pFormatContext->flags |= AVFMT_FLAG_NOBUFFER;
 
+  bool cached = m_probe_cache.Apply(m_pFormatContext);
+
   result = m_dllAvFormat.avformat_find_stream_info(m_pFormatContext, NULL);
   if(result < 0)
   {
@@ -305,6 +357,16 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
     return false;
   }
 
+  if(cached)
+    m_probe_cache.Finish(m_pFormatContext);
+  else
+    m_probe_cache.Store(m_pFormatContext);
+
+  int64_t open_end = CurrentHostCounter();
+  CLog::Log(LOGDEBUG, "COMXPlayer::OpenFile - probe %.1fms open %.1fms stream info %.1fms total %.1fms%s",
+            (open_input - open_start) * 1e-6, (open_info - open_input) * 1e-6, (open_end - open_info) * 1e-6,
+            (open_end - open_start) * 1e-6, cached ? " (cached)" : "");
+
   if(!GetStreams())
   {
     Close();
@@ -332,6 +394,8 @@ bool OMXReader::Open(std::string filename, bool dump_format, bool live /* =false
 
   UpdateCurrentPTS();
 
+  OpenSeekIndex();
+
   m_open        = true;
 
   return true;
@@ -361,8 +425,15 @@ void OMXReader::ClearStreams()
     m_streams[i].extrasize  = 0;
     m_streams[i].index      = 0;
     m_streams[i].id         = 0;
+    m_streams[i].hints_id   = 0;
   }
 
+  // ids keep counting up so packets of the previous file never match
+  pthread_mutex_lock(&m_hints_lock);
+  m_hints_base = (g_hints_generation++ % 0xffff + 1) * HINTS_PER_FILE;
+  m_hints.clear();
+  pthread_mutex_unlock(&m_hints_lock);
+
   m_program     = UINT_MAX;
 }
 
@@ -387,6 +458,10 @@ bool OMXReader::Close()
   m_ioContext       = NULL;
   m_pFormatContext  = NULL;
 
+  m_seek_index.Close();
+  m_seek_index_stream = -1;
+  m_probe_cache.Close();
+
   if(m_pFile)
   {
     m_pFile->Close();
@@ -414,6 +489,14 @@ bool OMXReader::Close()
   m_chapter_count   = 0;
   m_iCurrentPts     = DVD_NOPTS_VALUE;
   m_speed           = DVD_PLAYSPEED_NORMAL;
+  m_keyframe_hop    = false;
+  m_param_set_stream = -1;
+  m_time_offset     = 0.0;
+  m_loop            = false;
+  m_loop_cache_state = LOOP_CACHE_DISABLED;
+  ClearLoopCache();
+  ResetHop();
+  RestartGops(true);
 
   ClearStreams();
 
@@ -432,6 +515,8 @@ bool OMXReader::Close()
 
 bool OMXReader::SeekTime(int time, bool backwords, double *startpts)
 {
+  // callers seek on the continued timeline
+  time -= DVD_TIME_TO_MSEC(m_time_offset);
   if(time < 0)
     time = 0;
 
@@ -448,22 +533,29 @@ bool OMXReader::SeekTime(int time, bool backwords, double *startpts)
 
   //FlushRead();
 
-  if(m_ioContext)
-    m_ioContext->buf_ptr = m_ioContext->buf_end;
-
   int64_t seek_pts = (int64_t)time * (AV_TIME_BASE / 1000);
   if (m_pFormatContext->start_time != (int64_t)AV_NOPTS_VALUE)
     seek_pts += m_pFormatContext->start_time;
 
-  RESET_TIMEOUT(1);
-  int ret = m_dllAvFormat.av_seek_frame(m_pFormatContext, -1, seek_pts, backwords ? AVSEEK_FLAG_BACKWARD : 0);
+  int ret = SeekInternal(seek_pts, backwords);
 
-  if(ret >= 0)
-    UpdateCurrentPTS();
+  // trickplay starts hopping again from wherever we ended up
+  ResetHop();
+  RestartGops(false);
+
+  // the loop start is left behind, a GOP half recorded is recorded again on the next wrap
+  if(m_loop_cache_state == LOOP_CACHE_RECORDING)
+  {
+    ClearLoopCache();
+    m_loop_cache_state = LOOP_CACHE_EMPTY;
+  }
+  m_loop_replay = m_loop_cache.size();
+  m_loop_skip   = false;
+  m_loop_rebase = false;
 
   // in this case the start time is requested time
   if(startpts)
-    *startpts = DVD_MSEC_TO_TIME(time);
+    *startpts = DVD_MSEC_TO_TIME(time) + m_time_offset;
 
   // demuxer will return failure, if you seek to eof
   m_eof = false;
@@ -480,6 +572,86 @@ bool OMXReader::SeekTime(int time, bool backwords, double *startpts)
   return (ret >= 0);
 }
 
+// seek_pts in AV_TIME_BASE, the keyframe index is used when it knows the spot
+int OMXReader::SeekInternal(int64_t seek_pts, bool backwords)
+{
+  if(m_ioContext)
+    m_ioContext->buf_ptr = m_ioContext->buf_end;
+
+  RESET_TIMEOUT(1);
+  int ret = -1;
+  int64_t seek_pos;
+  if(m_seek_index.Lookup(seek_pts, backwords, &seek_pos))
+    ret = m_dllAvFormat.av_seek_frame(m_pFormatContext, -1, seek_pos, AVSEEK_FLAG_BYTE);
+  if(ret < 0)
+    ret = m_dllAvFormat.av_seek_frame(m_pFormatContext, -1, seek_pts, backwords ? AVSEEK_FLAG_BACKWARD : 0);
+
+  if(ret >= 0)
+    UpdateCurrentPTS();
+
+  return ret;
+}
+
+void OMXReader::ResetHop()
+{
+  m_hop_last   = AV_NOPTS_VALUE;
+  m_hop_target = AV_NOPTS_VALUE;
+  m_hop_seek   = AV_NOPTS_VALUE;
+  m_hop_start  = false;
+}
+
+// decides whether a packet read in trickplay is the next keyframe to show,
+// and plans the hop to the one after it, pkt has been through ClassifyPacket
+bool OMXReader::HopAccept(OMXPacket *pkt, AVPacket *av_pkt, AVStream *stream)
+{
+  if(m_video_index < 0 || pkt->stream_index != m_streams[m_video_index].id || !pkt->keyframe)
+    return false;
+
+  int64_t ts = av_pkt->pts != (int64_t)AV_NOPTS_VALUE ? av_pkt->pts : av_pkt->dts;
+  if(ts == (int64_t)AV_NOPTS_VALUE)
+    return false;
+  ts = m_dllAvUtil.av_rescale_q(ts, stream->time_base, AV_TIME_BASE_Q);
+
+  bool backwards = m_speed < 0;
+  int64_t step = (int64_t)abs(m_speed) * AV_TIME_BASE / (DVD_PLAYSPEED_NORMAL * TRICKPLAY_KEYFRAME_RATE);
+
+  if(m_hop_last != (int64_t)AV_NOPTS_VALUE)
+  {
+    if(!backwards && ts < m_hop_target)
+      return false;
+
+    if(backwards && ts >= m_hop_last)
+    {
+      // the seek landed on the keyframe we already showed, the GOP is longer than a hop
+      int64_t start = m_pFormatContext->start_time != (int64_t)AV_NOPTS_VALUE ? m_pFormatContext->start_time : 0;
+      m_hop_target -= step;
+      if(m_hop_target < start)
+        m_hop_start = true;
+      else
+        m_hop_seek = m_hop_target;
+      return false;
+    }
+  }
+
+  m_hop_last = ts;
+  if(backwards)
+  {
+    m_hop_target = ts - step;
+    m_hop_seek   = m_hop_target;
+  }
+  else
+  {
+    m_hop_target = ts + step;
+    // after a seek the first keyframe past the last one is taken, the index may be coarse
+    if(step >= TRICKPLAY_SEEK_MIN)
+    {
+      m_hop_seek   = m_hop_target;
+      m_hop_target = ts + 1;
+    }
+  }
+  return true;
+}
+
 AVMediaType OMXReader::PacketType(OMXPacket *pkt)
 {
   if(!m_pFormatContext || !pkt)
@@ -494,11 +666,36 @@ OMXPacket *OMXReader::Read()
   OMXPacket *m_omx_pkt = NULL;
   int       result = -1;
 
-  if(!m_pFormatContext || m_eof)
+  if(!m_pFormatContext || m_eof || m_hop_start)
     return NULL;
 
   Lock();
 
+  // the start of a loop comes from memory while the demuxer reads on behind it
+  if(m_loop_cache_state == LOOP_CACHE_READY && m_loop_replay < m_loop_cache.size())
+  {
+    m_omx_pkt = ClonePacket(m_loop_cache[m_loop_replay++]);
+    if(m_omx_pkt)
+      LoopRebase(m_omx_pkt);
+    UnLock();
+    return m_omx_pkt;
+  }
+
+  // a forward hop that cannot seek reads through instead, rewinding has to seek
+  if(m_keyframe_hop && m_hop_seek != (int64_t)AV_NOPTS_VALUE)
+  {
+    bool seeked = CanSeek() && SeekInternal(m_hop_seek, m_speed < 0) >= 0;
+    if(!seeked && m_speed >= 0)
+      m_hop_target = m_hop_seek;
+    m_hop_seek = AV_NOPTS_VALUE;
+    if(!seeked && m_speed < 0)
+    {
+      m_hop_start = true;
+      UnLock();
+      return NULL;
+    }
+  }
+
   // assume we are not eof
   if(m_pFormatContext->pb)
     m_pFormatContext->pb->eof_reached = 0;
@@ -512,7 +709,9 @@ OMXPacket *OMXReader::Read()
   result = m_dllAvFormat.av_read_frame(m_pFormatContext, &pkt);
   if (result < 0)
   {
-    m_eof = true;
+    // a looping file starts over instead of ending
+    if(!m_loop || !LoopWrap())
+      m_eof = true;
     //FlushRead();
     //m_dllAvCodec.av_free_packet(&pkt);
     UnLock();
@@ -537,15 +736,13 @@ OMXPacket *OMXReader::Read()
 
   AVStream *pStream = m_pFormatContext->streams[pkt.stream_index];
 
-  /* only read packets for active streams */
-  /*
-  if(!IsActive(pkt.stream_index))
+  /* demuxers that ignore discard still hand us these, drop them before copying */
+  if(pStream->discard >= AVDISCARD_ALL)
   {
     m_dllAvCodec.av_free_packet(&pkt);
     UnLock();
     return NULL;
   }
-  */
 
   // lavf sometimes bugs out and gives 0 dts/pts instead of no dts/pts
   // since this could only happens on initial frame under normal
@@ -579,7 +776,16 @@ OMXPacket *OMXReader::Read()
     pkt.pts = AV_NOPTS_VALUE;
   }
 
-  m_omx_pkt = AllocPacket(pkt.size);
+  /* keep a reference to the demuxer buffer, packets that are not refcounted
+   * (the demuxer will reuse the data) are copied into our own packet */
+  m_omx_pkt = AllocPacket(&pkt);
+  if(!m_omx_pkt)
+  {
+    m_omx_pkt = AllocPacket(pkt.size);
+    if(m_omx_pkt && pkt.data)
+      memcpy(m_omx_pkt->data, pkt.data, pkt.size);
+  }
+
   /* oom error allocation av packet */
   if(!m_omx_pkt)
   {
@@ -591,19 +797,51 @@ OMXPacket *OMXReader::Read()
 
   m_omx_pkt->codec_type = pStream->codec->codec_type;
 
-  /* copy content into our own packet */
-  m_omx_pkt->size = pkt.size;
-
-  if (pkt.data)
-    memcpy(m_omx_pkt->data, pkt.data, m_omx_pkt->size);
+  m_omx_pkt->codec_id   = pStream->codec->codec_id;
 
   m_omx_pkt->stream_index = pkt.stream_index;
-  GetHints(pStream, &m_omx_pkt->hints);
+  m_omx_pkt->hints_id = UpdateHints(pStream, m_streams[pkt.stream_index]);
 
   m_omx_pkt->dts = ConvertTimestamp(pkt.dts, pStream->time_base.den, pStream->time_base.num);
   m_omx_pkt->pts = ConvertTimestamp(pkt.pts, pStream->time_base.den, pStream->time_base.num);
   m_omx_pkt->duration = DVD_SEC_TO_TIME((double)pkt.duration * pStream->time_base.num / pStream->time_base.den);
 
+  if(m_loop_skip)
+  {
+    double ts = m_omx_pkt->pts != DVD_NOPTS_VALUE ? m_omx_pkt->pts : m_omx_pkt->dts;
+    double cached = m_loop_cached_ts[pkt.stream_index];
+    if(ts != DVD_NOPTS_VALUE && cached != DVD_NOPTS_VALUE && ts <= cached)
+    {
+      FreePacket(m_omx_pkt);
+      m_dllAvCodec.av_free_packet(&pkt);
+      UnLock();
+      return NULL;
+    }
+  }
+
+  ClassifyPacket(m_omx_pkt, &pkt, pStream);
+
+  /* trickplay only shows keyframes, skip everything in between the hops */
+  if(m_keyframe_hop && !HopAccept(m_omx_pkt, &pkt, pStream))
+  {
+    FreePacket(m_omx_pkt);
+    m_dllAvCodec.av_free_packet(&pkt);
+    UnLock();
+    return NULL;
+  }
+
+  if(m_loop_cache_state == LOOP_CACHE_RECORDING)
+    LoopRecord(m_omx_pkt, m_omx_pkt->keyframe,
+               pkt.pts != (int64_t)AV_NOPTS_VALUE ? m_dllAvUtil.av_rescale_q(pkt.pts, pStream->time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE);
+
+  // remember keyframe positions for seeking
+  if(pkt.stream_index == m_seek_index_stream && m_omx_pkt->keyframe)
+  {
+    int64_t ts = pkt.dts != (int64_t)AV_NOPTS_VALUE ? pkt.dts : pkt.pts;
+    if(ts != (int64_t)AV_NOPTS_VALUE)
+      m_seek_index.Add(m_dllAvUtil.av_rescale_q(ts, pStream->time_base, AV_TIME_BASE_Q), pkt.pos);
+  }
+
   // used to guess streamlength
   if (m_omx_pkt->dts != DVD_NOPTS_VALUE && (m_omx_pkt->dts > m_iCurrentPts || m_iCurrentPts == DVD_NOPTS_VALUE))
     m_iCurrentPts = m_omx_pkt->dts;
@@ -627,12 +865,331 @@ OMXPacket *OMXReader::Read()
     }
   }
 
+  if(m_loop)
+    LoopRebase(m_omx_pkt);
+  else if(m_time_offset != 0.0)
+  {
+    if(m_omx_pkt->dts != DVD_NOPTS_VALUE)
+      m_omx_pkt->dts += m_time_offset;
+    if(m_omx_pkt->pts != DVD_NOPTS_VALUE)
+      m_omx_pkt->pts += m_time_offset;
+  }
+
   m_dllAvCodec.av_free_packet(&pkt);
 
   UnLock();
   return m_omx_pkt;
 }
 
+void OMXReader::SetLoop(bool loop, int from_ms, bool keep_gop)
+{
+  Lock();
+
+  ClearLoopCache();
+  m_loop        = loop;
+  m_loop_from   = (int64_t)from_ms * (AV_TIME_BASE / 1000);
+  if(m_pFormatContext && m_pFormatContext->start_time != (int64_t)AV_NOPTS_VALUE)
+    m_loop_from += m_pFormatContext->start_time;
+  m_loop_end    = DVD_NOPTS_VALUE;
+  m_loop_rebase = false;
+  m_loop_discontinuity = false;
+  m_loop_count  = 0;
+  m_loop_cache_wraps = 0;
+  // the GOP ends at the next video keyframe
+  m_loop_cache_state = loop && keep_gop && m_video_index >= 0 ? LOOP_CACHE_EMPTY : LOOP_CACHE_DISABLED;
+
+  UnLock();
+}
+
+// called at the end of a looping file, reading goes on at the loop start
+bool OMXReader::LoopWrap()
+{
+  int ret;
+
+  if(m_loop_cache_state == LOOP_CACHE_READY && !m_keyframe_hop)
+  {
+    // the cached GOP is handed out first, the demuxer goes on after it
+    ret = SeekInternal(m_loop_resume, true);
+    m_loop_replay = 0;
+    m_loop_skip   = true;
+    m_loop_cache_wraps++;
+  }
+  else
+  {
+    ret = SeekInternal(m_loop_from, true);
+    m_loop_skip = false;
+
+    // a loop without a second keyframe is not worth keeping
+    if(m_loop_cache_state == LOOP_CACHE_RECORDING)
+    {
+      ClearLoopCache();
+      m_loop_cache_state = LOOP_CACHE_DISABLED;
+    }
+    else if(m_loop_cache_state == LOOP_CACHE_EMPTY && m_speed == DVD_PLAYSPEED_NORMAL)
+    {
+      m_loop_cache_state = LOOP_CACHE_RECORDING;
+    }
+  }
+
+  if(ret < 0)
+  {
+    CLog::Log(LOGERROR, "OMXReader::LoopWrap - seek to the loop start failed");
+    return false;
+  }
+
+  ResetHop();
+  RestartGops(false);
+  m_loop_rebase = true;
+  m_loop_discontinuity = true;
+  m_loop_count++;
+
+  return true;
+}
+
+void OMXReader::LoopRecord(OMXPacket *pkt, bool keyframe, int64_t pts)
+{
+  if(keyframe && IsActive(OMXSTREAM_VIDEO, pkt->stream_index) && m_loop_cache_keyframes++ > 0)
+  {
+    // the keyframe after the GOP is where reading resumes
+    m_loop_resume       = pts;
+    m_loop_replay       = m_loop_cache.size();
+    m_loop_cache_state  = pts != (int64_t)AV_NOPTS_VALUE ? LOOP_CACHE_READY : LOOP_CACHE_DISABLED;
+    if(m_loop_cache_state == LOOP_CACHE_DISABLED)
+      ClearLoopCache();
+    CLog::Log(LOGDEBUG, "OMXReader::LoopRecord - %u packets, %u bytes cached", (unsigned int)m_loop_cache.size(), m_loop_cache_size);
+    return;
+  }
+
+  OMXPacket *copy = NULL;
+  if(m_loop_cache_size + pkt->size <= LOOP_CACHE_MAX_SIZE)
+    copy = ClonePacket(pkt);
+
+  if(!copy)
+  {
+    CLog::Log(LOGWARNING, "OMXReader::LoopRecord - first GOP of the loop too large to keep");
+    ClearLoopCache();
+    m_loop_cache_state = LOOP_CACHE_DISABLED;
+    return;
+  }
+
+  m_loop_cache.push_back(copy);
+  m_loop_cache_size += pkt->size;
+
+  double ts = pkt->pts != DVD_NOPTS_VALUE ? pkt->pts : pkt->dts;
+  double &cached = m_loop_cached_ts[pkt->stream_index];
+  if(ts != DVD_NOPTS_VALUE && (cached == DVD_NOPTS_VALUE || ts > cached))
+    cached = ts;
+}
+
+// moves a packet of a looping file onto the continued timeline
+void OMXReader::LoopRebase(OMXPacket *pkt)
+{
+  double ts = pkt->pts != DVD_NOPTS_VALUE ? pkt->pts : pkt->dts;
+
+  // the first packet after a wrap follows the end of the previous iteration
+  if(m_loop_rebase && ts != DVD_NOPTS_VALUE)
+  {
+    if(m_loop_end != DVD_NOPTS_VALUE)
+      m_time_offset = m_loop_end - ts;
+    m_loop_rebase = false;
+  }
+
+  if(pkt->dts != DVD_NOPTS_VALUE)
+    pkt->dts += m_time_offset;
+  if(pkt->pts != DVD_NOPTS_VALUE)
+    pkt->pts += m_time_offset;
+
+  if(pkt->codec_type != AVMEDIA_TYPE_VIDEO && pkt->codec_type != AVMEDIA_TYPE_AUDIO)
+    return;
+
+  if(m_loop_discontinuity && IsActive(OMXSTREAM_VIDEO, pkt->stream_index))
+  {
+    pkt->discontinuity    = true;
+    m_loop_discontinuity  = false;
+  }
+
+  if(ts != DVD_NOPTS_VALUE)
+  {
+    double end = ts + m_time_offset + (pkt->duration != DVD_NOPTS_VALUE ? pkt->duration : 0);
+    if(m_loop_end == DVD_NOPTS_VALUE || end > m_loop_end)
+      m_loop_end = end;
+  }
+}
+
+void OMXReader::ClearLoopCache()
+{
+  for(size_t i = 0; i < m_loop_cache.size(); i++)
+    FreePacket(m_loop_cache[i]);
+  m_loop_cache.clear();
+
+  m_loop_cache_size       = 0;
+  m_loop_cache_keyframes  = 0;
+  m_loop_replay           = 0;
+  m_loop_skip             = false;
+  for(int i = 0; i < MAX_STREAMS; i++)
+    m_loop_cached_ts[i] = DVD_NOPTS_VALUE;
+}
+
+void OMXReader::ClassifyPacket(OMXPacket *pkt, AVPacket *av_pkt, AVStream *stream)
+{
+  bool flagged = (av_pkt->flags & AV_PKT_FLAG_KEY) != 0;
+
+  pkt->keyframe   = flagged;
+  pkt->reference  = true;
+  pkt->frame_type = OMX_FRAME_UNKNOWN;
+  pkt->param_sets = false;
+  pkt->format_changed = false;
+
+  if(pkt->codec_type != AVMEDIA_TYPE_VIDEO)
+    return;
+
+  const uint8_t *extradata = stream->codec->extradata;
+  int extrasize = stream->codec->extradata_size;
+  bool parsed = false;
+  h264_picture_info info;
+
+  // in-band parameter sets are compared with the ones the decoder was opened with
+  bool reset = pkt->stream_index != m_param_set_stream || pkt->hints_id != m_param_set_hints;
+  m_param_set_stream = pkt->stream_index;
+  m_param_set_hints  = pkt->hints_id;
+
+  if(pkt->codec_id == AV_CODEC_ID_H264)
+  {
+    // avcC extradata means length prefixed NAL units, none means Annex B
+    int length_size = 0;
+    if(extradata && extrasize >= 7 && extradata[0] == 1)
+      length_size = (extradata[4] & 3) + 1;
+    if(reset)
+      m_parser.ResetParamSets(extradata, extrasize);
+    parsed = m_parser.parseh264_picture(av_pkt->data, av_pkt->size, length_size, &info);
+    TrackParamSets(pkt, info);
+  }
+  else if(pkt->codec_id == AV_CODEC_ID_HEVC)
+  {
+    int length_size = 0;
+    if(extradata && extrasize >= 23 && extradata[0] == 1)
+      length_size = (extradata[21] & 3) + 1;
+    // the slice header layout depends on the PPS
+    if(reset)
+      m_parser.ResetHevcParamSets(extradata, extrasize);
+    parsed = m_parser.parsehevc_picture(av_pkt->data, av_pkt->size, length_size, &info);
+  }
+
+  if(parsed)
+  {
+    switch(info.slice_type)
+    {
+      case 2: case 4: pkt->frame_type = OMX_FRAME_I; break;
+      case 0: case 3: pkt->frame_type = OMX_FRAME_P; break;
+      case 1:         pkt->frame_type = OMX_FRAME_B; break;
+      default: break;
+    }
+    pkt->reference = info.nal_ref_idc != 0;
+    // an I slice the muxer marked as a keyframe is a recovery point, an IDR always is one
+    pkt->keyframe  = info.idr || (flagged && pkt->frame_type == OMX_FRAME_I);
+  }
+
+  // hopping skips pictures, what is left is no GOP
+  if(m_keyframe_hop)
+    return;
+
+  int index = pkt->stream_index;
+  double ts = pkt->dts != DVD_NOPTS_VALUE ? pkt->dts : pkt->pts;
+
+  pthread_mutex_lock(&m_gop_lock);
+
+  OMXGopStats &stats = m_gop_stats[index];
+  OMXGopState &state = m_gop_state[index];
+
+  if(parsed)
+  {
+    if(pkt->keyframe && !flagged)
+      stats.key_unflagged++;
+    else if(!pkt->keyframe && flagged)
+      stats.key_rejected++;
+  }
+
+  if(pkt->keyframe && ts != DVD_NOPTS_VALUE)
+  {
+    if(state.start != DVD_NOPTS_VALUE && ts > state.start)
+    {
+      double interval = (ts - state.start) / DVD_TIME_BASE;
+      double bitrate = state.bytes * 8 / interval;
+
+      stats.gops++;
+      stats.frames   += state.frames;
+      stats.interval += interval;
+      stats.bytes    += state.bytes;
+      if(interval > stats.interval_max)
+        stats.interval_max = interval;
+      if(bitrate > stats.bitrate_max)
+        stats.bitrate_max = bitrate;
+    }
+    state.start  = ts;
+    state.frames = 0;
+    state.bytes  = 0;
+  }
+
+  if(state.start != DVD_NOPTS_VALUE)
+  {
+    state.frames++;
+    state.bytes += av_pkt->size;
+    stats.frame_types[pkt->frame_type]++;
+    if(!pkt->reference)
+      stats.nonref++;
+  }
+
+  pthread_mutex_unlock(&m_gop_lock);
+}
+
+void OMXReader::TrackParamSets(OMXPacket *pkt, const h264_picture_info &info)
+{
+  m_param_sets[PARAM_SET_REDUNDANT] += info.param_sets_redundant;
+  m_param_sets[PARAM_SET_UPDATED]   += info.param_sets_updated;
+  pkt->param_sets = info.param_sets > 0;
+  if(!info.format_changed)
+    return;
+
+  m_param_sets[PARAM_SET_CHANGED]++;
+  pkt->format_changed = true;
+  CLog::Log(LOGINFO, "OMXReader::TrackParamSets in-band SPS changes the stream to %dx%d%s profile %d level %d ref frames %d",
+            info.format.width, info.format.height, info.format.interlaced ? "i" : "p", info.format.profile_idc,
+            info.format.level_idc, info.format.max_ref_frames);
+}
+
+void OMXReader::RestartGops(bool all)
+{
+  pthread_mutex_lock(&m_gop_lock);
+  for(int i = 0; i < MAX_STREAMS; i++)
+  {
+    if(all)
+      memset(&m_gop_stats[i], 0, sizeof(OMXGopStats));
+    m_gop_state[i].start  = DVD_NOPTS_VALUE;
+    m_gop_state[i].frames = 0;
+    m_gop_state[i].bytes  = 0;
+  }
+  pthread_mutex_unlock(&m_gop_lock);
+}
+
+bool OMXReader::GetGopStats(unsigned int index, OMXGopStats *stats)
+{
+  bool ret = false;
+
+  pthread_mutex_lock(&m_gop_lock);
+  for(int i = 0; i < MAX_STREAMS; i++)
+  {
+    if(m_streams[i].type == OMXSTREAM_VIDEO &&  m_streams[i].index == index)
+    {
+      *stats = m_gop_stats[i];
+      ret = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&m_gop_lock);
+
+  return ret;
+}
+
 bool OMXReader::GetStreams()
 {
   if(!m_pFormatContext)
@@ -741,7 +1298,7 @@ void OMXReader::AddStream(int id)
       m_streams[id].codec_name  = GetStreamCodecName(pStream);
       m_streams[id].id          = id;
       m_audio_count++;
-      GetHints(pStream, &m_streams[id].hints);
+      UpdateHints(pStream, m_streams[id]);
       break;
     case AVMEDIA_TYPE_VIDEO:
       m_streams[id].stream      = pStream;
@@ -750,7 +1307,7 @@ void OMXReader::AddStream(int id)
       m_streams[id].codec_name  = GetStreamCodecName(pStream);
       m_streams[id].id          = id;
       m_video_count++;
-      GetHints(pStream, &m_streams[id].hints);
+      UpdateHints(pStream, m_streams[id]);
       break;
     case AVMEDIA_TYPE_SUBTITLE:
       m_streams[id].stream      = pStream;
@@ -759,7 +1316,7 @@ void OMXReader::AddStream(int id)
       m_streams[id].codec_name  = GetStreamCodecName(pStream);
       m_streams[id].id          = id;
       m_subtitle_count++;
-      GetHints(pStream, &m_streams[id].hints);
+      UpdateHints(pStream, m_streams[id]);
       break;
     default:
       return;
@@ -853,9 +1410,62 @@ bool OMXReader::SetActiveStreamInternal(OMXStreamType type, unsigned int index)
     }
   }
 
+  UpdateDiscard();
+
   return ret;
 }
 
+void OMXReader::UpdateDiscard()
+{
+  if(!m_pFormatContext)
+    return;
+
+  m_discard_count   = 0;
+  m_discard_rate    = 0;
+  m_discard_unknown = 0;
+
+  AVDiscard discard = SpeedDiscard();
+
+  for(unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    AVStream *pStream = m_pFormatContext->streams[i];
+    bool keep = false;
+
+    // all subtitle streams are buffered so switching between them is instant
+    for(int j = 0; j < MAX_STREAMS; j++)
+    {
+      if(m_streams[j].type == OMXSTREAM_NONE || m_streams[j].id != (int)i)
+        continue;
+
+      if(m_streams[j].type == OMXSTREAM_SUBTITLE || j == m_audio_index || j == m_video_index)
+        keep = true;
+    }
+
+    pStream->discard = keep ? discard : AVDISCARD_ALL;
+
+    if(!keep)
+    {
+      m_discard_count++;
+      if(pStream->codec->bit_rate > 0)
+        m_discard_rate += pStream->codec->bit_rate / 8;
+      else
+        m_discard_unknown++;
+    }
+  }
+}
+
+AVDiscard OMXReader::SpeedDiscard()
+{
+  if(m_speed > 4*DVD_PLAYSPEED_NORMAL)
+    return AVDISCARD_NONKEY;
+  else if(m_speed > 2*DVD_PLAYSPEED_NORMAL)
+    return AVDISCARD_BIDIR;
+  else if(m_speed < DVD_PLAYSPEED_PAUSE)
+    return AVDISCARD_NONKEY;
+
+  return AVDISCARD_NONE;
+}
+
 bool OMXReader::IsActive(int stream_index)
 {
   if((m_audio_index != -1)    && m_streams[m_audio_index].id      == stream_index)
@@ -880,6 +1490,19 @@ bool OMXReader::IsActive(OMXStreamType type, int stream_index)
   return false;
 }
 
+int OMXReader::GetActiveStreamId(OMXStreamType type)
+{
+  int index = -1;
+  switch(type)
+  {
+    case OMXSTREAM_AUDIO:    index = m_audio_index;    break;
+    case OMXSTREAM_VIDEO:    index = m_video_index;    break;
+    case OMXSTREAM_SUBTITLE: index = m_subtitle_index; break;
+    default: break;
+  }
+  return index >= 0 ? m_streams[index].id : -1;
+}
+
 double OMXReader::SelectAspect(AVStream* st, bool& forced)
 {
   // trust matroshka container
@@ -962,6 +1585,63 @@ bool OMXReader::GetHints(AVStream *stream, COMXStreamInfo *hints)
   return true;
 }
 
+unsigned int OMXReader::UpdateHints(AVStream *stream, OMXStream &omx_stream)
+{
+  OMXHintsKey key;
+
+  memset(&key, 0, sizeof(key));
+  key.codec_id                  = stream->codec->codec_id;
+  key.channels                  = stream->codec->channels;
+  key.sample_rate               = stream->codec->sample_rate;
+  key.block_align               = stream->codec->block_align;
+  key.bits_per_coded_sample     = stream->codec->bits_per_coded_sample;
+  key.width                     = stream->codec->width;
+  key.height                    = stream->codec->height;
+  key.profile                   = stream->codec->profile;
+  key.extradata_size            = stream->codec->extradata_size;
+  key.extradata                 = stream->codec->extradata;
+  key.bit_rate                  = stream->codec->bit_rate;
+  key.r_frame_rate              = stream->r_frame_rate;
+  key.avg_frame_rate            = stream->avg_frame_rate;
+  key.sample_aspect_ratio       = stream->sample_aspect_ratio;
+  key.codec_sample_aspect_ratio = stream->codec->sample_aspect_ratio;
+
+  if(omx_stream.hints_id && memcmp(&key, &omx_stream.hints_key, sizeof(key)) == 0)
+    return omx_stream.hints_id;
+
+  COMXStreamInfo hints;
+  GetHints(stream, &hints);
+
+  // the stream table keeps what the stream was opened with, later versions
+  // only reach the players through the packets
+  if(!omx_stream.hints_id)
+    omx_stream.hints = hints;
+
+  pthread_mutex_lock(&m_hints_lock);
+  omx_stream.hints_id = m_hints_base + m_hints.size();
+  m_hints.push_back(hints);
+  pthread_mutex_unlock(&m_hints_lock);
+
+  memcpy(&omx_stream.hints_key, &key, sizeof(key));
+
+  return omx_stream.hints_id;
+}
+
+bool OMXReader::GetPacketHints(unsigned int hints_id, COMXStreamInfo &hints)
+{
+  bool ret = false;
+
+  pthread_mutex_lock(&m_hints_lock);
+  if(hints_id >= m_hints_base && hints_id - m_hints_base < m_hints.size())
+  {
+    hints = m_hints[hints_id - m_hints_base];
+    ret = true;
+  }
+  pthread_mutex_unlock(&m_hints_lock);
+
+  return ret;
+}
+
 bool OMXReader::GetHints(OMXStreamType type, unsigned int index, COMXStreamInfo &hints)
 {
   for(unsigned int i = 0; i < MAX_STREAMS; i++)
@@ -1019,23 +1699,42 @@ void OMXReader::FreePacket(OMXPacket *pkt)
 {
   if(pkt)
   {
-    if(pkt->data)
-      free(pkt->data);
-    free(pkt);
+    OMXPacketPool &pool = OMXPacketPool::Get();
+    if(pkt->buf)
+      av_buffer_unref(&pkt->buf);
+    else if(pkt->data)
+      pool.FreeData(pkt->data, pkt->capacity);
+    pool.FreeHeader(pkt);
   }
 }
 
+int OMXPacketSize(const OMXPacket *pkt)
+{
+  return pkt->size;
+}
+
+double OMXPacketDuration(const OMXPacket *pkt)
+{
+  return pkt->duration;
+}
+
+void OMXPacketFree(OMXPacket *pkt)
+{
+  OMXReader::FreePacket(pkt);
+}
+
 OMXPacket *OMXReader::AllocPacket(int size)
 {
-  OMXPacket *pkt = (OMXPacket *)malloc(sizeof(OMXPacket));
+  OMXPacketPool &pool = OMXPacketPool::Get();
+  OMXPacket *pkt = pool.AllocHeader();
   if(pkt)
   {
     memset(pkt, 0, sizeof(OMXPacket));
 
-    pkt->data = (uint8_t*) malloc(size + AV_INPUT_BUFFER_PADDING_SIZE);
+    pkt->data = pool.AllocData(size + AV_INPUT_BUFFER_PADDING_SIZE, &pkt->capacity);
     if(!pkt->data)
     {
-      free(pkt);
+      pool.FreeHeader(pkt);
       pkt = NULL;
     }
     else
@@ -1051,6 +1750,64 @@ OMXPacket *OMXReader::AllocPacket(int size)
   return pkt;
 }
 
+void OMXReader::UnrefPacketData(void *ref)
+{
+  AVBufferRef *buf = (AVBufferRef *)ref;
+  av_buffer_unref(&buf);
+}
+
+OMXPacket *OMXReader::AllocPacket(AVPacket *avpkt)
+{
+  if(!avpkt->buf || !avpkt->data)
+    return NULL;
+
+  // the consumers rely on the input padding being present after the payload
+  if(avpkt->data < avpkt->buf->data ||
+     avpkt->data + avpkt->size + AV_INPUT_BUFFER_PADDING_SIZE > avpkt->buf->data + avpkt->buf->size)
+    return NULL;
+
+  OMXPacket *pkt = OMXPacketPool::Get().AllocHeader();
+  if(pkt)
+  {
+    memset(pkt, 0, sizeof(OMXPacket));
+
+    // take over the reference, av_free_packet will leave the data alone
+    pkt->buf  = avpkt->buf;
+    avpkt->buf = NULL;
+    pkt->data = avpkt->data;
+    pkt->size = avpkt->size;
+    pkt->dts  = DVD_NOPTS_VALUE;
+    pkt->pts  = DVD_NOPTS_VALUE;
+    pkt->now  = DVD_NOPTS_VALUE;
+    pkt->duration = DVD_NOPTS_VALUE;
+  }
+  return pkt;
+}
+
+OMXPacket *OMXReader::ClonePacket(OMXPacket *pkt)
+{
+  OMXPacket *copy = AllocPacket(pkt->size);
+  if(copy)
+  {
+    memcpy(copy->data, pkt->data, pkt->size);
+    copy->pts           = pkt->pts;
+    copy->dts           = pkt->dts;
+    copy->now           = pkt->now;
+    copy->duration      = pkt->duration;
+    copy->stream_index  = pkt->stream_index;
+    copy->hints_id      = pkt->hints_id;
+    copy->discontinuity = pkt->discontinuity;
+    copy->keyframe      = pkt->keyframe;
+    copy->reference     = pkt->reference;
+    copy->param_sets    = pkt->param_sets;
+    copy->format_changed = pkt->format_changed;
+    copy->frame_type    = pkt->frame_type;
+    copy->codec_id      = pkt->codec_id;
+    copy->codec_type    = pkt->codec_type;
+  }
+  return copy;
+}
+
 bool OMXReader::SetActiveStream(OMXStreamType type, unsigned int index)
 {
   bool ret = false;
@@ -1074,7 +1831,7 @@ bool OMXReader::SeekChapter(int chapter, double* startpts)
 
   AVChapter *ch = m_pFormatContext->chapters[chapter-1];
   double dts = ConvertTimestamp(ch->start, ch->time_base.den, ch->time_base.num);
-  return SeekTime(DVD_TIME_TO_MSEC(dts), 0, startpts);
+  return SeekTime(DVD_TIME_TO_MSEC(dts + m_time_offset), 0, startpts);
 #else
   return false;
 #endif
@@ -1164,6 +1921,8 @@ void OMXReader::SetSpeed(int iSpeed)
   if(!m_pFormatContext)
     return;
 
+  Lock();
+
   if(m_speed != DVD_PLAYSPEED_PAUSE && iSpeed == DVD_PLAYSPEED_PAUSE)
   {
     m_dllAvFormat.av_read_pause(m_pFormatContext);
@@ -1174,13 +1933,20 @@ void OMXReader::SetSpeed(int iSpeed)
   }
   m_speed = iSpeed;
 
-  AVDiscard discard = AVDISCARD_NONE;
-  if(m_speed > 4*DVD_PLAYSPEED_NORMAL)
-    discard = AVDISCARD_NONKEY;
-  else if(m_speed > 2*DVD_PLAYSPEED_NORMAL)
-    discard = AVDISCARD_BIDIR;
-  else if(m_speed < DVD_PLAYSPEED_PAUSE)
-    discard = AVDISCARD_NONKEY;
+  m_keyframe_hop = m_speed < DVD_PLAYSPEED_PAUSE || m_speed > 4*DVD_PLAYSPEED_NORMAL;
+  ResetHop();
+  RestartGops(false);
+
+  // other speeds discard frames, that is not the GOP to replay
+  if(m_speed != DVD_PLAYSPEED_NORMAL && m_loop_cache_state == LOOP_CACHE_RECORDING)
+  {
+    ClearLoopCache();
+    m_loop_cache_state = LOOP_CACHE_EMPTY;
+  }
+  if(m_keyframe_hop)
+    m_loop_replay = m_loop_cache.size();
+
+  AVDiscard discard = SpeedDiscard();
 
   for(unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
   {
@@ -1190,6 +1956,44 @@ void OMXReader::SetSpeed(int iSpeed)
         m_pFormatContext->streams[i]->discard = discard;
     }
   }
+
+  UnLock();
+}
+
+void OMXReader::OpenSeekIndex()
+{
+  m_seek_index.Close();
+  m_seek_index_stream = -1;
+
+  if(!m_pFile || !m_pFile->IoControl(IOCTRL_SEEK_POSSIBLE, NULL) ||
+     (m_pFormatContext->iformat->flags & AVFMT_NO_BYTE_SEEK))
+    return;
+
+  if(m_video_index >= 0)
+    m_seek_index_stream = m_streams[m_video_index].id;
+  else if(m_audio_index >= 0)
+    m_seek_index_stream = m_streams[m_audio_index].id;
+  else
+    return;
+
+  // containers with a real index seek fine on their own
+  AVStream *pStream = m_pFormatContext->streams[m_seek_index_stream];
+  if(pStream->nb_index_entries > 1 && !(m_pFormatContext->iformat->flags & AVFMT_GENERIC_INDEX))
+  {
+    m_seek_index_stream = -1;
+    return;
+  }
+
+  if(!m_seek_index.Open(m_filename))
+    m_seek_index_stream = -1;
+}
+
+bool OMXReader::GetCacheStatus(XFILE::SCacheStatus *status)
+{
+  if(!m_pFile)
+    return false;
+
+  return m_pFile->IoControl(IOCTRL_CACHE_STATUS, status) >= 0;
 }
 
 int OMXReader::GetStreamLength()
@@ -32,9 +32,14 @@
 #include "OMXStreamInfo.h"
 
 #include "File.h"
+#include "OMXSeekIndex.h"
+#include "OMXProbeCache.h"
+#include "BitstreamConverter.h"
 
 #include <sys/types.h>
 #include <string>
+#include <vector>
+#include <atomic>
 
 using namespace XFILE;
 using namespace std;
@@ -49,6 +54,20 @@ using namespace std;
 #ifndef MAX_STREAMS
 #define MAX_STREAMS 100
 #endif
+// keyframes per second shown while fast forwarding or rewinding
+#define TRICKPLAY_KEYFRAME_RATE 8
+// hops shorter than this (in AV_TIME_BASE) read forward instead of seeking
+#define TRICKPLAY_SEEK_MIN      1000000
+// the first GOP of a seamless loop is only kept in memory up to this size
+#define LOOP_CACHE_MAX_SIZE     (16 * 1024 * 1024)
+
+enum OMXLoopCacheState
+{
+  LOOP_CACHE_DISABLED,  // not asked for, or the GOP did not fit
+  LOOP_CACHE_EMPTY,     // recorded after the next wrap
+  LOOP_CACHE_RECORDING,
+  LOOP_CACHE_READY
+};
 
 typedef struct OMXChapter
 {
@@ -59,6 +78,25 @@ typedef struct OMXChapter
 
 class OMXReader;
 
+// picture coding type of a video packet, of its first slice when the bitstream was parsed
+enum OMXFrameType
+{
+  OMX_FRAME_UNKNOWN = 0,
+  OMX_FRAME_I,
+  OMX_FRAME_P,
+  OMX_FRAME_B,
+  OMX_FRAME_TYPES
+};
+
+// what in-band H.264 parameter sets turned out to be
+enum EParamSetEvent
+{
+  PARAM_SET_CHANGED = 0, // new picture size, profile, reference frames or interlacing
+  PARAM_SET_UPDATED,     // new contents, same picture format
+  PARAM_SET_REDUNDANT,   // repeated unchanged
+  PARAM_SET_EVENTS
+};
+
 typedef struct OMXPacket
 {
   double    pts; // pts in DVD_TIME_BASE
@@ -67,8 +105,17 @@ typedef struct OMXPacket
   double    duration; // duration in DVD_TIME_BASE if available
   int       size;
   uint8_t   *data;
+  unsigned int capacity; // allocated size of data, owned by the packet pool
+  AVBufferRef *buf; // demuxer buffer holding data when it was not copied
   int       stream_index;
-  COMXStreamInfo hints;
+  unsigned int hints_id; // version of the stream hints, see OMXReader::GetPacketHints
+  bool      discontinuity; // first packet of a file spliced behind the previous one
+  bool      keyframe;   // random access point, checked against the bitstream for H.264 and HEVC
+  bool      reference;  // video only, other pictures may be predicted from it
+  bool      param_sets; // H.264 only, carries in-band SPS or PPS
+  bool      format_changed; // H.264 only, an in-band SPS changes the picture format
+  OMXFrameType frame_type;
+  enum AVCodecID codec_id;
   enum AVMediaType codec_type;
 } OMXPacket;
 
@@ -80,6 +127,27 @@ enum OMXStreamType
   OMXSTREAM_SUBTITLE  = 3
 };
 
+// the codec fields COMXStreamInfo is built from, compared on every packet
+// so the hints are only rebuilt when the demuxer changed them
+typedef struct OMXHintsKey
+{
+  int         codec_id;
+  int         channels;
+  int         sample_rate;
+  int         block_align;
+  int         bits_per_coded_sample;
+  int         width;
+  int         height;
+  int         profile;
+  int         extradata_size;
+  uint8_t     *extradata;
+  int64_t     bit_rate;
+  AVRational  r_frame_rate;
+  AVRational  avg_frame_rate;
+  AVRational  sample_aspect_ratio;
+  AVRational  codec_sample_aspect_ratio;
+} OMXHintsKey;
+
 typedef struct OMXStream
 {
   char language[4];
@@ -92,8 +160,33 @@ typedef struct OMXStream
   unsigned int extrasize;
   unsigned int index;
   COMXStreamInfo hints;
+  unsigned int hints_id;
+  OMXHintsKey hints_key;
 } OMXStream;
 
+// keyframe spacing and bitrate of a video stream, over the GOPs read since the file was opened
+typedef struct OMXGopStats
+{
+  unsigned int gops;          // complete ones, from a keyframe to the next
+  unsigned int frames;        // pictures in them
+  double       interval;      // seconds between their keyframes, added up
+  double       interval_max;
+  double       bytes;         // in them
+  double       bitrate_max;   // bits per second of the densest one
+  unsigned int frame_types[OMX_FRAME_TYPES];
+  unsigned int nonref;        // pictures nothing else is predicted from
+  unsigned int key_unflagged; // random access points the container did not flag
+  unsigned int key_rejected;  // flagged by the container, but no random access point
+} OMXGopStats;
+
+// the GOP being read on a stream
+typedef struct OMXGopState
+{
+  double       start;         // keyframe timestamp, DVD_NOPTS_VALUE before the first one
+  unsigned int frames;
+  double       bytes;
+} OMXGopState;
+
 class OMXReader
 {
 protected:
@@ -111,6 +204,10 @@ protected:
   bool                      m_bMatroska;
   bool                      m_bAVI;
   XFILE::CFile              *m_pFile;
+  unsigned int              m_cache_size;
+  OMXSeekIndex              m_seek_index;
+  OMXProbeCache             m_probe_cache;
+  int                       m_seek_index_stream;
   AVFormatContext           *m_pFormatContext;
   AVIOContext               *m_ioContext;
   bool                      m_eof;
@@ -119,14 +216,69 @@ protected:
   int                       m_chapter_count;
   double                    m_iCurrentPts;
   int                       m_speed;
+  // trickplay: only video keyframes are returned, spaced by the speed
+  bool                      m_keyframe_hop;
+  int64_t                   m_hop_last;   // pts of the last keyframe returned
+  int64_t                   m_hop_target; // the next keyframe should be at or past this
+  int64_t                   m_hop_seek;   // seek due before the next read
+  bool                      m_hop_start;  // rewind reached the start of the file
   unsigned int              m_program;
+  unsigned int              m_discard_count;
+  int64_t                   m_discard_rate;
+  unsigned int              m_discard_unknown; // discarded streams without a nominal bitrate
   pthread_mutex_t           m_lock;
+  std::vector<COMXStreamInfo> m_hints;
+  unsigned int              m_hints_base;
+  double                    m_time_offset;
+  // seamless loop: at the end the file wraps to m_loop_from and the timeline goes on
+  bool                      m_loop;
+  int64_t                   m_loop_from;    // AV_TIME_BASE
+  double                    m_loop_end;     // end of the packets read, on the continued timeline
+  bool                      m_loop_rebase;  // the next timestamp starts a new iteration
+  bool                      m_loop_discontinuity;
+  unsigned int              m_loop_count;
+  // the first GOP of the loop is replayed from memory while the demuxer seeks past it
+  OMXLoopCacheState         m_loop_cache_state;
+  std::vector<OMXPacket *>  m_loop_cache;
+  unsigned int              m_loop_cache_size;
+  unsigned int              m_loop_cache_keyframes;
+  size_t                    m_loop_replay;  // next cached packet to hand out
+  int64_t                   m_loop_resume;  // AV_TIME_BASE, the keyframe after the cached GOP
+  bool                      m_loop_skip;    // drop what the cache already delivered
+  double                    m_loop_cached_ts[MAX_STREAMS];
+  unsigned int              m_loop_cache_wraps;
+  pthread_mutex_t           m_hints_lock;
+  // verifies keyframes and tells frame types apart on video packets
+  CBitstreamConverter       m_parser;
+  // the stream and hints version whose extradata m_parser compares parameter sets with
+  int                       m_param_set_stream;
+  unsigned int              m_param_set_hints;
+  std::atomic<unsigned int> m_param_sets[PARAM_SET_EVENTS];
+  OMXGopStats               m_gop_stats[MAX_STREAMS];
+  OMXGopState               m_gop_state[MAX_STREAMS];
+  pthread_mutex_t           m_gop_lock;
   double                    m_aspect;
   int                       m_width;
   int                       m_height;
   void Lock();
   void UnLock();
   bool SetActiveStreamInternal(OMXStreamType type, unsigned int index);
+  void UpdateDiscard();
+  // what the playback speed lets through on the streams that are kept
+  AVDiscard SpeedDiscard();
+  int  SeekInternal(int64_t seek_pts, bool backwords);
+  void ResetHop();
+  bool HopAccept(OMXPacket *pkt, AVPacket *av_pkt, AVStream *stream);
+  unsigned int UpdateHints(AVStream *stream, OMXStream &omx_stream);
+  bool LoopWrap();
+  void LoopRecord(OMXPacket *pkt, bool keyframe, int64_t pts);
+  void LoopRebase(OMXPacket *pkt);
+  void ClearLoopCache();
+  void ClassifyPacket(OMXPacket *pkt, AVPacket *av_pkt, AVStream *stream);
+  // counts what the in-band parameter sets of an H.264 packet were and flags them on it
+  void TrackParamSets(OMXPacket *pkt, const h264_picture_info &info);
+  // a seek or wrap leaves the GOPs being read incomplete, all resets the totals too
+  void RestartGops(bool all);
   bool                      m_seek;
 private:
 public:
@@ -144,10 +296,13 @@ public:
   void AddStream(int id);
   bool IsActive(int stream_index);
   bool IsActive(OMXStreamType type, int stream_index);
+  // stream_index of the packets of the active stream of type, -1 without one
+  int GetActiveStreamId(OMXStreamType type);
   double SelectAspect(AVStream* st, bool& forced);
   bool GetHints(AVStream *stream, COMXStreamInfo *hints);
   bool GetHints(OMXStreamType type, unsigned int index, COMXStreamInfo &hints);
   bool GetHints(OMXStreamType type, COMXStreamInfo &hints);
+  bool GetPacketHints(unsigned int hints_id, COMXStreamInfo &hints);
   bool IsEof();
   int  AudioStreamCount() { return m_audio_count; };
   int  VideoStreamCount() { return m_video_count; };
@@ -160,7 +315,24 @@ public:
   OMXChapter GetChapter(unsigned int chapter) { return m_chapters[(chapter > MAX_OMX_CHAPTERS) ? MAX_OMX_CHAPTERS : chapter]; };
   static void FreePacket(OMXPacket *pkt);
   static OMXPacket *AllocPacket(int size);
+  static OMXPacket *AllocPacket(AVPacket *pkt);
+  // copy owning its data
+  static OMXPacket *ClonePacket(OMXPacket *pkt);
+  // release callback for a packet data reference handed to COMXCoreComponent::LendInputBuffer
+  static void UnrefPacketData(void *ref);
   void SetSpeed(int iSpeed);
+  // rewind ran into the start of the file, nothing is read until the speed changes or a seek
+  bool IsTrickplayStart() { return m_hop_start; };
+  // added to every timestamp read, so a file played after another continues its timeline
+  void SetTimeOffset(double offset) { m_time_offset = offset; };
+  double GetTimeOffset() { return m_time_offset; };
+  // wrap to from_ms at the end instead of reporting eof, keep_gop replays the first GOP from memory
+  void SetLoop(bool loop, int from_ms = 0, bool keep_gop = false);
+  unsigned int GetLoopCount() { return m_loop_count; };
+  unsigned int GetLoopCacheCount() { return m_loop_cache_wraps; };
+  // for the video stream at index
+  bool GetGopStats(unsigned int index, OMXGopStats *stats);
+  unsigned int GetParamSets(EParamSetEvent event) { return m_param_sets[event]; };
   void UpdateCurrentPTS();
   double ConvertTimestamp(int64_t pts, int den, int num);
   int GetChapter();
@@ -187,5 +359,13 @@ public:
   std::string GetStreamName(OMXStreamType type, unsigned int index);
   std::string GetStreamType(OMXStreamType type, unsigned int index);
   bool CanSeek();
+  bool GetCacheStatus(XFILE::SCacheStatus *status);
+  void OpenSeekIndex();
+  void SetCacheSize(unsigned int size) { m_cache_size = size; };
+  unsigned int GetDiscardCount() { return m_discard_count; };
+  // estimated bytes per second the demuxer skips for inactive streams, from their
+  // nominal bitrates, streams without one are left out and counted separately
+  int64_t GetDiscardRate() { return m_discard_rate; };
+  unsigned int GetDiscardUnknown() { return m_discard_unknown; };
 };
 #endif
@@ -0,0 +1,367 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXReaderThread.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "utils/log.h"
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+OMXReaderThread::OMXReaderThread()
+{
+  m_reader        = NULL;
+  m_cached_size   = 0;
+  m_max_size      = READAHEAD_MAX_SIZE;
+  m_max_duration  = READAHEAD_MAX_DURATION;
+  m_front_dts     = DVD_NOPTS_VALUE;
+  m_back_dts      = DVD_NOPTS_VALUE;
+  m_generation    = 0;
+  m_open          = false;
+  m_bAbort        = false;
+  m_wakeup        = NULL;
+  m_bytes         = 0;
+  m_read_time     = 0;
+  m_stall_time    = 0;
+  m_stall_start   = 0;
+
+  pthread_mutex_init(&m_lock, NULL);
+  pthread_mutex_init(&m_read_lock, NULL);
+  pthread_cond_init(&m_cond, NULL);
+}
+
+OMXReaderThread::~OMXReaderThread()
+{
+  Close();
+
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_read_lock);
+  pthread_mutex_destroy(&m_lock);
+}
+
+void OMXReaderThread::Lock()
+{
+  pthread_mutex_lock(&m_lock);
+}
+
+void OMXReaderThread::UnLock()
+{
+  pthread_mutex_unlock(&m_lock);
+}
+
+bool OMXReaderThread::Open(OMXReader *reader, unsigned int max_size, double max_duration)
+{
+  if(!reader)
+    return false;
+
+  if(ThreadHandle())
+    Close();
+
+  m_reader        = reader;
+  m_max_size      = max_size;
+  m_max_duration  = max_duration;
+  m_cached_size   = 0;
+  m_front_dts     = DVD_NOPTS_VALUE;
+  m_back_dts      = DVD_NOPTS_VALUE;
+  m_bAbort        = false;
+  m_bytes         = 0;
+  m_read_time     = 0;
+  m_stall_time    = 0;
+  m_stall_start   = 0;
+
+  Create();
+
+  m_open          = true;
+
+  return true;
+}
+
+void OMXReaderThread::Close()
+{
+  if(ThreadHandle())
+  {
+    Lock();
+    m_bAbort = true;
+    pthread_cond_broadcast(&m_cond);
+    UnLock();
+
+    StopThread();
+  }
+
+  Lock();
+  FlushInternal();
+  UnLock();
+
+  m_reader  = NULL;
+  m_open    = false;
+}
+
+bool OMXReaderThread::IsFull()
+{
+  if(m_cached_size >= m_max_size)
+    return true;
+
+  if(m_front_dts != DVD_NOPTS_VALUE && m_back_dts != DVD_NOPTS_VALUE &&
+     m_back_dts - m_front_dts >= m_max_duration)
+    return true;
+
+  return false;
+}
+
+void OMXReaderThread::Process()
+{
+  while(true)
+  {
+    Lock();
+    while(!(m_bStop || m_bAbort) && (IsFull() || m_reader->IsEof() || m_reader->IsTrickplayStart()))
+      pthread_cond_wait(&m_cond, &m_lock);
+
+    if(m_bStop || m_bAbort)
+    {
+      UnLock();
+      break;
+    }
+    UnLock();
+
+    // not held while waiting above, a seek flushing a full queue would never get it
+    pthread_mutex_lock(&m_read_lock);
+
+    // a flush while we are reading makes the packet stale
+    Lock();
+    unsigned int generation = m_generation;
+    UnLock();
+
+    int64_t start = CurrentHostCounter();
+    OMXPacket *pkt = m_reader->Read();
+    int64_t elapsed = CurrentHostCounter() - start;
+
+    Lock();
+    m_read_time += elapsed;
+    if(pkt && generation != m_generation)
+    {
+      OMXReader::FreePacket(pkt);
+    }
+    else if(pkt)
+    {
+      double dts = pkt->dts != DVD_NOPTS_VALUE ? pkt->dts : pkt->pts;
+      if(dts != DVD_NOPTS_VALUE)
+      {
+        if(m_front_dts == DVD_NOPTS_VALUE)
+          m_front_dts = dts;
+        m_back_dts = dts;
+      }
+      m_cached_size += pkt->size;
+      m_bytes += pkt->size;
+      m_packets.push_back(pkt);
+    }
+    UnLock();
+    pthread_mutex_unlock(&m_read_lock);
+
+    if(m_wakeup)
+      m_wakeup->Signal();
+  }
+}
+
+void OMXReaderThread::FlushInternal()
+{
+  while(!m_packets.empty())
+  {
+    OMXPacket *pkt = m_packets.front();
+    m_packets.pop_front();
+    OMXReader::FreePacket(pkt);
+  }
+  m_cached_size = 0;
+  m_front_dts   = DVD_NOPTS_VALUE;
+  m_back_dts    = DVD_NOPTS_VALUE;
+  m_stall_start = 0;
+  m_generation++;
+}
+
+void OMXReaderThread::FlushStream(int stream_index)
+{
+  std::deque<OMXPacket *> keep;
+  unsigned int dropped = 0;
+
+  m_front_dts = DVD_NOPTS_VALUE;
+  m_back_dts  = DVD_NOPTS_VALUE;
+  while(!m_packets.empty())
+  {
+    OMXPacket *pkt = m_packets.front();
+    m_packets.pop_front();
+    if(pkt->stream_index == stream_index)
+    {
+      m_cached_size -= pkt->size;
+      OMXReader::FreePacket(pkt);
+      dropped++;
+      continue;
+    }
+    double dts = pkt->dts != DVD_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if(dts != DVD_NOPTS_VALUE)
+    {
+      if(m_front_dts == DVD_NOPTS_VALUE)
+        m_front_dts = dts;
+      m_back_dts = dts;
+    }
+    keep.push_back(pkt);
+  }
+  m_packets.swap(keep);
+
+  if(dropped)
+    CLog::Log(LOGDEBUG, "OMXReaderThread::FlushStream dropped %u packets of stream %d", dropped, stream_index);
+}
+
+void OMXReaderThread::Flush()
+{
+  Lock();
+  FlushInternal();
+  pthread_cond_broadcast(&m_cond);
+  UnLock();
+}
+
+OMXPacket *OMXReaderThread::Read()
+{
+  OMXPacket *pkt = NULL;
+
+  Lock();
+  if(!m_packets.empty())
+  {
+    pkt = m_packets.front();
+    m_packets.pop_front();
+    m_cached_size -= pkt->size;
+
+    double dts = pkt->dts != DVD_NOPTS_VALUE ? pkt->dts : pkt->pts;
+    if(dts != DVD_NOPTS_VALUE)
+      m_front_dts = dts;
+    if(m_packets.empty())
+      m_front_dts = m_back_dts = DVD_NOPTS_VALUE;
+
+    if(m_stall_start)
+    {
+      m_stall_time += CurrentHostCounter() - m_stall_start;
+      m_stall_start = 0;
+    }
+    pthread_cond_broadcast(&m_cond);
+  }
+  else if(m_reader && !m_reader->IsEof() && !m_stall_start)
+  {
+    m_stall_start = CurrentHostCounter();
+  }
+  UnLock();
+
+  return pkt;
+}
+
+bool OMXReaderThread::IsEof()
+{
+  bool eof;
+
+  Lock();
+  eof = m_packets.empty() && (!m_reader || m_reader->IsEof());
+  UnLock();
+
+  return eof;
+}
+
+bool OMXReaderThread::SeekTime(int time, bool backwords, double *startpts)
+{
+  if(!m_reader)
+    return false;
+
+  // waits for an ongoing read to be queued, the flush afterwards drops
+  // anything that was read before the seek
+  pthread_mutex_lock(&m_read_lock);
+  bool ret = m_reader->SeekTime(time, backwords, startpts);
+  if(ret)
+    Flush();
+  pthread_mutex_unlock(&m_read_lock);
+
+  return ret;
+}
+
+bool OMXReaderThread::SeekChapter(int chapter, double *startpts)
+{
+  if(!m_reader)
+    return false;
+
+  pthread_mutex_lock(&m_read_lock);
+  bool ret = m_reader->SeekChapter(chapter, startpts);
+  if(ret)
+    Flush();
+  pthread_mutex_unlock(&m_read_lock);
+
+  return ret;
+}
+
+bool OMXReaderThread::SetActiveStream(OMXStreamType type, unsigned int index)
+{
+  if(!m_reader)
+    return false;
+
+  // like a seek, an ongoing read is queued first, then the packets read ahead
+  // for the stream switched away from are dropped
+  pthread_mutex_lock(&m_read_lock);
+  int old_stream = m_reader->GetActiveStreamId(type);
+  bool ret = m_reader->SetActiveStream(type, index);
+  if(old_stream >= 0 && old_stream != m_reader->GetActiveStreamId(type))
+  {
+    Lock();
+    FlushStream(old_stream);
+    pthread_cond_broadcast(&m_cond);
+    UnLock();
+  }
+  pthread_mutex_unlock(&m_read_lock);
+
+  return ret;
+}
+
+void OMXReaderThread::SetSpeed(int iSpeed)
+{
+  if(!m_reader)
+    return;
+
+  m_reader->SetSpeed(iSpeed);
+
+  // leaving trickplay at the start of the file has to wake the reading up again
+  Lock();
+  pthread_cond_broadcast(&m_cond);
+  UnLock();
+}
+
+double OMXReaderThread::GetThroughput()
+{
+  if(!m_read_time)
+    return 0.0;
+
+  return (double)m_bytes * 1e9 / m_read_time;
+}
@@ -0,0 +1,92 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_READERTHREAD_H_
+#define _OMX_READERTHREAD_H_
+
+#include "OMXReader.h"
+#include "OMXClock.h"
+#include "OMXThread.h"
+#include "OMXWakeup.h"
+
+#include <deque>
+#include <atomic>
+#include <sys/types.h>
+
+// read-ahead limits, whichever is reached first stops the demuxer
+#define READAHEAD_MAX_SIZE      (4 * 1024 * 1024)
+#define READAHEAD_MAX_DURATION  (2.0 * DVD_TIME_BASE)
+
+// Demuxes on its own thread into a bounded queue so a slow read does not
+// stall the control loop. Seeks and stream changes must go through here
+// so that packets read ahead of them are dropped.
+class OMXReaderThread : public OMXThread
+{
+protected:
+  OMXReader                 *m_reader;
+  std::deque<OMXPacket *>   m_packets;
+  pthread_mutex_t           m_lock;
+  pthread_cond_t            m_cond;
+  // held across a demuxer read and across a seek with its flush, so a packet
+  // is either read before the seek and flushed or read after it and kept
+  pthread_mutex_t           m_read_lock;
+  std::atomic<unsigned int> m_cached_size;
+  unsigned int              m_max_size;
+  double                    m_max_duration;
+  double                    m_front_dts;
+  double                    m_back_dts;
+  unsigned int              m_generation;
+  bool                      m_open;
+  bool                      m_bAbort;
+  OMXWakeup                 *m_wakeup;
+
+  // statistics
+  uint64_t                  m_bytes;
+  int64_t                   m_read_time;
+  int64_t                   m_stall_time;
+  int64_t                   m_stall_start;
+
+  void Lock();
+  void UnLock();
+  bool IsFull();
+  void FlushInternal();
+  void FlushStream(int stream_index);
+public:
+  OMXReaderThread();
+  ~OMXReaderThread();
+  bool Open(OMXReader *reader, unsigned int max_size = READAHEAD_MAX_SIZE, double max_duration = READAHEAD_MAX_DURATION);
+  void Close();
+  void Process();
+  void Flush();
+  OMXPacket *Read();
+  bool IsEof();
+  bool SeekTime(int time, bool backwords, double *startpts);
+  bool SeekChapter(int chapter, double *startpts);
+  bool SetActiveStream(OMXStreamType type, unsigned int index);
+  void SetSpeed(int iSpeed);
+  // signalled after every demuxer read
+  void SetWakeup(OMXWakeup *wakeup) { m_wakeup = wakeup; };
+  unsigned int GetCached() { return m_cached_size; };
+  double GetThroughput();
+  double GetStallTime() { return m_stall_time * 1e-9; };
+  uint64_t GetBytes() { return m_bytes; };
+};
+#endif
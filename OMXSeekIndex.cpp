@@ -0,0 +1,167 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXSeekIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "utils/log.h"
+
+#define OMX_SEEK_INDEX_MAGIC    "OMXIDX01"
+
+static bool EntryBefore(const OMXSeekIndexEntry &entry, int64_t pts)
+{
+  return entry.pts < pts;
+}
+
+OMXSeekIndex::OMXSeekIndex()
+{
+  m_open  = false;
+  m_dirty = false;
+}
+
+OMXSeekIndex::~OMXSeekIndex()
+{
+  Close();
+}
+
+bool OMXSeekIndex::Open(const std::string &filename)
+{
+  Close();
+
+  if(!m_cache.Open(filename, "index", OMX_SEEK_INDEX_MAGIC))
+    return false;
+
+  m_open  = true;
+  m_dirty = false;
+
+  if(Load())
+    CLog::Log(LOGDEBUG, "OMXSeekIndex::Open - loaded %d keyframes from %s", (int)m_entries.size(), m_cache.GetPath().c_str());
+
+  return true;
+}
+
+void OMXSeekIndex::Close()
+{
+  if(m_open && m_dirty)
+    Save();
+
+  m_entries.clear();
+  m_cache = OMXCacheFile();
+  m_open  = false;
+  m_dirty = false;
+}
+
+void OMXSeekIndex::Add(int64_t pts, int64_t pos)
+{
+  if(!m_open || pos < 0)
+    return;
+
+  std::vector<OMXSeekIndexEntry>::iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), pts, EntryBefore);
+
+  if(it != m_entries.end() && it->pts - pts < OMX_SEEK_INDEX_SPACING)
+    return;
+  if(it != m_entries.begin() && pts - (it - 1)->pts < OMX_SEEK_INDEX_SPACING)
+    return;
+
+  OMXSeekIndexEntry entry = { pts, pos };
+  m_entries.insert(it, entry);
+  m_dirty = true;
+}
+
+bool OMXSeekIndex::Lookup(int64_t pts, bool backwords, int64_t *pos)
+{
+  if(!m_open || m_entries.size() < 2)
+    return false;
+
+  // past the indexed range the demuxer knows better
+  if(pts < m_entries.front().pts || pts > m_entries.back().pts)
+    return false;
+
+  std::vector<OMXSeekIndexEntry>::iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), pts, EntryBefore);
+
+  if(backwords && it->pts > pts)
+    it--;
+
+  // only played stretches are indexed, an entry far from pts may lie across
+  // a part that was skipped and hold keyframes the index never saw
+  if(llabs(it->pts - pts) > 2 * OMX_SEEK_INDEX_SPACING)
+    return false;
+
+  *pos = it->pos;
+  return true;
+}
+
+bool OMXSeekIndex::Load()
+{
+  FILE *fp = m_cache.OpenRead();
+  if(!fp)
+    return false;
+
+  bool ret = false;
+  uint32_t count;
+  struct stat st;
+
+  // a corrupt count must not allocate more than the file could hold
+  if(fread(&count, sizeof(count), 1, fp) == 1 && fstat(fileno(fp), &st) == 0 &&
+     (int64_t)count * (int64_t)sizeof(OMXSeekIndexEntry) <= (int64_t)st.st_size - ftell(fp))
+  {
+    m_entries.resize(count);
+    ret = count == 0 || fread(&m_entries[0], sizeof(OMXSeekIndexEntry), count, fp) == count;
+  }
+
+  fclose(fp);
+
+  if(!ret)
+    m_entries.clear();
+
+  return ret;
+}
+
+bool OMXSeekIndex::Save()
+{
+  if(m_entries.size() < 2)
+    return false;
+
+  FILE *fp = m_cache.OpenWrite();
+  if(!fp)
+    return false;
+
+  uint32_t count = m_entries.size();
+  bool ret = fwrite(&count, sizeof(count), 1, fp) == 1 &&
+             fwrite(&m_entries[0], sizeof(OMXSeekIndexEntry), count, fp) == count;
+
+  if(!m_cache.CloseWrite(fp, ret))
+    return false;
+
+  CLog::Log(LOGDEBUG, "OMXSeekIndex::Save - wrote %d keyframes to %s", (int)count, m_cache.GetPath().c_str());
+  m_dirty = false;
+  return true;
+}
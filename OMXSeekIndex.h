@@ -0,0 +1,64 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_SEEKINDEX_H_
+#define _OMX_SEEKINDEX_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "OMXCacheFile.h"
+
+// keyframes closer than this (in microseconds) to an existing entry are not indexed
+#define OMX_SEEK_INDEX_SPACING  500000
+
+typedef struct OMXSeekIndexEntry
+{
+  int64_t pts;  // AV_TIME_BASE units, not corrected for the stream start time
+  int64_t pos;  // byte offset of the keyframe packet
+} OMXSeekIndexEntry;
+
+// Keyframe index for containers that can only seek by bisection or
+// scanning. It is built while playing and kept in the user's cache
+// directory.
+class OMXSeekIndex
+{
+public:
+  OMXSeekIndex();
+  ~OMXSeekIndex();
+  bool Open(const std::string &filename);
+  void Close();
+  bool IsOpen() { return m_open; };
+  void Add(int64_t pts, int64_t pos);
+  // false unless an entry lies within 2 * OMX_SEEK_INDEX_SPACING of pts
+  bool Lookup(int64_t pts, bool backwords, int64_t *pos);
+  size_t Size() { return m_entries.size(); };
+protected:
+  bool Load();
+  bool Save();
+
+  OMXCacheFile                    m_cache;
+  std::vector<OMXSeekIndexEntry>  m_entries;
+  bool                            m_open;
+  bool                            m_dirty;
+};
+#endif
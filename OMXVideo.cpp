@@ -61,11 +61,14 @@ COMXVideo::COMXVideo() : m_video_codec_name("")
   m_is_open           = false;
   m_deinterlace       = false;
   m_drop_state        = false;
+  m_start_pts         = DVD_NOPTS_VALUE;
+  m_discontinuity     = false;
   m_omx_clock         = NULL;
   m_av_clock          = NULL;
   m_submitted_eos     = false;
   m_failed_eos        = false;
   m_settings_changed  = false;
+  m_port_settings_count = 0;
   m_setStartTime      = false;
   m_transform         = OMX_DISPLAY_ROT0;
   m_pixel_aspect      = 1.0f;
@@ -143,6 +146,8 @@ bool COMXVideo::PortSettingsChanged()
   CSingleLock lock (m_critSection);
   OMX_ERRORTYPE omx_err   = OMX_ErrorNone;
 
+  m_port_settings_count++;
+
   if (m_settings_changed)
   {
     m_omx_decoder.DisablePort(m_omx_decoder.GetOutputPort(), true);
@@ -613,7 +618,8 @@ bool COMXVideo::Open(OMXClock *clock, const OMXVideoConfig &config)
   }
 
   // Alloc buffers for the omx intput port.
-  omx_err = m_omx_decoder.AllocInputBuffers();
+  // with direct input the packets are handed over by pointer, so the port needs client buffers
+  omx_err = m_omx_decoder.AllocInputBuffers(m_config.direct_input);
   if (omx_err != OMX_ErrorNone)
   {
     CLog::Log(LOGERROR, "COMXVideo::Open AllocOMXInputBuffers error (0%08x)\n", omx_err);
@@ -631,6 +637,8 @@ bool COMXVideo::Open(OMXClock *clock, const OMXVideoConfig &config)
 
   m_is_open           = true;
   m_drop_state        = false;
+  m_start_pts         = DVD_NOPTS_VALUE;
+  m_discontinuity     = false;
   m_setStartTime      = true;
 
   switch(m_config.hints.orientation)
@@ -702,11 +710,30 @@ void COMXVideo::Close()
   m_av_clock          = NULL;
 }
 
+void COMXVideo::SetStartPts(double pts)
+{
+  CSingleLock lock (m_critSection);
+  m_start_pts = pts;
+}
+
+void COMXVideo::SetDiscontinuity()
+{
+  CSingleLock lock (m_critSection);
+  m_discontinuity = true;
+}
+
 void COMXVideo::SetDropState(bool bDrop)
 {
   m_drop_state = bDrop;
 }
 
+void COMXVideo::SetWakeups(OMXWakeup *space, OMXWakeup *eos)
+{
+  CSingleLock lock (m_critSection);
+  m_omx_decoder.SetInputWakeup(space);
+  m_omx_render.SetEOSWakeup(eos);
+}
+
 unsigned int COMXVideo::GetFreeSpace()
 {
   CSingleLock lock (m_critSection);
@@ -719,7 +746,7 @@ unsigned int COMXVideo::GetSize()
   return m_omx_decoder.GetInputBufferSize();
 }
 
-int COMXVideo::Decode(uint8_t *pData, int iSize, double dts, double pts)
+int COMXVideo::Decode(uint8_t *pData, int iSize, double dts, double pts, AVBufferRef *ref)
 {
   CSingleLock lock (m_critSection);
   OMX_ERRORTYPE omx_err;
@@ -734,12 +761,28 @@ int COMXVideo::Decode(uint8_t *pData, int iSize, double dts, double pts)
   {
     OMX_U32 nFlags = 0;
 
-    if(m_setStartTime)
+    // pictures ahead of an accurate seek target only serve as references,
+    // the clock starts from the first one that is shown. Once that one is
+    // submitted the target is done with, so a later jump back in pts (a
+    // discontinuity, a wrap, a loop) does not hide everything after it.
+    if(m_start_pts != DVD_NOPTS_VALUE && pts != DVD_NOPTS_VALUE)
+    {
+      if(pts < m_start_pts)
+        nFlags |= OMX_BUFFERFLAG_DECODEONLY;
+      else
+        m_start_pts = DVD_NOPTS_VALUE;
+    }
+    if(!(nFlags & OMX_BUFFERFLAG_DECODEONLY) && m_setStartTime)
     {
       nFlags |= OMX_BUFFERFLAG_STARTTIME;
       CLog::Log(LOGDEBUG, "OMXVideo::Decode VDec : setStartTime %f\n", (pts == DVD_NOPTS_VALUE ? 0.0 : pts) / DVD_TIME_BASE);
       m_setStartTime = false;
     }
+    if(m_discontinuity)
+    {
+      nFlags |= OMX_BUFFERFLAG_DISCONTINUITY;
+      m_discontinuity = false;
+    }
     if (pts == DVD_NOPTS_VALUE && dts == DVD_NOPTS_VALUE)
       nFlags |= OMX_BUFFERFLAG_TIME_UNKNOWN;
     else if (pts == DVD_NOPTS_VALUE)
@@ -760,7 +803,17 @@ int COMXVideo::Decode(uint8_t *pData, int iSize, double dts, double pts)
       omx_buffer->nOffset = 0;
       omx_buffer->nTimeStamp = ToOMXTime((uint64_t)(pts != DVD_NOPTS_VALUE ? pts : dts != DVD_NOPTS_VALUE ? dts : 0));
       omx_buffer->nFilledLen = std::min((OMX_U32)demuxer_bytes, omx_buffer->nAllocLen);
-      memcpy(omx_buffer->pBuffer, demuxer_content, omx_buffer->nFilledLen);
+
+      // a packet that fits one buffer is submitted in place, anything split up is copied
+      AVBufferRef *lent = NULL;
+      if(ref && demuxer_content == pData && omx_buffer->nFilledLen == (OMX_U32)iSize)
+        lent = av_buffer_ref(ref);
+      if(!lent || !m_omx_decoder.LendInputBuffer(omx_buffer, demuxer_content, omx_buffer->nFilledLen, OMXReader::UnrefPacketData, lent))
+      {
+        if(lent)
+          av_buffer_unref(&lent);
+        memcpy(omx_buffer->pBuffer, demuxer_content, omx_buffer->nFilledLen);
+      }
 
       demuxer_bytes -= omx_buffer->nFilledLen;
       demuxer_content += omx_buffer->nFilledLen;
@@ -809,6 +862,8 @@ void COMXVideo::Reset(void)
     return;
 
   m_setStartTime      = true;
+  m_start_pts         = DVD_NOPTS_VALUE;
+  m_discontinuity     = false;
   m_omx_decoder.FlushInput();
   if(m_deinterlace || m_config.anaglyph)
     m_omx_image_fx.FlushInput();
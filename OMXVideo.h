@@ -57,6 +57,7 @@ public:
   OMX_IMAGEFILTERANAGLYPHTYPE anaglyph;
   bool hdmi_clock_sync;
   bool allow_mvc;
+  bool direct_input;
   int alpha;
   int aspectMode;
   int display;
@@ -75,6 +76,7 @@ public:
     anaglyph = OMX_ImageFilterAnaglyphNone;
     hdmi_clock_sync = false;
     allow_mvc = false;
+    direct_input = false;
     alpha = 255;
     aspectMode = 0;
     display = 0;
@@ -100,9 +102,15 @@ public:
   void PortSettingsChangedLogger(OMX_PARAM_PORTDEFINITIONTYPE port_image, int interlaceEMode);
   void Close(void);
   unsigned int GetFreeSpace();
+  // lets a player sleep until input space frees up or end of stream is reached
+  void SetWakeups(OMXWakeup *space, OMXWakeup *eos);
   unsigned int GetSize();
-  int  Decode(uint8_t *pData, int iSize, double dts, double pts);
+  int  Decode(uint8_t *pData, int iSize, double dts, double pts, AVBufferRef *ref = NULL);
   void Reset(void);
+  // pictures before pts are decoded but not shown, cleared by Reset
+  void SetStartPts(double pts);
+  // the next picture continues a different file, it is flagged as a discontinuity
+  void SetDiscontinuity();
   void SetDropState(bool bDrop);
   std::string GetDecoderName() { return m_video_codec_name; };
   void SetVideoRect(const CRect& SrcRect, const CRect& DestRect);
@@ -115,9 +123,13 @@ public:
   bool IsEOS();
   bool SubmittedEOS() { return m_submitted_eos; }
   bool BadState() { return m_omx_decoder.BadState(); };
+  // how often the decoder reported new output settings, read from the decoding thread
+  unsigned int GetPortSettingsCount() { return m_port_settings_count; };
 protected:
   // Video format
   bool              m_drop_state;
+  double            m_start_pts;
+  bool              m_discontinuity;
 
   OMX_VIDEO_CODINGTYPE m_codingType;
 
@@ -146,6 +158,7 @@ protected:
   bool              m_failed_eos;
   OMX_DISPLAYTRANSFORMTYPE m_transform;
   bool              m_settings_changed;
+  unsigned int      m_port_settings_count;
   CCriticalSection  m_critSection;
 };
 
@@ -0,0 +1,92 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#if (defined HAVE_CONFIG_H) && (!defined WIN32)
+  #include "config.h"
+#elif defined(_WIN32)
+#include "system.h"
+#endif
+
+#include "OMXWakeup.h"
+
+#include <time.h>
+
+std::atomic<unsigned int> OMXWakeup::s_wakeups(0);
+
+OMXWakeup::OMXWakeup()
+{
+  m_sequence  = 0;
+  m_waiters   = 0;
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&m_cond, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&m_lock, NULL);
+}
+
+OMXWakeup::~OMXWakeup()
+{
+  pthread_cond_destroy(&m_cond);
+  pthread_mutex_destroy(&m_lock);
+}
+
+bool OMXWakeup::Wait(unsigned int sequence, long timeout)
+{
+  if(Sequence() != sequence)
+    return true;
+
+  struct timespec endtime;
+  clock_gettime(CLOCK_MONOTONIC, &endtime);
+  endtime.tv_sec  += timeout / 1000;
+  endtime.tv_nsec += (timeout % 1000) * 1000000;
+  if(endtime.tv_nsec >= 1000000000)
+  {
+    endtime.tv_sec++;
+    endtime.tv_nsec -= 1000000000;
+  }
+
+  bool ret = true;
+
+  pthread_mutex_lock(&m_lock);
+  // pairs with Signal bumping the sequence before it looks for waiters
+  m_waiters.fetch_add(1, std::memory_order_seq_cst);
+  while(ret && Sequence() == sequence)
+    ret = pthread_cond_timedwait(&m_cond, &m_lock, &endtime) == 0;
+  m_waiters.fetch_sub(1, std::memory_order_relaxed);
+  pthread_mutex_unlock(&m_lock);
+
+  s_wakeups.fetch_add(1, std::memory_order_relaxed);
+
+  return ret || Sequence() != sequence;
+}
+
+void OMXWakeup::Signal()
+{
+  m_sequence.fetch_add(1, std::memory_order_seq_cst);
+  if(m_waiters.load(std::memory_order_seq_cst) == 0)
+    return;
+
+  pthread_mutex_lock(&m_lock);
+  pthread_cond_broadcast(&m_cond);
+  pthread_mutex_unlock(&m_lock);
+}
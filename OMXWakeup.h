@@ -0,0 +1,53 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#ifndef _OMX_WAKEUP_H_
+#define _OMX_WAKEUP_H_
+
+#include <pthread.h>
+#include <atomic>
+
+// Lets a thread sleep until another one reports progress (a buffer came
+// back, a queue slot was freed) instead of polling with OMXSleep. Take
+// Sequence() before checking the condition, then Wait() on it, so a
+// Signal() in between is never lost.
+class OMXWakeup
+{
+public:
+  OMXWakeup();
+  ~OMXWakeup();
+  unsigned int Sequence() { return m_sequence.load(std::memory_order_seq_cst); };
+  // returns false when the timeout (in ms) expired without a signal
+  bool Wait(unsigned int sequence, long timeout);
+  void Signal();
+  // number of times any waiter was put to sleep and woken up again
+  static unsigned int GetWakeups() { return s_wakeups.load(std::memory_order_relaxed); };
+private:
+  OMXWakeup(const OMXWakeup&) = delete;
+  OMXWakeup& operator=(const OMXWakeup&) = delete;
+
+  std::atomic<unsigned int>         m_sequence;
+  std::atomic<int>                  m_waiters;
+  pthread_mutex_t                   m_lock;
+  pthread_cond_t                    m_cond;
+  static std::atomic<unsigned int>  s_wakeups;
+};
+#endif
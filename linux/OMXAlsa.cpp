@@ -7,6 +7,10 @@
  * the Free Software Foundation; either version 2, or (at your option)
  * any later version.
  *
+ * Software stand-ins for the Broadcom clock, video_decode, video_scheduler,
+ * video_render, audio_decode, audio_mixer and audio_render components are
+ * built on the same framework, so the player can run without VideoCore.
+ *
  * TODO:
  * - timeouts for state transition failures
  */
@@ -27,6 +31,8 @@ extern "C" {
 #include <libavutil/channel_layout.h>
 #include <libavutil/opt.h>
 #include <libswresample/swresample.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/imgutils.h>
 }
 
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
@@ -115,6 +121,36 @@ static void *gomxq_dequeue(GOMX_QUEUE *q)
 	return item;
 }
 
+static bool gomxq_remove(GOMX_QUEUE *q, void *item)
+{
+	void *prev = 0, *cur;
+	for (cur = q->head; cur; prev = cur, cur = *gomxq_nextptr(q, cur)) {
+		if (cur != item) continue;
+		if (prev) *gomxq_nextptr(q, prev) = *gomxq_nextptr(q, cur);
+		else q->head = *gomxq_nextptr(q, cur);
+		if (q->tail == cur) q->tail = prev;
+		q->num--;
+		return true;
+	}
+	return false;
+}
+
+static void gomx_cond_init(pthread_cond_t *cond)
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+static int64_t gomx_now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 typedef struct _GOMX_COMMAND {
 	void *next;
 	OMX_COMMANDTYPE cmd;
@@ -136,6 +172,9 @@ typedef struct _GOMX_PORT {
 	bool tunnel_supplier;
 	GOMX_QUEUE tunnel_supplierq;
 
+	/* Output ports: empty buffers handed over by the tunnel supplier */
+	GOMX_QUEUE fillq;
+
 	OMX_ERRORTYPE (*do_buffer)(struct _GOMX_COMPONENT *, struct _GOMX_PORT *, OMX_BUFFERHEADERTYPE *);
 	OMX_ERRORTYPE (*flush)(struct _GOMX_COMPONENT *, struct _GOMX_PORT *);
 } GOMX_PORT;
@@ -164,6 +203,19 @@ static GOMX_PORT *gomx_get_port(GOMX_COMPONENT *comp, size_t idx)
 	return &comp->ports[idx];
 }
 
+static void __gomx_wait(GOMX_COMPONENT *comp, pthread_cond_t *cond, long usec)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ts.tv_sec += usec / 1000000;
+	ts.tv_nsec += (usec % 1000000) * 1000;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_nsec -= 1000000000L;
+		ts.tv_sec++;
+	}
+	pthread_cond_timedwait(cond, &comp->mutex, &ts);
+}
+
 OMX_ERRORTYPE gomx_get_component_version(
 		OMX_HANDLETYPE hComponent, OMX_STRING pComponentName,
 		OMX_VERSIONTYPE *pComponentVersion, OMX_VERSIONTYPE *pSpecVersion, OMX_UUIDTYPE *pComponentUUID)
@@ -183,6 +235,7 @@ static OMX_ERRORTYPE gomx_get_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE
 	GOMX_PORT *port;
 	OMX_PORT_PARAM_TYPE *ppt;
 	OMX_PARAM_PORTDEFINITIONTYPE *pdt;
+	OMX_PARAM_BUFFERSUPPLIERTYPE *pbs;
 	OMX_ERRORTYPE r;
 	OMX_PORTDOMAINTYPE domain;
 
@@ -219,6 +272,54 @@ static OMX_ERRORTYPE gomx_get_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE
 		if (!(port = gomx_get_port(comp, pdt->nPortIndex))) return OMX_ErrorBadPortIndex;
 		memcpy(pComponentParameterStructure, &port->def, sizeof *pdt);
 		break;
+	case OMX_IndexParamCompBufferSupplier:
+		if ((r = omx_cast(pbs, pComponentParameterStructure))) return r;
+		if (!(port = gomx_get_port(comp, pbs->nPortIndex))) return OMX_ErrorBadPortIndex;
+		/* Input ports always supply the tunnel buffers */
+		pbs->eBufferSupplier = OMX_BufferSupplyInput;
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nParamIndex, pComponentParameterStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE gomx_set_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	GOMX_PORT *port;
+	OMX_PARAM_PORTDEFINITIONTYPE *pdt;
+	OMX_PARAM_BUFFERSUPPLIERTYPE *pbs;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch (nParamIndex) {
+	case OMX_IndexParamPortDefinition:
+		if ((r = omx_cast(pdt, pComponentParameterStructure))) return r;
+		if (!(port = gomx_get_port(comp, pdt->nPortIndex))) return OMX_ErrorBadPortIndex;
+		if (comp->state != OMX_StateLoaded && port->def.bEnabled)
+			return OMX_ErrorIncorrectStateOperation;
+		if (pdt->nBufferCountActual < port->def.nBufferCountMin)
+			return OMX_ErrorBadParameter;
+
+		pthread_mutex_lock(&comp->mutex);
+		port->def.nBufferCountActual = pdt->nBufferCountActual;
+		if (pdt->nBufferSize) port->def.nBufferSize = pdt->nBufferSize;
+		if (port->def.eDomain == OMX_PortDomainVideo) {
+			port->def.format.video.nFrameWidth = pdt->format.video.nFrameWidth;
+			port->def.format.video.nFrameHeight = pdt->format.video.nFrameHeight;
+		}
+		pthread_mutex_unlock(&comp->mutex);
+		CDEBUG(comp, port, "buffers %u x %u", port->def.nBufferCountActual, port->def.nBufferSize);
+		break;
+	case OMX_IndexParamCompBufferSupplier:
+		if ((r = omx_cast(pbs, pComponentParameterStructure))) return r;
+		if (!(port = gomx_get_port(comp, pbs->nPortIndex))) return OMX_ErrorBadPortIndex;
+		if (pbs->eBufferSupplier != OMX_BufferSupplyInput)
+			return OMX_ErrorNotImplemented;
+		break;
 	default:
 		CINFO(comp, 0, "UNSUPPORTED %x, %p", nParamIndex, pComponentParameterStructure);
 		return OMX_ErrorNotImplemented;
@@ -226,6 +327,24 @@ static OMX_ERRORTYPE gomx_get_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE
 	return OMX_ErrorNone;
 }
 
+static OMX_ERRORTYPE gomx_get_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	CINFO(hComponent, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+	return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE gomx_set_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	CINFO(hComponent, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+	return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE gomx_get_extension_index(OMX_HANDLETYPE hComponent, OMX_STRING cParameterName, OMX_INDEXTYPE *pIndexType)
+{
+	CINFO(hComponent, 0, "UNSUPPORTED '%s', %p", cParameterName, pIndexType);
+	return OMX_ErrorNotImplemented;
+}
+
 static OMX_ERRORTYPE gomx_get_state(OMX_HANDLETYPE hComponent, OMX_STATETYPE *pState)
 {
 	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
@@ -247,6 +366,7 @@ static OMX_ERRORTYPE gomx_component_tunnel_request(
 
 	if (hTunneledComp == 0 || pTunnelSetup == 0) {
 		port->tunnel_comp = 0;
+		port->tunnel_supplier = false;
 		return OMX_ErrorNone;
 	}
 
@@ -289,8 +409,13 @@ static OMX_ERRORTYPE gomx_component_tunnel_request(
 		pTunnelSetup->eSupplier = suppl.eBufferSupplier;
 		CINFO(comp, port, "ComponentTunnnelRequest: %p %d", hTunneledComp, nTunneledPort);
 	} else {
-		CINFO(comp, port, "OUTPUT TUNNEL UNSUPPORTED: %p, %d, %p", hTunneledComp, nTunneledPort, pTunnelSetup);
-		return OMX_ErrorNotImplemented;
+		/* Output ports never supply buffers: the input side allocates
+		 * them and hands them over with FillThisBuffer */
+		port->tunnel_comp = hTunneledComp;
+		port->tunnel_port = nTunneledPort;
+		port->tunnel_supplier = false;
+		pTunnelSetup->eSupplier = OMX_BufferSupplyInput;
+		CINFO(comp, port, "ComponentTunnnelRequest: %p %d", hTunneledComp, nTunneledPort);
 	}
 	return OMX_ErrorNone;
 
@@ -417,8 +542,9 @@ static OMX_ERRORTYPE __gomx_empty_buffer_done(GOMX_COMPONENT *comp, OMX_BUFFERHE
 
 	if (port->tunnel_comp) {
 		/* Buffers are sent to the tunneled port once emptied as long as
-		 * the component is in the OMX_StateExecuting state */
-		if ((comp->state == OMX_StateExecuting && port->def.bEnabled) ||
+		 * the component is in, and stays in, the OMX_StateExecuting state */
+		if ((comp->state == OMX_StateExecuting &&
+		     comp->wanted_state == OMX_StateExecuting && port->def.bEnabled) ||
 		    !port->tunnel_supplier) {
 			pthread_mutex_unlock(&comp->mutex);
 			r = OMX_FillThisBuffer(port->tunnel_comp, hdr);
@@ -447,20 +573,20 @@ static OMX_ERRORTYPE gomx_empty_this_buffer(OMX_HANDLETYPE hComponent, OMX_BUFFE
 	OMX_ERRORTYPE r;
 
 	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
-	if (comp->state != OMX_StatePause && comp->state != OMX_StateExecuting &&
-	    comp->wanted_state != OMX_StateExecuting)
-		return OMX_ErrorIncorrectStateOperation;
 
 	if (!(port = gomx_get_port(comp, pBuffer->nInputPortIndex)))
 		return OMX_ErrorBadPortIndex;
 
 	pthread_mutex_lock(&comp->mutex);
-	if (port->def.bEnabled) {
+	if (port->def.bEnabled &&
+	    (comp->wanted_state == OMX_StateExecuting || comp->wanted_state == OMX_StatePause)) {
 		if (port->do_buffer)
 			r = port->do_buffer(comp, port, pBuffer);
 		else
 			r = __gomx_empty_buffer_done(comp, pBuffer);
 	} else {
+		/* Supplied buffers coming back while the port is disabled or
+		 * the component is leaving the executing state just go home */
 		if (port->tunnel_supplier) {
 			__gomx_port_queue_supplier_buffer(port, pBuffer);
 			r = OMX_ErrorNone;
@@ -472,10 +598,58 @@ static OMX_ERRORTYPE gomx_empty_this_buffer(OMX_HANDLETYPE hComponent, OMX_BUFFE
 	return r;
 }
 
+static OMX_ERRORTYPE __gomx_fill_buffer_done(GOMX_COMPONENT *comp, OMX_BUFFERHEADERTYPE *hdr)
+{
+	GOMX_PORT *port = gomx_get_port(comp, hdr->nOutputPortIndex);
+	OMX_ERRORTYPE r;
+
+	pthread_mutex_unlock(&comp->mutex);
+	if (port->tunnel_comp)
+		r = OMX_EmptyThisBuffer(port->tunnel_comp, hdr);
+	else
+		r = comp->cb.FillBufferDone((OMX_HANDLETYPE) comp, hdr->pAppPrivate, hdr);
+	pthread_mutex_lock(&comp->mutex);
+
+	/* Keep the buffer if the other side did not take it */
+	if (r != OMX_ErrorNone)
+		gomxq_enqueue(&port->fillq, (void *) hdr);
+
+	return r;
+}
+
+static void __gomx_port_return_unfilled(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_BUFFERHEADERTYPE *hdr;
+	size_t n = port->fillq.num;
+
+	/* Each buffer is tried once, refused ones end up back on fillq */
+	while (n-- > 0 && (hdr = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&port->fillq)) != 0) {
+		hdr->nOffset = 0;
+		hdr->nFilledLen = 0;
+		hdr->nFlags = OMX_BUFFERFLAG_DECODEONLY | OMX_BUFFERFLAG_TIME_UNKNOWN;
+		__gomx_fill_buffer_done(comp, hdr);
+	}
+}
+
 static OMX_ERRORTYPE gomx_fill_this_buffer(OMX_HANDLETYPE hComponent, OMX_BUFFERHEADERTYPE* pBuffer)
 {
-	CDEBUG(hComponent, 0, "stub");
-	return OMX_ErrorNotImplemented;
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	GOMX_PORT *port;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	if (!(port = gomx_get_port(comp, pBuffer->nOutputPortIndex)) ||
+	    port->def.eDir != OMX_DirOutput)
+		return OMX_ErrorBadPortIndex;
+
+	pthread_mutex_lock(&comp->mutex);
+	if (port->def.bEnabled && port->do_buffer && comp->state != OMX_StateLoaded)
+		r = port->do_buffer(comp, port, pBuffer);
+	else
+		r = OMX_ErrorIncorrectStateOperation;
+	pthread_mutex_unlock(&comp->mutex);
+	return r;
 }
 
 static void __gomx_process_mark(GOMX_COMPONENT *comp, OMX_BUFFERHEADERTYPE *hdr)
@@ -656,6 +830,10 @@ static OMX_ERRORTYPE gomx_do_set_state(GOMX_COMPONENT *comp, GOMX_COMMAND *cmd)
 			pthread_mutex_lock(&comp->mutex);
 			comp->worker_thread = 0;
 		}
+		for (i = 0; i < comp->nports; i++) {
+			port = &comp->ports[i];
+			if (port->def.bEnabled && port->flush) port->flush(comp, port);
+		}
 		for (i = 0; i < comp->nports; i++) {
 			port = &comp->ports[i];
 			if (!port->tunnel_supplier || !port->def.bEnabled) continue;
@@ -686,10 +864,19 @@ static OMX_ERRORTYPE gomx_do_port_command(GOMX_COMPONENT *comp, GOMX_PORT *port,
 		if (port->flush) r = port->flush(comp, port);
 		break;
 	case OMX_CommandPortEnable:
-		port->def.bEnabled = OMX_TRUE;
-		r = __gomx_port_populate(comp, port);
-		if (r != OMX_ErrorNone)
-			port->def.bEnabled = OMX_FALSE;
+		if (port->tunnel_supplier) {
+			port->def.bEnabled = OMX_TRUE;
+			r = __gomx_port_populate(comp, port);
+			if (r != OMX_ErrorNone)
+				port->def.bEnabled = OMX_FALSE;
+		} else {
+			/* The client or the tunnel supplier allocates buffers
+			 * while the port is still disabled */
+			if (comp->state != OMX_StateLoaded)
+				r = __gomx_port_populate(comp, port);
+			if (r == OMX_ErrorNone)
+				port->def.bEnabled = OMX_TRUE;
+		}
 		break;
 	case OMX_CommandPortDisable:
 		port->def.bEnabled = OMX_FALSE;
@@ -805,6 +992,10 @@ static void gomx_init(GOMX_COMPONENT *comp, const char *name, OMX_PTR pAppData,
 	comp->omx.GetComponentVersion = gomx_get_component_version;
 	comp->omx.SendCommand = gomx_send_command;
 	comp->omx.GetParameter = gomx_get_parameter;
+	comp->omx.SetParameter = gomx_set_parameter;
+	comp->omx.GetConfig = gomx_get_config;
+	comp->omx.SetConfig = gomx_set_config;
+	comp->omx.GetExtensionIndex = gomx_get_extension_index;
 	comp->omx.GetState = gomx_get_state;
 	comp->omx.ComponentTunnelRequest = gomx_component_tunnel_request;
 	comp->omx.UseBuffer = gomx_use_buffer;
@@ -836,6 +1027,7 @@ static void gomx_init(GOMX_COMPONENT *comp, const char *name, OMX_PTR pAppData,
 			port->def.eDir == OMX_DirInput
 			? offsetof(OMX_BUFFERHEADERTYPE, pInputPortPrivate)
 			: offsetof(OMX_BUFFERHEADERTYPE, pOutputPortPrivate));
+		gomxq_init(&port->fillq, offsetof(OMX_BUFFERHEADERTYPE, pOutputPortPrivate));
 	}
 }
 
@@ -1336,20 +1528,1928 @@ static OMX_ERRORTYPE omxalsasink_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppDat
 	return OMX_ErrorNone;
 }
 
-/* OMX Glue to get the handle */
+/* Software stand-in components
+ *
+ * These mimic the Broadcom components closely enough for omxplayer to run
+ * its complete OMX pipeline on hosts without VideoCore. Decoded pictures
+ * are passed downstream by reference: a video buffer carries a pointer to
+ * a GOMX_PICTURE owned by the decoder until the buffer is returned. */
 
-#include <OMXAlsa.h>
+static bool gomx_soft_avcodec;
+static char gomx_soft_video_out[256];
 
-OMX_ERRORTYPE OMXALSA_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OMX_IN OMX_STRING cComponentName,
-				OMX_IN  OMX_PTR pAppData, OMX_IN OMX_CALLBACKTYPE* pCallbacks)
+typedef struct _GOMX_SOFT {
+	GOMX_COMPONENT gcomp;
+	pthread_cond_t cond_work;
+	void (*fini)(struct _GOMX_SOFT *);
+} GOMX_SOFT;
+
+static void gomx_soft_port(GOMX_PORT *port, OMX_U32 idx, OMX_DIRTYPE dir, OMX_PORTDOMAINTYPE domain,
+			   OMX_U32 min_buffers, OMX_U32 num_buffers, OMX_U32 buffer_size)
 {
-	if (strcmp(cComponentName, "OMX.alsa.audio_render") == 0)
-		return omxalsasink_create(pHandle, pAppData, pCallbacks);
+	port->def.nSize = sizeof port->def;
+	port->def.nVersion.nVersion = OMX_VERSION;
+	port->def.nPortIndex = idx;
+	port->def.eDir = dir;
+	port->def.nBufferCountMin = min_buffers;
+	port->def.nBufferCountActual = num_buffers;
+	port->def.nBufferSize = buffer_size;
+	port->def.bEnabled = OMX_TRUE;
+	port->def.eDomain = domain;
+	port->def.nBufferAlignment = 4;
+}
 
-	return OMX_ErrorComponentNotFound;
+static OMX_ERRORTYPE gomx_soft_statechange(GOMX_COMPONENT *comp)
+{
+	GOMX_SOFT *soft = (GOMX_SOFT *) comp;
+	pthread_cond_signal(&soft->cond_work);
+	return OMX_ErrorNone;
 }
 
-OMX_ERRORTYPE OMXALSA_FreeHandle(OMX_IN OMX_HANDLETYPE hComponent)
+static OMX_ERRORTYPE gomx_soft_deinit(OMX_HANDLETYPE hComponent)
 {
-	return ((OMX_COMPONENTTYPE*)hComponent)->ComponentDeInit(hComponent);
+	GOMX_SOFT *soft = (GOMX_SOFT *) hComponent;
+	gomx_fini(&soft->gcomp);
+	if (soft->fini) soft->fini(soft);
+	pthread_cond_destroy(&soft->cond_work);
+	free(soft);
+	return OMX_ErrorNone;
+}
+
+static void gomx_soft_init(GOMX_SOFT *soft, const char *name, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks, GOMX_PORT *ports, size_t nports)
+{
+	gomx_cond_init(&soft->cond_work);
+	gomx_init(&soft->gcomp, name, pAppData, pCallbacks, ports, nports);
+	soft->gcomp.omx.ComponentDeInit = gomx_soft_deinit;
+	soft->gcomp.statechange = gomx_soft_statechange;
+}
+
+/* Output ports keep the buffers to fill on fillq and wake the worker */
+static OMX_ERRORTYPE gomx_soft_fill_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	GOMX_SOFT *soft = (GOMX_SOFT *) comp;
+	gomxq_enqueue(&port->fillq, (void *) buf);
+	pthread_cond_signal(&soft->cond_work);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE gomx_soft_fill_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	__gomx_port_return_unfilled(comp, port);
+	return OMX_ErrorNone;
+}
+
+typedef struct _GOMX_PICTURE {
+	void *next;
+	AVFrame *frame;
+	uint8_t *data;
+	size_t size;
+	OMX_U32 flags;
+	OMX_TICKS ts;
+} GOMX_PICTURE;
+
+static void gomx_picture_free(GOMX_PICTURE *pic)
+{
+	if (pic->frame) av_frame_free(&pic->frame);
+	free(pic->data);
+	free(pic);
+}
+
+static GOMX_PICTURE *gomx_picture_get(OMX_BUFFERHEADERTYPE *buf)
+{
+	GOMX_PICTURE *pic;
+	if (buf->nFilledLen != sizeof pic) return 0;
+	memcpy(&pic, buf->pBuffer + buf->nOffset, sizeof pic);
+	return pic;
+}
+
+/* Clock */
+
+#define SOFTCLOCK_PORTS			6
+
+typedef struct _OMX_SOFTCLOCK {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[SOFTCLOCK_PORTS];
+	OMX_TIME_CLOCKSTATE state;
+	OMX_TIME_REFCLOCKTYPE ref_clock;
+	OMX_U32 wait_mask, start_mask;
+	int64_t start_time[SOFTCLOCK_PORTS];
+	int64_t offset;
+	int32_t scale;
+	int64_t media_anchor, wall_anchor;
+	OMX_U32 step_count;
+	unsigned int update_seq, sent_seq[SOFTCLOCK_PORTS];
+} OMX_SOFTCLOCK;
+
+static int64_t omxsoftclock_media_time(OMX_SOFTCLOCK *clk)
+{
+	if (clk->state != OMX_TIME_ClockStateRunning)
+		return clk->media_anchor;
+	return clk->media_anchor + (((gomx_now_us() - clk->wall_anchor) * clk->scale) >> 16);
+}
+
+static void omxsoftclock_anchor(OMX_SOFTCLOCK *clk, int64_t media_time)
+{
+	clk->media_anchor = media_time;
+	clk->wall_anchor = gomx_now_us();
+}
+
+static OMX_ERRORTYPE omxsoftclock_get_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTCLOCK *clk = (OMX_SOFTCLOCK *) hComponent;
+	OMX_TIME_CONFIG_TIMESTAMPTYPE *tst;
+	OMX_TIME_CONFIG_SCALETYPE *sct;
+	OMX_TIME_CONFIG_CLOCKSTATETYPE *cst;
+	OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE *arc;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nIndex) {
+	case OMX_IndexConfigTimeCurrentMediaTime:
+		if ((r = omx_cast(tst, pComponentConfigStructure))) return r;
+		pthread_mutex_lock(&comp->mutex);
+		tst->nTimestamp = omx_ticks_from_s64(omxsoftclock_media_time(clk));
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	case OMX_IndexConfigClockAdjustment:
+		/* The wall clock is the reference, there is nothing to adjust */
+		if ((r = omx_cast(tst, pComponentConfigStructure))) return r;
+		tst->nTimestamp = omx_ticks_from_s64(0);
+		break;
+	case OMX_IndexConfigTimeScale:
+		if ((r = omx_cast(sct, pComponentConfigStructure))) return r;
+		sct->xScale = clk->scale;
+		break;
+	case OMX_IndexConfigTimeClockState:
+		if ((r = omx_cast(cst, pComponentConfigStructure))) return r;
+		pthread_mutex_lock(&comp->mutex);
+		cst->eState = clk->state;
+		cst->nStartTime = omx_ticks_from_s64(clk->media_anchor);
+		cst->nOffset = omx_ticks_from_s64(clk->offset);
+		cst->nWaitMask = clk->wait_mask;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	case OMX_IndexConfigTimeActiveRefClock:
+		if ((r = omx_cast(arc, pComponentConfigStructure))) return r;
+		arc->eClock = clk->ref_clock;
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftclock_set_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTCLOCK *clk = (OMX_SOFTCLOCK *) hComponent;
+	OMX_TIME_CONFIG_CLOCKSTATETYPE *cst;
+	OMX_TIME_CONFIG_TIMESTAMPTYPE *tst;
+	OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE *arc;
+	OMX_TIME_CONFIG_SCALETYPE *sct;
+	OMX_PARAM_U32TYPE *u32param;
+	OMX_ERRORTYPE r = OMX_ErrorNone;
+	int64_t ts;
+	bool audio;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	pthread_mutex_lock(&comp->mutex);
+	switch ((int) nIndex) {
+	case OMX_IndexConfigTimeClockState:
+		if ((r = omx_cast(cst, pComponentConfigStructure))) break;
+		CDEBUG(comp, 0, "OMX_IndexConfigTimeClockState %d", cst->eState);
+		switch (cst->eState) {
+		case OMX_TIME_ClockStateRunning:
+			omxsoftclock_anchor(clk, omx_ticks_to_s64(cst->nStartTime));
+			break;
+		case OMX_TIME_ClockStateWaitingForStartTime:
+			clk->media_anchor = omxsoftclock_media_time(clk);
+			clk->wait_mask = cst->nWaitMask;
+			clk->start_mask = 0;
+			clk->offset = omx_ticks_to_s64(cst->nOffset);
+			break;
+		default:
+			clk->media_anchor = omxsoftclock_media_time(clk);
+			break;
+		}
+		clk->state = cst->eState;
+		break;
+	case OMX_IndexConfigTimeClientStartTime:
+		if ((r = omx_cast(tst, pComponentConfigStructure))) break;
+		if (clk->state != OMX_TIME_ClockStateWaitingForStartTime ||
+		    tst->nPortIndex >= SOFTCLOCK_PORTS)
+			break;
+		clk->start_time[tst->nPortIndex] = omx_ticks_to_s64(tst->nTimestamp);
+		clk->start_mask |= 1 << tst->nPortIndex;
+		if ((clk->start_mask & clk->wait_mask) != clk->wait_mask)
+			break;
+
+		/* Everybody reported, start from the earliest client */
+		ts = INT64_MAX;
+		for (size_t i = 0; i < SOFTCLOCK_PORTS; i++)
+			if ((clk->wait_mask & (1 << i)) && clk->start_time[i] < ts)
+				ts = clk->start_time[i];
+		omxsoftclock_anchor(clk, ts + clk->offset);
+		clk->state = OMX_TIME_ClockStateRunning;
+		CINFO(comp, 0, "running from %lld", (long long) clk->media_anchor);
+		break;
+	case OMX_IndexConfigTimeCurrentAudioReference:
+	case OMX_IndexConfigTimeCurrentVideoReference:
+		if ((r = omx_cast(tst, pComponentConfigStructure))) break;
+		audio = (nIndex == OMX_IndexConfigTimeCurrentAudioReference);
+		if (clk->state != OMX_TIME_ClockStateRunning || clk->scale == 0 ||
+		    (audio && clk->ref_clock == OMX_TIME_RefClockAudio) ||
+		    (!audio && clk->ref_clock == OMX_TIME_RefClockVideo))
+			omxsoftclock_anchor(clk, omx_ticks_to_s64(tst->nTimestamp));
+		break;
+	case OMX_IndexConfigTimeActiveRefClock:
+		if ((r = omx_cast(arc, pComponentConfigStructure))) break;
+		clk->ref_clock = arc->eClock;
+		break;
+	case OMX_IndexConfigTimeScale:
+		if ((r = omx_cast(sct, pComponentConfigStructure))) break;
+		omxsoftclock_anchor(clk, omxsoftclock_media_time(clk));
+		clk->scale = sct->xScale;
+		CDEBUG(comp, 0, "OMX_IndexConfigTimeScale %x", sct->xScale);
+		break;
+	case OMX_IndexConfigSingleStep:
+		if ((r = omx_cast(u32param, pComponentConfigStructure))) break;
+		clk->step_count += u32param->nU32;
+		break;
+	default:
+		/* Latency targets and such have no meaning here */
+		CDEBUG(comp, 0, "ignored %x", nIndex);
+		break;
+	}
+	if (r == OMX_ErrorNone) {
+		clk->update_seq++;
+		pthread_cond_signal(&clk->soft.cond_work);
+	}
+	pthread_mutex_unlock(&comp->mutex);
+	return r;
+}
+
+static void *omxsoftclock_worker(void *ptr)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) ptr;
+	OMX_SOFTCLOCK *clk = (OMX_SOFTCLOCK *) ptr;
+	OMX_BUFFERHEADERTYPE *buf;
+	OMX_TIME_MEDIATIMETYPE *mt;
+	GOMX_PORT *port;
+	bool sent;
+
+	CINFO(comp, 0, "worker started");
+	pthread_mutex_lock(&comp->mutex);
+	while (comp->wanted_state == OMX_StateExecuting) {
+		/* Push the clock state to every client that has not seen it */
+		sent = false;
+		for (size_t i = 0; i < SOFTCLOCK_PORTS; i++) {
+			port = &comp->ports[i];
+			if (!port->def.bEnabled || !port->tunnel_comp ||
+			    clk->sent_seq[i] == clk->update_seq)
+				continue;
+			if (!(buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&port->fillq)))
+				continue;
+
+			mt = (OMX_TIME_MEDIATIMETYPE *) buf->pBuffer;
+			memset(mt, 0, sizeof *mt);
+			omx_init(*mt);
+			mt->nClientPrivate = clk->step_count;
+			mt->eUpdateType = OMX_TIME_UpdateClockStateChanged;
+			mt->eMediaTimeType = clk->ref_clock;
+			mt->eState = clk->state;
+			mt->nMediaTimestamp = omx_ticks_from_s64(omxsoftclock_media_time(clk));
+			mt->nOffset = omx_ticks_from_s64(clk->offset);
+			mt->nWallTimeAtMediaTime = omx_ticks_from_s64(gomx_now_us());
+			mt->xScale = clk->scale;
+			buf->nOffset = 0;
+			buf->nFilledLen = sizeof *mt;
+			buf->nFlags = 0;
+			clk->sent_seq[i] = clk->update_seq;
+			__gomx_fill_buffer_done(comp, buf);
+			sent = true;
+		}
+		if (!sent)
+			__gomx_wait(comp, &clk->soft.cond_work, 100000);
+	}
+	pthread_mutex_unlock(&comp->mutex);
+	CINFO(comp, 0, "worker stopped");
+	return 0;
+}
+
+static OMX_ERRORTYPE omxsoftclock_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_SOFTCLOCK *clk = (OMX_SOFTCLOCK *) comp;
+	/* A new client gets the current state once it hands over a buffer */
+	clk->sent_seq[port->def.nPortIndex] = clk->update_seq - 1;
+	return gomx_soft_fill_flush(comp, port);
+}
+
+static OMX_ERRORTYPE omxsoftclock_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	OMX_SOFTCLOCK *clk;
+	GOMX_PORT *port;
+
+	clk = (OMX_SOFTCLOCK *) calloc(1, sizeof *clk);
+	if (!clk) return OMX_ErrorInsufficientResources;
+
+	for (size_t i = 0; i < SOFTCLOCK_PORTS; i++) {
+		port = &clk->port_data[i];
+		gomx_soft_port(port, i, OMX_DirOutput, OMX_PortDomainOther, 1, 1, sizeof(OMX_TIME_MEDIATIMETYPE));
+		port->def.format.other.eFormat = OMX_OTHER_FormatTime;
+		port->do_buffer = gomx_soft_fill_do_buffer;
+		port->flush = omxsoftclock_flush;
+	}
+	clk->state = OMX_TIME_ClockStateStopped;
+	clk->ref_clock = OMX_TIME_RefClockNone;
+	clk->scale = 0x10000;
+	clk->update_seq = 1;
+
+	gomx_soft_init(&clk->soft, "OMX.broadcom.clock", pAppData, pCallbacks, clk->port_data, ARRAY_SIZE(clk->port_data));
+	clk->soft.gcomp.omx.GetConfig = omxsoftclock_get_config;
+	clk->soft.gcomp.omx.SetConfig = omxsoftclock_set_config;
+	clk->soft.gcomp.worker = omxsoftclock_worker;
+
+	*pHandle = (OMX_HANDLETYPE) clk;
+	return OMX_ErrorNone;
+}
+
+/* Video decoder */
+
+#define SOFTVDEC_PORT_IN		0
+#define SOFTVDEC_PORT_OUT		1
+
+typedef struct _OMX_SOFTVDEC {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[2];
+	GOMX_QUEUE inq, pics;
+	OMX_VIDEO_CODINGTYPE coding;
+	AVCodecContext *avctx;
+	bool use_avcodec;
+	uint8_t *extradata;
+	size_t extradata_size;
+	/* Access unit gathered from the input buffers */
+	uint8_t *au;
+	size_t au_len, au_size;
+	OMX_U32 au_flags;
+	OMX_TICKS au_ts;
+	bool au_ready, eos_input, eos_pending;
+	bool need_input, start_pending, codec_flush, settings_sent;
+	unsigned int flush_seq;
+	/* Pictures up to this time were sent DECODEONLY and are not output */
+	bool decode_only;
+	int64_t decode_only_ts;
+	AVRational sar;
+	unsigned long frames;
+} OMX_SOFTVDEC;
+
+static enum AVCodecID omxsoftvdec_codec_id(OMX_SOFTVDEC *dec)
+{
+	switch ((int) dec->coding) {
+	case OMX_VIDEO_CodingAVC:
+	case OMX_VIDEO_CodingMVC:
+		return AV_CODEC_ID_H264;
+	case OMX_VIDEO_CodingMPEG4:
+		return AV_CODEC_ID_MPEG4;
+	case OMX_VIDEO_CodingMPEG2:
+		return AV_CODEC_ID_MPEG2VIDEO;
+	case OMX_VIDEO_CodingVP6:
+		return AV_CODEC_ID_VP6;
+	case OMX_VIDEO_CodingVP8:
+		return AV_CODEC_ID_VP8;
+	case OMX_VIDEO_CodingTheora:
+		return AV_CODEC_ID_THEORA;
+	case OMX_VIDEO_CodingMJPEG:
+		return AV_CODEC_ID_MJPEG;
+	case OMX_VIDEO_CodingWMV:
+		/* VC-1 advanced profile extradata starts with a sequence header */
+		if (dec->extradata_size >= 3 && dec->extradata[0] == 0 &&
+		    dec->extradata[1] == 0 && dec->extradata[2] == 1)
+			return AV_CODEC_ID_VC1;
+		return AV_CODEC_ID_WMV3;
+	}
+	return AV_CODEC_ID_NONE;
+}
+
+static bool omxsoftvdec_open(OMX_SOFTVDEC *dec)
+{
+	GOMX_COMPONENT *comp = &dec->soft.gcomp;
+	AVCodec *codec = 0;
+	AVRational tb = { 1, OMX_TICKS_PER_SECOND };
+	enum AVCodecID id;
+
+	id = omxsoftvdec_codec_id(dec);
+	if (id != AV_CODEC_ID_NONE) codec = avcodec_find_decoder(id);
+	if (!codec) {
+		CINFO(comp, 0, "no decoder for coding %x", dec->coding);
+		return false;
+	}
+
+	dec->avctx = avcodec_alloc_context3(codec);
+	if (!dec->avctx) return false;
+	if (dec->extradata_size) {
+		dec->avctx->extradata = (uint8_t *) av_mallocz(dec->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+		if (dec->avctx->extradata) {
+			memcpy(dec->avctx->extradata, dec->extradata, dec->extradata_size);
+			dec->avctx->extradata_size = dec->extradata_size;
+		}
+	}
+	dec->avctx->pkt_timebase = tb;
+	dec->avctx->thread_count = 0;
+	if (avcodec_open2(dec->avctx, codec, 0) < 0) {
+		CINFO(comp, 0, "failed to open %s", codec->name);
+		avcodec_free_context(&dec->avctx);
+		return false;
+	}
+	CINFO(comp, 0, "decoding with %s", codec->name);
+	return true;
+}
+
+static void omxsoftvdec_reset_au(OMX_SOFTVDEC *dec)
+{
+	dec->au_len = 0;
+	dec->au_flags = 0;
+	dec->au_ready = false;
+}
+
+static void omxsoftvdec_gather(OMX_SOFTVDEC *dec, OMX_BUFFERHEADERTYPE *buf)
+{
+	const uint8_t *data = buf->pBuffer + buf->nOffset;
+	size_t len = buf->nFilledLen, size;
+	uint8_t *p;
+
+	if (buf->nFlags & OMX_BUFFERFLAG_CODECCONFIG) {
+		p = (uint8_t *) realloc(dec->extradata, len);
+		if (p || !len) {
+			dec->extradata = p;
+			dec->extradata_size = len;
+			memcpy(dec->extradata, data, len);
+		}
+		/* Stream parameters changed, decoder is reopened */
+		if (dec->avctx) avcodec_free_context(&dec->avctx);
+		return;
+	}
+
+	if (len) {
+		if (!dec->au_len) {
+			dec->au_flags = buf->nFlags;
+			dec->au_ts = buf->nTimeStamp;
+		}
+		size = dec->au_len + len + AV_INPUT_BUFFER_PADDING_SIZE;
+		if (size > dec->au_size) {
+			p = (uint8_t *) realloc(dec->au, size);
+			if (!p) return;
+			dec->au = p;
+			dec->au_size = size;
+		}
+		memcpy(dec->au + dec->au_len, data, len);
+		dec->au_len += len;
+		memset(dec->au + dec->au_len, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+	}
+	if ((buf->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) && dec->au_len)
+		dec->au_ready = true;
+	if (buf->nFlags & OMX_BUFFERFLAG_EOS)
+		dec->eos_input = true;
+}
+
+static GOMX_PICTURE *omxsoftvdec_take_au(OMX_SOFTVDEC *dec)
+{
+	GOMX_PICTURE *pic;
+
+	pic = (GOMX_PICTURE *) calloc(1, sizeof *pic);
+	if (!pic) return 0;
+	pic->data = dec->au;
+	pic->size = dec->au_len;
+	pic->flags = dec->au_flags & (OMX_BUFFERFLAG_STARTTIME | OMX_BUFFERFLAG_TIME_UNKNOWN | OMX_BUFFERFLAG_DISCONTINUITY);
+	pic->ts = dec->au_ts;
+	dec->au = 0;
+	dec->au_size = 0;
+	return pic;
+}
+
+static GOMX_PICTURE *omxsoftvdec_take_frame(OMX_SOFTVDEC *dec, AVFrame *frame)
+{
+	GOMX_PICTURE *pic;
+	int64_t pts;
+
+	pic = (GOMX_PICTURE *) calloc(1, sizeof *pic);
+	if (!pic || !(pic->frame = av_frame_alloc())) {
+		free(pic);
+		av_frame_unref(frame);
+		return 0;
+	}
+	av_frame_move_ref(pic->frame, frame);
+
+	pts = av_frame_get_best_effort_timestamp(pic->frame);
+	if (pts == AV_NOPTS_VALUE) {
+		pic->flags = OMX_BUFFERFLAG_TIME_UNKNOWN;
+		pts = 0;
+	}
+	pic->ts = omx_ticks_from_s64(pts);
+	if (dec->start_pending) {
+		pic->flags |= OMX_BUFFERFLAG_STARTTIME;
+		dec->start_pending = false;
+	}
+	if (pic->frame->sample_aspect_ratio.num)
+		dec->sar = pic->frame->sample_aspect_ratio;
+	return pic;
+}
+
+static void omxsoftvdec_port_settings(OMX_SOFTVDEC *dec, GOMX_PICTURE *pic)
+{
+	GOMX_PORT *in_port = &dec->soft.gcomp.ports[SOFTVDEC_PORT_IN];
+	GOMX_PORT *out_port = &dec->soft.gcomp.ports[SOFTVDEC_PORT_OUT];
+	OMX_U32 width = in_port->def.format.video.nFrameWidth;
+	OMX_U32 height = in_port->def.format.video.nFrameHeight;
+
+	if (pic && pic->frame) {
+		width = pic->frame->width;
+		height = pic->frame->height;
+	}
+	if (!width || !height) width = height = 16;
+
+	out_port->def.format.video.nFrameWidth = width;
+	out_port->def.format.video.nFrameHeight = height;
+	out_port->def.format.video.nStride = width;
+	out_port->def.format.video.nSliceHeight = height;
+	out_port->def.format.video.xFramerate = in_port->def.format.video.xFramerate;
+	dec->settings_sent = true;
+	__gomx_event(&dec->soft.gcomp, OMX_EventPortSettingsChanged, SOFTVDEC_PORT_OUT, 0, 0);
+}
+
+static void *omxsoftvdec_worker(void *ptr)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) ptr;
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) ptr;
+	GOMX_PORT *out_port = &comp->ports[SOFTVDEC_PORT_OUT];
+	OMX_BUFFERHEADERTYPE *buf;
+	GOMX_PICTURE *pic = 0;
+	AVFrame *frame;
+	AVPacket pkt;
+	unsigned int seq;
+	int ret;
+
+	CINFO(comp, 0, "worker started");
+	frame = av_frame_alloc();
+
+	pthread_mutex_lock(&comp->mutex);
+	while (comp->wanted_state == OMX_StateExecuting) {
+		if (dec->codec_flush) {
+			dec->codec_flush = false;
+			if (pic) gomx_picture_free(pic);
+			pic = 0;
+			if (dec->avctx) avcodec_flush_buffers(dec->avctx);
+			dec->need_input = true;
+			continue;
+		}
+
+		/* Hand the decoded picture, or end of stream, downstream */
+		if (pic || dec->eos_pending) {
+			if (!dec->settings_sent) {
+				omxsoftvdec_port_settings(dec, pic);
+				continue;
+			}
+			if (!out_port->def.bEnabled ||
+			    !(buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&out_port->fillq))) {
+				__gomx_wait(comp, &dec->soft.cond_work, 10000);
+				continue;
+			}
+			buf->nOffset = 0;
+			if (pic) {
+				memcpy(buf->pBuffer, &pic, sizeof pic);
+				buf->nFilledLen = sizeof pic;
+				buf->nFlags = pic->flags | OMX_BUFFERFLAG_ENDOFFRAME;
+				buf->nTimeStamp = pic->ts;
+				gomxq_enqueue(&dec->pics, pic);
+				if (__gomx_fill_buffer_done(comp, buf) == OMX_ErrorNone)
+					dec->frames++;
+				else if (gomxq_remove(&dec->pics, pic))
+					gomx_picture_free(pic);
+				pic = 0;
+			} else {
+				CDEBUG(comp, 0, "end-of-stream after %lu frames", dec->frames);
+				buf->nFilledLen = 0;
+				buf->nFlags = OMX_BUFFERFLAG_EOS | OMX_BUFFERFLAG_TIME_UNKNOWN;
+				buf->nTimeStamp = omx_ticks_from_s64(0);
+				dec->eos_pending = false;
+				__gomx_event(comp, OMX_EventBufferFlag, SOFTVDEC_PORT_OUT, buf->nFlags, 0);
+				__gomx_fill_buffer_done(comp, buf);
+			}
+			continue;
+		}
+
+		/* Collect pictures from the decoder */
+		if (dec->avctx && !dec->need_input) {
+			seq = dec->flush_seq;
+			pthread_mutex_unlock(&comp->mutex);
+			ret = avcodec_receive_frame(dec->avctx, frame);
+			pthread_mutex_lock(&comp->mutex);
+			if (seq != dec->flush_seq) {
+				av_frame_unref(frame);
+				continue;
+			}
+			if (ret == 0) {
+				if (dec->decode_only &&
+				    av_frame_get_best_effort_timestamp(frame) != AV_NOPTS_VALUE &&
+				    av_frame_get_best_effort_timestamp(frame) <= dec->decode_only_ts) {
+					av_frame_unref(frame);
+					continue;
+				}
+				pic = omxsoftvdec_take_frame(dec, frame);
+				continue;
+			}
+			if (ret == AVERROR_EOF) {
+				avcodec_flush_buffers(dec->avctx);
+				dec->eos_pending = true;
+			}
+			dec->need_input = true;
+			continue;
+		}
+
+		/* Decode a complete access unit */
+		if (dec->au_ready) {
+			if (dec->au_flags & OMX_BUFFERFLAG_STARTTIME)
+				dec->start_pending = true;
+			if (dec->use_avcodec && !dec->avctx && !omxsoftvdec_open(dec)) {
+				CINFO(comp, 0, "passing compressed frames through");
+				dec->use_avcodec = false;
+			}
+			if (dec->au_flags & OMX_BUFFERFLAG_DECODEONLY) {
+				int64_t ts = omx_ticks_to_s64(dec->au_ts);
+				if (!dec->decode_only || ts > dec->decode_only_ts)
+					dec->decode_only_ts = ts;
+				dec->decode_only = true;
+			}
+			if (!dec->use_avcodec) {
+				/* Compressed pass-through has nothing to decode, skip the unit */
+				if (!(dec->au_flags & OMX_BUFFERFLAG_DECODEONLY))
+					pic = omxsoftvdec_take_au(dec);
+				omxsoftvdec_reset_au(dec);
+				continue;
+			}
+
+			av_init_packet(&pkt);
+			pkt.data = dec->au;
+			pkt.size = dec->au_len;
+			if (dec->au_flags & OMX_BUFFERFLAG_TIME_UNKNOWN)
+				pkt.pts = pkt.dts = AV_NOPTS_VALUE;
+			else if (dec->au_flags & OMX_BUFFERFLAG_TIME_IS_DTS)
+				pkt.pts = AV_NOPTS_VALUE, pkt.dts = omx_ticks_to_s64(dec->au_ts);
+			else
+				pkt.pts = pkt.dts = omx_ticks_to_s64(dec->au_ts);
+
+			seq = dec->flush_seq;
+			pthread_mutex_unlock(&comp->mutex);
+			ret = avcodec_send_packet(dec->avctx, &pkt);
+			pthread_mutex_lock(&comp->mutex);
+			if (seq != dec->flush_seq) continue;
+
+			dec->need_input = false;
+			/* Decoder is full, drain pictures and retry the same unit */
+			if (ret == AVERROR(EAGAIN)) continue;
+			if (ret < 0) CDEBUG(comp, 0, "decode error %d", ret);
+			omxsoftvdec_reset_au(dec);
+			continue;
+		}
+
+		if (dec->eos_input) {
+			dec->eos_input = false;
+			if (dec->avctx) {
+				pthread_mutex_unlock(&comp->mutex);
+				avcodec_send_packet(dec->avctx, 0);
+				pthread_mutex_lock(&comp->mutex);
+				dec->need_input = false;
+			} else {
+				dec->eos_pending = true;
+			}
+			continue;
+		}
+
+		/* Gather more input, buffers are returned right away */
+		if ((buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&dec->inq)) != 0) {
+			omxsoftvdec_gather(dec, buf);
+			__gomx_process_mark(comp, buf);
+			__gomx_empty_buffer_done(comp, buf);
+			continue;
+		}
+
+		__gomx_wait(comp, &dec->soft.cond_work, 10000);
+	}
+	pthread_mutex_unlock(&comp->mutex);
+
+	if (pic) gomx_picture_free(pic);
+	av_frame_free(&frame);
+	CINFO(comp, 0, "worker stopped");
+	return 0;
+}
+
+static OMX_ERRORTYPE omxsoftvdec_in_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) comp;
+	gomxq_enqueue(&dec->inq, (void *) buf);
+	pthread_cond_signal(&dec->soft.cond_work);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftvdec_in_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) comp;
+	OMX_BUFFERHEADERTYPE *buf;
+
+	while ((buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&dec->inq)) != 0)
+		__gomx_empty_buffer_done(comp, buf);
+	omxsoftvdec_reset_au(dec);
+	dec->eos_input = false;
+	dec->eos_pending = false;
+	dec->start_pending = false;
+	dec->decode_only = false;
+	dec->codec_flush = true;
+	dec->flush_seq++;
+	pthread_cond_signal(&dec->soft.cond_work);
+	return OMX_ErrorNone;
+}
+
+/* Pictures come back when the scheduler returns the output buffer */
+static OMX_ERRORTYPE omxsoftvdec_out_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) comp;
+	GOMX_PICTURE *pic = gomx_picture_get(buf);
+
+	if (pic && gomxq_remove(&dec->pics, pic))
+		gomx_picture_free(pic);
+	buf->nFilledLen = 0;
+	return gomx_soft_fill_do_buffer(comp, port, buf);
+}
+
+static OMX_ERRORTYPE omxsoftvdec_get_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) hComponent;
+	OMX_CONFIG_POINTTYPE *pt;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nParamIndex) {
+	case OMX_IndexParamBrcmPixelAspectRatio:
+		if ((r = omx_cast(pt, pComponentParameterStructure))) return r;
+		pthread_mutex_lock(&comp->mutex);
+		pt->nX = dec->sar.num;
+		pt->nY = dec->sar.den;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	default:
+		return gomx_get_parameter(hComponent, nParamIndex, pComponentParameterStructure);
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftvdec_set_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) hComponent;
+	OMX_VIDEO_PARAM_PORTFORMATTYPE *vpf;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nParamIndex) {
+	case OMX_IndexParamVideoPortFormat:
+		if ((r = omx_cast(vpf, pComponentParameterStructure))) return r;
+		if (vpf->nPortIndex != SOFTVDEC_PORT_IN) return OMX_ErrorBadPortIndex;
+		dec->coding = vpf->eCompressionFormat;
+		comp->ports[SOFTVDEC_PORT_IN].def.format.video.eCompressionFormat = vpf->eCompressionFormat;
+		comp->ports[SOFTVDEC_PORT_IN].def.format.video.xFramerate = vpf->xFramerate;
+		CDEBUG(comp, 0, "OMX_IndexParamVideoPortFormat %x", vpf->eCompressionFormat);
+		break;
+	case OMX_IndexConfigRequestCallback:
+	case OMX_IndexParamBrcmVideoDecodeErrorConcealment:
+	case OMX_IndexParamNalStreamFormatSelect:
+		/* libavcodec detects these on its own */
+		CDEBUG(comp, 0, "ignored %x", nParamIndex);
+		break;
+	default:
+		return gomx_set_parameter(hComponent, nParamIndex, pComponentParameterStructure);
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftvdec_get_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_CONFIG_INTERLACETYPE *it;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch (nIndex) {
+	case OMX_IndexConfigCommonInterlace:
+		if ((r = omx_cast(it, pComponentConfigStructure))) return r;
+		it->eMode = OMX_InterlaceProgressive;
+		it->bRepeatFirstField = OMX_FALSE;
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static void omxsoftvdec_fini(GOMX_SOFT *soft)
+{
+	OMX_SOFTVDEC *dec = (OMX_SOFTVDEC *) soft;
+	GOMX_PICTURE *pic;
+
+	while ((pic = (GOMX_PICTURE *) gomxq_dequeue(&dec->pics)) != 0)
+		gomx_picture_free(pic);
+	if (dec->avctx) avcodec_free_context(&dec->avctx);
+	free(dec->extradata);
+	free(dec->au);
+}
+
+static OMX_ERRORTYPE omxsoftvdec_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	OMX_SOFTVDEC *dec;
+	GOMX_PORT *port;
+
+	dec = (OMX_SOFTVDEC *) calloc(1, sizeof *dec);
+	if (!dec) return OMX_ErrorInsufficientResources;
+
+	gomxq_init(&dec->inq, offsetof(OMX_BUFFERHEADERTYPE, pInputPortPrivate));
+	gomxq_init(&dec->pics, offsetof(GOMX_PICTURE, next));
+	dec->coding = OMX_VIDEO_CodingAVC;
+	dec->use_avcodec = gomx_soft_avcodec;
+	dec->need_input = true;
+
+	port = &dec->port_data[SOFTVDEC_PORT_IN];
+	gomx_soft_port(port, SOFTVDEC_PORT_IN, OMX_DirInput, OMX_PortDomainVideo, 1, 20, 80 * 1024);
+	port->def.format.video.cMIMEType = (char *) "video/x-raw";
+	port->def.format.video.eCompressionFormat = OMX_VIDEO_CodingAVC;
+	port->def.format.video.eColorFormat = OMX_COLOR_FormatUnused;
+	port->do_buffer = omxsoftvdec_in_do_buffer;
+	port->flush = omxsoftvdec_in_flush;
+
+	port = &dec->port_data[SOFTVDEC_PORT_OUT];
+	gomx_soft_port(port, SOFTVDEC_PORT_OUT, OMX_DirOutput, OMX_PortDomainVideo, 1, 1, sizeof(GOMX_PICTURE *));
+	port->def.format.video.cMIMEType = (char *) "video/x-raw";
+	port->def.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+	port->def.format.video.eColorFormat = OMX_COLOR_FormatYUV420PackedPlanar;
+	port->do_buffer = omxsoftvdec_out_do_buffer;
+	port->flush = gomx_soft_fill_flush;
+
+	gomx_soft_init(&dec->soft, "OMX.broadcom.video_decode", pAppData, pCallbacks, dec->port_data, ARRAY_SIZE(dec->port_data));
+	dec->soft.gcomp.omx.GetParameter = omxsoftvdec_get_parameter;
+	dec->soft.gcomp.omx.SetParameter = omxsoftvdec_set_parameter;
+	dec->soft.gcomp.omx.GetConfig = omxsoftvdec_get_config;
+	dec->soft.gcomp.worker = omxsoftvdec_worker;
+	dec->soft.fini = omxsoftvdec_fini;
+
+	*pHandle = (OMX_HANDLETYPE) dec;
+	return OMX_ErrorNone;
+}
+
+/* Video scheduler */
+
+#define SOFTSCHED_PORT_IN		0
+#define SOFTSCHED_PORT_OUT		1
+#define SOFTSCHED_PORT_CLOCK		2
+
+typedef struct _OMX_SOFTSCHED {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[3];
+	GOMX_QUEUE frameq;
+	OMX_TIME_CLOCKSTATE clock_state;
+	int32_t timescale;
+	OMX_U32 steps, steps_seen;
+	bool steps_valid;
+} OMX_SOFTSCHED;
+
+static bool omxsoftsched_due(OMX_SOFTSCHED *sched, OMX_BUFFERHEADERTYPE *buf, GOMX_PORT *clock_port)
+{
+	GOMX_COMPONENT *comp = &sched->soft.gcomp;
+	OMX_TIME_CONFIG_TIMESTAMPTYPE tst;
+	OMX_HANDLETYPE clock = clock_port->tunnel_comp;
+	OMX_ERRORTYPE r;
+
+	if (!clock || buf->nFilledLen == 0 ||
+	    (buf->nFlags & (OMX_BUFFERFLAG_EOS | OMX_BUFFERFLAG_TIME_UNKNOWN)))
+		return true;
+
+	/* Frame stepping while the clock is paused */
+	if (sched->timescale == 0) {
+		if (sched->steps_seen == sched->steps)
+			return false;
+		sched->steps_seen++;
+		omx_init(tst);
+		tst.nPortIndex = clock_port->tunnel_port;
+		tst.nTimestamp = buf->nTimeStamp;
+		pthread_mutex_unlock(&comp->mutex);
+		OMX_SetConfig(clock, OMX_IndexConfigTimeCurrentVideoReference, &tst);
+		pthread_mutex_lock(&comp->mutex);
+		return true;
+	}
+	if (sched->clock_state != OMX_TIME_ClockStateRunning || sched->timescale < 0)
+		return false;
+
+	omx_init(tst);
+	tst.nPortIndex = clock_port->tunnel_port;
+	pthread_mutex_unlock(&comp->mutex);
+	r = OMX_GetConfig(clock, OMX_IndexConfigTimeCurrentMediaTime, &tst);
+	pthread_mutex_lock(&comp->mutex);
+	if (r != OMX_ErrorNone) return true;
+
+	return omx_ticks_to_s64(tst.nTimestamp) >= omx_ticks_to_s64(buf->nTimeStamp);
+}
+
+static void *omxsoftsched_worker(void *ptr)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) ptr;
+	OMX_SOFTSCHED *sched = (OMX_SOFTSCHED *) ptr;
+	GOMX_PORT *out_port = &comp->ports[SOFTSCHED_PORT_OUT];
+	GOMX_PORT *clock_port = &comp->ports[SOFTSCHED_PORT_CLOCK];
+	OMX_TIME_CONFIG_TIMESTAMPTYPE tst;
+	OMX_BUFFERHEADERTYPE *buf, *out;
+
+	CINFO(comp, 0, "worker started");
+	pthread_mutex_lock(&comp->mutex);
+	while (comp->wanted_state == OMX_StateExecuting) {
+		buf = (OMX_BUFFERHEADERTYPE *) sched->frameq.head;
+		if (!buf || !out_port->def.bEnabled || !out_port->fillq.head) {
+			__gomx_wait(comp, &sched->soft.cond_work, 10000);
+			continue;
+		}
+
+		if ((buf->nFlags & OMX_BUFFERFLAG_STARTTIME) && clock_port->tunnel_comp) {
+			buf->nFlags &= ~OMX_BUFFERFLAG_STARTTIME;
+			omx_init(tst);
+			tst.nPortIndex = clock_port->tunnel_port;
+			tst.nTimestamp = buf->nTimeStamp;
+			if (buf->nFlags & OMX_BUFFERFLAG_TIME_UNKNOWN)
+				tst.nTimestamp = omx_ticks_from_s64(0);
+			pthread_mutex_unlock(&comp->mutex);
+			OMX_SetConfig(clock_port->tunnel_comp, OMX_IndexConfigTimeClientStartTime, &tst);
+			pthread_mutex_lock(&comp->mutex);
+			continue;
+		}
+
+		if (!omxsoftsched_due(sched, buf, clock_port)) {
+			__gomx_wait(comp, &sched->soft.cond_work, 10000);
+			continue;
+		}
+		/* The queue may have been flushed while the clock was asked */
+		if (sched->frameq.head != (void *) buf || !out_port->def.bEnabled ||
+		    !(out = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&out_port->fillq)))
+			continue;
+		gomxq_dequeue(&sched->frameq);
+
+		/* Forward the picture reference, the input buffer is held until
+		 * the renderer is done with it */
+		memcpy(out->pBuffer, buf->pBuffer + buf->nOffset, buf->nFilledLen);
+		out->nOffset = 0;
+		out->nFilledLen = buf->nFilledLen;
+		out->nFlags = buf->nFlags;
+		out->nTimeStamp = buf->nTimeStamp;
+		out->pPlatformPrivate = buf;
+		if (__gomx_fill_buffer_done(comp, out) != OMX_ErrorNone) {
+			out->pPlatformPrivate = 0;
+			__gomx_empty_buffer_done(comp, buf);
+		}
+	}
+	pthread_mutex_unlock(&comp->mutex);
+	CINFO(comp, 0, "worker stopped");
+	return 0;
+}
+
+static OMX_ERRORTYPE omxsoftsched_in_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTSCHED *sched = (OMX_SOFTSCHED *) comp;
+	gomxq_enqueue(&sched->frameq, (void *) buf);
+	pthread_cond_signal(&sched->soft.cond_work);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftsched_in_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_SOFTSCHED *sched = (OMX_SOFTSCHED *) comp;
+	OMX_BUFFERHEADERTYPE *buf;
+	while ((buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&sched->frameq)) != 0)
+		__gomx_empty_buffer_done(comp, buf);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftsched_out_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_BUFFERHEADERTYPE *held = (OMX_BUFFERHEADERTYPE *) buf->pPlatformPrivate;
+
+	buf->pPlatformPrivate = 0;
+	buf->nFilledLen = 0;
+	gomx_soft_fill_do_buffer(comp, port, buf);
+	if (held) __gomx_empty_buffer_done(comp, held);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftsched_clock_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTSCHED *sched = (OMX_SOFTSCHED *) comp;
+	OMX_TIME_MEDIATIMETYPE *mt;
+
+	if (buf->nFilledLen >= sizeof *mt && omx_cast(mt, buf->pBuffer) == OMX_ErrorNone) {
+		sched->clock_state = mt->eState;
+		sched->timescale = mt->xScale;
+		/* Steps requested before this client existed do not count */
+		if (!sched->steps_valid) sched->steps_seen = mt->nClientPrivate;
+		sched->steps = mt->nClientPrivate;
+		sched->steps_valid = true;
+		pthread_cond_signal(&sched->soft.cond_work);
+	}
+	__gomx_process_mark(comp, buf);
+	__gomx_empty_buffer_done(comp, buf);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftsched_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	OMX_SOFTSCHED *sched;
+	GOMX_PORT *port;
+
+	sched = (OMX_SOFTSCHED *) calloc(1, sizeof *sched);
+	if (!sched) return OMX_ErrorInsufficientResources;
+
+	gomxq_init(&sched->frameq, offsetof(OMX_BUFFERHEADERTYPE, pInputPortPrivate));
+	sched->clock_state = OMX_TIME_ClockStateStopped;
+	sched->timescale = 0x10000;
+
+	port = &sched->port_data[SOFTSCHED_PORT_IN];
+	gomx_soft_port(port, SOFTSCHED_PORT_IN, OMX_DirInput, OMX_PortDomainVideo, 8, 8, sizeof(GOMX_PICTURE *));
+	port->def.format.video.cMIMEType = (char *) "video/x-raw";
+	port->def.format.video.eColorFormat = OMX_COLOR_FormatYUV420PackedPlanar;
+	port->do_buffer = omxsoftsched_in_do_buffer;
+	port->flush = omxsoftsched_in_flush;
+
+	port = &sched->port_data[SOFTSCHED_PORT_OUT];
+	gomx_soft_port(port, SOFTSCHED_PORT_OUT, OMX_DirOutput, OMX_PortDomainVideo, 1, 1, sizeof(GOMX_PICTURE *));
+	port->def.format.video.cMIMEType = (char *) "video/x-raw";
+	port->def.format.video.eColorFormat = OMX_COLOR_FormatYUV420PackedPlanar;
+	port->do_buffer = omxsoftsched_out_do_buffer;
+	port->flush = gomx_soft_fill_flush;
+
+	port = &sched->port_data[SOFTSCHED_PORT_CLOCK];
+	gomx_soft_port(port, SOFTSCHED_PORT_CLOCK, OMX_DirInput, OMX_PortDomainOther, 1, 1, sizeof(OMX_TIME_MEDIATIMETYPE));
+	port->def.format.other.eFormat = OMX_OTHER_FormatTime;
+	port->do_buffer = omxsoftsched_clock_do_buffer;
+
+	gomx_soft_init(&sched->soft, "OMX.broadcom.video_scheduler", pAppData, pCallbacks, sched->port_data, ARRAY_SIZE(sched->port_data));
+	sched->soft.gcomp.worker = omxsoftsched_worker;
+
+	*pHandle = (OMX_HANDLETYPE) sched;
+	return OMX_ErrorNone;
+}
+
+/* Video renderer, optionally dumping the pictures to a file */
+
+#define SOFTVREND_PORT_IN		0
+
+typedef struct _OMX_SOFTVREND {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[1];
+	FILE *out;
+	uint8_t *image;
+	size_t image_size;
+	unsigned long frames;
+	uint64_t bytes;
+} OMX_SOFTVREND;
+
+static void omxsoftvrend_write(OMX_SOFTVREND *rend, GOMX_PICTURE *pic)
+{
+	AVFrame *frame = pic->frame;
+	const uint8_t *data = pic->data;
+	size_t size = pic->size;
+	int n;
+
+	if (frame) {
+		n = av_image_get_buffer_size((enum AVPixelFormat) frame->format, frame->width, frame->height, 1);
+		if (n <= 0) return;
+		if ((size_t) n > rend->image_size) {
+			uint8_t *p = (uint8_t *) realloc(rend->image, n);
+			if (!p) return;
+			rend->image = p;
+			rend->image_size = n;
+		}
+		n = av_image_copy_to_buffer(rend->image, n,
+			(const uint8_t * const *) frame->data, frame->linesize,
+			(enum AVPixelFormat) frame->format, frame->width, frame->height, 1);
+		if (n <= 0) return;
+		data = rend->image;
+		size = n;
+	}
+	if (rend->out && fwrite(data, 1, size, rend->out) != size) {
+		CINFO(&rend->soft.gcomp, 0, "write failed, output disabled");
+		fclose(rend->out);
+		rend->out = 0;
+	}
+	rend->bytes += size;
+}
+
+static OMX_ERRORTYPE omxsoftvrend_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTVREND *rend = (OMX_SOFTVREND *) comp;
+	GOMX_PICTURE *pic = gomx_picture_get(buf);
+
+	if (pic) {
+		omxsoftvrend_write(rend, pic);
+		rend->frames++;
+	}
+	if (buf->nFlags & OMX_BUFFERFLAG_EOS) {
+		CDEBUG(comp, port, "end-of-stream after %lu frames", rend->frames);
+		__gomx_event(comp, OMX_EventBufferFlag, SOFTVREND_PORT_IN, buf->nFlags, 0);
+	}
+	__gomx_process_mark(comp, buf);
+	__gomx_empty_buffer_done(comp, buf);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftvrend_set_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nIndex) {
+	case OMX_IndexConfigDisplayRegion:
+	case OMX_IndexConfigLatencyTarget:
+		/* There is no display to configure */
+		CDEBUG(comp, 0, "ignored %x", nIndex);
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static void omxsoftvrend_fini(GOMX_SOFT *soft)
+{
+	OMX_SOFTVREND *rend = (OMX_SOFTVREND *) soft;
+
+	CINFO(&soft->gcomp, 0, "rendered %lu frames, %llu bytes", rend->frames, (unsigned long long) rend->bytes);
+	if (rend->out) fclose(rend->out);
+	free(rend->image);
+}
+
+static OMX_ERRORTYPE omxsoftvrend_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	OMX_SOFTVREND *rend;
+	GOMX_PORT *port;
+
+	rend = (OMX_SOFTVREND *) calloc(1, sizeof *rend);
+	if (!rend) return OMX_ErrorInsufficientResources;
+
+	if (gomx_soft_video_out[0]) {
+		rend->out = fopen(gomx_soft_video_out, "ab");
+		if (!rend->out) CLog::Log(LOGERROR, "%s: cannot open %s", __func__, gomx_soft_video_out);
+	}
+
+	port = &rend->port_data[SOFTVREND_PORT_IN];
+	gomx_soft_port(port, SOFTVREND_PORT_IN, OMX_DirInput, OMX_PortDomainVideo, 1, 1, sizeof(GOMX_PICTURE *));
+	port->def.format.video.cMIMEType = (char *) "video/x-raw";
+	port->def.format.video.eColorFormat = OMX_COLOR_FormatYUV420PackedPlanar;
+	port->do_buffer = omxsoftvrend_do_buffer;
+
+	gomx_soft_init(&rend->soft, "OMX.broadcom.video_render", pAppData, pCallbacks, rend->port_data, ARRAY_SIZE(rend->port_data));
+	rend->soft.gcomp.omx.SetConfig = omxsoftvrend_set_config;
+	rend->soft.fini = omxsoftvrend_fini;
+
+	*pHandle = (OMX_HANDLETYPE) rend;
+	return OMX_ErrorNone;
+}
+
+/* Audio decoder and mixer
+ *
+ * omxplayer decodes audio itself and only hands PCM to the decoder, so
+ * both are PCM filters: the decoder interleaves planar float to S16 and
+ * the mixer maps the channel count. The mixer's ports are swapped to
+ * match the Broadcom one. */
+
+typedef struct _OMX_SOFTPCM {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[2];
+	OMX_U32 in_port, out_port;
+	bool mixer;
+	GOMX_QUEUE inq;
+	OMX_AUDIO_PARAM_PCMMODETYPE pcm_in, pcm_out;
+	bool planar_float, have_format, settings_sent;
+	/* Converted data waiting to be passed downstream */
+	uint8_t *stage;
+	size_t stage_len, stage_pos, stage_size;
+	OMX_U32 stage_flags;
+	OMX_TICKS stage_ts;
+	bool stage_first;
+	OMX_U32 max_sample;
+	OMX_TICKS max_sample_ts;
+} OMX_SOFTPCM;
+
+static void omxsoftpcm_parse_config(OMX_SOFTPCM *pcm, OMX_BUFFERHEADERTYPE *buf)
+{
+	const uint8_t *p = buf->pBuffer + buf->nOffset;
+	uint16_t tag, channels, bits;
+	uint32_t rate;
+
+	/* WAVEFORMATEX: tag, channels, rate, byte rate, block align, bits */
+	if (buf->nFilledLen < 16) return;
+	tag = p[0] | (p[1] << 8);
+	channels = p[2] | (p[3] << 8);
+	rate = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t) p[7] << 24);
+	bits = p[14] | (p[15] << 8);
+
+	pcm->pcm_in.nChannels = channels;
+	pcm->pcm_in.nSamplingRate = rate;
+	pcm->pcm_in.nBitPerSample = bits;
+	pcm->planar_float = (tag == 0x8000);
+
+	pcm->pcm_out.nChannels = channels;
+	pcm->pcm_out.nSamplingRate = rate;
+	pcm->pcm_out.nBitPerSample = pcm->planar_float ? 16 : bits;
+	pcm->have_format = true;
+	CINFO(&pcm->soft.gcomp, 0, "format %x, %u channels, %u Hz, %u bits", tag, channels, rate, bits);
+}
+
+static bool omxsoftpcm_fetch_format(OMX_SOFTPCM *pcm)
+{
+	GOMX_COMPONENT *comp = &pcm->soft.gcomp;
+	GOMX_PORT *in_port = &comp->ports[pcm->in_port];
+	OMX_AUDIO_PARAM_PCMMODETYPE fmt;
+	OMX_HANDLETYPE peer = in_port->tunnel_comp;
+	OMX_ERRORTYPE r;
+
+	if (!peer) return false;
+	omx_init(fmt);
+	fmt.nPortIndex = in_port->tunnel_port;
+	pthread_mutex_unlock(&comp->mutex);
+	r = OMX_GetParameter(peer, OMX_IndexParamAudioPcm, &fmt);
+	pthread_mutex_lock(&comp->mutex);
+	if (r != OMX_ErrorNone) return false;
+
+	pcm->pcm_in.nChannels = fmt.nChannels;
+	pcm->pcm_in.nSamplingRate = fmt.nSamplingRate;
+	pcm->pcm_in.nBitPerSample = fmt.nBitPerSample;
+	pcm->have_format = true;
+	return true;
+}
+
+static bool omxsoftpcm_reserve(OMX_SOFTPCM *pcm, size_t size)
+{
+	uint8_t *p;
+
+	if (size <= pcm->stage_size) return true;
+	p = (uint8_t *) realloc(pcm->stage, size);
+	if (!p) return false;
+	pcm->stage = p;
+	pcm->stage_size = size;
+	return true;
+}
+
+static void omxsoftpcm_track_peak(OMX_SOFTPCM *pcm, const int16_t *s, size_t n, OMX_TICKS ts)
+{
+	OMX_U32 peak = pcm->max_sample;
+
+	for (size_t i = 0; i < n; i++) {
+		OMX_U32 v = s[i] < 0 ? -(int32_t) s[i] : s[i];
+		if (v > peak) peak = v;
+	}
+	if (peak != pcm->max_sample) {
+		pcm->max_sample = peak;
+		pcm->max_sample_ts = ts;
+	}
+}
+
+/* Convert one input buffer into the staging buffer */
+static void omxsoftpcm_convert(OMX_SOFTPCM *pcm, OMX_BUFFERHEADERTYPE *buf)
+{
+	const uint8_t *in = buf->pBuffer + buf->nOffset;
+	size_t len = buf->nFilledLen;
+	size_t ich = pcm->pcm_in.nChannels, och = pcm->pcm_out.nChannels;
+	size_t frames, sample_size;
+
+	pcm->stage_len = pcm->stage_pos = 0;
+	pcm->stage_flags = buf->nFlags;
+	pcm->stage_ts = buf->nTimeStamp;
+	pcm->stage_first = true;
+	if (!len || !ich) return;
+
+	if (!pcm->mixer && pcm->planar_float) {
+		const float *planes = (const float *) in;
+		int16_t *out;
+
+		frames = len / (sizeof(float) * ich);
+		if (!omxsoftpcm_reserve(pcm, frames * ich * sizeof(int16_t))) return;
+		out = (int16_t *) pcm->stage;
+		for (size_t f = 0; f < frames; f++) {
+			for (size_t c = 0; c < ich; c++) {
+				float v = planes[c * frames + f] * 32768.0f;
+				if (v > 32767.0f) v = 32767.0f;
+				else if (v < -32768.0f) v = -32768.0f;
+				*out++ = (int16_t) v;
+			}
+		}
+		pcm->stage_len = frames * ich * sizeof(int16_t);
+		omxsoftpcm_track_peak(pcm, (const int16_t *) pcm->stage, frames * ich, buf->nTimeStamp);
+	} else if (pcm->mixer && och && och != ich) {
+		/* Extra channels are dropped, missing ones are silent */
+		sample_size = pcm->pcm_in.nBitPerSample / 8;
+		if (!sample_size) return;
+		frames = len / (sample_size * ich);
+		if (!omxsoftpcm_reserve(pcm, frames * och * sample_size)) return;
+		memset(pcm->stage, 0, frames * och * sample_size);
+		for (size_t f = 0; f < frames; f++)
+			memcpy(pcm->stage + f * och * sample_size,
+			       in + f * ich * sample_size,
+			       (ich < och ? ich : och) * sample_size);
+		pcm->stage_len = frames * och * sample_size;
+	} else {
+		if (!omxsoftpcm_reserve(pcm, len)) return;
+		memcpy(pcm->stage, in, len);
+		pcm->stage_len = len;
+		if (!pcm->mixer && pcm->pcm_in.nBitPerSample == 16)
+			omxsoftpcm_track_peak(pcm, (const int16_t *) pcm->stage, len / 2, buf->nTimeStamp);
+	}
+}
+
+static void *omxsoftpcm_worker(void *ptr)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) ptr;
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) ptr;
+	GOMX_PORT *out_port = &comp->ports[pcm->out_port];
+	OMX_BUFFERHEADERTYPE *buf, *out;
+	size_t n;
+	bool last;
+
+	CINFO(comp, 0, "worker started");
+	pthread_mutex_lock(&comp->mutex);
+	while (comp->wanted_state == OMX_StateExecuting) {
+		/* Pass on the staged data in output buffer sized chunks */
+		if (pcm->stage_first || pcm->stage_pos < pcm->stage_len) {
+			if (!pcm->settings_sent && !pcm->mixer) {
+				pcm->settings_sent = true;
+				__gomx_event(comp, OMX_EventPortSettingsChanged, pcm->out_port, 0, 0);
+				continue;
+			}
+			if (!out_port->def.bEnabled ||
+			    !(out = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&out_port->fillq))) {
+				__gomx_wait(comp, &pcm->soft.cond_work, 10000);
+				continue;
+			}
+			n = pcm->stage_len - pcm->stage_pos;
+			if (n > out->nAllocLen) n = out->nAllocLen;
+			memcpy(out->pBuffer, pcm->stage + pcm->stage_pos, n);
+			pcm->stage_pos += n;
+			last = (pcm->stage_pos >= pcm->stage_len);
+
+			out->nOffset = 0;
+			out->nFilledLen = n;
+			out->nTimeStamp = pcm->stage_ts;
+			out->nFlags = pcm->stage_first
+				? pcm->stage_flags & ~(OMX_BUFFERFLAG_EOS | OMX_BUFFERFLAG_ENDOFFRAME)
+				: OMX_BUFFERFLAG_TIME_UNKNOWN;
+			if (last) out->nFlags |= pcm->stage_flags & (OMX_BUFFERFLAG_EOS | OMX_BUFFERFLAG_ENDOFFRAME);
+			pcm->stage_first = false;
+			if (last && (out->nFlags & OMX_BUFFERFLAG_EOS))
+				__gomx_event(comp, OMX_EventBufferFlag, pcm->out_port, out->nFlags, 0);
+			__gomx_fill_buffer_done(comp, out);
+			continue;
+		}
+
+		if (!(buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&pcm->inq))) {
+			__gomx_wait(comp, &pcm->soft.cond_work, 10000);
+			continue;
+		}
+
+		if (buf->nFlags & OMX_BUFFERFLAG_CODECCONFIG) {
+			if (!pcm->mixer) omxsoftpcm_parse_config(pcm, buf);
+		} else if (buf->nFilledLen == 0 && !(buf->nFlags & OMX_BUFFERFLAG_EOS)) {
+			/* Nothing to pass on */
+		} else {
+			if (pcm->mixer && !pcm->have_format)
+				omxsoftpcm_fetch_format(pcm);
+			omxsoftpcm_convert(pcm, buf);
+		}
+		__gomx_process_mark(comp, buf);
+		__gomx_empty_buffer_done(comp, buf);
+	}
+	pthread_mutex_unlock(&comp->mutex);
+	CINFO(comp, 0, "worker stopped");
+	return 0;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_in_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) comp;
+	gomxq_enqueue(&pcm->inq, (void *) buf);
+	pthread_cond_signal(&pcm->soft.cond_work);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_in_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) comp;
+	OMX_BUFFERHEADERTYPE *buf;
+
+	while ((buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&pcm->inq)) != 0)
+		__gomx_empty_buffer_done(comp, buf);
+	pcm->stage_len = pcm->stage_pos = 0;
+	pcm->stage_first = false;
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_get_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) hComponent;
+	OMX_AUDIO_PARAM_PCMMODETYPE *pmt;
+	OMX_U32 idx;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch (nParamIndex) {
+	case OMX_IndexParamAudioPcm:
+		if ((r = omx_cast(pmt, pComponentParameterStructure))) return r;
+		idx = pmt->nPortIndex;
+		if (idx != pcm->in_port && idx != pcm->out_port) return OMX_ErrorBadPortIndex;
+		pthread_mutex_lock(&comp->mutex);
+		memcpy(pmt, idx == pcm->out_port ? &pcm->pcm_out : &pcm->pcm_in, sizeof *pmt);
+		pmt->nPortIndex = idx;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	default:
+		return gomx_get_parameter(hComponent, nParamIndex, pComponentParameterStructure);
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_set_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) hComponent;
+	OMX_AUDIO_PARAM_PCMMODETYPE *pmt;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nParamIndex) {
+	case OMX_IndexParamAudioPcm:
+		if ((r = omx_cast(pmt, pComponentParameterStructure))) return r;
+		if (pmt->nPortIndex != pcm->in_port && pmt->nPortIndex != pcm->out_port)
+			return OMX_ErrorBadPortIndex;
+		if (pmt->nBitPerSample != 16 && pmt->nBitPerSample != 32)
+			return OMX_ErrorBadParameter;
+		pthread_mutex_lock(&comp->mutex);
+		if (pmt->nPortIndex == pcm->out_port) {
+			memcpy(&pcm->pcm_out, pmt, sizeof *pmt);
+		} else {
+			memcpy(&pcm->pcm_in, pmt, sizeof *pmt);
+			pcm->have_format = true;
+		}
+		pthread_mutex_unlock(&comp->mutex);
+		CDEBUG(comp, 0, "OMX_IndexParamAudioPcm port %u: %u channels, %u Hz",
+			pmt->nPortIndex, pmt->nChannels, pmt->nSamplingRate);
+		break;
+	case OMX_IndexParamBrcmDecoderPassThrough:
+	case OMX_IndexParamAudioPortFormat:
+		CDEBUG(comp, 0, "ignored %x", nParamIndex);
+		break;
+	default:
+		return gomx_set_parameter(hComponent, nParamIndex, pComponentParameterStructure);
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_get_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) hComponent;
+	OMX_CONFIG_BRCMAUDIOMAXSAMPLE *ms;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nIndex) {
+	case OMX_IndexConfigBrcmAudioMaxSample:
+		if ((r = omx_cast(ms, pComponentConfigStructure))) return r;
+		/* Peak since the previous query */
+		pthread_mutex_lock(&comp->mutex);
+		ms->nMaxSample = pcm->max_sample;
+		ms->nTimeStamp = pcm->max_sample_ts;
+		pcm->max_sample = 0;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_set_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nIndex) {
+	case OMX_IndexConfigBrcmAudioDownmixCoefficients8x8:
+		/* Channels are mapped one to one */
+		CDEBUG(comp, 0, "ignored %x", nIndex);
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static void omxsoftpcm_fini(GOMX_SOFT *soft)
+{
+	OMX_SOFTPCM *pcm = (OMX_SOFTPCM *) soft;
+	free(pcm->stage);
+}
+
+static void omxsoftpcm_init_pcm(OMX_AUDIO_PARAM_PCMMODETYPE *pmt, OMX_U32 port)
+{
+	omx_init(*pmt);
+	pmt->nPortIndex = port;
+	pmt->nChannels = 2;
+	pmt->eNumData = OMX_NumericalDataSigned;
+	pmt->eEndian = OMX_EndianLittle;
+	pmt->bInterleaved = OMX_TRUE;
+	pmt->nBitPerSample = 16;
+	pmt->nSamplingRate = 48000;
+	pmt->ePCMMode = OMX_AUDIO_PCMModeLinear;
+}
+
+static OMX_ERRORTYPE omxsoftpcm_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks, bool mixer)
+{
+	OMX_SOFTPCM *pcm;
+	GOMX_PORT *port;
+
+	pcm = (OMX_SOFTPCM *) calloc(1, sizeof *pcm);
+	if (!pcm) return OMX_ErrorInsufficientResources;
+
+	pcm->mixer = mixer;
+	pcm->in_port = mixer ? 1 : 0;
+	pcm->out_port = mixer ? 0 : 1;
+	gomxq_init(&pcm->inq, offsetof(OMX_BUFFERHEADERTYPE, pInputPortPrivate));
+	omxsoftpcm_init_pcm(&pcm->pcm_in, pcm->in_port);
+	omxsoftpcm_init_pcm(&pcm->pcm_out, pcm->out_port);
+
+	port = &pcm->port_data[pcm->in_port];
+	gomx_soft_port(port, pcm->in_port, OMX_DirInput, OMX_PortDomainAudio, 1, 16, 32 * 1024);
+	port->def.format.audio.cMIMEType = (char *) "raw/audio";
+	port->def.format.audio.eEncoding = OMX_AUDIO_CodingPCM;
+	port->do_buffer = omxsoftpcm_in_do_buffer;
+	port->flush = omxsoftpcm_in_flush;
+
+	port = &pcm->port_data[pcm->out_port];
+	gomx_soft_port(port, pcm->out_port, OMX_DirOutput, OMX_PortDomainAudio, 1, 4, 32 * 1024);
+	port->def.format.audio.cMIMEType = (char *) "raw/audio";
+	port->def.format.audio.eEncoding = OMX_AUDIO_CodingPCM;
+	port->do_buffer = gomx_soft_fill_do_buffer;
+	port->flush = gomx_soft_fill_flush;
+
+	gomx_soft_init(&pcm->soft, mixer ? "OMX.broadcom.audio_mixer" : "OMX.broadcom.audio_decode",
+		pAppData, pCallbacks, pcm->port_data, ARRAY_SIZE(pcm->port_data));
+	pcm->soft.gcomp.omx.GetParameter = omxsoftpcm_get_parameter;
+	pcm->soft.gcomp.omx.SetParameter = omxsoftpcm_set_parameter;
+	pcm->soft.gcomp.omx.GetConfig = omxsoftpcm_get_config;
+	pcm->soft.gcomp.omx.SetConfig = omxsoftpcm_set_config;
+	pcm->soft.gcomp.worker = omxsoftpcm_worker;
+	pcm->soft.fini = omxsoftpcm_fini;
+
+	*pHandle = (OMX_HANDLETYPE) pcm;
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftadec_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	return omxsoftpcm_create(pHandle, pAppData, pCallbacks, false);
+}
+
+static OMX_ERRORTYPE omxsoftmixer_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	return omxsoftpcm_create(pHandle, pAppData, pCallbacks, true);
+}
+
+/* Audio renderer playing into a virtual DAC paced by the wall clock */
+
+#define SOFTAREND_PORT_AUDIO		0
+#define SOFTAREND_PORT_CLOCK		1
+#define SOFTAREND_BUFFER_US		100000
+
+typedef struct _OMX_SOFTAREND {
+	GOMX_SOFT soft;
+	GOMX_PORT port_data[2];
+	GOMX_QUEUE playq;
+	size_t frame_size, sample_rate, play_queue_size;
+	int64_t starttime;
+	int64_t dac_end;
+	int32_t timescale;
+} OMX_SOFTAREND;
+
+static int64_t omxsoftarend_dac_delay(OMX_SOFTAREND *rend)
+{
+	int64_t delay = rend->dac_end - gomx_now_us();
+	return delay > 0 ? delay : 0;
+}
+
+static void *omxsoftarend_worker(void *ptr)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) ptr;
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) ptr;
+	GOMX_PORT *clock_port = &comp->ports[SOFTAREND_PORT_CLOCK];
+	OMX_BUFFERHEADERTYPE *buf;
+	int64_t now, duration;
+
+	CINFO(comp, 0, "worker started, sample_rate %d, frame_size %d", (int) rend->sample_rate, (int) rend->frame_size);
+	pthread_mutex_lock(&comp->mutex);
+	while (comp->wanted_state == OMX_StateExecuting) {
+		buf = 0;
+		if (rend->timescale && omxsoftarend_dac_delay(rend) < SOFTAREND_BUFFER_US)
+			buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&rend->playq);
+		if (!buf) {
+			__gomx_wait(comp, &rend->soft.cond_work, 10000);
+			continue;
+		}
+
+		if (clock_port->tunnel_comp && !(buf->nFlags & OMX_BUFFERFLAG_TIME_UNKNOWN)) {
+			OMX_TIME_CONFIG_TIMESTAMPTYPE tst;
+			int64_t pts = omx_ticks_to_s64(buf->nTimeStamp);
+
+			omx_init(tst);
+			tst.nPortIndex = clock_port->tunnel_port;
+			tst.nTimestamp = buf->nTimeStamp;
+			if (buf->nFlags & (OMX_BUFFERFLAG_STARTTIME|OMX_BUFFERFLAG_DISCONTINUITY)) {
+				CINFO(comp, 0, "STARTTIME nTimeStamp=%llx", pts);
+				rend->starttime = pts;
+			}
+			pts -= omxsoftarend_dac_delay(rend) * rend->timescale >> 16;
+
+			pthread_mutex_unlock(&comp->mutex);
+			if (buf->nFlags & (OMX_BUFFERFLAG_STARTTIME|OMX_BUFFERFLAG_DISCONTINUITY))
+				OMX_SetConfig(clock_port->tunnel_comp, OMX_IndexConfigTimeClientStartTime, &tst);
+			if (pts >= rend->starttime) {
+				tst.nTimestamp = omx_ticks_from_s64(pts);
+				OMX_SetConfig(clock_port->tunnel_comp, OMX_IndexConfigTimeCurrentAudioReference, &tst);
+			}
+			pthread_mutex_lock(&comp->mutex);
+		}
+
+		rend->play_queue_size -= buf->nFilledLen;
+		if (!(buf->nFlags & (OMX_BUFFERFLAG_DECODEONLY|OMX_BUFFERFLAG_CODECCONFIG|OMX_BUFFERFLAG_DATACORRUPT)) &&
+		    rend->frame_size && rend->sample_rate) {
+			/* Played faster or slower with the clock scale */
+			duration = (int64_t) buf->nFilledLen / rend->frame_size * 1000000 / rend->sample_rate;
+			duration = (duration << 16) / rend->timescale;
+			now = gomx_now_us();
+			rend->dac_end = max(rend->dac_end, now) + duration;
+		}
+
+		__gomx_process_mark(comp, buf);
+		if (buf->nFlags & OMX_BUFFERFLAG_EOS) {
+			CDEBUG(comp, 0, "end-of-stream");
+			while (comp->wanted_state == OMX_StateExecuting && omxsoftarend_dac_delay(rend) > 0)
+				__gomx_wait(comp, &rend->soft.cond_work, 10000);
+			__gomx_event(comp, OMX_EventBufferFlag, SOFTAREND_PORT_AUDIO, buf->nFlags, 0);
+		}
+		__gomx_empty_buffer_done(comp, buf);
+	}
+	pthread_mutex_unlock(&comp->mutex);
+	CINFO(comp, 0, "worker stopped");
+	return 0;
+}
+
+static OMX_ERRORTYPE omxsoftarend_audio_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) comp;
+	rend->play_queue_size += buf->nFilledLen;
+	gomxq_enqueue(&rend->playq, (void *) buf);
+	pthread_cond_signal(&rend->soft.cond_work);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_audio_flush(GOMX_COMPONENT *comp, GOMX_PORT *port)
+{
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) comp;
+	OMX_BUFFERHEADERTYPE *buf;
+	while ((buf = (OMX_BUFFERHEADERTYPE *) gomxq_dequeue(&rend->playq)) != 0) {
+		rend->play_queue_size -= buf->nFilledLen;
+		__gomx_empty_buffer_done(comp, buf);
+	}
+	rend->dac_end = 0;
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_clock_do_buffer(GOMX_COMPONENT *comp, GOMX_PORT *port, OMX_BUFFERHEADERTYPE *buf)
+{
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) comp;
+	OMX_TIME_MEDIATIMETYPE *mt;
+
+	if (buf->nFilledLen >= sizeof *mt && omx_cast(mt, buf->pBuffer) == OMX_ErrorNone) {
+		rend->timescale = mt->xScale;
+		pthread_cond_signal(&rend->soft.cond_work);
+	}
+	__gomx_process_mark(comp, buf);
+	__gomx_empty_buffer_done(comp, buf);
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_set_parameter(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nParamIndex, OMX_PTR pComponentParameterStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) hComponent;
+	OMX_AUDIO_PARAM_PCMMODETYPE *pmt;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch (nParamIndex) {
+	case OMX_IndexParamAudioPcm:
+		if ((r = omx_cast(pmt, pComponentParameterStructure))) return r;
+		if (pmt->nPortIndex != SOFTAREND_PORT_AUDIO) return OMX_ErrorBadPortIndex;
+		if (!pmt->nChannels || !pmt->nBitPerSample || !pmt->nSamplingRate)
+			return OMX_ErrorBadParameter;
+		pthread_mutex_lock(&comp->mutex);
+		rend->frame_size = (pmt->nChannels * pmt->nBitPerSample) >> 3;
+		rend->sample_rate = pmt->nSamplingRate;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	default:
+		return gomx_set_parameter(hComponent, nParamIndex, pComponentParameterStructure);
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_get_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+	OMX_SOFTAREND *rend = (OMX_SOFTAREND *) hComponent;
+	OMX_PARAM_U32TYPE *u32param;
+	OMX_ERRORTYPE r;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+	if (!rend->frame_size) return OMX_ErrorInvalidState;
+
+	switch (nIndex) {
+	case OMX_IndexConfigAudioRenderingLatency:
+		if ((r = omx_cast(u32param, pComponentConfigStructure))) return r;
+		/* Number of samples received but not played */
+		pthread_mutex_lock(&comp->mutex);
+		u32param->nU32 = rend->play_queue_size / rend->frame_size +
+			omxsoftarend_dac_delay(rend) * rend->sample_rate / 1000000;
+		pthread_mutex_unlock(&comp->mutex);
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_set_config(OMX_HANDLETYPE hComponent, OMX_INDEXTYPE nIndex, OMX_PTR pComponentConfigStructure)
+{
+	GOMX_COMPONENT *comp = (GOMX_COMPONENT *) hComponent;
+
+	if (comp->state == OMX_StateInvalid) return OMX_ErrorInvalidState;
+
+	switch ((int) nIndex) {
+	case OMX_IndexConfigBrcmClockReferenceSource:
+	case OMX_IndexConfigBrcmAudioDestination:
+		CDEBUG(comp, 0, "ignored %x", nIndex);
+		break;
+	default:
+		CINFO(comp, 0, "UNSUPPORTED %x, %p", nIndex, pComponentConfigStructure);
+		return OMX_ErrorNotImplemented;
+	}
+	return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE omxsoftarend_create(OMX_HANDLETYPE *pHandle, OMX_PTR pAppData, OMX_CALLBACKTYPE *pCallbacks)
+{
+	OMX_SOFTAREND *rend;
+	GOMX_PORT *port;
+
+	rend = (OMX_SOFTAREND *) calloc(1, sizeof *rend);
+	if (!rend) return OMX_ErrorInsufficientResources;
+
+	gomxq_init(&rend->playq, offsetof(OMX_BUFFERHEADERTYPE, pInputPortPrivate));
+
+	port = &rend->port_data[SOFTAREND_PORT_AUDIO];
+	gomx_soft_port(port, SOFTAREND_PORT_AUDIO, OMX_DirInput, OMX_PortDomainAudio, 4, 4, 8 * 1024);
+	port->def.format.audio.cMIMEType = (char *) "raw/audio";
+	port->def.format.audio.eEncoding = OMX_AUDIO_CodingPCM;
+	port->do_buffer = omxsoftarend_audio_do_buffer;
+	port->flush = omxsoftarend_audio_flush;
+
+	port = &rend->port_data[SOFTAREND_PORT_CLOCK];
+	gomx_soft_port(port, SOFTAREND_PORT_CLOCK, OMX_DirInput, OMX_PortDomainOther, 1, 1, sizeof(OMX_TIME_MEDIATIMETYPE));
+	port->def.format.other.eFormat = OMX_OTHER_FormatTime;
+	port->do_buffer = omxsoftarend_clock_do_buffer;
+
+	gomx_soft_init(&rend->soft, "OMX.broadcom.audio_render", pAppData, pCallbacks, rend->port_data, ARRAY_SIZE(rend->port_data));
+	rend->soft.gcomp.omx.SetParameter = omxsoftarend_set_parameter;
+	rend->soft.gcomp.omx.GetConfig = omxsoftarend_get_config;
+	rend->soft.gcomp.omx.SetConfig = omxsoftarend_set_config;
+	rend->soft.gcomp.worker = omxsoftarend_worker;
+
+	*pHandle = (OMX_HANDLETYPE) rend;
+	return OMX_ErrorNone;
+}
+
+/* OMX Glue to get the handle */
+
+#include <OMXAlsa.h>
+
+static int gomx_soft_mode = OMXALSA_SOFT_OFF;
+
+static const struct {
+	const char *name;
+	OMX_ERRORTYPE (*create)(OMX_HANDLETYPE *, OMX_PTR, OMX_CALLBACKTYPE *);
+} gomx_soft_components[] = {
+	{ "OMX.broadcom.clock",			omxsoftclock_create },
+	{ "OMX.broadcom.video_decode",		omxsoftvdec_create },
+	{ "OMX.broadcom.video_scheduler",	omxsoftsched_create },
+	{ "OMX.broadcom.video_render",		omxsoftvrend_create },
+	{ "OMX.broadcom.audio_decode",		omxsoftadec_create },
+	{ "OMX.broadcom.audio_mixer",		omxsoftmixer_create },
+	{ "OMX.broadcom.audio_render",		omxsoftarend_create },
+};
+
+OMX_ERRORTYPE OMXALSA_SetSoftComponents(int mode, const char *video_out)
+{
+	FILE *f;
+
+	gomx_soft_mode = mode;
+	gomx_soft_avcodec = (mode == OMXALSA_SOFT_AVCODEC);
+	gomx_soft_video_out[0] = 0;
+	if (mode == OMXALSA_SOFT_OFF || !video_out || !video_out[0])
+		return OMX_ErrorNone;
+
+	/* Renderers append, so start with an empty file */
+	if (strlen(video_out) >= sizeof gomx_soft_video_out)
+		return OMX_ErrorBadParameter;
+	if (!(f = fopen(video_out, "wb")))
+		return OMX_ErrorInsufficientResources;
+	fclose(f);
+	strcpy(gomx_soft_video_out, video_out);
+	return OMX_ErrorNone;
+}
+
+int OMXALSA_GetSoftComponents(void)
+{
+	return gomx_soft_mode;
+}
+
+OMX_ERRORTYPE OMXALSA_GetHandle(OMX_OUT OMX_HANDLETYPE* pHandle, OMX_IN OMX_STRING cComponentName,
+				OMX_IN  OMX_PTR pAppData, OMX_IN OMX_CALLBACKTYPE* pCallbacks)
+{
+	if (strcmp(cComponentName, "OMX.alsa.audio_render") == 0)
+		return omxalsasink_create(pHandle, pAppData, pCallbacks);
+
+	if (gomx_soft_mode != OMXALSA_SOFT_OFF) {
+		for (size_t i = 0; i < ARRAY_SIZE(gomx_soft_components); i++)
+			if (strcmp(cComponentName, gomx_soft_components[i].name) == 0)
+				return gomx_soft_components[i].create(pHandle, pAppData, pCallbacks);
+	}
+
+	return OMX_ErrorComponentNotFound;
+}
+
+OMX_ERRORTYPE OMXALSA_FreeHandle(OMX_IN OMX_HANDLETYPE hComponent)
+{
+	return ((OMX_COMPONENTTYPE*)hComponent)->ComponentDeInit(hComponent);
+}
+
+OMX_ERRORTYPE OMXALSA_SetupTunnel(OMX_IN OMX_HANDLETYPE hOutput, OMX_IN OMX_U32 nPortOutput,
+				  OMX_IN OMX_HANDLETYPE hInput, OMX_IN OMX_U32 nPortInput)
+{
+	OMX_TUNNELSETUPTYPE setup = { 0, OMX_BufferSupplyUnspecified };
+	OMX_COMPONENTTYPE *out = (OMX_COMPONENTTYPE *) hOutput;
+	OMX_COMPONENTTYPE *in = (OMX_COMPONENTTYPE *) hInput;
+	OMX_ERRORTYPE r;
+
+	/* Same sequence as OMX_SetupTunnel in the IL core */
+	if (out) {
+		r = out->ComponentTunnelRequest(hOutput, nPortOutput, hInput, nPortInput, hInput ? &setup : 0);
+		if (r != OMX_ErrorNone) return r;
+	}
+	if (in) {
+		r = in->ComponentTunnelRequest(hInput, nPortInput, hOutput, nPortOutput, hOutput ? &setup : 0);
+		if (r != OMX_ErrorNone) {
+			if (out) out->ComponentTunnelRequest(hOutput, nPortOutput, 0, 0, 0);
+			return r;
+		}
+	}
+	return OMX_ErrorNone;
 }
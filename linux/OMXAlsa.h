@@ -9,3 +9,21 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY OMXALSA_GetHandle(
 
 OMX_API OMX_ERRORTYPE OMX_APIENTRY OMXALSA_FreeHandle(
     OMX_IN  OMX_HANDLETYPE hComponent);
+
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMXALSA_SetupTunnel(
+    OMX_IN  OMX_HANDLETYPE hOutput,
+    OMX_IN  OMX_U32 nPortOutput,
+    OMX_IN  OMX_HANDLETYPE hInput,
+    OMX_IN  OMX_U32 nPortInput);
+
+/* Software stand-ins for the OMX.broadcom.* components, used when there
+ * is no VideoCore. Video is either passed through undecoded or decoded
+ * with libavcodec; video_out, if set, receives the rendered frames. */
+enum {
+  OMXALSA_SOFT_OFF = 0,
+  OMXALSA_SOFT_NULL,
+  OMXALSA_SOFT_AVCODEC,
+};
+
+OMX_ERRORTYPE OMXALSA_SetSoftComponents(int mode, const char *video_out);
+int OMXALSA_GetSoftComponents(void);
@@ -0,0 +1,389 @@
+/*
+ *      Copyright (C) 2005-2009 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Stand-ins for libbcm_host, libopenmaxil, libEGL and libOpenVG when built
+// with PLATFORM=x86. There is no VideoCore: every call fails or reports that
+// nothing is attached, and the player runs with the software components
+// (--soft-omx), which do not reach any of this.
+
+#include <string.h>
+#include <stdarg.h>
+
+#include <bcm_host.h>
+#include <EGL/egl.h>
+#include <VG/openvg.h>
+#include <VG/vgu.h>
+#include <IL/OMX_Core.h>
+
+void bcm_host_init(void)
+{
+}
+
+void bcm_host_deinit(void)
+{
+}
+
+int32_t graphics_get_display_size(const uint16_t display_number, uint32_t *width, uint32_t *height)
+{
+  return -1;
+}
+
+int vc_dispmanx_rect_set(VC_RECT_T *rect, uint32_t x_offset, uint32_t y_offset, uint32_t width, uint32_t height)
+{
+  rect->x      = x_offset;
+  rect->y      = y_offset;
+  rect->width  = width;
+  rect->height = height;
+  return 0;
+}
+
+DISPMANX_RESOURCE_HANDLE_T vc_dispmanx_resource_create(VC_IMAGE_TYPE_T type, uint32_t width, uint32_t height, uint32_t *native_image_handle)
+{
+  return 0;
+}
+
+int vc_dispmanx_resource_write_data(DISPMANX_RESOURCE_HANDLE_T res, VC_IMAGE_TYPE_T src_type, int src_pitch, void *src_address, const VC_RECT_T *rect)
+{
+  return -1;
+}
+
+int vc_dispmanx_resource_delete(DISPMANX_RESOURCE_HANDLE_T res)
+{
+  return -1;
+}
+
+DISPMANX_DISPLAY_HANDLE_T vc_dispmanx_display_open(uint32_t device)
+{
+  return 0;
+}
+
+int vc_dispmanx_display_close(DISPMANX_DISPLAY_HANDLE_T display)
+{
+  return -1;
+}
+
+int vc_dispmanx_display_get_info(DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_MODEINFO_T *pinfo)
+{
+  return -1;
+}
+
+int vc_dispmanx_display_set_background(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+                                       uint8_t red, uint8_t green, uint8_t blue)
+{
+  return -1;
+}
+
+DISPMANX_UPDATE_HANDLE_T vc_dispmanx_update_start(int32_t priority)
+{
+  return 0;
+}
+
+int vc_dispmanx_update_submit_sync(DISPMANX_UPDATE_HANDLE_T update)
+{
+  return -1;
+}
+
+DISPMANX_ELEMENT_HANDLE_T vc_dispmanx_element_add(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+                                                  int32_t layer, const VC_RECT_T *dest_rect, DISPMANX_RESOURCE_HANDLE_T src,
+                                                  const VC_RECT_T *src_rect, DISPMANX_PROTECTION_T protection,
+                                                  VC_DISPMANX_ALPHA_T *alpha,
+                                                  DISPMANX_CLAMP_T *clamp, DISPMANX_TRANSFORM_T transform)
+{
+  return 0;
+}
+
+int vc_dispmanx_element_change_attributes(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+                                          uint32_t change_flags, int32_t layer, uint8_t opacity,
+                                          const VC_RECT_T *dest_rect, const VC_RECT_T *src_rect,
+                                          DISPMANX_RESOURCE_HANDLE_T mask, DISPMANX_TRANSFORM_T transform)
+{
+  return -1;
+}
+
+int vc_dispmanx_element_remove(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element)
+{
+  return -1;
+}
+
+int vc_tv_hdmi_get_supported_modes_new(HDMI_RES_GROUP_T group, TV_SUPPORTED_MODE_NEW_T *supported_modes,
+                                       uint32_t max_supported_modes, HDMI_RES_GROUP_T *preferred_group,
+                                       uint32_t *preferred_mode)
+{
+  if(preferred_group)
+    *preferred_group = HDMI_RES_GROUP_INVALID;
+  if(preferred_mode)
+    *preferred_mode = 0;
+  return 0;
+}
+
+int vc_tv_hdmi_power_on_explicit_new(HDMI_MODE_T mode, HDMI_RES_GROUP_T group, uint32_t code)
+{
+  return -1;
+}
+
+int vc_tv_hdmi_set_property(const HDMI_PROPERTY_PARAM_T *property)
+{
+  return -1;
+}
+
+int vc_tv_get_display_state(TV_DISPLAY_STATE_T *tvstate)
+{
+  memset(tvstate, 0, sizeof(*tvstate));
+  tvstate->state = VC_HDMI_UNPLUGGED;
+  return 0;
+}
+
+int vc_tv_show_info(uint32_t show)
+{
+  return -1;
+}
+
+int vc_tv_hdmi_audio_supported(uint32_t audio_format, uint32_t num_channels,
+                               EDID_AudioSampleRate fs, uint32_t bitrate)
+{
+  return -1;
+}
+
+void vc_tv_register_callback(TVSERVICE_CALLBACK_T callback, void *callback_data)
+{
+}
+
+void vc_tv_unregister_callback(TVSERVICE_CALLBACK_T callback)
+{
+}
+
+void vc_cec_register_callback(CECSERVICE_CALLBACK_T callback, void *callback_data)
+{
+}
+
+void vc_cec_unregister_callback(CECSERVICE_CALLBACK_T callback)
+{
+}
+
+int vc_gencmd(char *response, int maxlen, const char *format, ...)
+{
+  if(response && maxlen > 0)
+    response[0] = '\0';
+  return -1;
+}
+
+int vc_gencmd_number_property(char *text, const char *property, int *number)
+{
+  return 0;
+}
+
+OMX_ERRORTYPE OMX_Init(void)
+{
+  return OMX_ErrorInsufficientResources;
+}
+
+OMX_ERRORTYPE OMX_Deinit(void)
+{
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE OMX_GetHandle(OMX_HANDLETYPE *pHandle, OMX_STRING cComponentName, OMX_PTR pAppData,
+                            OMX_CALLBACKTYPE *pCallBacks)
+{
+  return OMX_ErrorComponentNotFound;
+}
+
+OMX_ERRORTYPE OMX_FreeHandle(OMX_HANDLETYPE hComponent)
+{
+  return OMX_ErrorInvalidComponent;
+}
+
+OMX_ERRORTYPE OMX_GetComponentsOfRole(OMX_STRING role, OMX_U32 *pNumComps, OMX_U8 **compNames)
+{
+  if(pNumComps)
+    *pNumComps = 0;
+  return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE OMX_GetRolesOfComponent(OMX_STRING compName, OMX_U32 *pNumRoles, OMX_U8 **roles)
+{
+  return OMX_ErrorComponentNotFound;
+}
+
+OMX_ERRORTYPE OMX_ComponentNameEnum(OMX_STRING cComponentName, OMX_U32 nNameLength, OMX_U32 nIndex)
+{
+  return OMX_ErrorNoMore;
+}
+
+OMX_ERRORTYPE OMX_SetupTunnel(OMX_HANDLETYPE hOutput, OMX_U32 nPortOutput, OMX_HANDLETYPE hInput,
+                              OMX_U32 nPortInput)
+{
+  return OMX_ErrorNotImplemented;
+}
+
+EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id)
+{
+  return EGL_NO_DISPLAY;
+}
+
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor)
+{
+  return EGL_FALSE;
+}
+
+EGLBoolean eglTerminate(EGLDisplay dpy)
+{
+  return EGL_FALSE;
+}
+
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list,
+                           EGLConfig *configs, EGLint config_size, EGLint *num_config)
+{
+  if(num_config)
+    *num_config = 0;
+  return EGL_FALSE;
+}
+
+EGLBoolean eglBindAPI(EGLenum api)
+{
+  return EGL_FALSE;
+}
+
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config,
+                                  EGLNativeWindowType win, const EGLint *attrib_list)
+{
+  return EGL_NO_SURFACE;
+}
+
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
+                            EGLContext share_context, const EGLint *attrib_list)
+{
+  return EGL_NO_CONTEXT;
+}
+
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface)
+{
+  return EGL_FALSE;
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx)
+{
+  return EGL_FALSE;
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx)
+{
+  return EGL_FALSE;
+}
+
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+  return EGL_FALSE;
+}
+
+VGErrorCode vgGetError(void)
+{
+  return VG_NO_CONTEXT_ERROR;
+}
+
+void vgSeti(VGParamType type, VGint value)
+{
+}
+
+void vgSetfv(VGParamType type, VGint count, const VGfloat *values)
+{
+}
+
+void vgClear(VGint x, VGint y, VGint width, VGint height)
+{
+}
+
+VGPath vgCreatePath(VGint pathFormat, VGPathDatatype datatype, VGfloat scale, VGfloat bias,
+                    VGint segmentCapacityHint, VGint coordCapacityHint, VGbitfield capabilities)
+{
+  return VG_INVALID_HANDLE;
+}
+
+void vgClearPath(VGPath path, VGbitfield capabilities)
+{
+}
+
+void vgDestroyPath(VGPath path)
+{
+}
+
+void vgDrawPath(VGPath path, VGbitfield paintModes)
+{
+}
+
+VGPaint vgCreatePaint(void)
+{
+  return VG_INVALID_HANDLE;
+}
+
+void vgDestroyPaint(VGPaint paint)
+{
+}
+
+void vgSetPaint(VGPaint paint, VGbitfield paintModes)
+{
+}
+
+void vgSetColor(VGPaint paint, VGuint rgba)
+{
+}
+
+VGImage vgCreateImage(VGImageFormat format, VGint width, VGint height, VGbitfield allowedQuality)
+{
+  return VG_INVALID_HANDLE;
+}
+
+void vgDestroyImage(VGImage image)
+{
+}
+
+void vgImageSubData(VGImage image, const void *data, VGint dataStride, VGImageFormat dataFormat,
+                    VGint x, VGint y, VGint width, VGint height)
+{
+}
+
+void vgGaussianBlur(VGImage dst, VGImage src, VGfloat stdDeviationX, VGfloat stdDeviationY,
+                    VGTilingMode tilingMode)
+{
+}
+
+VGFont vgCreateFont(VGint glyphCapacityHint)
+{
+  return VG_INVALID_HANDLE;
+}
+
+void vgDestroyFont(VGFont font)
+{
+}
+
+void vgSetGlyphToImage(VGFont font, VGuint glyphIndex, VGImage image,
+                       const VGfloat glyphOrigin[2], const VGfloat escapement[2])
+{
+}
+
+void vgDrawGlyph(VGFont font, VGuint glyphIndex, VGbitfield paintModes, VGboolean allowAutoHinting)
+{
+}
+
+VGUErrorCode vguRect(VGPath path, VGfloat x, VGfloat y, VGfloat width, VGfloat height)
+{
+  return VGU_BAD_HANDLE_ERROR;
+}
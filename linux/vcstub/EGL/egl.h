@@ -0,0 +1,73 @@
+/*
+ * Stand-in for the EGL 1.4 header from the Raspberry Pi userland, for
+ * building without VideoCore (make PLATFORM=x86). Only what
+ * SubtitleRenderer uses; implemented in linux/VCStub.cpp.
+ */
+
+#ifndef __egl_h_
+#define __egl_h_
+
+#include <stdint.h>
+#include <bcm_host.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int32_t EGLint;
+typedef unsigned int EGLBoolean;
+typedef unsigned int EGLenum;
+typedef void *EGLConfig;
+typedef void *EGLContext;
+typedef void *EGLDisplay;
+typedef void *EGLSurface;
+typedef void *EGLNativeDisplayType;
+typedef void *EGLNativeWindowType;
+
+typedef struct {
+  DISPMANX_ELEMENT_HANDLE_T element;
+  int width;
+  int height;
+} EGL_DISPMANX_WINDOW_T;
+
+#define EGL_FALSE 0
+#define EGL_TRUE 1
+
+#define EGL_DEFAULT_DISPLAY ((EGLNativeDisplayType)0)
+#define EGL_NO_CONTEXT ((EGLContext)0)
+#define EGL_NO_DISPLAY ((EGLDisplay)0)
+#define EGL_NO_SURFACE ((EGLSurface)0)
+
+#define EGL_SUCCESS 0x3000
+#define EGL_NOT_INITIALIZED 0x3001
+
+#define EGL_ALPHA_SIZE 0x3021
+#define EGL_BLUE_SIZE 0x3022
+#define EGL_GREEN_SIZE 0x3023
+#define EGL_RED_SIZE 0x3024
+#define EGL_SURFACE_TYPE 0x3033
+#define EGL_NONE 0x3038
+
+#define EGL_WINDOW_BIT 0x0004
+#define EGL_OPENVG_API 0x30A1
+
+EGLDisplay eglGetDisplay(EGLNativeDisplayType display_id);
+EGLBoolean eglInitialize(EGLDisplay dpy, EGLint *major, EGLint *minor);
+EGLBoolean eglTerminate(EGLDisplay dpy);
+EGLBoolean eglChooseConfig(EGLDisplay dpy, const EGLint *attrib_list,
+                           EGLConfig *configs, EGLint config_size, EGLint *num_config);
+EGLBoolean eglBindAPI(EGLenum api);
+EGLSurface eglCreateWindowSurface(EGLDisplay dpy, EGLConfig config,
+                                  EGLNativeWindowType win, const EGLint *attrib_list);
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config,
+                            EGLContext share_context, const EGLint *attrib_list);
+EGLBoolean eglDestroySurface(EGLDisplay dpy, EGLSurface surface);
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx);
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx);
+EGLBoolean eglSwapBuffers(EGLDisplay dpy, EGLSurface surface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
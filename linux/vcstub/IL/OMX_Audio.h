@@ -0,0 +1,127 @@
+/*
+ * Stand-in for the OpenMAX IL audio header, see OMX_Types.h.
+ */
+
+#ifndef OMX_Audio_h
+#define OMX_Audio_h
+
+#include <IL/OMX_Core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_AUDIO_CODINGTYPE {
+  OMX_AUDIO_CodingUnused = 0,
+  OMX_AUDIO_CodingAutoDetect,
+  OMX_AUDIO_CodingPCM,
+  OMX_AUDIO_CodingADPCM,
+  OMX_AUDIO_CodingAMR,
+  OMX_AUDIO_CodingGSMFR,
+  OMX_AUDIO_CodingGSMEFR,
+  OMX_AUDIO_CodingGSMHR,
+  OMX_AUDIO_CodingPDCFR,
+  OMX_AUDIO_CodingPDCEFR,
+  OMX_AUDIO_CodingPDCHR,
+  OMX_AUDIO_CodingTDMAFR,
+  OMX_AUDIO_CodingTDMAEFR,
+  OMX_AUDIO_CodingQCELP8,
+  OMX_AUDIO_CodingQCELP13,
+  OMX_AUDIO_CodingEVRC,
+  OMX_AUDIO_CodingSMV,
+  OMX_AUDIO_CodingG711,
+  OMX_AUDIO_CodingG723,
+  OMX_AUDIO_CodingG726,
+  OMX_AUDIO_CodingG729,
+  OMX_AUDIO_CodingAAC,
+  OMX_AUDIO_CodingMP3,
+  OMX_AUDIO_CodingSBC,
+  OMX_AUDIO_CodingVORBIS,
+  OMX_AUDIO_CodingWMA,
+  OMX_AUDIO_CodingRA,
+  OMX_AUDIO_CodingMIDI,
+  OMX_AUDIO_CodingKhronosExtensions = 0x6F000000,
+  OMX_AUDIO_CodingVendorStartUnused = 0x7F000000,
+  OMX_AUDIO_CodingFLAC,
+  OMX_AUDIO_CodingDDP,
+  OMX_AUDIO_CodingDTS,
+  OMX_AUDIO_CodingWMAPRO,
+  OMX_AUDIO_CodingATRAC3,
+  OMX_AUDIO_CodingATRACX,
+  OMX_AUDIO_CodingATRACAAL,
+  OMX_AUDIO_CodingMax = 0x7FFFFFFF
+} OMX_AUDIO_CODINGTYPE;
+
+typedef struct OMX_AUDIO_PORTDEFINITIONTYPE {
+  OMX_STRING cMIMEType;
+  OMX_NATIVE_DEVICETYPE pNativeRender;
+  OMX_BOOL bFlagErrorConcealment;
+  OMX_AUDIO_CODINGTYPE eEncoding;
+} OMX_AUDIO_PORTDEFINITIONTYPE;
+
+typedef struct OMX_AUDIO_PARAM_PORTFORMATTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nIndex;
+  OMX_AUDIO_CODINGTYPE eEncoding;
+} OMX_AUDIO_PARAM_PORTFORMATTYPE;
+
+typedef enum OMX_AUDIO_PCMMODETYPE {
+  OMX_AUDIO_PCMModeLinear = 0,
+  OMX_AUDIO_PCMModeALaw,
+  OMX_AUDIO_PCMModeMULaw,
+  OMX_AUDIO_PCMModeKhronosExtensions = 0x6F000000,
+  OMX_AUDIO_PCMModeVendorStartUnused = 0x7F000000,
+  OMX_AUDIO_PCMModeMax = 0x7FFFFFFF
+} OMX_AUDIO_PCMMODETYPE;
+
+typedef enum OMX_AUDIO_CHANNELTYPE {
+  OMX_AUDIO_ChannelNone = 0x0,
+  OMX_AUDIO_ChannelLF   = 0x1,
+  OMX_AUDIO_ChannelRF   = 0x2,
+  OMX_AUDIO_ChannelCF   = 0x3,
+  OMX_AUDIO_ChannelLS   = 0x4,
+  OMX_AUDIO_ChannelRS   = 0x5,
+  OMX_AUDIO_ChannelLFE  = 0x6,
+  OMX_AUDIO_ChannelCS   = 0x7,
+  OMX_AUDIO_ChannelLR   = 0x8,
+  OMX_AUDIO_ChannelRR   = 0x9,
+  OMX_AUDIO_ChannelKhronosExtensions = 0x6F000000,
+  OMX_AUDIO_ChannelVendorStartUnused = 0x7F000000,
+  OMX_AUDIO_ChannelMax  = 0x7FFFFFFF
+} OMX_AUDIO_CHANNELTYPE;
+
+#define OMX_AUDIO_MAXCHANNELS 16
+
+typedef struct OMX_AUDIO_PARAM_PCMMODETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nChannels;
+  OMX_NUMERICALDATATYPE eNumData;
+  OMX_ENDIANTYPE eEndian;
+  OMX_BOOL bInterleaved;
+  OMX_U32 nBitPerSample;
+  OMX_U32 nSamplingRate;
+  OMX_AUDIO_PCMMODETYPE ePCMMode;
+  OMX_AUDIO_CHANNELTYPE eChannelMapping[OMX_AUDIO_MAXCHANNELS];
+} OMX_AUDIO_PARAM_PCMMODETYPE;
+
+typedef struct OMX_AUDIO_PARAM_DTSTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nChannels;
+  OMX_U32 nBitRate;
+  OMX_U32 nSampleRate;
+  OMX_U32 nDtsType;
+  OMX_U32 nFormat;
+  OMX_U32 nDtsFrameSizeBytes;
+} OMX_AUDIO_PARAM_DTSTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
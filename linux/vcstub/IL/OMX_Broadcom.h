@@ -0,0 +1,243 @@
+/*
+ * Stand-in for the Broadcom OpenMAX IL extensions header, see
+ * OMX_Types.h.
+ */
+
+#ifndef OMX_Broadcom_h
+#define OMX_Broadcom_h
+
+#include <IL/OMX_Component.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMX_CLOCKPORT0 0x00000001
+#define OMX_CLOCKPORT1 0x00000002
+#define OMX_CLOCKPORT2 0x00000004
+#define OMX_CLOCKPORT3 0x00000008
+#define OMX_CLOCKPORT4 0x00000010
+#define OMX_CLOCKPORT5 0x00000020
+
+typedef struct OMX_DISPLAYRECTTYPE {
+  OMX_S16 x_offset;
+  OMX_S16 y_offset;
+  OMX_S16 width;
+  OMX_S16 height;
+} OMX_DISPLAYRECTTYPE;
+
+typedef enum OMX_DISPLAYTRANSFORMTYPE {
+  OMX_DISPLAY_ROT0 = 0,
+  OMX_DISPLAY_MIRROR_ROT0 = 1,
+  OMX_DISPLAY_MIRROR_ROT180 = 2,
+  OMX_DISPLAY_ROT180 = 3,
+  OMX_DISPLAY_MIRROR_ROT90 = 4,
+  OMX_DISPLAY_ROT270 = 5,
+  OMX_DISPLAY_ROT90 = 6,
+  OMX_DISPLAY_MIRROR_ROT270 = 7,
+  OMX_DISPLAY_DUMMY = 0x7FFFFFFF
+} OMX_DISPLAYTRANSFORMTYPE;
+
+typedef enum OMX_DISPLAYMODETYPE {
+  OMX_DISPLAY_MODE_FILL = 0,
+  OMX_DISPLAY_MODE_LETTERBOX = 1,
+  OMX_DISPLAY_MODE_STEREO_LEFT_TO_LEFT = 2,
+  OMX_DISPLAY_MODE_STEREO_TOP_TO_TOP = 3,
+  OMX_DISPLAY_MODE_STEREO_LEFT_TO_TOP = 4,
+  OMX_DISPLAY_MODE_STEREO_TOP_TO_LEFT = 5,
+  OMX_DISPLAY_MODE_DUMMY = 0x7FFFFFFF
+} OMX_DISPLAYMODETYPE;
+
+typedef enum OMX_DISPLAYSETTYPE {
+  OMX_DISPLAY_SET_NONE = 0,
+  OMX_DISPLAY_SET_NUM = 1,
+  OMX_DISPLAY_SET_FULLSCREEN = 2,
+  OMX_DISPLAY_SET_TRANSFORM = 4,
+  OMX_DISPLAY_SET_DEST_RECT = 8,
+  OMX_DISPLAY_SET_SRC_RECT = 0x10,
+  OMX_DISPLAY_SET_MODE = 0x20,
+  OMX_DISPLAY_SET_PIXEL = 0x40,
+  OMX_DISPLAY_SET_NOASPECT = 0x80,
+  OMX_DISPLAY_SET_LAYER = 0x100,
+  OMX_DISPLAY_SET_COPYPROTECT = 0x200,
+  OMX_DISPLAY_SET_ALPHA = 0x400,
+  OMX_DISPLAY_SET_DUMMY = 0x7FFFFFFF
+} OMX_DISPLAYSETTYPE;
+
+#define OMX_DISPLAY_ALPHA_FLAGS_OPAQUE 0
+#define OMX_DISPLAY_ALPHA_FLAGS_DISCARD_LOWER_LAYERS (1<<29)
+#define OMX_DISPLAY_ALPHA_FLAGS_MIX (1<<28)
+
+typedef struct OMX_CONFIG_DISPLAYREGIONTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_DISPLAYSETTYPE set;
+  OMX_U32 num;
+  OMX_BOOL fullscreen;
+  OMX_DISPLAYTRANSFORMTYPE transform;
+  OMX_DISPLAYRECTTYPE dest_rect;
+  OMX_DISPLAYRECTTYPE src_rect;
+  OMX_BOOL noaspect;
+  OMX_DISPLAYMODETYPE mode;
+  OMX_U32 pixel_x;
+  OMX_U32 pixel_y;
+  OMX_S32 layer;
+  OMX_BOOL copyprotect_required;
+  OMX_U32 alpha;
+  OMX_U32 wfc_context_width;
+  OMX_U32 wfc_context_height;
+} OMX_CONFIG_DISPLAYREGIONTYPE;
+
+typedef struct OMX_CONFIG_REQUESTCALLBACKTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_INDEXTYPE nIndex;
+  OMX_BOOL bEnable;
+} OMX_CONFIG_REQUESTCALLBACKTYPE;
+
+typedef enum OMX_INTERLACETYPE {
+  OMX_InterlaceProgressive,
+  OMX_InterlaceFieldSingleUpperFirst,
+  OMX_InterlaceFieldSingleLowerFirst,
+  OMX_InterlaceFieldsInterleavedUpperFirst,
+  OMX_InterlaceFieldsInterleavedLowerFirst,
+  OMX_InterlaceMixed,
+  OMX_InterlaceKhronosExtensions = 0x6F000000,
+  OMX_InterlaceVendorStartUnused = 0x7F000000,
+  OMX_InterlaceMax = 0x7FFFFFFF
+} OMX_INTERLACETYPE;
+
+typedef struct OMX_CONFIG_INTERLACETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_INTERLACETYPE eMode;
+  OMX_BOOL bRepeatFirstField;
+} OMX_CONFIG_INTERLACETYPE;
+
+typedef enum OMX_IMAGEFILTERTYPE {
+  OMX_ImageFilterNone,
+  OMX_ImageFilterNoise,
+  OMX_ImageFilterEmboss,
+  OMX_ImageFilterNegative,
+  OMX_ImageFilterSketch,
+  OMX_ImageFilterOilPaint,
+  OMX_ImageFilterHatch,
+  OMX_ImageFilterGpen,
+  OMX_ImageFilterAntialias,
+  OMX_ImageFilterDeRing,
+  OMX_ImageFilterSolarize,
+  OMX_ImageFilterKhronosExtensions = 0x6F000000,
+  OMX_ImageFilterVendorStartUnused = 0x7F000000,
+  OMX_ImageFilterWatercolor,
+  OMX_ImageFilterPastel,
+  OMX_ImageFilterSharpen,
+  OMX_ImageFilterFilm,
+  OMX_ImageFilterBlur,
+  OMX_ImageFilterSaturation,
+  OMX_ImageFilterDeInterlaceLineDouble,
+  OMX_ImageFilterDeInterlaceAdvanced,
+  OMX_ImageFilterColourSwap,
+  OMX_ImageFilterWashedOut,
+  OMX_ImageFilterColourPoint,
+  OMX_ImageFilterPosterise,
+  OMX_ImageFilterColourBalance,
+  OMX_ImageFilterCartoon,
+  OMX_ImageFilterAnaglyph,
+  OMX_ImageFilterDeInterlaceFast,
+  OMX_ImageFilterMax = 0x7FFFFFFF
+} OMX_IMAGEFILTERTYPE;
+
+typedef enum OMX_IMAGEFILTERANAGLYPHTYPE {
+  OMX_ImageFilterAnaglyphNone,
+  OMX_ImageFilterAnaglyphSBStoRedCyan,
+  OMX_ImageFilterAnaglyphSBStoCyanRed,
+  OMX_ImageFilterAnaglyphSBStoGreenMagenta,
+  OMX_ImageFilterAnaglyphSBStoMagentaGreen,
+  OMX_ImageFilterAnaglyphTABtoRedCyan,
+  OMX_ImageFilterAnaglyphTABtoCyanRed,
+  OMX_ImageFilterAnaglyphTABtoGreenMagenta,
+  OMX_ImageFilterAnaglyphTABtoMagentaGreen,
+} OMX_IMAGEFILTERANAGLYPHTYPE;
+
+#define OMX_CONFIG_IMAGEFILTERPARAMS_MAXPARAMS 6
+
+typedef struct OMX_CONFIG_IMAGEFILTERPARAMSTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_IMAGEFILTERTYPE eImageFilter;
+  OMX_U32 nNumParams;
+  OMX_U32 nParams[OMX_CONFIG_IMAGEFILTERPARAMS_MAXPARAMS];
+} OMX_CONFIG_IMAGEFILTERPARAMSTYPE;
+
+typedef struct OMX_CONFIG_LATENCYTARGETTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_BOOL bEnabled;
+  OMX_U32 nFilter;
+  OMX_U32 nTarget;
+  OMX_U32 nShift;
+  OMX_S32 nSpeedFactor;
+  OMX_S32 nInterFactor;
+  OMX_S32 nAdjCap;
+} OMX_CONFIG_LATENCYTARGETTYPE;
+
+typedef struct OMX_CONFIG_BRCMAUDIODESTINATIONTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U8 sName[16];
+} OMX_CONFIG_BRCMAUDIODESTINATIONTYPE;
+
+typedef struct OMX_CONFIG_BRCMAUDIOMAXSAMPLE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nMaxSample;
+  OMX_TICKS nTimeStamp;
+} OMX_CONFIG_BRCMAUDIOMAXSAMPLE;
+
+typedef struct OMX_CONFIG_BRCMAUDIODOWNMIXCOEFFICIENTS {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 coeff[16];
+} OMX_CONFIG_BRCMAUDIODOWNMIXCOEFFICIENTS;
+
+typedef struct OMX_CONFIG_BRCMAUDIODOWNMIXCOEFFICIENTS8x8 {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 coeff[64];
+} OMX_CONFIG_BRCMAUDIODOWNMIXCOEFFICIENTS8x8;
+
+typedef enum OMX_NALUFORMATSTYPE {
+  OMX_NaluFormatStartCodes = 1,
+  OMX_NaluFormatOneNaluPerBuffer = 2,
+  OMX_NaluFormatOneByteInterleaveLength = 4,
+  OMX_NaluFormatTwoByteInterleaveLength = 8,
+  OMX_NaluFormatFourByteInterleaveLength = 16,
+  OMX_NaluFormatCodingMax = 0x7FFFFFFF
+} OMX_NALUFORMATSTYPE;
+
+typedef struct OMX_NALSTREAMFORMATTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_NALUFORMATSTYPE eNaluFormat;
+} OMX_NALSTREAMFORMATTYPE;
+
+typedef struct OMX_PARAM_BRCMVIDEODECODEERRORCONCEALMENTTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_BOOL bStartWithValidFrame;
+} OMX_PARAM_BRCMVIDEODECODEERRORCONCEALMENTTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Stand-in for the OpenMAX IL component header, see OMX_Types.h.
+ */
+
+#ifndef OMX_Component_h
+#define OMX_Component_h
+
+#include <IL/OMX_Audio.h>
+#include <IL/OMX_Video.h>
+#include <IL/OMX_Image.h>
+#include <IL/OMX_Other.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_PORTDOMAINTYPE {
+  OMX_PortDomainAudio,
+  OMX_PortDomainVideo,
+  OMX_PortDomainImage,
+  OMX_PortDomainOther,
+  OMX_PortDomainKhronosExtensions = 0x6F000000,
+  OMX_PortDomainVendorStartUnused = 0x7F000000,
+  OMX_PortDomainMax = 0x7ffffff
+} OMX_PORTDOMAINTYPE;
+
+typedef struct OMX_PARAM_PORTDEFINITIONTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_DIRTYPE eDir;
+  OMX_U32 nBufferCountActual;
+  OMX_U32 nBufferCountMin;
+  OMX_U32 nBufferSize;
+  OMX_BOOL bEnabled;
+  OMX_BOOL bPopulated;
+  OMX_PORTDOMAINTYPE eDomain;
+  union {
+    OMX_AUDIO_PORTDEFINITIONTYPE audio;
+    OMX_VIDEO_PORTDEFINITIONTYPE video;
+    OMX_IMAGE_PORTDEFINITIONTYPE image;
+    OMX_OTHER_PORTDEFINITIONTYPE other;
+  } format;
+  OMX_BOOL bBuffersContiguous;
+  OMX_U32 nBufferAlignment;
+} OMX_PARAM_PORTDEFINITIONTYPE;
+
+typedef struct OMX_PARAM_U32TYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nU32;
+} OMX_PARAM_U32TYPE;
+
+typedef struct OMX_COMPONENTTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_PTR pComponentPrivate;
+  OMX_PTR pApplicationPrivate;
+
+  OMX_ERRORTYPE (*GetComponentVersion)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_OUT OMX_STRING pComponentName,
+      OMX_OUT OMX_VERSIONTYPE* pComponentVersion,
+      OMX_OUT OMX_VERSIONTYPE* pSpecVersion,
+      OMX_OUT OMX_UUIDTYPE* pComponentUUID);
+  OMX_ERRORTYPE (*SendCommand)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_COMMANDTYPE Cmd,
+      OMX_IN  OMX_U32 nParam1,
+      OMX_IN  OMX_PTR pCmdData);
+  OMX_ERRORTYPE (*GetParameter)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_INDEXTYPE nParamIndex,
+      OMX_INOUT OMX_PTR pComponentParameterStructure);
+  OMX_ERRORTYPE (*SetParameter)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_INDEXTYPE nIndex,
+      OMX_IN  OMX_PTR pComponentParameterStructure);
+  OMX_ERRORTYPE (*GetConfig)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_INDEXTYPE nIndex,
+      OMX_INOUT OMX_PTR pComponentConfigStructure);
+  OMX_ERRORTYPE (*SetConfig)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_INDEXTYPE nIndex,
+      OMX_IN  OMX_PTR pComponentConfigStructure);
+  OMX_ERRORTYPE (*GetExtensionIndex)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_STRING cParameterName,
+      OMX_OUT OMX_INDEXTYPE* pIndexType);
+  OMX_ERRORTYPE (*GetState)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_OUT OMX_STATETYPE* pState);
+  OMX_ERRORTYPE (*ComponentTunnelRequest)(
+      OMX_IN  OMX_HANDLETYPE hComp,
+      OMX_IN  OMX_U32 nPort,
+      OMX_IN  OMX_HANDLETYPE hTunneledComp,
+      OMX_IN  OMX_U32 nTunneledPort,
+      OMX_INOUT OMX_TUNNELSETUPTYPE* pTunnelSetup);
+  OMX_ERRORTYPE (*UseBuffer)(
+      OMX_IN OMX_HANDLETYPE hComponent,
+      OMX_INOUT OMX_BUFFERHEADERTYPE** ppBufferHdr,
+      OMX_IN OMX_U32 nPortIndex,
+      OMX_IN OMX_PTR pAppPrivate,
+      OMX_IN OMX_U32 nSizeBytes,
+      OMX_IN OMX_U8* pBuffer);
+  OMX_ERRORTYPE (*AllocateBuffer)(
+      OMX_IN OMX_HANDLETYPE hComponent,
+      OMX_INOUT OMX_BUFFERHEADERTYPE** ppBuffer,
+      OMX_IN OMX_U32 nPortIndex,
+      OMX_IN OMX_PTR pAppPrivate,
+      OMX_IN OMX_U32 nSizeBytes);
+  OMX_ERRORTYPE (*FreeBuffer)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_U32 nPortIndex,
+      OMX_IN  OMX_BUFFERHEADERTYPE* pBuffer);
+  OMX_ERRORTYPE (*EmptyThisBuffer)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_BUFFERHEADERTYPE* pBuffer);
+  OMX_ERRORTYPE (*FillThisBuffer)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_BUFFERHEADERTYPE* pBuffer);
+  OMX_ERRORTYPE (*SetCallbacks)(
+      OMX_IN  OMX_HANDLETYPE hComponent,
+      OMX_IN  OMX_CALLBACKTYPE* pCallbacks,
+      OMX_IN  OMX_PTR pAppData);
+  OMX_ERRORTYPE (*ComponentDeInit)(
+      OMX_IN  OMX_HANDLETYPE hComponent);
+  OMX_ERRORTYPE (*UseEGLImage)(
+      OMX_IN OMX_HANDLETYPE hComponent,
+      OMX_INOUT OMX_BUFFERHEADERTYPE** ppBufferHdr,
+      OMX_IN OMX_U32 nPortIndex,
+      OMX_IN OMX_PTR pAppPrivate,
+      OMX_IN void* eglImage);
+  OMX_ERRORTYPE (*ComponentRoleEnum)(
+      OMX_IN OMX_HANDLETYPE hComponent,
+      OMX_OUT OMX_U8 *cRole,
+      OMX_IN OMX_U32 nIndex);
+} OMX_COMPONENTTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
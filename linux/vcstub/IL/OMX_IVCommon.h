@@ -0,0 +1,45 @@
+/*
+ * Stand-in for the OpenMAX IL common video/image header, see OMX_Types.h.
+ */
+
+#ifndef OMX_IVCommon_h
+#define OMX_IVCommon_h
+
+#include <IL/OMX_Core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_COLOR_FORMATTYPE {
+  OMX_COLOR_FormatUnused = 0,
+  OMX_COLOR_FormatMonochrome = 1,
+  OMX_COLOR_Format16bitRGB565 = 6,
+  OMX_COLOR_Format24bitRGB888 = 11,
+  OMX_COLOR_Format32bitARGB8888 = 16,
+  OMX_COLOR_FormatYUV420Planar = 19,
+  OMX_COLOR_FormatYUV420PackedPlanar = 20,
+  OMX_COLOR_FormatKhronosExtensions = 0x6F000000,
+  OMX_COLOR_FormatVendorStartUnused = 0x7F000000,
+  OMX_COLOR_FormatMax = 0x7FFFFFFF
+} OMX_COLOR_FORMATTYPE;
+
+typedef struct OMX_CONFIG_POINTTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_S32 nX;
+  OMX_S32 nY;
+} OMX_CONFIG_POINTTYPE;
+
+typedef struct OMX_CONFIG_BOOLEANTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_BOOL bEnabled;
+} OMX_CONFIG_BOOLEANTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
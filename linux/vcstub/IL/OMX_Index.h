@@ -0,0 +1,100 @@
+/*
+ * Stand-in for the OpenMAX IL index header, see OMX_Types.h. Broadcom
+ * indices are placed in the vendor range as in the userland headers.
+ */
+
+#ifndef OMX_Index_h
+#define OMX_Index_h
+
+#include <IL/OMX_Types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_INDEXTYPE {
+  OMX_IndexComponentStartUnused = 0x01000000,
+  OMX_IndexParamPriorityMgmt,
+  OMX_IndexParamAudioInit,
+  OMX_IndexParamImageInit,
+  OMX_IndexParamVideoInit,
+  OMX_IndexParamOtherInit,
+  OMX_IndexParamNumAvailableStreams,
+  OMX_IndexParamActiveStream,
+  OMX_IndexParamSuspensionPolicy,
+  OMX_IndexParamComponentSuspended,
+  OMX_IndexConfigCapturing,
+  OMX_IndexConfigCaptureMode,
+  OMX_IndexAutoPauseAfterCapture,
+  OMX_IndexParamContentURI,
+  OMX_IndexParamCustomContentPipe,
+  OMX_IndexParamDisableResourceConcealment,
+  OMX_IndexConfigMetadataItemCount,
+  OMX_IndexConfigContainerNodeCount,
+  OMX_IndexConfigMetadataItem,
+  OMX_IndexConfigCounterNodeID,
+  OMX_IndexParamMetadataFilterType,
+  OMX_IndexParamMetadataKeyFilter,
+  OMX_IndexConfigPriorityMgmt,
+  OMX_IndexParamStandardComponentRole,
+
+  OMX_IndexPortStartUnused = 0x02000000,
+  OMX_IndexParamPortDefinition,
+  OMX_IndexParamCompBufferSupplier,
+  OMX_IndexReservedStartUnused = 0x03000000,
+
+  OMX_IndexAudioStartUnused = 0x04000000,
+  OMX_IndexParamAudioPortFormat,
+  OMX_IndexParamAudioPcm,
+
+  OMX_IndexImageStartUnused = 0x05000000,
+
+  OMX_IndexVideoStartUnused = 0x06000000,
+  OMX_IndexParamVideoPortFormat,
+
+  OMX_IndexCommonStartUnused = 0x07000000,
+  OMX_IndexConfigCommonImageFilterParameters,
+
+  OMX_IndexOtherStartUnused = 0x08000000,
+
+  OMX_IndexTimeStartUnused = 0x09000000,
+  OMX_IndexConfigTimeScale,
+  OMX_IndexConfigTimeClockState,
+  OMX_IndexConfigTimeActiveRefClock,
+  OMX_IndexConfigTimeCurrentMediaTime,
+  OMX_IndexConfigTimeCurrentWallTime,
+  OMX_IndexConfigTimeCurrentAudioReference,
+  OMX_IndexConfigTimeCurrentVideoReference,
+  OMX_IndexConfigTimeMediaTimeRequest,
+  OMX_IndexConfigTimeClientStartTime,
+  OMX_IndexConfigTimePosition,
+  OMX_IndexConfigTimeSeekMode,
+
+  OMX_IndexKhronosExtensions = 0x6F000000,
+  OMX_IndexVendorStartUnused = 0x7F000000,
+  OMX_IndexParamAudioDts,
+  OMX_IndexConfigDisplayRegion,
+  OMX_IndexConfigRequestCallback,
+  OMX_IndexConfigCommonInterlace,
+  OMX_IndexConfigLatencyTarget,
+  OMX_IndexConfigClockAdjustment,
+  OMX_IndexConfigSingleStep,
+  OMX_IndexConfigAudioRenderingLatency,
+  OMX_IndexConfigBrcmAudioDestination,
+  OMX_IndexConfigBrcmAudioDownmixCoefficients,
+  OMX_IndexConfigBrcmAudioDownmixCoefficients8x8,
+  OMX_IndexConfigBrcmAudioMaxSample,
+  OMX_IndexConfigBrcmClockReferenceSource,
+  OMX_IndexParamBrcmDecoderPassThrough,
+  OMX_IndexParamBrcmExtraBuffers,
+  OMX_IndexParamBrcmPixelAspectRatio,
+  OMX_IndexParamBrcmVideoDecodeErrorConcealment,
+  OMX_IndexParamNalStreamFormatSelect,
+  OMX_IndexMax = 0x7FFFFFFF
+} OMX_INDEXTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
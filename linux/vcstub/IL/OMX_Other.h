@@ -0,0 +1,101 @@
+/*
+ * Stand-in for the OpenMAX IL other domain header, see OMX_Types.h.
+ */
+
+#ifndef OMX_Other_h
+#define OMX_Other_h
+
+#include <IL/OMX_Core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_OTHER_FORMATTYPE {
+  OMX_OTHER_FormatTime = 0,
+  OMX_OTHER_FormatPower,
+  OMX_OTHER_FormatStats,
+  OMX_OTHER_FormatBinary,
+  OMX_OTHER_FormatVendorReserved = 1000,
+  OMX_OTHER_FormatKhronosExtensions = 0x6F000000,
+  OMX_OTHER_FormatVendorStartUnused = 0x7F000000,
+  OMX_OTHER_FormatMax = 0x7FFFFFFF
+} OMX_OTHER_FORMATTYPE;
+
+typedef struct OMX_OTHER_PORTDEFINITIONTYPE {
+  OMX_OTHER_FORMATTYPE eFormat;
+} OMX_OTHER_PORTDEFINITIONTYPE;
+
+typedef enum OMX_TIME_REFCLOCKTYPE {
+  OMX_TIME_RefClockNone,
+  OMX_TIME_RefClockAudio,
+  OMX_TIME_RefClockVideo,
+  OMX_TIME_RefClockKhronosExtensions = 0x6F000000,
+  OMX_TIME_RefClockVendorStartUnused = 0x7F000000,
+  OMX_TIME_RefClockMax = 0x7FFFFFFF
+} OMX_TIME_REFCLOCKTYPE;
+
+typedef enum OMX_TIME_CLOCKSTATE {
+  OMX_TIME_ClockStateRunning,
+  OMX_TIME_ClockStateWaitingForStartTime,
+  OMX_TIME_ClockStateStopped,
+  OMX_TIME_ClockStateKhronosExtensions = 0x6F000000,
+  OMX_TIME_ClockStateVendorStartUnused = 0x7F000000,
+  OMX_TIME_ClockStateMax = 0x7FFFFFFF
+} OMX_TIME_CLOCKSTATE;
+
+typedef enum OMX_TIME_UPDATETYPE {
+  OMX_TIME_UpdateRequestFulfillment,
+  OMX_TIME_UpdateScaleChanged,
+  OMX_TIME_UpdateClockStateChanged,
+  OMX_TIME_UpdateKhronosExtensions = 0x6F000000,
+  OMX_TIME_UpdateVendorStartUnused = 0x7F000000,
+  OMX_TIME_UpdateMax = 0x7FFFFFFF
+} OMX_TIME_UPDATETYPE;
+
+typedef struct OMX_TIME_MEDIATIMETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nClientPrivate;
+  OMX_TIME_UPDATETYPE eUpdateType;
+  OMX_TIME_REFCLOCKTYPE eMediaTimeType;
+  OMX_TICKS nMediaTimestamp;
+  OMX_TICKS nOffset;
+  OMX_TICKS nWallTimeAtMediaTime;
+  OMX_S32 xScale;
+  OMX_TIME_CLOCKSTATE eState;
+} OMX_TIME_MEDIATIMETYPE;
+
+typedef struct OMX_TIME_CONFIG_TIMESTAMPTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_TICKS nTimestamp;
+} OMX_TIME_CONFIG_TIMESTAMPTYPE;
+
+typedef struct OMX_TIME_CONFIG_SCALETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_S32 xScale;
+} OMX_TIME_CONFIG_SCALETYPE;
+
+typedef struct OMX_TIME_CONFIG_CLOCKSTATETYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_TIME_CLOCKSTATE eState;
+  OMX_TICKS nStartTime;
+  OMX_TICKS nOffset;
+  OMX_U32 nWaitMask;
+} OMX_TIME_CONFIG_CLOCKSTATETYPE;
+
+typedef struct OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_TIME_REFCLOCKTYPE eClock;
+} OMX_TIME_CONFIG_ACTIVEREFCLOCKTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Stand-in for the Khronos OpenMAX IL 1.1.2 headers shipped in
+ * /opt/vc/include/IL, for building without the Raspberry Pi userland
+ * (make PLATFORM=x86). Only what omxplayer uses is declared; layouts
+ * follow the Khronos and Broadcom headers so the soft components in
+ * linux/OMXAlsa.cpp see the same structures as on the Pi.
+ */
+
+#ifndef OMX_Types_h
+#define OMX_Types_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OMX_API extern
+#define OMX_APIENTRY
+#define OMX_IN
+#define OMX_OUT
+#define OMX_INOUT
+
+#define OMX_ALL 0xFFFFFFFF
+
+typedef uint8_t  OMX_U8;
+typedef int8_t   OMX_S8;
+typedef uint16_t OMX_U16;
+typedef int16_t  OMX_S16;
+typedef uint32_t OMX_U32;
+typedef int32_t  OMX_S32;
+typedef uint64_t OMX_U64;
+typedef int64_t  OMX_S64;
+
+typedef enum OMX_BOOL {
+  OMX_FALSE = 0,
+  OMX_TRUE = !OMX_FALSE,
+  OMX_BOOL_MAX = 0x7FFFFFFF
+} OMX_BOOL;
+
+typedef void *OMX_PTR;
+typedef char *OMX_STRING;
+typedef unsigned char OMX_UUIDTYPE[128];
+typedef void *OMX_HANDLETYPE;
+typedef void *OMX_NATIVE_DEVICETYPE;
+typedef void *OMX_NATIVE_WINDOWTYPE;
+
+typedef enum OMX_DIRTYPE {
+  OMX_DirInput,
+  OMX_DirOutput,
+  OMX_DirMax = 0x7FFFFFFF
+} OMX_DIRTYPE;
+
+typedef enum OMX_ENDIANTYPE {
+  OMX_EndianBig,
+  OMX_EndianLittle,
+  OMX_EndianMax = 0x7FFFFFFF
+} OMX_ENDIANTYPE;
+
+typedef enum OMX_NUMERICALDATATYPE {
+  OMX_NumericalDataSigned,
+  OMX_NumericalDataUnsigned,
+  OMX_NumercialDataMax = 0x7FFFFFFF
+} OMX_NUMERICALDATATYPE;
+
+typedef struct OMX_BU32 {
+  OMX_U32 nValue;
+  OMX_U32 nMin;
+  OMX_U32 nMax;
+} OMX_BU32;
+
+typedef struct OMX_BS32 {
+  OMX_S32 nValue;
+  OMX_S32 nMin;
+  OMX_S32 nMax;
+} OMX_BS32;
+
+#ifndef OMX_SKIP64BIT
+typedef OMX_S64 OMX_TICKS;
+#define omx_ticks_from_s64(s) (s)
+#define omx_ticks_to_s64(t) (t)
+#else
+typedef struct OMX_TICKS {
+  OMX_U32 nLowPart;
+  OMX_U32 nHighPart;
+} OMX_TICKS;
+
+static inline OMX_TICKS omx_ticks_from_s64(signed long long s)
+{
+  OMX_TICKS t;
+  t.nLowPart = (OMX_U32)s;
+  t.nHighPart = (OMX_U32)(s >> 32);
+  return t;
+}
+#define omx_ticks_to_s64(t) ((t).nLowPart | ((uint64_t)((t).nHighPart) << 32))
+#endif
+#define OMX_TICKS_PER_SECOND 1000000
+
+typedef void *OMX_BUFFERPOINTER;
+
+typedef union OMX_VERSIONTYPE {
+  struct {
+    OMX_U8 nVersionMajor;
+    OMX_U8 nVersionMinor;
+    OMX_U8 nRevision;
+    OMX_U8 nStep;
+  } s;
+  OMX_U32 nVersion;
+} OMX_VERSIONTYPE;
+
+typedef struct OMX_MARKTYPE {
+  OMX_HANDLETYPE hMarkTargetComponent;
+  OMX_PTR pMarkData;
+} OMX_MARKTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
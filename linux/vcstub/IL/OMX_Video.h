@@ -0,0 +1,65 @@
+/*
+ * Stand-in for the OpenMAX IL video header, see OMX_Types.h.
+ */
+
+#ifndef OMX_Video_h
+#define OMX_Video_h
+
+#include <IL/OMX_IVCommon.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum OMX_VIDEO_CODINGTYPE {
+  OMX_VIDEO_CodingUnused,
+  OMX_VIDEO_CodingAutoDetect,
+  OMX_VIDEO_CodingMPEG2,
+  OMX_VIDEO_CodingH263,
+  OMX_VIDEO_CodingMPEG4,
+  OMX_VIDEO_CodingWMV,
+  OMX_VIDEO_CodingRV,
+  OMX_VIDEO_CodingAVC,
+  OMX_VIDEO_CodingMJPEG,
+  OMX_VIDEO_CodingKhronosExtensions = 0x6F000000,
+  OMX_VIDEO_CodingVendorStartUnused = 0x7F000000,
+  OMX_VIDEO_CodingVP6,
+  OMX_VIDEO_CodingVP7,
+  OMX_VIDEO_CodingVP8,
+  OMX_VIDEO_CodingYUV,
+  OMX_VIDEO_CodingSorenson,
+  OMX_VIDEO_CodingTheora,
+  OMX_VIDEO_CodingMVC,
+  OMX_VIDEO_CodingMax = 0x7FFFFFFF
+} OMX_VIDEO_CODINGTYPE;
+
+typedef struct OMX_VIDEO_PORTDEFINITIONTYPE {
+  OMX_STRING cMIMEType;
+  OMX_NATIVE_DEVICETYPE pNativeRender;
+  OMX_U32 nFrameWidth;
+  OMX_U32 nFrameHeight;
+  OMX_S32 nStride;
+  OMX_U32 nSliceHeight;
+  OMX_U32 nBitrate;
+  OMX_U32 xFramerate;
+  OMX_BOOL bFlagErrorConcealment;
+  OMX_VIDEO_CODINGTYPE eCompressionFormat;
+  OMX_COLOR_FORMATTYPE eColorFormat;
+  OMX_NATIVE_WINDOWTYPE pNativeWindow;
+} OMX_VIDEO_PORTDEFINITIONTYPE;
+
+typedef struct OMX_VIDEO_PARAM_PORTFORMATTYPE {
+  OMX_U32 nSize;
+  OMX_VERSIONTYPE nVersion;
+  OMX_U32 nPortIndex;
+  OMX_U32 nIndex;
+  OMX_VIDEO_CODINGTYPE eCompressionFormat;
+  OMX_COLOR_FORMATTYPE eColorFormat;
+  OMX_U32 xFramerate;
+} OMX_VIDEO_PARAM_PORTFORMATTYPE;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
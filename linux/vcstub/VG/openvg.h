@@ -0,0 +1,132 @@
+/*
+ * Stand-in for the OpenVG 1.1 header from the Raspberry Pi userland, for
+ * building without VideoCore (make PLATFORM=x86). Only what
+ * SubtitleRenderer uses; implemented in linux/VCStub.cpp.
+ */
+
+#ifndef _OPENVG_H
+#define _OPENVG_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef float VGfloat;
+typedef int8_t VGbyte;
+typedef uint8_t VGubyte;
+typedef int16_t VGshort;
+typedef int32_t VGint;
+typedef uint32_t VGuint;
+typedef uint32_t VGbitfield;
+
+typedef enum {
+  VG_FALSE = 0,
+  VG_TRUE = 1
+} VGboolean;
+
+typedef VGuint VGHandle;
+typedef VGHandle VGPath;
+typedef VGHandle VGImage;
+typedef VGHandle VGPaint;
+typedef VGHandle VGFont;
+
+#define VG_INVALID_HANDLE ((VGHandle)0)
+
+typedef enum {
+  VG_NO_ERROR = 0,
+  VG_BAD_HANDLE_ERROR = 0x1000,
+  VG_ILLEGAL_ARGUMENT_ERROR = 0x1001,
+  VG_OUT_OF_MEMORY_ERROR = 0x1002,
+  VG_PATH_CAPABILITY_ERROR = 0x1003,
+  VG_UNSUPPORTED_IMAGE_FORMAT_ERROR = 0x1004,
+  VG_UNSUPPORTED_PATH_FORMAT_ERROR = 0x1005,
+  VG_IMAGE_IN_USE_ERROR = 0x1006,
+  VG_NO_CONTEXT_ERROR = 0x1007
+} VGErrorCode;
+
+typedef enum {
+  VG_IMAGE_QUALITY = 0x1102,
+  VG_IMAGE_MODE = 0x1105,
+  VG_CLEAR_COLOR = 0x1121,
+  VG_GLYPH_ORIGIN = 0x1122,
+  VG_FILTER_FORMAT_LINEAR = 0x1131
+} VGParamType;
+
+typedef enum {
+  VG_IMAGE_QUALITY_NONANTIALIASED = (1 << 0),
+  VG_IMAGE_QUALITY_FASTER = (1 << 1),
+  VG_IMAGE_QUALITY_BETTER = (1 << 2)
+} VGImageQuality;
+
+typedef enum {
+  VG_DRAW_IMAGE_NORMAL = 0x1F00,
+  VG_DRAW_IMAGE_MULTIPLY = 0x1F01,
+  VG_DRAW_IMAGE_STENCIL = 0x1F02
+} VGImageMode;
+
+typedef enum {
+  VG_TILE_FILL = 0x1D00,
+  VG_TILE_PAD = 0x1D01,
+  VG_TILE_REPEAT = 0x1D02,
+  VG_TILE_REFLECT = 0x1D03
+} VGTilingMode;
+
+typedef enum {
+  VG_STROKE_PATH = (1 << 0),
+  VG_FILL_PATH = (1 << 1)
+} VGPaintMode;
+
+#define VG_PATH_FORMAT_STANDARD 0
+
+typedef enum {
+  VG_PATH_DATATYPE_S_8 = 0,
+  VG_PATH_DATATYPE_S_16 = 1,
+  VG_PATH_DATATYPE_S_32 = 2,
+  VG_PATH_DATATYPE_F = 3
+} VGPathDatatype;
+
+typedef enum {
+  VG_PATH_CAPABILITY_ALL = (1 << 12) - 1
+} VGPathCapabilities;
+
+typedef enum {
+  VG_sRGBA_8888 = 0,
+  VG_A_8 = 11
+} VGImageFormat;
+
+VGErrorCode vgGetError(void);
+void vgSeti(VGParamType type, VGint value);
+void vgSetfv(VGParamType type, VGint count, const VGfloat *values);
+void vgClear(VGint x, VGint y, VGint width, VGint height);
+
+VGPath vgCreatePath(VGint pathFormat, VGPathDatatype datatype, VGfloat scale, VGfloat bias,
+                    VGint segmentCapacityHint, VGint coordCapacityHint, VGbitfield capabilities);
+void vgClearPath(VGPath path, VGbitfield capabilities);
+void vgDestroyPath(VGPath path);
+void vgDrawPath(VGPath path, VGbitfield paintModes);
+
+VGPaint vgCreatePaint(void);
+void vgDestroyPaint(VGPaint paint);
+void vgSetPaint(VGPaint paint, VGbitfield paintModes);
+void vgSetColor(VGPaint paint, VGuint rgba);
+
+VGImage vgCreateImage(VGImageFormat format, VGint width, VGint height, VGbitfield allowedQuality);
+void vgDestroyImage(VGImage image);
+void vgImageSubData(VGImage image, const void *data, VGint dataStride, VGImageFormat dataFormat,
+                    VGint x, VGint y, VGint width, VGint height);
+void vgGaussianBlur(VGImage dst, VGImage src, VGfloat stdDeviationX, VGfloat stdDeviationY,
+                    VGTilingMode tilingMode);
+
+VGFont vgCreateFont(VGint glyphCapacityHint);
+void vgDestroyFont(VGFont font);
+void vgSetGlyphToImage(VGFont font, VGuint glyphIndex, VGImage image,
+                       const VGfloat glyphOrigin[2], const VGfloat escapement[2]);
+void vgDrawGlyph(VGFont font, VGuint glyphIndex, VGbitfield paintModes, VGboolean allowAutoHinting);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,29 @@
+/*
+ * Stand-in for the OpenVG utility header, see VG/openvg.h.
+ */
+
+#ifndef _VGU_H
+#define _VGU_H
+
+#include <VG/openvg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  VGU_NO_ERROR = 0,
+  VGU_BAD_HANDLE_ERROR = 0xF000,
+  VGU_ILLEGAL_ARGUMENT_ERROR = 0xF001,
+  VGU_OUT_OF_MEMORY_ERROR = 0xF002,
+  VGU_PATH_CAPABILITY_ERROR = 0xF003,
+  VGU_BAD_WARP_ERROR = 0xF004
+} VGUErrorCode;
+
+VGUErrorCode vguRect(VGPath path, VGfloat x, VGfloat y, VGfloat width, VGfloat height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
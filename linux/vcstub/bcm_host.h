@@ -0,0 +1,369 @@
+/*
+ * Stand-in for the Raspberry Pi userland bcm_host.h (dispmanx, tvservice,
+ * cecservice and gencmd), for building without VideoCore (make
+ * PLATFORM=x86). The functions are implemented in linux/VCStub.cpp and
+ * report that no display is attached.
+ */
+
+#ifndef BCM_HOST_H
+#define BCM_HOST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void bcm_host_init(void);
+void bcm_host_deinit(void);
+int32_t graphics_get_display_size(const uint16_t display_number, uint32_t *width, uint32_t *height);
+
+/* dispmanx */
+
+typedef uint32_t DISPMANX_DISPLAY_HANDLE_T;
+typedef uint32_t DISPMANX_UPDATE_HANDLE_T;
+typedef uint32_t DISPMANX_ELEMENT_HANDLE_T;
+typedef uint32_t DISPMANX_RESOURCE_HANDLE_T;
+typedef uint32_t DISPMANX_PROTECTION_T;
+
+#define DISPMANX_PROTECTION_NONE 0
+#define DISPMANX_PROTECTION_HDCP 11
+
+typedef enum {
+  DISPMANX_NO_ROTATE = 0,
+  DISPMANX_ROTATE_90 = 1,
+  DISPMANX_ROTATE_180 = 2,
+  DISPMANX_ROTATE_270 = 3,
+  DISPMANX_FLIP_HRIZ = 1 << 16,
+  DISPMANX_FLIP_VERT = 1 << 17,
+  DISPMANX_STEREOSCOPIC_MONO = 0 << 20,
+  DISPMANX_STEREOSCOPIC_SBS = 1 << 20,
+  DISPMANX_STEREOSCOPIC_TB = 2 << 20,
+} DISPMANX_TRANSFORM_T;
+
+typedef enum {
+  DISPMANX_FLAGS_ALPHA_FROM_SOURCE = 0,
+  DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS = 1,
+  DISPMANX_FLAGS_ALPHA_FIXED_NON_ZERO = 2,
+  DISPMANX_FLAGS_ALPHA_FIXED_EXCEED_0X07 = 3,
+  DISPMANX_FLAGS_ALPHA_PREMULT = 1 << 16,
+  DISPMANX_FLAGS_ALPHA_MIX = 1 << 17
+} DISPMANX_FLAGS_ALPHA_T;
+
+typedef struct {
+  DISPMANX_FLAGS_ALPHA_T flags;
+  uint32_t opacity;
+  DISPMANX_RESOURCE_HANDLE_T mask;
+} VC_DISPMANX_ALPHA_T;
+
+typedef enum {
+  DISPMANX_FLAGS_CLAMP_NONE = 0,
+  DISPMANX_FLAGS_CLAMP_LUMA_TRANSPARENT = 1,
+  DISPMANX_FLAGS_CLAMP_TRANSPARENT = 2,
+  DISPMANX_FLAGS_CLAMP_REPLACE = 3
+} DISPMANX_FLAGS_CLAMP_T;
+
+typedef enum {
+  DISPMANX_FLAGS_KEYMASK_OVERRIDE = 1,
+  DISPMANX_FLAGS_KEYMASK_SMOOTH = 1 << 1,
+  DISPMANX_FLAGS_KEYMASK_CR_INV = 1 << 2,
+  DISPMANX_FLAGS_KEYMASK_CB_INV = 1 << 3,
+  DISPMANX_FLAGS_KEYMASK_YY_INV = 1 << 4
+} DISPMANX_FLAGS_KEYMASK_T;
+
+typedef union {
+  struct {
+    uint8_t yy_upper;
+    uint8_t yy_lower;
+    uint8_t cr_upper;
+    uint8_t cr_lower;
+    uint8_t cb_upper;
+    uint8_t cb_lower;
+  } yuv;
+  struct {
+    uint8_t red_upper;
+    uint8_t red_lower;
+    uint8_t blue_upper;
+    uint8_t blue_lower;
+    uint8_t green_upper;
+    uint8_t green_lower;
+  } rgb;
+} DISPMANX_CLAMP_KEYS_T;
+
+typedef struct {
+  DISPMANX_FLAGS_CLAMP_T mode;
+  DISPMANX_FLAGS_KEYMASK_T key_mask;
+  DISPMANX_CLAMP_KEYS_T key_value;
+  uint32_t replace_value;
+} DISPMANX_CLAMP_T;
+
+typedef struct tag_VC_RECT_T {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+} VC_RECT_T;
+
+typedef enum {
+  VC_IMAGE_MIN = 0,
+  VC_IMAGE_RGB565 = 1,
+  VC_IMAGE_RGBA32 = 15,
+  VC_IMAGE_ARGB8888 = 43,
+  VC_IMAGE_MAX
+} VC_IMAGE_TYPE_T;
+
+typedef enum {
+  VC_IMAGE_ROT0 = 0
+} VC_IMAGE_TRANSFORM_T;
+
+typedef struct {
+  int32_t width;
+  int32_t height;
+  DISPMANX_TRANSFORM_T transform;
+  uint32_t input_format;
+  uint32_t display_num;
+} DISPMANX_MODEINFO_T;
+
+int vc_dispmanx_rect_set(VC_RECT_T *rect, uint32_t x_offset, uint32_t y_offset, uint32_t width, uint32_t height);
+DISPMANX_RESOURCE_HANDLE_T vc_dispmanx_resource_create(VC_IMAGE_TYPE_T type, uint32_t width, uint32_t height, uint32_t *native_image_handle);
+int vc_dispmanx_resource_write_data(DISPMANX_RESOURCE_HANDLE_T res, VC_IMAGE_TYPE_T src_type, int src_pitch, void *src_address, const VC_RECT_T *rect);
+int vc_dispmanx_resource_delete(DISPMANX_RESOURCE_HANDLE_T res);
+DISPMANX_DISPLAY_HANDLE_T vc_dispmanx_display_open(uint32_t device);
+int vc_dispmanx_display_close(DISPMANX_DISPLAY_HANDLE_T display);
+int vc_dispmanx_display_get_info(DISPMANX_DISPLAY_HANDLE_T display, DISPMANX_MODEINFO_T *pinfo);
+int vc_dispmanx_display_set_background(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+                                       uint8_t red, uint8_t green, uint8_t blue);
+DISPMANX_UPDATE_HANDLE_T vc_dispmanx_update_start(int32_t priority);
+int vc_dispmanx_update_submit_sync(DISPMANX_UPDATE_HANDLE_T update);
+DISPMANX_ELEMENT_HANDLE_T vc_dispmanx_element_add(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_DISPLAY_HANDLE_T display,
+                                                  int32_t layer, const VC_RECT_T *dest_rect, DISPMANX_RESOURCE_HANDLE_T src,
+                                                  const VC_RECT_T *src_rect, DISPMANX_PROTECTION_T protection,
+                                                  VC_DISPMANX_ALPHA_T *alpha,
+                                                  DISPMANX_CLAMP_T *clamp, DISPMANX_TRANSFORM_T transform);
+int vc_dispmanx_element_change_attributes(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element,
+                                          uint32_t change_flags, int32_t layer, uint8_t opacity,
+                                          const VC_RECT_T *dest_rect, const VC_RECT_T *src_rect,
+                                          DISPMANX_RESOURCE_HANDLE_T mask, DISPMANX_TRANSFORM_T transform);
+int vc_dispmanx_element_remove(DISPMANX_UPDATE_HANDLE_T update, DISPMANX_ELEMENT_HANDLE_T element);
+
+/* tvservice */
+
+typedef enum {
+  VC_HDMI_UNPLUGGED = (1 << 0),
+  VC_HDMI_ATTACHED = (1 << 1),
+  VC_HDMI_DVI = (1 << 2),
+  VC_HDMI_HDMI = (1 << 3),
+  VC_HDMI_HDCP_UNAUTH = (1 << 4),
+  VC_HDMI_HDCP_AUTH = (1 << 5),
+  VC_HDMI_HDCP_KEY_DOWNLOAD = (1 << 6),
+  VC_HDMI_HDCP_SRM_DOWNLOAD = (1 << 7),
+  VC_HDMI_CHANGING_MODE = (1 << 8),
+  VC_HDMI_STANDBY = (1 << 9),
+  VC_SDTV_UNPLUGGED = 1 << 16,
+  VC_SDTV_ATTACHED = 1 << 17,
+  VC_SDTV_NTSC = 1 << 18,
+  VC_SDTV_PAL = 1 << 19,
+  VC_SDTV_CP_INACTIVE = 1 << 20,
+  VC_SDTV_CP_ACTIVE = 1 << 21
+} VC_HDMI_NOTIFY_T;
+
+typedef enum {
+  HDMI_RES_GROUP_INVALID = 0,
+  HDMI_RES_GROUP_CEA = 1,
+  HDMI_RES_GROUP_DMT = 2,
+  HDMI_RES_GROUP_CEA_3D = 3,
+  HDMI_RES_GROUP_PAL = 4,
+  HDMI_RES_GROUP_NTSC = 5,
+  HDMI_RES_GROUP_DUMMY = 0x7FFFFFFF
+} HDMI_RES_GROUP_T;
+
+typedef enum {
+  HDMI_MODE_OFF,
+  HDMI_MODE_DVI,
+  HDMI_MODE_HDMI,
+  HDMI_MODE_3D,
+  HDMI_MODE_DUMMY = 0x7FFFFFFF
+} HDMI_MODE_T;
+
+typedef enum {
+  HDMI_ASPECT_UNKNOWN = 0,
+  HDMI_ASPECT_4_3 = 1,
+  HDMI_ASPECT_14_9 = 2,
+  HDMI_ASPECT_16_9 = 3,
+  HDMI_ASPECT_5_4 = 4,
+  HDMI_ASPECT_16_10 = 5,
+  HDMI_ASPECT_15_9 = 6,
+  HDMI_ASPECT_64_27 = 7,
+  HDMI_ASPECT_HD_4_3 = 8,
+  HDMI_ASPECT_HD_14_9 = 9,
+  HDMI_ASPECT_HD_16_9 = 10,
+  HDMI_ASPECT_HD_5_4 = 11,
+  HDMI_ASPECT_HD_16_10 = 12,
+  HDMI_ASPECT_HD_15_9 = 13,
+  HDMI_ASPECT_HD_64_27 = 14,
+  HDMI_ASPECT_DUMMY = 0x7FFFFFFF
+} HDMI_ASPECT_T;
+
+typedef enum {
+  SDTV_ASPECT_UNKNOWN = 0,
+  SDTV_ASPECT_4_3 = 1,
+  SDTV_ASPECT_14_9 = 2,
+  SDTV_ASPECT_16_9 = 3
+} SDTV_ASPECT_T;
+
+#define HDMI_3D_STRUCT_NONE 0
+#define HDMI_3D_STRUCT_FRAME_PACKING (1 << 0)
+#define HDMI_3D_STRUCT_FIELD_ALTERNATIVE (1 << 1)
+#define HDMI_3D_STRUCT_LINE_ALTERNATIVE (1 << 2)
+#define HDMI_3D_STRUCT_SIDE_BY_SIDE_FULL (1 << 3)
+#define HDMI_3D_STRUCT_L_DEPTH (1 << 4)
+#define HDMI_3D_STRUCT_L_DEPTH_GRAPHICS_GRAPHICS_DEPTH (1 << 5)
+#define HDMI_3D_STRUCT_TOP_AND_BOTTOM (1 << 6)
+#define HDMI_3D_STRUCT_SIDE_BY_SIDE_HALF_HORIZONTAL (1 << 8)
+
+typedef enum {
+  HDMI_PROPERTY_PIXEL_ENCODING = 0,
+  HDMI_PROPERTY_PIXEL_CLOCK_TYPE = 1,
+  HDMI_PROPERTY_CONTENT_TYPE = 2,
+  HDMI_PROPERTY_FUZZY_MATCH = 3,
+  HDMI_PROPERTY_3D_STRUCTURE = 4,
+  HDMI_PROPERTY_MAX
+} HDMI_PROPERTY_T;
+
+typedef enum {
+  HDMI_PIXEL_CLOCK_TYPE_PAL = 0,
+  HDMI_PIXEL_CLOCK_TYPE_NTSC = 1,
+  HDMI_PIXEL_CLOCK_TYPE_MAX
+} HDMI_PIXEL_CLOCK_TYPE_T;
+
+typedef enum {
+  HDMI_3D_FORMAT_NONE = 0,
+  HDMI_3D_FORMAT_SBS_HALF = 1,
+  HDMI_3D_FORMAT_TB_HALF = 2,
+  HDMI_3D_FORMAT_FRAME_PACKING = 3,
+  HDMI_3D_FORMAT_FRAME_SEQUENTIAL = 4
+} HDMI_3D_FORMAT_T;
+
+typedef struct {
+  HDMI_PROPERTY_T property;
+  uint32_t param1;
+  uint32_t param2;
+} HDMI_PROPERTY_PARAM_T;
+
+typedef struct {
+  uint16_t scan_mode : 1;
+  uint16_t native : 1;
+  uint16_t group : 3;
+  uint16_t reserved : 11;
+  uint16_t code;
+  uint32_t struct_3d_mask;
+  uint16_t width;
+  uint16_t height;
+  uint16_t frame_rate;
+  uint16_t aspect_ratio;
+  uint32_t pixel_freq;
+} TV_SUPPORTED_MODE_NEW_T;
+
+typedef struct {
+  uint32_t state;
+  uint32_t width;
+  uint32_t height;
+  uint16_t frame_rate;
+  uint16_t scan_mode;
+  uint32_t group;
+  uint32_t mode;
+  uint16_t pixel_rep;
+  uint16_t aspect_ratio;
+  uint32_t pixel_encoding;
+  uint32_t format_3d;
+} TV_HDMI_DISPLAY_STATE_T;
+
+typedef struct {
+  uint32_t aspect;
+} SDTV_OPTIONS_T;
+
+typedef struct {
+  uint32_t state;
+  uint32_t width;
+  uint32_t height;
+  uint16_t frame_rate;
+  uint16_t scan_mode;
+  uint32_t mode;
+  SDTV_OPTIONS_T display_options;
+  uint32_t cp_mode;
+  uint32_t cp_status;
+} TV_SDTV_DISPLAY_STATE_T;
+
+typedef struct {
+  uint32_t state;
+  union {
+    TV_SDTV_DISPLAY_STATE_T sdtv;
+    TV_HDMI_DISPLAY_STATE_T hdmi;
+  } display;
+} TV_DISPLAY_STATE_T;
+
+typedef enum {
+  EDID_AudioFormat_eReserved,
+  EDID_AudioFormat_ePCM,
+  EDID_AudioFormat_eAC3,
+  EDID_AudioFormat_eMPEG1,
+  EDID_AudioFormat_eMP3,
+  EDID_AudioFormat_eMPEG2,
+  EDID_AudioFormat_eAAC,
+  EDID_AudioFormat_eDTS,
+  EDID_AudioFormat_eATRAC,
+  EDID_AudioFormat_eDSD,
+  EDID_AudioFormat_eEAC3,
+  EDID_AudioFormat_eDTS_HD,
+  EDID_AudioFormat_eMLP,
+  EDID_AudioFormat_eDST,
+  EDID_AudioFormat_eWMAPRO,
+  EDID_AudioFormat_eExtended
+} EDID_AudioFormat;
+
+typedef enum {
+  EDID_AudioSampleRate_eReferToHeader = 0x0,
+  EDID_AudioSampleRate_e32KHz = 1 << 0,
+  EDID_AudioSampleRate_e44KHz = 1 << 1,
+  EDID_AudioSampleRate_e48KHz = 1 << 2,
+  EDID_AudioSampleRate_e88KHz = 1 << 3,
+  EDID_AudioSampleRate_e96KHz = 1 << 4,
+  EDID_AudioSampleRate_e176KHz = 1 << 5,
+  EDID_AudioSampleRate_e192KHz = 1 << 6
+} EDID_AudioSampleRate;
+
+typedef enum {
+  EDID_AudioSampleSize_refheader = 0x0,
+  EDID_AudioSampleSize_16bit = 1 << 0,
+  EDID_AudioSampleSize_20bit = 1 << 1,
+  EDID_AudioSampleSize_24bit = 1 << 2
+} EDID_AudioSampleSize;
+
+typedef void (*TVSERVICE_CALLBACK_T)(void *callback_data, uint32_t reason, uint32_t param1, uint32_t param2);
+typedef void (*CECSERVICE_CALLBACK_T)(void *callback_data, uint32_t reason, uint32_t param1,
+                                      uint32_t param2, uint32_t param3, uint32_t param4);
+
+int vc_tv_hdmi_get_supported_modes_new(HDMI_RES_GROUP_T group, TV_SUPPORTED_MODE_NEW_T *supported_modes,
+                                       uint32_t max_supported_modes, HDMI_RES_GROUP_T *preferred_group,
+                                       uint32_t *preferred_mode);
+int vc_tv_hdmi_power_on_explicit_new(HDMI_MODE_T mode, HDMI_RES_GROUP_T group, uint32_t code);
+int vc_tv_hdmi_set_property(const HDMI_PROPERTY_PARAM_T *property);
+int vc_tv_get_display_state(TV_DISPLAY_STATE_T *tvstate);
+int vc_tv_show_info(uint32_t show);
+int vc_tv_hdmi_audio_supported(uint32_t audio_format, uint32_t num_channels,
+                               EDID_AudioSampleRate fs, uint32_t bitrate);
+void vc_tv_register_callback(TVSERVICE_CALLBACK_T callback, void *callback_data);
+void vc_tv_unregister_callback(TVSERVICE_CALLBACK_T callback);
+void vc_cec_register_callback(CECSERVICE_CALLBACK_T callback, void *callback_data);
+void vc_cec_unregister_callback(CECSERVICE_CALLBACK_T callback);
+
+/* gencmd */
+
+int vc_gencmd(char *response, int maxlen, const char *format, ...);
+int vc_gencmd_number_property(char *text, const char *property, int *number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
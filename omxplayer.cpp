@@ -42,6 +42,7 @@ extern "C" {
 #include "DllAvFormat.h"
 #include "DllAvCodec.h"
 #include "linux/RBP.h"
+#include "linux/OMXAlsa.h"
 
 #include "OMXVideo.h"
 #include "OMXAudioCodecOMX.h"
@@ -49,6 +50,10 @@ extern "C" {
 #include "OMXClock.h"
 #include "OMXAudio.h"
 #include "OMXReader.h"
+#include "OMXPacketPool.h"
+#include "OMXReaderThread.h"
+#include "OMXPlaylist.h"
+#include "OMXWakeup.h"
 #include "OMXPlayerVideo.h"
 #include "OMXPlayerAudio.h"
 #include "OMXPlayerSubtitles.h"
@@ -67,6 +72,9 @@ extern "C" {
 // when we repeatedly seek, rather than play continuously
 #define TRICKPLAY(speed) (speed < 0 || speed > 4 * DVD_PLAYSPEED_NORMAL)
 
+// longest the control loop sleeps waiting for the pipeline, in ms
+#define FEED_WAKEUP_TIMEOUT 50
+
 #define DISPLAY_TEXT(text, ms) if(m_osd) m_player_subtitles.DisplayText(text, ms)
 
 #define DISPLAY_TEXT_SHORT(text) DISPLAY_TEXT(text, 1000)
@@ -97,7 +105,11 @@ bool              m_title_centered      = false;
 bool              m_ghost_box           = true;
 unsigned int      m_subtitle_lines      = 3;
 bool              m_Pause               = false;
-OMXReader         m_omx_reader;
+// the spare reader holds the next playlist entry while the other one plays
+OMXReader         m_omx_readers[2];
+OMXReader         *m_omx_reader         = &m_omx_readers[0];
+OMXReaderThread   m_omx_reader_thread;
+OMXPlaylist       m_playlist;
 int               m_audio_index_use     = 0;
 OMXClock          *m_av_clock           = NULL;
 OMXControl        m_omxcontrol;
@@ -112,6 +124,7 @@ DllBcmHost        m_BcmHost;
 OMXPlayerVideo    m_player_video;
 OMXPlayerAudio    m_player_audio;
 OMXPlayerSubtitles  m_player_subtitles;
+OMXWakeup         m_feed_wakeup;
 int               m_tv_show_info        = 0;
 bool              m_has_video           = false;
 bool              m_has_audio           = false;
@@ -166,7 +179,7 @@ void print_version()
 
 static void PrintSubtitleInfo()
 {
-  auto count = m_omx_reader.SubtitleStreamCount();
+  auto count = m_omx_reader->SubtitleStreamCount();
   size_t index = 0;
 
   if(m_has_external_subtitles)
@@ -194,7 +207,7 @@ static void SetSpeed(int iSpeed)
   if(!m_av_clock)
     return;
 
-  m_omx_reader.SetSpeed(iSpeed);
+  m_omx_reader_thread.SetSpeed(iSpeed);
 
   // flush when in trickplay mode
   if (TRICKPLAY(iSpeed) || TRICKPLAY(m_av_clock->OMXPlaySpeed()))
@@ -251,11 +264,50 @@ static void FlushStreams(double pts)
 
   if(m_omx_pkt)
   {
-    m_omx_reader.FreePacket(m_omx_pkt);
+    m_omx_reader->FreePacket(m_omx_pkt);
     m_omx_pkt = NULL;
   }
 }
 
+// how a preopened playlist entry follows the current file
+enum EPlaylistSwitch
+{
+  PLAYLIST_SPLICE,      // packets go on into the running decoders
+  PLAYLIST_RECONFIGURE, // the video decoder is reopened for the new stream
+  PLAYLIST_RESTART      // everything is set up again as for a new file
+};
+
+static EPlaylistSwitch GetPlaylistSwitch(OMXReader *next, bool match_fps)
+{
+  bool has_video = next->VideoStreamCount() > 0;
+  bool has_audio = m_audio_index_use < 0 ? false : next->AudioStreamCount() > 0;
+
+  if(has_video != m_has_video || has_audio != m_has_audio)
+    return PLAYLIST_RESTART;
+
+  // the subtitle player is set up for a number of streams
+  if(m_has_subtitle && next->SubtitleStreamCount() != m_omx_reader->SubtitleStreamCount())
+    return PLAYLIST_RESTART;
+
+  // audio format changes are picked up by the audio player itself
+  if(!m_has_video)
+    return PLAYLIST_SPLICE;
+
+  COMXStreamInfo hints;
+  const COMXStreamInfo &current = m_config_video.hints;
+  next->GetHints(OMXSTREAM_VIDEO, hints);
+
+  if(hints.codec != current.codec || hints.width != current.width || hints.height != current.height ||
+     hints.extrasize != current.extrasize ||
+     (hints.extrasize && memcmp(hints.extradata, current.extradata, hints.extrasize) != 0))
+    return PLAYLIST_RECONFIGURE;
+
+  if(match_fps && (int64_t)hints.fpsrate * current.fpsscale != (int64_t)current.fpsrate * hints.fpsscale)
+    return PLAYLIST_RECONFIGURE;
+
+  return PLAYLIST_SPLICE;
+}
+
 static void CallbackTvServiceCallback(void *userdata, uint32_t reason, uint32_t param1, uint32_t param2)
 {
   sem_t *tv_synced = (sem_t *)userdata;
@@ -509,6 +561,7 @@ int main(int argc, char *argv[])
 
   bool                  m_send_eos            = false;
   bool                  m_packet_after_seek   = false;
+  int                   m_trickplay_speed     = DVD_PLAYSPEED_NORMAL;
   bool                  m_seek_flush          = false;
   bool                  m_chapter_seek        = false;
   std::string           m_filename;
@@ -530,11 +583,49 @@ int main(int argc, char *argv[])
   float m_fps            = 0.0f; // unset
   TV_DISPLAY_STATE_T   tv_state;
   double last_seek_pos = 0;
+  // accurate seeks land on the requested time instead of the keyframe before it
+  bool m_accurate_seek   = false;
+  bool seek_accurate     = false;
+  // seek-to-first-frame timing, by fast (0) and accurate (1) seeks
+  int64_t seek_start     = 0;
+  bool seek_start_accurate = false;
+  unsigned int seek_count[2] = { 0, 0 };
+  int64_t seek_time[2]   = { 0, 0 };
+  // the reader wraps a looping file by itself, optionally replaying the first GOP from memory
+  bool m_seamless_loop   = false;
+  bool m_loop_keep_gop   = false;
+  // gapless playlist, the entry after the current one is opened in the spare reader
+  bool m_use_playlist    = false;
+  bool preopened         = false;
+  OMXReader *next_reader = NULL;
+  OMXReader *retired_reader = NULL; // read out, closed once nothing refers to it
+  std::string next_filename;
+  double clip_end        = DVD_NOPTS_VALUE; // end of the packets read so far, on the continued timeline
+  double clip_last       = DVD_NOPTS_VALUE; // start of the last packet read
+  bool splice_video      = false; // the next packet of the stream gets the discontinuity flag
+  bool splice_audio      = false;
+  bool splice_pending    = false; // the clock has not reached the spliced file yet
+  // inter-clip gap: wall time from the clock passing gap_from to reaching gap_to,
+  // less the media time in between
+  double gap_from        = DVD_NOPTS_VALUE;
+  double gap_to          = DVD_NOPTS_VALUE;
+  int64_t gap_start      = 0;
+  unsigned int clip_count[3] = { 0, 0, 0 };
+  int64_t gap_total[3]   = { 0, 0, 0 };
+  int64_t gap_max        = 0;
+  EPlaylistSwitch gap_switch = PLAYLIST_SPLICE;
   bool idle = false;
   std::string            m_cookie              = "";
   std::string            m_user_agent          = "";
   std::string            m_lavfdopts           = "";
   std::string            m_avdict              = "";
+#ifdef USE_VIDEOCORE_STUBS
+  // no VideoCore to fall back to, see linux/VCStub.cpp
+  int                    m_soft_omx            = OMXALSA_SOFT_NULL;
+#else
+  int                    m_soft_omx            = OMXALSA_SOFT_OFF;
+#endif
+  std::string            m_soft_omx_out        = "";
 
   const int font_opt        = 0x100;
   const int italic_font_opt = 0x201;
@@ -556,6 +647,7 @@ int main(int argc, char *argv[])
   const int no_deinterlace_opt = 0x10b;
   const int threshold_opt   = 0x10c;
   const int timeout_opt     = 0x10f;
+  const int file_cache_opt  = 0x110;
   const int boost_on_downmix_opt = 0x200;
   const int no_boost_on_downmix_opt = 0x207;
   const int key_config_opt  = 0x10d;
@@ -580,6 +672,12 @@ int main(int argc, char *argv[])
   const int http_user_agent_opt = 0x301;
   const int lavfdopts_opt   = 0x400;
   const int avdict_opt      = 0x401;
+  const int soft_omx_opt    = 0x402;
+  const int soft_omx_out_opt = 0x403;
+  const int direct_input_opt = 0x404;
+  const int accurate_seek_opt = 0x405;
+  const int playlist_opt    = 0x406;
+  const int seamless_loop_opt = 0x407;
 
   struct option longopts[] = {
     { "info",         no_argument,        NULL,          'i' },
@@ -629,6 +727,7 @@ int main(int argc, char *argv[])
     { "video_queue",  required_argument,  NULL,          video_queue_opt },
     { "threshold",    required_argument,  NULL,          threshold_opt },
     { "timeout",      required_argument,  NULL,          timeout_opt },
+    { "file_cache",   required_argument,  NULL,          file_cache_opt },
     { "boost-on-downmix", no_argument,    NULL,          boost_on_downmix_opt },
     { "no-boost-on-downmix", no_argument, NULL,          no_boost_on_downmix_opt },
     { "key-config",   required_argument,  NULL,          key_config_opt },
@@ -647,6 +746,12 @@ int main(int argc, char *argv[])
     { "user-agent",   required_argument,  NULL,          http_user_agent_opt },
     { "lavfdopts",    required_argument,  NULL,          lavfdopts_opt },
     { "avdict",       required_argument,  NULL,          avdict_opt },
+    { "soft-omx",     optional_argument,  NULL,          soft_omx_opt },
+    { "soft-omx-out", required_argument,  NULL,          soft_omx_out_opt },
+    { "direct-input", no_argument,        NULL,          direct_input_opt },
+    { "accurate-seek", no_argument,       NULL,          accurate_seek_opt },
+    { "playlist",     no_argument,        NULL,          playlist_opt },
+    { "seamless-loop", optional_argument, NULL,          seamless_loop_opt },
     { 0, 0, 0, 0 }
   };
 
@@ -879,6 +984,10 @@ int main(int argc, char *argv[])
       case timeout_opt:
         m_timeout = atof(optarg);
         break;
+      case file_cache_opt:
+        m_omx_readers[0].SetCacheSize((unsigned int)(atof(optarg) * 1024 * 1024));
+        m_omx_readers[1].SetCacheSize((unsigned int)(atof(optarg) * 1024 * 1024));
+        break;
       case orientation_opt:
         m_orientation = atoi(optarg);
         break;
@@ -941,6 +1050,44 @@ int main(int argc, char *argv[])
       case avdict_opt:
         m_avdict = optarg;
         break;
+      case soft_omx_opt:
+        if (!optarg || strcmp(optarg, "null") == 0)
+          m_soft_omx = OMXALSA_SOFT_NULL;
+        else if (strcmp(optarg, "avcodec") == 0)
+          m_soft_omx = OMXALSA_SOFT_AVCODEC;
+        else
+        {
+          printf("Wrong soft-omx mode specified: %s\n", optarg);
+          print_usage();
+          return EXIT_FAILURE;
+        }
+        break;
+      case soft_omx_out_opt:
+        m_soft_omx_out = optarg;
+        break;
+      case direct_input_opt:
+        m_config_video.direct_input = true;
+        m_config_audio.direct_input = true;
+        break;
+      case accurate_seek_opt:
+        m_accurate_seek = true;
+        break;
+      case playlist_opt:
+        m_use_playlist = true;
+        break;
+      case seamless_loop_opt:
+        if (optarg && strcmp(optarg, "gop") != 0)
+        {
+          printf("Wrong seamless-loop mode specified: %s\n", optarg);
+          print_usage();
+          return EXIT_FAILURE;
+        }
+        if(m_incr != 0)
+            m_loop_from = m_incr;
+        m_loop = true;
+        m_seamless_loop = true;
+        m_loop_keep_gop = optarg != NULL;
+        break;
       case 0:
         break;
       case 'h':
@@ -971,6 +1118,19 @@ int main(int argc, char *argv[])
 
   m_filename = argv[optind];
 
+  if (m_use_playlist)
+  {
+    if (!m_playlist.Load(m_filename))
+    {
+      printf("Playlist \"%s\" is empty or could not be read.\n", m_filename.c_str());
+      return EXIT_FAILURE;
+    }
+    // a looping playlist starts over with its first entry
+    m_playlist.SetWrap(m_loop);
+    m_playlist.SetOpenOptions(m_dump_format, m_config_audio.is_live, m_timeout, m_cookie, m_user_agent, m_lavfdopts, m_avdict);
+    m_filename = m_playlist.First();
+  }
+
   auto PrintFileNotFound = [](const std::string& path)
   {
     printf("File \"%s\" not found.\n", path.c_str());
@@ -1038,22 +1198,45 @@ int main(int argc, char *argv[])
     CLog::SetLogLevel(LOG_LEVEL_NONE);
   }
 
-  g_RBP.Initialize();
+  if (m_soft_omx != OMXALSA_SOFT_OFF)
+  {
+    // software components: no VideoCore, so nothing that needs the display or dispmanx
+    if (OMXALSA_SetSoftComponents(m_soft_omx, m_soft_omx_out.c_str()) != OMX_ErrorNone)
+    {
+      printf("Cannot open soft-omx output %s\n", m_soft_omx_out.c_str());
+      return EXIT_FAILURE;
+    }
+    m_NativeDeinterlace = false;
+    m_osd = false;
+    m_config_video.deinterlace = VS_DEINTERLACEMODE_OFF;
+    m_config_video.anaglyph = OMX_ImageFilterAnaglyphNone;
+    m_config_audio.passthrough = false;
+    m_config_audio.hwdecode = false;
+    if (m_config_audio.device != "omx:alsa")
+      m_config_audio.device = "omx:local";
+  }
+  else
+  {
+    g_RBP.Initialize();
+  }
   g_OMX.Initialize();
 
-  blank_background(m_blank_background);
+  if (m_soft_omx == OMXALSA_SOFT_OFF)
+  {
+    blank_background(m_blank_background);
 
-  int gpu_mem = get_mem_gpu();
-  int min_gpu_mem = 64;
-  if (gpu_mem > 0 && gpu_mem < min_gpu_mem)
-    printf("Only %dM of gpu_mem is configured. Try running \"sudo raspi-config\" and ensure that \"memory_split\" has a value of %d or greater\n", gpu_mem, min_gpu_mem);
+    int gpu_mem = get_mem_gpu();
+    int min_gpu_mem = 64;
+    if (gpu_mem > 0 && gpu_mem < min_gpu_mem)
+      printf("Only %dM of gpu_mem is configured. Try running \"sudo raspi-config\" and ensure that \"memory_split\" has a value of %d or greater\n", gpu_mem, min_gpu_mem);
+  }
 
   m_av_clock = new OMXClock();
   int control_err = m_omxcontrol.init(
     m_av_clock,
     &m_player_audio,
     &m_player_subtitles,
-    &m_omx_reader,
+    m_omx_reader,
     m_dbus_name
   );
   if (false == m_no_keys)
@@ -1068,17 +1251,23 @@ int main(int argc, char *argv[])
 
   change_file:
 
-  if(!m_omx_reader.Open(m_filename.c_str(), m_dump_format, m_config_audio.is_live, m_timeout, m_cookie.c_str(), m_user_agent.c_str(), m_lavfdopts.c_str(), m_avdict.c_str()))
+  if(!preopened && !m_omx_reader->Open(m_filename.c_str(), m_dump_format, m_config_audio.is_live, m_timeout, m_cookie.c_str(), m_user_agent.c_str(), m_lavfdopts.c_str(), m_avdict.c_str()))
     goto do_exit;
+  preopened = false;
 
   if (m_dump_format_exit)
     goto do_exit;
 
-  m_has_video     = m_omx_reader.VideoStreamCount();
-  m_has_audio     = m_audio_index_use < 0 ? false : m_omx_reader.AudioStreamCount();
-  m_has_subtitle  = m_has_external_subtitles ||
-                    m_omx_reader.SubtitleStreamCount();
-  m_loop          = m_loop && m_omx_reader.CanSeek();
+  m_has_video     = m_omx_reader->VideoStreamCount();
+  m_has_audio     = m_audio_index_use < 0 ? false : m_omx_reader->AudioStreamCount();
+  m_has_subtitle  = m_soft_omx == OMXALSA_SOFT_OFF &&
+                    (m_has_external_subtitles ||
+                     m_omx_reader->SubtitleStreamCount());
+  m_loop          = m_loop && m_omx_reader->CanSeek();
+
+  // the decoders and the clock never see the end, the reader wraps and keeps the timestamps going
+  if (m_seamless_loop && m_loop && !m_use_playlist)
+    m_omx_reader->SetLoop(true, (int)(m_loop_from * 1000), m_loop_keep_gop);
 
   if (m_audio_extension)
   {
@@ -1095,6 +1284,13 @@ int main(int argc, char *argv[])
   if (m_3d != CONF_FLAGS_FORMAT_NONE || m_NativeDeinterlace)
     m_refresh = true;
 
+  // there is no display to switch with the software components
+  if (m_soft_omx != OMXALSA_SOFT_OFF)
+  {
+    m_3d = CONF_FLAGS_FORMAT_NONE;
+    m_refresh = false;
+  }
+
   // you really don't want want to match refresh rate without hdmi clock sync
   if ((m_refresh || m_NativeDeinterlace) && !m_no_hdmi_clock_sync)
     m_config_video.hdmi_clock_sync = true;
@@ -1109,14 +1305,14 @@ int main(int argc, char *argv[])
   m_av_clock->OMXStop();
   m_av_clock->OMXPause();
 
-  m_omx_reader.GetHints(OMXSTREAM_AUDIO, m_config_audio.hints);
-  m_omx_reader.GetHints(OMXSTREAM_VIDEO, m_config_video.hints);
+  m_omx_reader->GetHints(OMXSTREAM_AUDIO, m_config_audio.hints);
+  m_omx_reader->GetHints(OMXSTREAM_VIDEO, m_config_video.hints);
 
   if (m_fps > 0.0f)
     m_config_video.hints.fpsrate = m_fps * DVD_TIME_BASE, m_config_video.hints.fpsscale = DVD_TIME_BASE;
 
   if(m_audio_index_use > 0)
-    m_omx_reader.SetActiveStream(OMXSTREAM_AUDIO, m_audio_index_use-1);
+    m_omx_reader->SetActiveStream(OMXSTREAM_AUDIO, m_audio_index_use-1);
           
   if(m_has_video && m_refresh)
   {
@@ -1126,20 +1322,32 @@ int main(int argc, char *argv[])
     SetVideoMode(m_config_video.hints.width, m_config_video.hints.height, m_config_video.hints.fpsrate, m_config_video.hints.fpsscale, m_3d);
   }
   // get display aspect
-  TV_DISPLAY_STATE_T current_tv_state;
-  memset(&current_tv_state, 0, sizeof(TV_DISPLAY_STATE_T));
-  m_BcmHost.vc_tv_get_display_state(&current_tv_state);
-  if(current_tv_state.state & ( VC_HDMI_HDMI | VC_HDMI_DVI )) {
-    //HDMI or DVI on
-    m_config_video.display_aspect = get_display_aspect_ratio((HDMI_ASPECT_T)current_tv_state.display.hdmi.aspect_ratio);
-  } else {
-    //composite on
-    m_config_video.display_aspect = get_display_aspect_ratio((SDTV_ASPECT_T)current_tv_state.display.sdtv.display_options.aspect);
+  if (m_soft_omx != OMXALSA_SOFT_OFF)
+  {
+    m_config_video.display_aspect = 1.0f;
+  }
+  else
+  {
+    TV_DISPLAY_STATE_T current_tv_state;
+    memset(&current_tv_state, 0, sizeof(TV_DISPLAY_STATE_T));
+    m_BcmHost.vc_tv_get_display_state(&current_tv_state);
+    if(current_tv_state.state & ( VC_HDMI_HDMI | VC_HDMI_DVI )) {
+      //HDMI or DVI on
+      m_config_video.display_aspect = get_display_aspect_ratio((HDMI_ASPECT_T)current_tv_state.display.hdmi.aspect_ratio);
+    } else {
+      //composite on
+      m_config_video.display_aspect = get_display_aspect_ratio((SDTV_ASPECT_T)current_tv_state.display.sdtv.display_options.aspect);
+    }
+    m_config_video.display_aspect *= (float)current_tv_state.display.hdmi.height/(float)current_tv_state.display.hdmi.width;
   }
-  m_config_video.display_aspect *= (float)current_tv_state.display.hdmi.height/(float)current_tv_state.display.hdmi.width;
 
   if (m_orientation >= 0)
     m_config_video.hints.orientation = m_orientation;
+  // the main loop sleeps on this until the demuxer or a player made progress
+  m_player_video.SetWakeup(&m_feed_wakeup);
+  m_player_audio.SetWakeup(&m_feed_wakeup);
+  m_omx_reader_thread.SetWakeup(&m_feed_wakeup);
+
   if(m_has_video && !m_player_video.Open(m_av_clock, m_config_video))
     goto do_exit;
 
@@ -1153,7 +1361,7 @@ int main(int argc, char *argv[])
        goto do_exit;
     }
 
-    if(!m_player_subtitles.Open(m_omx_reader.SubtitleStreamCount(),
+    if(!m_player_subtitles.Open(m_omx_reader->SubtitleStreamCount(),
                                 std::move(external_subtitles),
                                 m_font_path,
                                 m_italic_font_path,
@@ -1180,7 +1388,7 @@ int main(int argc, char *argv[])
       if(m_subtitle_index != -1)
       {
         m_player_subtitles.SetActiveStream(
-          std::min(m_subtitle_index, m_omx_reader.SubtitleStreamCount()-1));
+          std::min(m_subtitle_index, m_omx_reader->SubtitleStreamCount()-1));
       }
       m_player_subtitles.SetUseExternalSubtitles(false);
     }
@@ -1189,7 +1397,7 @@ int main(int argc, char *argv[])
       m_player_subtitles.SetVisible(false);
   }
 
-  m_omx_reader.GetHints(OMXSTREAM_AUDIO, m_config_audio.hints);
+  m_omx_reader->GetHints(OMXSTREAM_AUDIO, m_config_audio.hints);
 
   if (m_config_audio.device == "")
   {
@@ -1202,14 +1410,15 @@ int main(int argc, char *argv[])
   if(m_config_audio.device == "omx:alsa" && m_config_audio.subdevice.empty())
     m_config_audio.subdevice = "default";
 
-  if ((m_config_audio.hints.codec == AV_CODEC_ID_AC3 || m_config_audio.hints.codec == AV_CODEC_ID_EAC3) &&
+  if (m_config_audio.passthrough &&
+      (m_config_audio.hints.codec == AV_CODEC_ID_AC3 || m_config_audio.hints.codec == AV_CODEC_ID_EAC3) &&
       m_BcmHost.vc_tv_hdmi_audio_supported(EDID_AudioFormat_eAC3, 2, EDID_AudioSampleRate_e44KHz, EDID_AudioSampleSize_16bit ) != 0)
     m_config_audio.passthrough = false;
-  if (m_config_audio.hints.codec == AV_CODEC_ID_DTS &&
+  if (m_config_audio.passthrough && m_config_audio.hints.codec == AV_CODEC_ID_DTS &&
       m_BcmHost.vc_tv_hdmi_audio_supported(EDID_AudioFormat_eDTS, 2, EDID_AudioSampleRate_e44KHz, EDID_AudioSampleSize_16bit ) != 0)
     m_config_audio.passthrough = false;
 
-  if(m_has_audio && !m_player_audio.Open(m_av_clock, m_config_audio, &m_omx_reader))
+  if(m_has_audio && !m_player_audio.Open(m_av_clock, m_config_audio, m_omx_reader))
     goto do_exit;
 
   if(m_has_audio)
@@ -1228,6 +1437,12 @@ int main(int argc, char *argv[])
   m_av_clock->OMXStateExecute();
   sentStarted = true;
 
+  m_omx_reader_thread.Open(m_omx_reader);
+
+  // the next playlist entry is probed while this one plays
+  if (m_use_playlist && !m_playlist.IsPreopening() && !retired_reader)
+    m_playlist.Preopen(&m_omx_readers[m_omx_reader == &m_omx_readers[0] ? 1 : 0]);
+
   while(!m_stop)
   {
     if(g_abort)
@@ -1251,7 +1466,15 @@ int main(int argc, char *argv[])
     {
      case KeyConfig::ACTION_CHANGE_FILE:
         FlushStreams(DVD_NOPTS_VALUE);
-        m_omx_reader.Close();
+        m_omx_reader_thread.Close();
+        m_omx_reader->Close();
+        if (retired_reader)
+          retired_reader->Close();
+        retired_reader = NULL;
+        m_omxcontrol.SetReader(m_omx_reader);
+        splice_pending = false;
+        gap_from = gap_to = clip_end = clip_last = DVD_NOPTS_VALUE;
+        gap_start = 0;
         m_player_subtitles.Close();
         m_player_video.Close();
         m_player_audio.Close();
@@ -1259,8 +1482,10 @@ int main(int argc, char *argv[])
         goto change_file;
         break;
       case KeyConfig::ACTION_SHOW_INFO:
+        if (m_soft_omx != OMXALSA_SOFT_OFF)
+          break;
         m_tv_show_info = !m_tv_show_info;
-        vc_tv_show_info(m_tv_show_info);
+        m_BcmHost.vc_tv_show_info(m_tv_show_info);
         break;
       case KeyConfig::ACTION_DECREASE_SPEED:
         if (playspeed_current < playspeed_slow_min || playspeed_current > playspeed_slow_max)
@@ -1319,7 +1544,7 @@ int main(int argc, char *argv[])
         printf("Step\n");
         {
           auto t = (unsigned) (m_av_clock->OMXMediaTime()*1e-3);
-          auto dur = m_omx_reader.GetStreamLength() / 1000;
+          auto dur = m_omx_reader->GetStreamLength() / 1000;
           DISPLAY_TEXT_SHORT(
             strprintf("Step\n%02d:%02d:%02d.%03d / %02d:%02d:%02d",
               (t/3600000), (t/60000)%60, (t/1000)%60, t%1000,
@@ -1329,28 +1554,28 @@ int main(int argc, char *argv[])
       case KeyConfig::ACTION_PREVIOUS_AUDIO:
         if(m_has_audio)
         {
-          int new_index = m_omx_reader.GetAudioIndex() - 1;
+          int new_index = m_omx_reader->GetAudioIndex() - 1;
           if(new_index >= 0)
           {
-            m_omx_reader.SetActiveStream(OMXSTREAM_AUDIO, new_index);
+            m_omx_reader_thread.SetActiveStream(OMXSTREAM_AUDIO, new_index);
             DISPLAY_TEXT_SHORT(
-              strprintf("Audio stream: %d", m_omx_reader.GetAudioIndex() + 1));
+              strprintf("Audio stream: %d", m_omx_reader->GetAudioIndex() + 1));
           }
         }
         break;
       case KeyConfig::ACTION_NEXT_AUDIO:
         if(m_has_audio)
         {
-          m_omx_reader.SetActiveStream(OMXSTREAM_AUDIO, m_omx_reader.GetAudioIndex() + 1);
+          m_omx_reader_thread.SetActiveStream(OMXSTREAM_AUDIO, m_omx_reader->GetAudioIndex() + 1);
           DISPLAY_TEXT_SHORT(
-            strprintf("Audio stream: %d", m_omx_reader.GetAudioIndex() + 1));
+            strprintf("Audio stream: %d", m_omx_reader->GetAudioIndex() + 1));
         }
         break;
       case KeyConfig::ACTION_PREVIOUS_CHAPTER:
-        if(m_omx_reader.GetChapterCount() > 0)
+        if(m_omx_reader->GetChapterCount() > 0)
         {
-          m_omx_reader.SeekChapter(m_omx_reader.GetChapter() - 1, &startpts);
-          DISPLAY_TEXT_LONG(strprintf("Chapter %d", m_omx_reader.GetChapter()));
+          m_omx_reader_thread.SeekChapter(m_omx_reader->GetChapter() - 1, &startpts);
+          DISPLAY_TEXT_LONG(strprintf("Chapter %d", m_omx_reader->GetChapter()));
           FlushStreams(startpts);
           m_seek_flush = true;
           m_chapter_seek = true;
@@ -1361,10 +1586,10 @@ int main(int argc, char *argv[])
         }
         break;
       case KeyConfig::ACTION_NEXT_CHAPTER:
-        if(m_omx_reader.GetChapterCount() > 0)
+        if(m_omx_reader->GetChapterCount() > 0)
         {
-          m_omx_reader.SeekChapter(m_omx_reader.GetChapter() + 1, &startpts);
-          DISPLAY_TEXT_LONG(strprintf("Chapter %d", m_omx_reader.GetChapter()));
+          m_omx_reader_thread.SeekChapter(m_omx_reader->GetChapter() + 1, &startpts);
+          DISPLAY_TEXT_LONG(strprintf("Chapter %d", m_omx_reader->GetChapter()));
           FlushStreams(startpts);
           m_seek_flush = true;
           m_chapter_seek = true;
@@ -1404,7 +1629,7 @@ int main(int argc, char *argv[])
         {
           if(m_player_subtitles.GetUseExternalSubtitles())
           {
-            if(m_omx_reader.SubtitleStreamCount())
+            if(m_omx_reader->SubtitleStreamCount())
             {
               assert(m_player_subtitles.GetActiveStream() == 0);
               DISPLAY_TEXT_SHORT("Subtitle stream: 1");
@@ -1414,7 +1639,7 @@ int main(int argc, char *argv[])
           else
           {
             auto new_index = m_player_subtitles.GetActiveStream()+1;
-            if(new_index < (size_t) m_omx_reader.SubtitleStreamCount())
+            if(new_index < (size_t) m_omx_reader->SubtitleStreamCount())
             {
               DISPLAY_TEXT_SHORT(strprintf("Subtitle stream: %d", new_index+1));
               m_player_subtitles.SetActiveStream(new_index);
@@ -1469,24 +1694,26 @@ int main(int argc, char *argv[])
         goto do_exit;
         break;
       case KeyConfig::ACTION_SEEK_BACK_SMALL:
-        if(m_omx_reader.CanSeek()) m_incr = -30.0;
+        if(m_omx_reader->CanSeek()) m_incr = -30.0;
         break;
       case KeyConfig::ACTION_SEEK_FORWARD_SMALL:
-        if(m_omx_reader.CanSeek()) m_incr = 30.0;
+        if(m_omx_reader->CanSeek()) m_incr = 30.0;
         break;
       case KeyConfig::ACTION_SEEK_FORWARD_LARGE:
-        if(m_omx_reader.CanSeek()) m_incr = 600.0;
+        if(m_omx_reader->CanSeek()) m_incr = 600.0;
         break;
       case KeyConfig::ACTION_SEEK_BACK_LARGE:
-        if(m_omx_reader.CanSeek()) m_incr = -600.0;
+        if(m_omx_reader->CanSeek()) m_incr = -600.0;
         break;
       case KeyConfig::ACTION_SEEK_RELATIVE:
           m_incr = result.getArg() * 1e-6;
           break;
       case KeyConfig::ACTION_SEEK_ABSOLUTE:
-          newPos = result.getArg() * 1e-6;
+          newPos = (result.getArg() + m_omx_reader->GetTimeOffset()) * 1e-6;
           oldPos = m_av_clock->OMXMediaTime()*1e-6;
           m_incr = newPos - oldPos;
+          // a position set from outside is expected to be exact
+          seek_accurate = true;
           break;
       case KeyConfig::ACTION_SET_ALPHA:
           m_player_video.SetAlpha(result.getArg());
@@ -1523,7 +1750,7 @@ int main(int argc, char *argv[])
             m_player_subtitles.Pause();
 
           auto t = (unsigned) (m_av_clock->OMXMediaTime()*1e-6);
-          auto dur = m_omx_reader.GetStreamLength() / 1000;
+          auto dur = m_omx_reader->GetStreamLength() / 1000;
           DISPLAY_TEXT_LONG(strprintf("Pause\n%02d:%02d:%02d / %02d:%02d:%02d",
             (t/3600), (t/60)%60, t%60, (dur/3600), (dur/60)%60, dur%60));
         }
@@ -1533,7 +1760,7 @@ int main(int argc, char *argv[])
             m_player_subtitles.Resume();
 
           auto t = (unsigned) (m_av_clock->OMXMediaTime()*1e-6);
-          auto dur = m_omx_reader.GetStreamLength() / 1000;
+          auto dur = m_omx_reader->GetStreamLength() / 1000;
           DISPLAY_TEXT_SHORT(strprintf("Play\n%02d:%02d:%02d / %02d:%02d:%02d",
             (t/3600), (t/60)%60, t%60, (dur/3600), (dur/60)%60, dur%60));
         }
@@ -1627,14 +1854,26 @@ int main(int argc, char *argv[])
       continue;
     }
 
+    // rewinding ran into the start of the file, carry on playing from there
+    if(m_omx_reader->IsTrickplayStart() && m_av_clock->OMXPlaySpeed() < 0)
+    {
+      playspeed_current = playspeed_normal;
+      SetSpeed(playspeeds[playspeed_current]);
+      m_seek_flush = true;
+    }
+
     if(m_seek_flush || m_incr != 0)
     {
       double seek_pos     = 0;
       double pts          = 0;
+      bool accurate       = m_incr != 0 && (seek_accurate || m_accurate_seek);
 
       if(m_has_subtitle)
         m_player_subtitles.Pause();
 
+      seek_start = m_av_clock->GetAbsoluteClock();
+      seek_start_accurate = false;
+
       if (!m_chapter_seek)
       {
         pts = m_av_clock->OMXMediaTime();
@@ -1644,26 +1883,39 @@ int main(int argc, char *argv[])
 
         seek_pos *= 1000.0;
 
-        if(m_omx_reader.SeekTime((int)seek_pos, m_incr < 0.0f, &startpts))
+        // an accurate seek needs the keyframe before the target to decode from
+        if(m_omx_reader_thread.SeekTime((int)seek_pos, m_incr < 0.0f || accurate, &startpts))
         {
           unsigned t = (unsigned)(startpts*1e-6);
-          auto dur = m_omx_reader.GetStreamLength() / 1000;
+          auto dur = m_omx_reader->GetStreamLength() / 1000;
           DISPLAY_TEXT_LONG(strprintf("Seek\n%02d:%02d:%02d / %02d:%02d:%02d",
               (t/3600), (t/60)%60, t%60, (dur/3600), (dur/60)%60, dur%60));
           printf("Seek to: %02d:%02d:%02d\n", (t/3600), (t/60)%60, t%60);
           FlushStreams(startpts);
         }
+        else
+          accurate = false; // startpts is not where the reader is
       }
 
       sentStarted = false;
 
-      if (m_omx_reader.IsEof())
+      if (m_omx_reader_thread.IsEof())
         goto do_exit;
 
       // Quick reset to reduce delay during loop & seek.
       if (m_has_video && !m_player_video.Reset())
         goto do_exit;
 
+      // everything between the keyframe and the target is decoded but not shown
+      if (accurate && !m_chapter_seek)
+      {
+        if (m_has_video)
+          m_player_video.SetStartPts(startpts);
+        if (m_has_audio)
+          m_player_audio.SetStartPts(startpts);
+        seek_start_accurate = true;
+      }
+
       CLog::Log(LOGDEBUG, "Seeked %.0f %.0f %.0f\n", DVD_MSEC_TO_TIME(seek_pos), startpts, m_av_clock->OMXMediaTime());
 
       m_av_clock->OMXPause();
@@ -1673,6 +1925,7 @@ int main(int argc, char *argv[])
       m_packet_after_seek = false;
       m_seek_flush = false;
       m_incr = 0;
+      seek_accurate = false;
     }
     else if(m_packet_after_seek && TRICKPLAY(m_av_clock->OMXPlaySpeed()))
     {
@@ -1684,7 +1937,7 @@ int main(int argc, char *argv[])
 
       seek_pos *= 1000.0;
 
-      if(m_omx_reader.SeekTime((int)seek_pos, m_av_clock->OMXPlaySpeed() < 0, &startpts))
+      if(m_omx_reader_thread.SeekTime((int)seek_pos, m_av_clock->OMXPlaySpeed() < 0, &startpts))
         ; //FlushStreams(DVD_NOPTS_VALUE);
 
       CLog::Log(LOGDEBUG, "Seeked %.0f %.0f %.0f\n", DVD_MSEC_TO_TIME(seek_pos), startpts, m_av_clock->OMXMediaTime());
@@ -1732,10 +1985,31 @@ int main(int argc, char *argv[])
       {
         static int count;
         if ((count++ & 7) == 0)
-           printf("M:%8.0f V:%6.2fs %6dk/%6dk A:%6.2f %6.02fs/%6.02fs Cv:%6dk Ca:%6dk                            \r", stamp,
+        {
+           XFILE::SCacheStatus cache_status = {};
+           m_omx_reader->GetCacheStatus(&cache_status);
+
+           static unsigned int last_wakeups;
+           static int64_t last_clock;
+           unsigned int wakeups = OMXWakeup::GetWakeups();
+           int64_t wakeup_clock = m_av_clock->GetAbsoluteClock();
+           float wakeup_rate = last_clock ? (wakeups - last_wakeups) * 1e6f / (wakeup_clock - last_clock) : 0.0f;
+           // decoder input memcpy traffic, drops towards zero with --direct-input
+           static uint64_t last_copied;
+           uint64_t copied = COMXCoreComponent::GetInputBytesCopied();
+           float copy_rate = last_clock ? (copied - last_copied) * 1e6f / (wakeup_clock - last_clock) / 1024.0f : 0.0f;
+           last_copied = copied;
+           last_wakeups = wakeups;
+           last_clock = wakeup_clock;
+
+           printf("M:%8.0f V:%6.2fs %6dk/%6dk A:%6.2f %6.02fs/%6.02fs Cv:%6dk/%5.2fs Ca:%6dk/%5.2fs Cr:%6dk Cf:%6dk W:%4.0f/s Cp:%5.0fk/s                   \r", stamp,
                video_fifo, (m_player_video.GetDecoderBufferSize()-m_player_video.GetDecoderFreeSpace())>>10, m_player_video.GetDecoderBufferSize()>>10,
                audio_fifo, m_player_audio.GetDelay(), m_player_audio.GetCacheTotal(),
-               m_player_video.GetCached()>>10, m_player_audio.GetCached()>>10);
+               m_player_video.GetCached()>>10, m_player_video.GetCachedDuration() / DVD_TIME_BASE,
+               m_player_audio.GetCached()>>10, m_player_audio.GetCachedDuration() / DVD_TIME_BASE,
+               m_omx_reader_thread.GetCached()>>10,
+               (int)(cache_status.forward>>10), wakeup_rate, copy_rate);
+        }
       }
 
       if(m_tv_show_info)
@@ -1789,7 +2063,7 @@ int main(int argc, char *argv[])
           {
             if (latency > m_threshold)
             {
-              CLog::Log(LOGDEBUG, "Resume %.2f,%.2f (%d,%d,%d,%d) EOF:%d PKT:%p\n", audio_fifo, video_fifo, audio_fifo_low, video_fifo_low, audio_fifo_high, video_fifo_high, m_omx_reader.IsEof(), m_omx_pkt);
+              CLog::Log(LOGDEBUG, "Resume %.2f,%.2f (%d,%d,%d,%d) EOF:%d PKT:%p\n", audio_fifo, video_fifo, audio_fifo_low, video_fifo_low, audio_fifo_high, video_fifo_high, m_omx_reader_thread.IsEof(), m_omx_pkt);
               m_av_clock->OMXResume();
               m_latency = latency;
             }
@@ -1813,11 +2087,11 @@ int main(int argc, char *argv[])
           }
         }
       }
-      else if(!m_Pause && (m_omx_reader.IsEof() || m_omx_pkt || TRICKPLAY(m_av_clock->OMXPlaySpeed()) || (audio_fifo_high && video_fifo_high)))
+      else if(!m_Pause && (m_omx_reader_thread.IsEof() || m_omx_pkt || TRICKPLAY(m_av_clock->OMXPlaySpeed()) || (audio_fifo_high && video_fifo_high)))
       {
         if (m_av_clock->OMXIsPaused())
         {
-          CLog::Log(LOGDEBUG, "Resume %.2f,%.2f (%d,%d,%d,%d) EOF:%d PKT:%p\n", audio_fifo, video_fifo, audio_fifo_low, video_fifo_low, audio_fifo_high, video_fifo_high, m_omx_reader.IsEof(), m_omx_pkt);
+          CLog::Log(LOGDEBUG, "Resume %.2f,%.2f (%d,%d,%d,%d) EOF:%d PKT:%p\n", audio_fifo, video_fifo, audio_fifo_low, video_fifo_low, audio_fifo_high, video_fifo_high, m_omx_reader_thread.IsEof(), m_omx_pkt);
           m_av_clock->OMXResume();
         }
       }
@@ -1831,6 +2105,48 @@ int main(int argc, char *argv[])
           m_av_clock->OMXPause();
         }
       }
+
+      // the first picture after a seek goes out as soon as the clock runs
+      if (seek_start && !m_av_clock->OMXIsPaused())
+      {
+        int64_t elapsed = m_av_clock->GetAbsoluteClock() - seek_start;
+        CLog::Log(LOGINFO, "%s seek to first frame %.1f ms\n", seek_start_accurate ? "Accurate" : "Fast", elapsed / 1000.0);
+        seek_count[seek_start_accurate]++;
+        seek_time[seek_start_accurate] += elapsed;
+        seek_start = 0;
+      }
+    }
+
+    // inter-clip gap, how much longer the clock took from the end of one file to the start of
+    // the next than the media time in between
+    if (gap_to != DVD_NOPTS_VALUE || gap_start)
+    {
+      double media = m_av_clock->OMXMediaTime();
+      int64_t now_abs = m_av_clock->GetAbsoluteClock();
+
+      if (!gap_start && gap_from != DVD_NOPTS_VALUE && media >= gap_from)
+        gap_start = now_abs;
+
+      if (gap_start && !m_av_clock->OMXIsPaused() && (gap_to == DVD_NOPTS_VALUE || media >= gap_to))
+      {
+        int64_t gap = now_abs - gap_start;
+        if (gap_from != DVD_NOPTS_VALUE && gap_to != DVD_NOPTS_VALUE && m_av_clock->OMXPlaySpeed() > 0)
+          gap -= (int64_t)((gap_to - gap_from) * DVD_PLAYSPEED_NORMAL / m_av_clock->OMXPlaySpeed());
+        if (gap < 0)
+          gap = 0;
+
+        CLog::Log(LOGINFO, "Playlist: inter-clip gap %.1f ms\n", gap / 1000.0);
+        clip_count[gap_switch]++;
+        gap_total[gap_switch] += gap;
+        if (gap > gap_max)
+          gap_max = gap;
+
+        if (splice_pending)
+          m_omxcontrol.SetReader(m_omx_reader);
+        splice_pending = false;
+        gap_from = gap_to = DVD_NOPTS_VALUE;
+        gap_start = 0;
+      }
     }
     if (!sentStarted)
     {
@@ -1839,13 +2155,87 @@ int main(int argc, char *argv[])
       sentStarted = true;
     }
 
+    // anything signalled after this point ends the wait below right away
+    unsigned int feed_sequence = m_feed_wakeup.Sequence();
+
     if(!m_omx_pkt)
-      m_omx_pkt = m_omx_reader.Read();
+    {
+      m_omx_pkt = m_omx_reader_thread.Read();
+
+      // remember where the file ends, a spliced one continues from there
+      if(m_omx_pkt && m_use_playlist && m_omx_reader->IsActive(m_omx_pkt->stream_index))
+      {
+        double ts = m_omx_pkt->pts != DVD_NOPTS_VALUE ? m_omx_pkt->pts : m_omx_pkt->dts;
+        if(ts != DVD_NOPTS_VALUE)
+        {
+          double end = ts + (m_omx_pkt->duration != DVD_NOPTS_VALUE ? m_omx_pkt->duration : 0);
+          if(clip_end == DVD_NOPTS_VALUE || end > clip_end)
+            clip_end = end;
+          if(clip_last == DVD_NOPTS_VALUE || ts > clip_last)
+            clip_last = ts;
+        }
+
+        if(splice_video && m_omx_reader->IsActive(OMXSTREAM_VIDEO, m_omx_pkt->stream_index))
+        {
+          m_omx_pkt->discontinuity = true;
+          splice_video = false;
+        }
+        else if(splice_audio && m_omx_reader->IsActive(OMXSTREAM_AUDIO, m_omx_pkt->stream_index))
+        {
+          m_omx_pkt->discontinuity = true;
+          splice_audio = false;
+        }
+      }
+    }
 
     if(m_omx_pkt)
       m_send_eos = false;
 
-    if(m_omx_reader.IsEof() && !m_omx_pkt)
+    // the previous reader can go once the audio player and the clock have left it
+    if(retired_reader && !splice_pending && (!m_has_audio || !m_player_audio.IsSwitchingReader()))
+    {
+      retired_reader->Close();
+      m_playlist.Preopen(retired_reader);
+      retired_reader = NULL;
+    }
+
+    if(m_omx_reader_thread.IsEof() && !m_omx_pkt && m_playlist.IsPreopening() && !next_reader)
+    {
+      int64_t wait_start = m_av_clock->GetAbsoluteClock();
+      next_reader = m_playlist.Take(next_filename);
+      CLog::Log(LOGINFO, "Playlist: %s opened in %.1f ms, waited %.1f ms\n", next_filename.c_str(),
+                m_playlist.GetOpenTime() * 1000.0, (m_av_clock->GetAbsoluteClock() - wait_start) / 1000.0);
+    }
+
+    // a file that fits the running decoders follows without them seeing end of stream
+    if(m_omx_reader_thread.IsEof() && !m_omx_pkt && next_reader && !m_send_eos &&
+       GetPlaylistSwitch(next_reader, m_refresh && m_fps <= 0.0f) == PLAYLIST_SPLICE)
+    {
+      m_omx_reader_thread.Close();
+      retired_reader = m_omx_reader;
+      m_omx_reader = next_reader;
+      next_reader = NULL;
+
+      m_omx_reader->SetTimeOffset(clip_end != DVD_NOPTS_VALUE ? clip_end : 0.0);
+      if(m_audio_index_use > 0)
+        m_omx_reader->SetActiveStream(OMXSTREAM_AUDIO, m_audio_index_use-1);
+      if(m_has_audio)
+        m_player_audio.SetReader(m_omx_reader);
+      splice_video    = m_has_video;
+      splice_audio    = m_has_audio;
+      splice_pending  = true;
+
+      gap_switch  = PLAYLIST_SPLICE;
+      gap_from    = clip_last;
+      gap_to      = clip_end;
+      gap_start   = 0;
+
+      CLog::Log(LOGINFO, "Playlist: splicing %s at %.3f\n", next_filename.c_str(), clip_end / DVD_TIME_BASE);
+      m_omx_reader_thread.Open(m_omx_reader);
+      continue;
+    }
+
+    if(m_omx_reader_thread.IsEof() && !m_omx_pkt)
     {
       if (!m_send_eos && m_has_video)
         m_player_video.SubmitEOS();
@@ -1855,7 +2245,81 @@ int main(int argc, char *argv[])
       if ( (m_has_video && !m_player_video.IsEOS()) ||
            (m_has_audio && !m_player_audio.IsEOS()) )
       {
-        OMXClock::OMXSleep(10);
+        m_feed_wakeup.Wait(feed_sequence, FEED_WAKEUP_TIMEOUT);
+        continue;
+      }
+
+      // a short file can end before the one it was spliced behind was let go
+      if (retired_reader)
+      {
+        m_omxcontrol.SetReader(m_omx_reader);
+        splice_pending = false;
+        retired_reader->Close();
+        m_playlist.Preopen(retired_reader);
+        retired_reader = NULL;
+        continue;
+      }
+
+      if (next_reader)
+      {
+        EPlaylistSwitch mode = GetPlaylistSwitch(next_reader, m_refresh && m_fps <= 0.0f);
+        OMXReader *prev_reader = m_omx_reader;
+
+        CLog::Log(LOGINFO, "Playlist: %s %s after end of stream\n", mode == PLAYLIST_RESTART ? "restarting for" :
+                  mode == PLAYLIST_RECONFIGURE ? "reconfiguring for" : "resetting for", next_filename.c_str());
+
+        m_omx_reader_thread.Close();
+        m_omx_reader = next_reader;
+        next_reader = NULL;
+        m_omxcontrol.SetReader(m_omx_reader);
+
+        gap_switch  = mode;
+        gap_start   = m_av_clock->GetAbsoluteClock();
+
+        if (mode == PLAYLIST_RESTART)
+        {
+          FlushStreams(DVD_NOPTS_VALUE);
+          prev_reader->Close();
+          m_player_subtitles.Close();
+          m_player_video.Close();
+          m_player_audio.Close();
+          m_filename = next_filename;
+          gap_from = gap_to = clip_end = clip_last = DVD_NOPTS_VALUE;
+          preopened = true;
+          goto change_file;
+        }
+
+        // the timeline goes on, only the video decoder is set up again
+        m_omx_reader->SetTimeOffset(clip_end != DVD_NOPTS_VALUE ? clip_end : 0.0);
+        if(m_audio_index_use > 0)
+          m_omx_reader->SetActiveStream(OMXSTREAM_AUDIO, m_audio_index_use-1);
+        if(m_has_audio)
+          m_player_audio.SetReader(m_omx_reader);
+        FlushStreams(DVD_NOPTS_VALUE);
+        prev_reader->Close();
+
+        if(m_has_video && mode == PLAYLIST_RECONFIGURE)
+        {
+          m_omx_reader->GetHints(OMXSTREAM_VIDEO, m_config_video.hints);
+          if (m_fps > 0.0f)
+            m_config_video.hints.fpsrate = m_fps * DVD_TIME_BASE, m_config_video.hints.fpsscale = DVD_TIME_BASE;
+          if (m_orientation >= 0)
+            m_config_video.hints.orientation = m_orientation;
+          if (m_refresh)
+            SetVideoMode(m_config_video.hints.width, m_config_video.hints.height, m_config_video.hints.fpsrate, m_config_video.hints.fpsscale, m_3d);
+
+          m_player_video.Close();
+          if(!m_player_video.Open(m_av_clock, m_config_video))
+            goto do_exit;
+        }
+        else if(m_has_video && !m_player_video.Reset())
+          goto do_exit;
+
+        gap_from = gap_to = clip_end;
+        sentStarted = false;
+        m_send_eos = false;
+        m_omx_reader_thread.Open(m_omx_reader);
+        m_playlist.Preopen(prev_reader);
         continue;
       }
 
@@ -1868,29 +2332,36 @@ int main(int argc, char *argv[])
       break;
     }
 
-    if(m_has_video && m_omx_pkt && m_omx_reader.IsActive(OMXSTREAM_VIDEO, m_omx_pkt->stream_index))
+    if(m_has_video && m_omx_pkt && m_omx_reader->IsActive(OMXSTREAM_VIDEO, m_omx_pkt->stream_index))
     {
-      if (TRICKPLAY(m_av_clock->OMXPlaySpeed()))
+      // the reader hops from keyframe to keyframe by itself, it only needs to
+      // start from the clock position when trickplay begins or changes speed
+      if (!TRICKPLAY(m_av_clock->OMXPlaySpeed()))
+      {
+         m_trickplay_speed = DVD_PLAYSPEED_NORMAL;
+      }
+      else if (m_trickplay_speed != m_av_clock->OMXPlaySpeed())
       {
+         m_trickplay_speed = m_av_clock->OMXPlaySpeed();
          m_packet_after_seek = true;
       }
       if(m_player_video.AddPacket(m_omx_pkt))
         m_omx_pkt = NULL;
       else
-        OMXClock::OMXSleep(10);
+        m_feed_wakeup.Wait(feed_sequence, FEED_WAKEUP_TIMEOUT);
     }
     else if(m_has_audio && m_omx_pkt && !TRICKPLAY(m_av_clock->OMXPlaySpeed()) && m_omx_pkt->codec_type == AVMEDIA_TYPE_AUDIO)
     {
       if(m_player_audio.AddPacket(m_omx_pkt))
         m_omx_pkt = NULL;
       else
-        OMXClock::OMXSleep(10);
+        m_feed_wakeup.Wait(feed_sequence, FEED_WAKEUP_TIMEOUT);
     }
     else if(m_has_subtitle && m_omx_pkt && !TRICKPLAY(m_av_clock->OMXPlaySpeed()) &&
             m_omx_pkt->codec_type == AVMEDIA_TYPE_SUBTITLE)
     {
       auto result = m_player_subtitles.AddPacket(m_omx_pkt,
-                      m_omx_reader.GetRelativeIndex(m_omx_pkt->stream_index));
+                      m_omx_reader->GetRelativeIndex(m_omx_pkt->stream_index));
       if (result)
         m_omx_pkt = NULL;
       else
@@ -1900,17 +2371,60 @@ int main(int argc, char *argv[])
     {
       if(m_omx_pkt)
       {
-        m_omx_reader.FreePacket(m_omx_pkt);
+        m_omx_reader->FreePacket(m_omx_pkt);
         m_omx_pkt = NULL;
       }
       else
-        OMXClock::OMXSleep(10);
+        m_feed_wakeup.Wait(feed_sequence, FEED_WAKEUP_TIMEOUT);
     }
   }
 
 do_exit:
   if (m_stats)
+  {
     printf("\n");
+    printf("Packet pool: %u hits %u misses\n", OMXPacketPool::Get().GetHits(), OMXPacketPool::Get().GetMisses());
+    printf("Demuxer: %.2f MB at %.2f MB/s, stalled %.2fs\n", m_omx_reader_thread.GetBytes() / (1024.0 * 1024.0),
+           m_omx_reader_thread.GetThroughput() / (1024.0 * 1024.0), m_omx_reader_thread.GetStallTime());
+    XFILE::SCacheStatus cache_status = {};
+    if (m_omx_reader->GetCacheStatus(&cache_status))
+      printf("File: %u underruns, reading at %.2f MB/s\n", cache_status.underruns, cache_status.currate / (1024.0 * 1024.0));
+    printf("Discarded %u inactive streams, estimated %.1f kB/s skipped by nominal bitrate, %u with none\n",
+           m_omx_reader->GetDiscardCount(), m_omx_reader->GetDiscardRate() / 1024.0, m_omx_reader->GetDiscardUnknown());
+    printf("Decoder input: %.2f MB copied, %.2f MB by pointer\n", COMXCoreComponent::GetInputBytesCopied() / (1024.0 * 1024.0),
+           COMXCoreComponent::GetInputBytesDirect() / (1024.0 * 1024.0));
+    printf("Video dropped: %u late non-reference, %u skipping to keyframe\n", m_player_video.GetDropped(VIDEO_DROP_NONREF),
+           m_player_video.GetDropped(VIDEO_DROP_GOP));
+    printf("Parameter sets: %u format changes, decoder followed %u after avg %.1f ms max %.1f ms, %u updates, %u repeats, %u kept from the decoder\n",
+           m_omx_reader->GetParamSets(PARAM_SET_CHANGED), m_player_video.GetFormatLatencyCount(),
+           m_player_video.GetFormatLatencyAvg() / 1000.0, m_player_video.GetFormatLatencyMax() / 1000.0,
+           m_omx_reader->GetParamSets(PARAM_SET_UPDATED), m_omx_reader->GetParamSets(PARAM_SET_REDUNDANT),
+           m_player_video.GetParamSetsDropped());
+    OMXGopStats gop;
+    if (m_has_video && m_omx_reader->GetGopStats(m_omx_reader->GetVideoIndex(), &gop) && gop.gops)
+    {
+      printf("GOP: %u, %.1f frames avg, keyframe every %.2fs avg %.2fs max, %.0f kbit/s avg %.0f kbit/s max\n",
+             gop.gops, (double)gop.frames / gop.gops, gop.interval / gop.gops, gop.interval_max,
+             gop.bytes * 8 / gop.interval / 1000.0, gop.bitrate_max / 1000.0);
+      printf("Frames: %u I %u P %u B %u unknown, %u non-reference, keyframes %u found unflagged %u flagged rejected\n",
+             gop.frame_types[OMX_FRAME_I], gop.frame_types[OMX_FRAME_P], gop.frame_types[OMX_FRAME_B],
+             gop.frame_types[OMX_FRAME_UNKNOWN], gop.nonref, gop.key_unflagged, gop.key_rejected);
+    }
+    printf("Seek to first frame: %u fast avg %.0f ms, %u accurate avg %.0f ms\n",
+           seek_count[0], seek_count[0] ? seek_time[0] / 1000.0 / seek_count[0] : 0.0,
+           seek_count[1], seek_count[1] ? seek_time[1] / 1000.0 / seek_count[1] : 0.0);
+    if (m_seamless_loop)
+      printf("Loop: %u wraps, %u started from the GOP kept in memory\n", m_omx_reader->GetLoopCount(), m_omx_reader->GetLoopCacheCount());
+    if (m_use_playlist)
+    {
+      printf("Playlist: inter-clip gap");
+      const char *names[] = { "spliced", "reconfigured", "restarted" };
+      for (int i = PLAYLIST_SPLICE; i <= PLAYLIST_RESTART; i++)
+        printf("%s %u %s avg %.1f ms", i == PLAYLIST_SPLICE ? "" : ",", clip_count[i], names[i],
+               clip_count[i] ? gap_total[i] / 1000.0 / clip_count[i] : 0.0);
+      printf(", max %.1f ms\n", gap_max / 1000.0);
+    }
+  }
 
   if (m_stop)
   {
@@ -1941,20 +2455,28 @@ do_exit:
 
   if(m_omx_pkt)
   {
-    m_omx_reader.FreePacket(m_omx_pkt);
+    m_omx_reader->FreePacket(m_omx_pkt);
     m_omx_pkt = NULL;
   }
 
-  m_omx_reader.Close();
+  m_omx_reader_thread.Close();
+  m_omx_reader->Close();
+  m_playlist.Abort();
+  if (retired_reader)
+    retired_reader->Close();
+  if (next_reader)
+    next_reader->Close();
 
   m_av_clock->OMXDeinitialize();
   if (m_av_clock)
     delete m_av_clock;
 
-  vc_tv_show_info(0);
+  if (m_soft_omx == OMXALSA_SOFT_OFF)
+    m_BcmHost.vc_tv_show_info(0);
 
   g_OMX.Deinitialize();
-  g_RBP.Deinitialize();
+  if (m_soft_omx == OMXALSA_SOFT_OFF)
+    g_RBP.Deinitialize();
 
   printf("have a nice day ;)\n");
 
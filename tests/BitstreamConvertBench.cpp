@@ -0,0 +1,292 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Per frame cost of CBitstreamConverter's avcC to Annex B conversion against
+// the one realloc per NAL unit version it replaced, which is kept below as
+// the reference. The frames are laid out like a sliced 1080p x264 stream:
+// an IDR with SEI, then P and non-reference B pictures, 8 slices each, with
+// random, emulation prevented slice data. Every frame is checked against
+// the reference first, for 2 and 4 byte NAL sizes. Exits with 1 on a mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "BitstreamConverter.h"
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+static uint32_t g_seed = 0x12345678;
+
+static uint32_t Random(void)
+{
+  // xorshift32, the same frames on every run
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// 1920x1080 High profile level 4.0, as x264 writes it
+static const uint8_t g_sps[] = { 0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78, 0x02, 0x27, 0xe5, 0xc0,
+                                 0x44, 0x00, 0x00, 0x03, 0x00, 0x04, 0x00, 0x00, 0x03, 0x00, 0xc8, 0x3c,
+                                 0x60, 0xc6, 0x58 };
+static const uint8_t g_pps[] = { 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0 };
+
+#define BENCH_SLICES 8
+#define BENCH_GOP    48
+
+typedef struct
+{
+  std::vector<uint8_t>  data;
+} BenchFrame;
+
+static std::vector<uint8_t> MakeExtradata(int length_size)
+{
+  std::vector<uint8_t> avcc;
+  avcc.push_back(1);
+  avcc.push_back(g_sps[1]);
+  avcc.push_back(g_sps[2]);
+  avcc.push_back(g_sps[3]);
+  avcc.push_back(0xfc | (length_size - 1));
+  avcc.push_back(0xe1);
+  avcc.push_back(sizeof(g_sps) >> 8);
+  avcc.push_back(sizeof(g_sps) & 0xff);
+  avcc.insert(avcc.end(), g_sps, g_sps + sizeof(g_sps));
+  avcc.push_back(1);
+  avcc.push_back(sizeof(g_pps) >> 8);
+  avcc.push_back(sizeof(g_pps) & 0xff);
+  avcc.insert(avcc.end(), g_pps, g_pps + sizeof(g_pps));
+  return avcc;
+}
+
+static void AddNal(BenchFrame &frame, int length_size, uint8_t header, uint32_t size)
+{
+  for (int i = length_size - 1; i >= 0; i--)
+    frame.data.push_back((size >> (8 * i)) & 0xff);
+  frame.data.push_back(header);
+  // random payload that keeps the rules of a real one: an emulation prevention
+  // byte after two zeros, and the stop bit at the end
+  int zeros = 0;
+  for (uint32_t i = 1; i < size - 1; i++)
+  {
+    uint8_t byte = zeros >= 2 ? 3 : (uint8_t)Random();
+    zeros = byte ? 0 : zeros + 1;
+    frame.data.push_back(byte);
+  }
+  frame.data.push_back(0x80);
+}
+
+// an IDR of about 160 kB, P pictures of 40 kB and B pictures of 12 kB
+static std::vector<BenchFrame> MakeGop(int length_size)
+{
+  std::vector<BenchFrame> gop(BENCH_GOP);
+  for (int i = 0; i < BENCH_GOP; i++)
+  {
+    BenchFrame &frame = gop[i];
+    uint8_t header;
+    uint32_t size;
+    if (i == 0)
+    {
+      AddNal(frame, length_size, 0x06, 600 + Random() % 100); // SEI
+      header = 0x65;
+      size = 20000;
+    }
+    else if (i % 3 == 1)
+    {
+      header = 0x41;
+      size = 5000;
+    }
+    else
+    {
+      header = 0x01;
+      size = 1500;
+    }
+    for (int slice = 0; slice < BENCH_SLICES; slice++)
+      AddNal(frame, length_size, header, size / 2 + Random() % size);
+  }
+  return gop;
+}
+
+// the conversion as it was, every NAL unit grows the output by realloc
+class ReferenceConverter
+{
+public:
+  ReferenceConverter(const std::vector<uint8_t> &extradata) : m_length_size((extradata[4] & 3) + 1), m_first_idr(1)
+  {
+    static const uint8_t header[4] = { 0, 0, 0, 1 };
+    m_sps_pps.insert(m_sps_pps.end(), header, header + 4);
+    m_sps_pps.insert(m_sps_pps.end(), g_sps, g_sps + sizeof(g_sps));
+    m_sps_pps.insert(m_sps_pps.end(), header, header + 4);
+    m_sps_pps.insert(m_sps_pps.end(), g_pps, g_pps + sizeof(g_pps));
+  }
+
+  bool Convert(const uint8_t *buf, int buf_size, uint8_t **poutbuf, int *poutbuf_size)
+  {
+    const uint8_t *buf_end = buf + buf_size;
+    int32_t  nal_size;
+    uint32_t cumul_size = 0;
+
+    *poutbuf = NULL;
+    *poutbuf_size = 0;
+    do
+    {
+      if (buf + m_length_size > buf_end)
+        return false;
+      if (m_length_size == 2)
+        nal_size = buf[0] << 8 | buf[1];
+      else
+        nal_size = buf[0] << 24 | buf[1] << 16 | buf[2] << 8 | buf[3];
+      buf += m_length_size;
+      uint8_t unit_type = *buf & 0x1f;
+      if (buf + nal_size > buf_end || nal_size < 0)
+        return false;
+
+      if (m_first_idr && unit_type == 5)
+      {
+        AllocAndCopy(poutbuf, poutbuf_size, &m_sps_pps[0], m_sps_pps.size(), buf, nal_size);
+        m_first_idr = 0;
+      }
+      else
+      {
+        AllocAndCopy(poutbuf, poutbuf_size, NULL, 0, buf, nal_size);
+        if (!m_first_idr && unit_type == 1)
+          m_first_idr = 1;
+      }
+      buf += nal_size;
+      cumul_size += nal_size + m_length_size;
+    } while (cumul_size < (uint32_t)buf_size);
+    return true;
+  }
+
+private:
+  static void AllocAndCopy(uint8_t **poutbuf, int *poutbuf_size, const uint8_t *sps_pps, uint32_t sps_pps_size,
+                           const uint8_t *in, uint32_t in_size)
+  {
+    uint32_t offset = *poutbuf_size;
+    uint8_t nal_header_size = offset ? 3 : 4;
+
+    *poutbuf_size += sps_pps_size + in_size + nal_header_size;
+    *poutbuf = (uint8_t*)realloc(*poutbuf, *poutbuf_size);
+    if (sps_pps)
+      memcpy(*poutbuf + offset, sps_pps, sps_pps_size);
+    memcpy(*poutbuf + sps_pps_size + nal_header_size + offset, in, in_size);
+    uint8_t *start = *poutbuf + offset + sps_pps_size;
+    if (!offset)
+    {
+      start[0] = 0; start[1] = 0; start[2] = 0; start[3] = 1;
+    }
+    else
+    {
+      start[0] = 0; start[1] = 0; start[2] = 1;
+    }
+  }
+
+  int m_length_size;
+  int m_first_idr;
+  std::vector<uint8_t> m_sps_pps;
+};
+
+static bool Check(int length_size)
+{
+  std::vector<uint8_t> extradata = MakeExtradata(length_size);
+  std::vector<BenchFrame> gop = MakeGop(length_size);
+  ReferenceConverter reference(extradata);
+  CBitstreamConverter converter;
+
+  if (!converter.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), true) || !converter.NeedConvert())
+  {
+    printf("%d byte sizes: the converter did not open\n", length_size);
+    return false;
+  }
+
+  // twice round, the IDR after a GOP gets the parameter sets again
+  for (int i = 0; i < 2 * BENCH_GOP; i++)
+  {
+    BenchFrame &frame = gop[i % BENCH_GOP];
+    uint8_t *want;
+    int want_size;
+    if (!reference.Convert(&frame.data[0], frame.data.size(), &want, &want_size) ||
+        !converter.Convert(&frame.data[0], frame.data.size()))
+    {
+      printf("%d byte sizes: frame %d did not convert\n", length_size, i);
+      return false;
+    }
+    bool same = converter.GetConvertSize() == want_size && !memcmp(converter.GetConvertBuffer(), want, want_size);
+    free(want);
+    if (!same)
+    {
+      printf("%d byte sizes: frame %d differs from the reference\n", length_size, i);
+      return false;
+    }
+  }
+  printf("%d byte sizes: %d frames match the reference\n", length_size, 2 * BENCH_GOP);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  if (!Check(2) || !Check(4))
+    return 1;
+
+  const int length_size = 4;
+  int passes = argc > 1 ? atoi(argv[1]) : 200;
+  if (passes < 1)
+    passes = 1;
+
+  std::vector<uint8_t> extradata = MakeExtradata(length_size);
+  std::vector<BenchFrame> gop = MakeGop(length_size);
+  size_t bytes = 0;
+  for (int i = 0; i < BENCH_GOP; i++)
+    bytes += gop[i].data.size();
+  int frames = passes * BENCH_GOP;
+  printf("%d frames of %.1f kB avg, %d slices each\n", frames, bytes / 1024.0 / BENCH_GOP, BENCH_SLICES);
+
+  ReferenceConverter reference(extradata);
+  int64_t start = CurrentHostCounter();
+  for (int i = 0; i < frames; i++)
+  {
+    BenchFrame &frame = gop[i % BENCH_GOP];
+    uint8_t *out;
+    int out_size;
+    reference.Convert(&frame.data[0], frame.data.size(), &out, &out_size);
+    free(out);
+  }
+  printf("%-22s %8.0f ns/frame\n", "realloc per NAL unit", (double)(CurrentHostCounter() - start) / frames);
+
+  CBitstreamConverter converter;
+  converter.Open(AV_CODEC_ID_H264, &extradata[0], extradata.size(), true);
+  start = CurrentHostCounter();
+  for (int i = 0; i < frames; i++)
+  {
+    BenchFrame &frame = gop[i % BENCH_GOP];
+    converter.Convert(&frame.data[0], frame.data.size());
+  }
+  printf("%-22s %8.0f ns/frame\n", "two pass", (double)(CurrentHostCounter() - start) / frames);
+  return 0;
+}
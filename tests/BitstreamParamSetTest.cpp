@@ -0,0 +1,301 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Checks CBitstreamConverter::StripParamSets on H.264 access units built
+// here, with 4 byte sizes and with Annex B start codes of both lengths:
+// what is dropped and kept as parameter sets repeat, change and after a
+// reset, and that the NAL units left are intact behind their own framing.
+// Then parsehevc_picture on HEVC slice headers written here, behind PPS
+// with extra slice header bits from the stream and from hvcC extradata.
+// Exits with 1 on the first mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BitstreamConverter.h"
+#include "BitstreamStartCode.h"
+
+typedef std::vector<uint8_t> nal_bytes;
+
+// seq_parameter_set_id and pic_parameter_set_id 0, the second SPS differs past its id
+static const uint8_t sps0[]  = { 0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x78 };
+static const uint8_t sps0b[] = { 0x67, 0x64, 0x00, 0x28, 0xac, 0xd9, 0x40, 0x50 };
+static const uint8_t pps0[]  = { 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0 };
+// pic_parameter_set_id 1
+static const uint8_t pps1[]  = { 0x68, 0x5e, 0x38, 0x80 };
+static const uint8_t idr[]   = { 0x65, 0x88, 0x84, 0x21, 0xa0, 0x7f, 0x13 };
+static const uint8_t slice[] = { 0x41, 0x9a, 0x21, 0x6c, 0x45 };
+
+#define UNIT(a) nal_bytes(a, a + sizeof(a))
+
+static nal_bytes Pack(const std::vector<nal_bytes> &units, int length_size)
+{
+  nal_bytes out;
+  for (size_t i = 0; i < units.size(); i++)
+  {
+    if (length_size)
+    {
+      for (int b = length_size - 1; b >= 0; b--)
+        out.push_back((units[i].size() >> (8 * b)) & 0xff);
+    }
+    else
+    {
+      // a zero_byte on the first and every other unit, a trailing zero on the rest but the last
+      if (!(i & 1))
+        out.push_back(0);
+      out.push_back(0); out.push_back(0); out.push_back(1);
+    }
+    out.insert(out.end(), units[i].begin(), units[i].end());
+    if (!length_size && (i & 1) && i + 1 < units.size())
+      out.push_back(0);
+  }
+  return out;
+}
+
+static std::vector<nal_bytes> Unpack(const uint8_t *data, int size, int length_size)
+{
+  std::vector<nal_bytes> units;
+  if (!length_size)
+  {
+    std::vector<nal_unit> split;
+    startcode_split(data, size, split);
+    // the split leaves trailing zeros other than the zero_byte on the unit
+    for (size_t i = 0; i < split.size(); i++)
+    {
+      int nal_size = split[i].size;
+      while (nal_size > 1 && !split[i].data[nal_size - 1])
+        nal_size--;
+      units.push_back(nal_bytes(split[i].data, split[i].data + nal_size));
+    }
+    return units;
+  }
+
+  const uint8_t *p = data, *end = data + size;
+  while (end - p >= length_size)
+  {
+    uint32_t nal_size = 0;
+    for (int i = 0; i < length_size; i++)
+      nal_size = (nal_size << 8) | *p++;
+    if (nal_size > (uint32_t)(end - p))
+      break;
+    units.push_back(nal_bytes(p, p + nal_size));
+    p += nal_size;
+  }
+  return units;
+}
+
+static bool Strip(CBitstreamConverter &strip, const char *name, int length_size,
+                  const std::vector<nal_bytes> &in, const std::vector<nal_bytes> &want, int want_dropped)
+{
+  nal_bytes buf = Pack(in, length_size);
+  int kept, dropped;
+  int size = strip.StripParamSets(&buf[0], buf.size(), length_size, &kept, &dropped);
+
+  std::vector<nal_bytes> got = Unpack(&buf[0], size, length_size);
+  int want_kept = 0;
+  for (size_t i = 0; i < want.size(); i++)
+    want_kept += (want[i][0] & 0x1f) == 7 || (want[i][0] & 0x1f) == 8;
+  if (got != want || kept != want_kept || dropped != want_dropped)
+  {
+    printf("%s, %s: %d units left want %d, kept %d want %d, dropped %d want %d\n",
+           length_size ? "sizes" : "start codes", name, (int)got.size(), (int)want.size(),
+           kept, want_kept, dropped, want_dropped);
+    return false;
+  }
+  return true;
+}
+
+static bool Check(int length_size)
+{
+  CBitstreamConverter strip;
+  std::vector<nal_bytes> au, left;
+
+  au.push_back(UNIT(sps0)); au.push_back(UNIT(pps0)); au.push_back(UNIT(idr));
+  if (!Strip(strip, "first", length_size, au, au, 0))
+    return false;
+
+  left.push_back(UNIT(idr));
+  if (!Strip(strip, "repeat", length_size, au, left, 2))
+    return false;
+
+  // the new PPS stays, the known one in between goes
+  au.clear(); left.clear();
+  au.push_back(UNIT(slice)); au.push_back(UNIT(pps0)); au.push_back(UNIT(pps1)); au.push_back(UNIT(slice));
+  left.push_back(UNIT(slice)); left.push_back(UNIT(pps1)); left.push_back(UNIT(slice));
+  if (!Strip(strip, "new pps", length_size, au, left, 1))
+    return false;
+
+  // nothing but repeats leaves an empty packet
+  au.clear(); left.clear();
+  au.push_back(UNIT(pps1)); au.push_back(UNIT(sps0));
+  if (!Strip(strip, "only repeats", length_size, au, left, 2))
+    return false;
+
+  // a changed SPS makes every PPS new again
+  au.clear();
+  au.push_back(UNIT(sps0b)); au.push_back(UNIT(pps0)); au.push_back(UNIT(idr));
+  if (!Strip(strip, "sps change", length_size, au, au, 0))
+    return false;
+
+  strip.ResetParamSets(NULL, 0);
+  if (!Strip(strip, "reset", length_size, au, au, 0))
+    return false;
+
+  printf("%s: repeats dropped, changes and resets kept\n", length_size ? "4 byte sizes" : "start codes");
+  return true;
+}
+
+// HEVC units are written bit by bit, padded with ones so no start code can appear
+class CBitWriter
+{
+public:
+  CBitWriter(int nal_type) { m_bytes.push_back(nal_type << 1); m_bytes.push_back(1); m_bits = 0; }
+  void Put(uint32_t value, int n)
+  {
+    while (n-- > 0)
+    {
+      if (!(m_bits & 7))
+        m_bytes.push_back(0);
+      m_bytes.back() |= ((value >> n) & 1) << (7 - (m_bits & 7));
+      m_bits++;
+    }
+  }
+  void PutUe(uint32_t value)
+  {
+    int n = 0;
+    while ((value + 1) >> (n + 1))
+      n++;
+    Put(0, n);
+    Put(value + 1, n + 1);
+  }
+  nal_bytes Get()
+  {
+    Put(0xffff, 16);
+    return m_bytes;
+  }
+private:
+  nal_bytes m_bytes;
+  int       m_bits;
+};
+
+static nal_bytes HevcPps(int id, int extra_bits)
+{
+  CBitWriter w(34);
+  w.PutUe(id);
+  w.PutUe(0);           // pps_seq_parameter_set_id
+  w.Put(0, 2);          // dependent_slice_segments_enabled_flag, output_flag_present_flag
+  w.Put(extra_bits, 3); // num_extra_slice_header_bits
+  return w.Get();
+}
+
+// slice_type 0 is B, 1 P and 2 I
+static nal_bytes HevcSlice(int nal_type, bool first, int pps_id, int extra_bits, int slice_type)
+{
+  CBitWriter w(nal_type);
+  w.Put(first, 1);
+  if (!first)
+    return w.Get();
+  if (nal_type >= 16 && nal_type <= 23)
+    w.Put(0, 1);        // no_output_of_prior_pics_flag
+  w.PutUe(pps_id);
+  // the reserved flags are zero, a reader not skipping them sees another slice_type
+  w.Put(0, extra_bits);
+  w.PutUe(slice_type);
+  return w.Get();
+}
+
+static bool Hevc(CBitstreamConverter &parser, const char *name, const std::vector<nal_bytes> &au,
+                 int want_type, bool want_idr, int want_ref)
+{
+  nal_bytes buf = Pack(au, 4);
+  h264_picture_info info;
+  if (!parser.parsehevc_picture(&buf[0], buf.size(), 4, &info) ||
+      info.slice_type != want_type || info.idr != want_idr || info.nal_ref_idc != want_ref)
+  {
+    printf("hevc, %s: slice_type %d want %d, idr %d want %d, nal_ref_idc %d want %d\n",
+           name, info.slice_type, want_type, info.idr, want_idr, info.nal_ref_idc, want_ref);
+    return false;
+  }
+  return true;
+}
+
+static bool CheckHevc(void)
+{
+  CBitstreamConverter parser;
+  std::vector<nal_bytes> au;
+
+  // hvcC with length_size 4 and one array holding a PPS with a reserved flag
+  nal_bytes pps5 = HevcPps(5, 1);
+  nal_bytes hvcc(22, 0);
+  hvcc[0]  = 1;
+  hvcc[21] = 3;
+  hvcc.push_back(1);
+  hvcc.push_back(0x80 | 34);
+  hvcc.push_back(0); hvcc.push_back(1);
+  hvcc.push_back(pps5.size() >> 8); hvcc.push_back(pps5.size() & 0xff);
+  hvcc.insert(hvcc.end(), pps5.begin(), pps5.end());
+  parser.ResetHevcParamSets(&hvcc[0], hvcc.size());
+
+  // TRAIL_R, TRAIL_N and a CRA, numbers as in H.264
+  au.push_back(HevcSlice(1, true, 0, 0, 1));
+  if (!Hevc(parser, "trail_r p", au, 0, false, 1))
+    return false;
+  au.clear();
+  au.push_back(HevcSlice(0, true, 0, 0, 0));
+  if (!Hevc(parser, "trail_n b", au, 1, false, 0))
+    return false;
+  au.clear();
+  au.push_back(HevcSlice(1, true, 5, 1, 1));
+  if (!Hevc(parser, "hvcC pps", au, 0, false, 1))
+    return false;
+
+  // a PPS in the packet counts for the slices behind it, segments after the first are skipped
+  au.clear();
+  au.push_back(HevcPps(3, 2));
+  au.push_back(HevcSlice(21, true, 3, 2, 2));
+  au.push_back(HevcSlice(21, false, 3, 2, 0));
+  if (!Hevc(parser, "in-band pps", au, 2, true, 1))
+    return false;
+  au.clear();
+  au.push_back(HevcSlice(1, false, 0, 0, 0));
+  au.push_back(HevcSlice(1, true, 3, 2, 0));
+  if (!Hevc(parser, "later segment", au, 1, false, 1))
+    return false;
+
+  // a reset forgets the in-band PPS
+  parser.ResetHevcParamSets(&hvcc[0], hvcc.size());
+  au.clear();
+  au.push_back(HevcSlice(1, true, 3, 0, 2));
+  if (!Hevc(parser, "reset", au, 2, false, 1))
+    return false;
+
+  printf("hevc: slice types read behind extra slice header bits\n");
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  if (!Check(4) || !Check(0) || !CheckHevc())
+    return 1;
+  return 0;
+}
@@ -0,0 +1,517 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Checks CBitstreamConverter's NAL bit reader (nal_bs_*) on fixed inputs,
+// including the emulation prevention cases where it differs from the byte
+// at a time reader it replaced, then on random syntax elements written and
+// escaped here, then call by call against that old reader, kept below as
+// the reference, on random data where the two should agree. Then times
+// both on Exp-Golomb and 3 bit reads, as in a slice header.
+// Exits with 1 on the first mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "BitstreamConverter.h"
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+static uint32_t g_seed = 0x12345678;
+
+static uint32_t Random(void)
+{
+  // xorshift32, the same sequence on every run
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// the reader is protected, this only opens it up
+class CReader : public CBitstreamConverter
+{
+public:
+  using CBitstreamConverter::nal_bs_init;
+  using CBitstreamConverter::nal_bs_read;
+  using CBitstreamConverter::nal_bs_eos;
+  using CBitstreamConverter::nal_bs_read_ue;
+  using CBitstreamConverter::nal_bs_read_se;
+};
+
+// the reader as it was before the 64 bit cache
+typedef struct
+{
+  const uint8_t *data;
+  const uint8_t *end;
+  int head;
+  uint64_t cache;
+} ref_bitstream;
+
+static void ref_bs_init(ref_bitstream *bs, const uint8_t *data, size_t size)
+{
+  bs->data = data;
+  bs->end  = data + size;
+  bs->head = 0;
+  // fill with something other than 0 to detect
+  //  emulation prevention bytes
+  bs->cache = 0xffffffff;
+}
+
+static uint32_t ref_bs_read(ref_bitstream *bs, int n)
+{
+  uint32_t res = 0;
+  int shift;
+
+  if (n == 0)
+    return res;
+
+  // fill up the cache if we need to
+  while (bs->head < n)
+  {
+    uint8_t a_byte;
+    bool check_three_byte;
+
+    check_three_byte = true;
+next_byte:
+    if (bs->data >= bs->end)
+    {
+      // we're at the end, can't produce more than head number of bits
+      n = bs->head;
+      break;
+    }
+    // get the byte, this can be an emulation_prevention_three_byte that we need
+    // to ignore.
+    a_byte = *bs->data++;
+    if (check_three_byte && a_byte == 0x03 && ((bs->cache & 0xffff) == 0))
+    {
+      // next byte goes unconditionally to the cache, even if it's 0x03
+      check_three_byte = false;
+      goto next_byte;
+    }
+    // shift bytes in cache, moving the head bits of the cache left
+    bs->cache = (bs->cache << 8) | a_byte;
+    bs->head += 8;
+  }
+
+  // bring the required bits down and truncate
+  if ((shift = bs->head - n) > 0)
+    res = bs->cache >> shift;
+  else
+    res = bs->cache;
+
+  // mask out required bits
+  if (n < 32)
+    res &= (1 << n) - 1;
+  bs->head = shift;
+
+  return res;
+}
+
+static bool ref_bs_eos(ref_bitstream *bs)
+{
+  return (bs->data >= bs->end) && (bs->head == 0);
+}
+
+static int ref_bs_read_ue(ref_bitstream *bs)
+{
+  int i = 0;
+
+  while (ref_bs_read(bs, 1) == 0 && !ref_bs_eos(bs) && i < 32)
+    i++;
+
+  return ((1 << i) - 1 + ref_bs_read(bs, i));
+}
+
+static int ref_bs_read_se(ref_bitstream *bs)
+{
+  int code = ref_bs_read_ue(bs);
+  return (code & 1) ? (code + 1) / 2 : -(code / 2);
+}
+
+// writes RBSP bits, Escape() then adds the emulation prevention bytes
+class CBitWriter
+{
+public:
+  CBitWriter() : m_bits(0), m_count(0) {}
+
+  void PutBits(uint32_t value, int n)
+  {
+    while (n--)
+    {
+      m_bits = (m_bits << 1) | ((value >> n) & 1);
+      if (++m_count == 8)
+      {
+        m_rbsp.push_back(m_bits);
+        m_bits = m_count = 0;
+      }
+    }
+  }
+  void PutUe(uint32_t value)
+  {
+    int len = 32 - __builtin_clz(value + 1);
+    PutBits(0, len - 1);
+    PutBits(value + 1, len);
+  }
+  void PutSe(int value)
+  {
+    PutUe(value > 0 ? 2 * value - 1 : -2 * value);
+  }
+  // rbsp_trailing_bits, then the NAL payload as it would be in the stream
+  std::vector<uint8_t> Escape(void)
+  {
+    PutBits(1, 1);
+    while (m_count)
+      PutBits(0, 1);
+
+    std::vector<uint8_t> out;
+    int zeros = 0;
+    for (size_t i = 0; i < m_rbsp.size(); i++)
+    {
+      if (zeros >= 2 && m_rbsp[i] <= 3)
+      {
+        out.push_back(3);
+        zeros = 0;
+      }
+      zeros = m_rbsp[i] ? 0 : zeros + 1;
+      out.push_back(m_rbsp[i]);
+    }
+    return out;
+  }
+
+private:
+  std::vector<uint8_t> m_rbsp;
+  uint8_t m_bits;
+  int m_count;
+};
+
+static bool CheckBytes(const char *name, const uint8_t *in, int in_size, const uint8_t *want, int want_size)
+{
+  CReader reader;
+  nal_bitstream bs;
+  std::vector<uint8_t> got;
+
+  reader.nal_bs_init(&bs, in, in_size);
+  while (!reader.nal_bs_eos(&bs))
+    got.push_back(reader.nal_bs_read(&bs, 8));
+
+  if ((int)got.size() != want_size || memcmp(&got[0], want, want_size))
+  {
+    printf("%s: read", name);
+    for (size_t i = 0; i < got.size(); i++)
+      printf(" %02x", got[i]);
+    printf(", want");
+    for (int i = 0; i < want_size; i++)
+      printf(" %02x", want[i]);
+    printf("\n");
+    return false;
+  }
+  return true;
+}
+
+#define CHECK_BYTES(name, in, want) CheckBytes(name, in, sizeof(in), want, sizeof(want))
+
+static bool CheckFixed(void)
+{
+  static const uint8_t ep_in[]          = { 0x00, 0x00, 0x03, 0x01 };
+  static const uint8_t ep_want[]        = { 0x00, 0x00, 0x01 };
+  // the byte after an emulation prevention byte is kept, even a 03
+  static const uint8_t ep_ep_in[]       = { 0x00, 0x00, 0x03, 0x03 };
+  static const uint8_t ep_ep_want[]     = { 0x00, 0x00, 0x03 };
+  // RBSP 00 00 00 03. The zeros are counted in the stream, so only one of
+  // the kept zeros follows the first 03 and the second 03 is data. The old
+  // reader looked at the last two bytes kept and dropped it as well.
+  static const uint8_t ep_zero_in[]     = { 0x00, 0x00, 0x03, 0x00, 0x03 };
+  static const uint8_t ep_zero_want[]   = { 0x00, 0x00, 0x00, 0x03 };
+  static const uint8_t ep_twice_in[]    = { 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x01 };
+  static const uint8_t ep_twice_want[]  = { 0x00, 0x00, 0x00, 0x00, 0x01 };
+  static const uint8_t one_zero_in[]    = { 0x03, 0x00, 0x03, 0x00, 0x00 };
+  // a trailing emulation prevention byte is dropped and adds nothing
+  static const uint8_t ep_end_in[]      = { 0x11, 0x00, 0x00, 0x03 };
+  static const uint8_t ep_end_want[]    = { 0x11, 0x00, 0x00 };
+
+  if (!CHECK_BYTES("00 00 03 01", ep_in, ep_want) ||
+      !CHECK_BYTES("00 00 03 03", ep_ep_in, ep_ep_want) ||
+      !CHECK_BYTES("00 00 03 00 03", ep_zero_in, ep_zero_want) ||
+      !CHECK_BYTES("00 00 03 00 00 03 01", ep_twice_in, ep_twice_want) ||
+      !CHECK_BYTES("03 00 03 00 00", one_zero_in, one_zero_in) ||
+      !CHECK_BYTES("11 00 00 03", ep_end_in, ep_end_want))
+    return false;
+
+  // an emulation prevention byte at every offset across the 8 byte refills
+  for (int offset = 0; offset < 20; offset++)
+  {
+    uint8_t in[24], want[23];
+    memset(in, 0xff, sizeof(in));
+    memset(want, 0xff, sizeof(want));
+    memcpy(in + offset, ep_in, sizeof(ep_in));
+    memcpy(want + offset, ep_want, sizeof(ep_want));
+    if (!CHECK_BYTES("00 00 03 01 in ff", in, want))
+      return false;
+  }
+
+  // 1 010 011 00100 00101, then the stop bit
+  static const uint8_t golomb[] = { 0xa6, 0x42, 0xc0 };
+  CReader reader;
+  nal_bitstream bs;
+  reader.nal_bs_init(&bs, golomb, sizeof(golomb));
+  for (int i = 0; i < 5; i++)
+  {
+    int code = reader.nal_bs_read_ue(&bs);
+    if (code != i)
+    {
+      printf("Exp-Golomb code %d read as %d\n", i, code);
+      return false;
+    }
+  }
+  reader.nal_bs_init(&bs, golomb, sizeof(golomb));
+  static const int se[] = { 0, 1, -1, 2, -2 };
+  for (int i = 0; i < 5; i++)
+  {
+    int code = reader.nal_bs_read_se(&bs);
+    if (code != se[i])
+    {
+      printf("signed Exp-Golomb code %d read as %d\n", se[i], code);
+      return false;
+    }
+  }
+
+  // reads past the end give what is left, then nothing
+  static const uint8_t one[] = { 0xab };
+  reader.nal_bs_init(&bs, one, sizeof(one));
+  uint32_t a = reader.nal_bs_read(&bs, 4);
+  uint32_t b = reader.nal_bs_read(&bs, 8);
+  bool eos = reader.nal_bs_eos(&bs);
+  uint32_t c = reader.nal_bs_read(&bs, 8);
+  if (a != 0xa || b != 0xb || !eos || c != 0)
+  {
+    printf("read past the end: %x %x %d %x, want a b 1 0\n", a, b, eos, c);
+    return false;
+  }
+
+  printf("fixed inputs read as expected\n");
+  return true;
+}
+
+enum { OP_BITS, OP_UE, OP_SE, OP_EOS };
+
+typedef struct
+{
+  int type;
+  int n;
+  int value;
+} op;
+
+static bool CheckRoundTrip(void)
+{
+  CReader reader;
+  unsigned long reads = 0;
+
+  for (int round = 0; round < 20000; round++)
+  {
+    CBitWriter writer;
+    std::vector<op> ops(Random() % 64 + 1);
+    for (size_t i = 0; i < ops.size(); i++)
+    {
+      // mostly small values, so runs of zero bytes come up, up to the
+      // largest ue that still fits in an int
+      uint32_t magnitude = Random() >> (Random() % 32);
+      ops[i].type = Random() % 3;
+      switch (ops[i].type)
+      {
+      case OP_BITS:
+        ops[i].n = Random() % 32 + 1;
+        ops[i].value = magnitude & (ops[i].n < 32 ? (1u << ops[i].n) - 1 : ~0u);
+        writer.PutBits(ops[i].value, ops[i].n);
+        break;
+      case OP_UE:
+        ops[i].value = magnitude % 0x7fffffff;
+        writer.PutUe(ops[i].value);
+        break;
+      case OP_SE:
+        ops[i].value = (int)(magnitude % 0x7fffffff / 2) * (Random() & 1 ? 1 : -1);
+        writer.PutSe(ops[i].value);
+        break;
+      }
+    }
+    std::vector<uint8_t> nal = writer.Escape();
+
+    nal_bitstream bs;
+    reader.nal_bs_init(&bs, &nal[0], nal.size());
+    for (size_t i = 0; i < ops.size(); i++, reads++)
+    {
+      int got = 0;
+      switch (ops[i].type)
+      {
+      case OP_BITS: got = reader.nal_bs_read(&bs, ops[i].n); break;
+      case OP_UE:   got = reader.nal_bs_read_ue(&bs);        break;
+      case OP_SE:   got = reader.nal_bs_read_se(&bs);        break;
+      }
+      if (got != ops[i].value)
+      {
+        printf("round trip mismatch: round %d element %d of type %d, wrote %d read %d\n",
+               round, (int)i, ops[i].type, ops[i].value, got);
+        return false;
+      }
+    }
+    if (reader.nal_bs_read(&bs, 1) != 1)
+    {
+      printf("round trip mismatch: round %d, no stop bit\n", round);
+      return false;
+    }
+  }
+  printf("round trip: %lu syntax elements read back as written\n", reads);
+  return true;
+}
+
+// where the readers are known to differ: a trailing emulation prevention
+// byte, which the old reader turned into a missing bit, and three kept zero
+// bytes in a row, which covers 00 00 03 00 03 and also keeps ue codes short
+// of 32 leading zeros, where both readers shift out of an int
+static bool OutsideReference(const std::vector<uint8_t> &buf)
+{
+  size_t size = buf.size();
+  if (size >= 3 && !buf[size - 3] && !buf[size - 2] && buf[size - 1] == 3)
+    return true;
+
+  int zeros = 0, kept_zeros = 0;
+  for (size_t i = 0; i < size; i++)
+  {
+    if (buf[i] == 3 && zeros >= 2)
+    {
+      zeros = 0;
+      continue;
+    }
+    zeros = buf[i] ? 0 : zeros + 1;
+    kept_zeros = buf[i] ? 0 : kept_zeros + 1;
+    if (kept_zeros >= 3)
+      return true;
+  }
+  return false;
+}
+
+static bool CheckReference(void)
+{
+  CReader reader;
+  unsigned long calls = 0;
+  int rounds = 0;
+
+  while (rounds < 20000)
+  {
+    // mostly 00 and 03 so emulation prevention is everywhere
+    std::vector<uint8_t> buf(Random() % 64);
+    for (size_t i = 0; i < buf.size(); i++)
+    {
+      uint32_t r = Random() & 7;
+      buf[i] = r < 3 ? 0 : r < 5 ? 3 : (uint8_t)Random();
+    }
+    if (OutsideReference(buf))
+      continue;
+    rounds++;
+
+    nal_bitstream bs;
+    ref_bitstream ref;
+    const uint8_t *data = buf.empty() ? NULL : &buf[0];
+    reader.nal_bs_init(&bs, data, buf.size());
+    ref_bs_init(&ref, data, buf.size());
+
+    int count = Random() % 48 + 1;
+    for (int i = 0; i < count; i++, calls++)
+    {
+      int type = Random() % 4, n = Random() % 33;
+      int want = 0, got = 0;
+      switch (type)
+      {
+      case OP_BITS: want = ref_bs_read(&ref, n);  got = reader.nal_bs_read(&bs, n);  break;
+      case OP_UE:   want = ref_bs_read_ue(&ref);  got = reader.nal_bs_read_ue(&bs); break;
+      case OP_SE:   want = ref_bs_read_se(&ref);  got = reader.nal_bs_read_se(&bs); break;
+      case OP_EOS:  want = ref_bs_eos(&ref);      got = reader.nal_bs_eos(&bs);     break;
+      }
+      if (want != got)
+      {
+        printf("reference mismatch: %d bytes, call %d of type %d (n %d), want %d got %d\n",
+               (int)buf.size(), i, type, n, want, got);
+        return false;
+      }
+    }
+  }
+  printf("reference: %lu calls on %d buffers match the old reader\n", calls, rounds);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  if (!CheckFixed() || !CheckRoundTrip() || !CheckReference())
+    return 1;
+
+  // 1M pairs of a short Exp-Golomb code and a 3 bit field
+  const int pairs = 1024 * 1024;
+  CBitWriter writer;
+  for (int i = 0; i < pairs; i++)
+  {
+    writer.PutUe(Random() % 64);
+    writer.PutBits(Random(), 3);
+  }
+  std::vector<uint8_t> nal = writer.Escape();
+
+  int passes = argc > 1 ? atoi(argv[1]) : 8;
+  if (passes < 1)
+    passes = 1;
+
+  unsigned int sum = 0;
+  int64_t start = CurrentHostCounter();
+  for (int pass = 0; pass < passes; pass++)
+  {
+    ref_bitstream ref;
+    ref_bs_init(&ref, &nal[0], nal.size());
+    for (int i = 0; i < pairs; i++)
+      sum += ref_bs_read_ue(&ref) + ref_bs_read(&ref, 3);
+  }
+  int64_t old_ns = CurrentHostCounter() - start;
+
+  CReader reader;
+  start = CurrentHostCounter();
+  for (int pass = 0; pass < passes; pass++)
+  {
+    nal_bitstream bs;
+    reader.nal_bs_init(&bs, &nal[0], nal.size());
+    for (int i = 0; i < pairs; i++)
+      sum -= reader.nal_bs_read_ue(&bs) + reader.nal_bs_read(&bs, 3);
+  }
+  int64_t new_ns = CurrentHostCounter() - start;
+
+  // both read the same codes, so this is 0 and keeps the loops
+  if (sum)
+  {
+    printf("the readers disagree on the benchmark data\n");
+    return 1;
+  }
+  printf("%-10s %7.1f M codes/s\n", "old reader", 2.0 * pairs * passes * 1000 / old_ns);
+  printf("%-10s %7.1f M codes/s\n", "nal_bs", 2.0 * pairs * passes * 1000 / new_ns);
+  return 0;
+}
@@ -0,0 +1,181 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Checks the start code search startcode_find picked on this CPU against
+// startcode_find_c on random buffers full of 00 and 01 bytes, at every
+// alignment and buffer end, and startcode_split against the two pass split
+// the converter used before. Then times both searches over slice-like data.
+// Exits with 1 on the first mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "BitstreamStartCode.h"
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+static uint32_t g_seed = 0x12345678;
+
+static uint32_t Random(void)
+{
+  // xorshift32, the same sequence on every run
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+// mostly 00 and 01 so start codes and near misses are everywhere
+static void FillBiased(uint8_t *buf, int size)
+{
+  for (int i = 0; i < size; i++)
+  {
+    uint32_t r = Random() & 7;
+    buf[i] = r < 4 ? 0 : r < 6 ? 1 : (uint8_t)Random();
+  }
+}
+
+// the split as avc_parse_nal_units did it, on startcode_find_c
+static void SplitReference(const uint8_t *buf, int size, std::vector<nal_unit> &units)
+{
+  const uint8_t *end = buf + size;
+  const uint8_t *nal_start, *nal_end;
+
+  units.clear();
+  nal_start = startcode_find_c(buf, end);
+  if (buf < nal_start && nal_start < end && !nal_start[-1])
+    nal_start--;
+  for (;;)
+  {
+    while (nal_start < end && !*(nal_start++));
+    if (nal_start == end)
+      break;
+
+    nal_end = startcode_find_c(nal_start, end);
+    if (nal_start < nal_end && nal_end < end && !nal_end[-1])
+      nal_end--;
+    nal_unit unit = { nal_start, (int)(nal_end - nal_start) };
+    units.push_back(unit);
+    nal_start = nal_end;
+  }
+}
+
+static bool CheckFind(void)
+{
+  // room for every alignment of the largest buffer, and a guard behind it
+  std::vector<uint8_t> storage(4096 + 64 + 64);
+  unsigned long checks = 0;
+
+  for (int round = 0; round < 20000; round++)
+  {
+    int size = round < 2000 ? round % 80 : Random() % 4096;
+    uint8_t *buf = &storage[Random() % 64];
+    FillBiased(buf, size + 64);
+
+    for (int start = 0; start <= size; start += 1 + (size > 200 ? Random() % 16 : 0))
+    {
+      const uint8_t *want = startcode_find_c(buf + start, buf + size);
+      const uint8_t *got  = startcode_find(buf + start, buf + size);
+      checks++;
+      if (want != got)
+      {
+        printf("startcode_find (%s) mismatch: size %d start %d, want %d got %d\n", startcode_find_name(),
+               size, start, (int)(want - buf), (int)(got - buf));
+        return false;
+      }
+    }
+  }
+  printf("startcode_find (%s): %lu searches match startcode_find_c\n", startcode_find_name(), checks);
+  return true;
+}
+
+static bool CheckSplit(void)
+{
+  std::vector<uint8_t> buf(4096);
+  std::vector<nal_unit> want, got;
+
+  for (int round = 0; round < 20000; round++)
+  {
+    int size = Random() % buf.size();
+    FillBiased(&buf[0], size);
+    SplitReference(&buf[0], size, want);
+    startcode_split(&buf[0], size, got);
+
+    bool same = want.size() == got.size();
+    for (size_t i = 0; same && i < want.size(); i++)
+      same = want[i].data == got[i].data && want[i].size == got[i].size;
+    if (!same)
+    {
+      printf("startcode_split mismatch: size %d, %d units want %d\n", size, (int)got.size(), (int)want.size());
+      return false;
+    }
+  }
+  printf("startcode_split: 20000 buffers match the two pass split\n");
+  return true;
+}
+
+static double Throughput(startcode_finder find, const uint8_t *buf, int size, int passes)
+{
+  unsigned int found = 0;
+  int64_t start = CurrentHostCounter();
+  for (int pass = 0; pass < passes; pass++)
+  {
+    const uint8_t *end = buf + size;
+    for (const uint8_t *p = find(buf, end); p < end; p = find(p + 3, end))
+      found++;
+  }
+  int64_t elapsed = CurrentHostCounter() - start;
+  // keeps the loop from being optimised out
+  if (found == 0xffffffff)
+    printf(" ");
+  return (double)size * passes / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+  if (!CheckFind() || !CheckSplit())
+    return 1;
+
+  // 16 MB of random bytes with a NAL unit every 8 kB, like slice data
+  const int size = 16 * 1024 * 1024;
+  std::vector<uint8_t> buf(size);
+  for (int i = 0; i < size; i++)
+    buf[i] = (uint8_t)Random();
+  for (int i = 0; i + 4 < size; i += 8192)
+  {
+    buf[i] = 0; buf[i + 1] = 0; buf[i + 2] = 0; buf[i + 3] = 1;
+  }
+
+  int passes = argc > 1 ? atoi(argv[1]) : 8;
+  if (passes < 1)
+    passes = 1;
+  printf("%-6s %6.2f GB/s\n", "c", Throughput(startcode_find_c, &buf[0], size, passes));
+  printf("%-6s %6.2f GB/s\n", startcode_find_name(), Throughput(startcode_find, &buf[0], size, passes));
+  return 0;
+}
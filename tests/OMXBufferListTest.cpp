@@ -0,0 +1,182 @@
+/*
+ *      Copyright (C) 2010 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Checks OMXBufferList on one thread: FIFO order, the capacity rounded up
+// to a power of two, a full list refusing pushes, Reset and Clear. Then
+// four threads cycle a component's worth of buffer headers through it, as
+// the decoder and the OMX callbacks do, and every header has to come back
+// exactly once. Exits with 1 on the first mismatch.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "OMXBufferList.h"
+
+#define BUFFERS  20
+#define THREADS  4
+#define CYCLES   200000
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+static OMX_BUFFERHEADERTYPE g_headers[BUFFERS];
+
+static bool CheckSingle(void)
+{
+  OMXBufferList list;
+
+  // 5 rounds up to 8 cells
+  list.Reset(5);
+  for (int i = 0; i < 8; i++)
+  {
+    if (!list.Push(&g_headers[i]))
+    {
+      printf("push %d of 8 refused\n", i);
+      return false;
+    }
+  }
+  if (list.Push(&g_headers[8]) || list.Size() != 8)
+  {
+    printf("full list: size %u want 8, ninth push taken\n", list.Size());
+    return false;
+  }
+  for (int i = 0; i < 8; i++)
+  {
+    OMX_BUFFERHEADERTYPE *buffer = list.Pop();
+    if (buffer != &g_headers[i])
+    {
+      printf("pop %d: header %d\n", i, buffer ? (int)(buffer - g_headers) : -1);
+      return false;
+    }
+  }
+  if (list.Pop() || !list.Empty())
+  {
+    printf("empty list: size %u, pop returned a header\n", list.Size());
+    return false;
+  }
+
+  // around the ring several times, then Clear and Reset drop what is left
+  for (int i = 0; i < 100; i++)
+  {
+    list.Push(&g_headers[i % BUFFERS]);
+    if (i % 3 == 2)
+      list.Pop();
+  }
+  if (list.Size() != 8)
+  {
+    printf("after wrapping: size %u want 8\n", list.Size());
+    return false;
+  }
+  list.Clear();
+  list.Push(&g_headers[0]);
+  list.Reset(BUFFERS);
+  if (!list.Empty() || list.Pop())
+  {
+    printf("reset left size %u\n", list.Size());
+    return false;
+  }
+
+  printf("single thread: order, capacity and reset as expected\n");
+  return true;
+}
+
+static OMXBufferList g_list;
+
+static void *Cycle(void *arg)
+{
+  for (int i = 0; i < CYCLES; i++)
+  {
+    OMX_BUFFERHEADERTYPE *buffer;
+    // the decoder takes a free header, the callback returns it
+    while (!(buffer = g_list.Pop()))
+      ;
+    buffer->nFilledLen++;
+    if (!g_list.Push(buffer))
+    {
+      printf("push refused with %u of %d headers queued\n", g_list.Size(), BUFFERS);
+      exit(1);
+    }
+  }
+  return NULL;
+}
+
+static bool CheckThreads(void)
+{
+  memset(g_headers, 0, sizeof(g_headers));
+  g_list.Reset(BUFFERS);
+  for (int i = 0; i < BUFFERS; i++)
+    g_list.Push(&g_headers[i]);
+
+  pthread_t threads[THREADS];
+  int64_t start = CurrentHostCounter();
+  for (int i = 0; i < THREADS; i++)
+    pthread_create(&threads[i], NULL, Cycle, NULL);
+  for (int i = 0; i < THREADS; i++)
+    pthread_join(threads[i], NULL);
+  int64_t elapsed = CurrentHostCounter() - start;
+
+  std::vector<int> seen(BUFFERS, 0);
+  unsigned int cycles = 0;
+  OMX_BUFFERHEADERTYPE *buffer;
+  while ((buffer = g_list.Pop()))
+  {
+    if (buffer < g_headers || buffer >= g_headers + BUFFERS || seen[buffer - g_headers]++)
+    {
+      printf("header %d came back twice or is not ours\n", (int)(buffer - g_headers));
+      return false;
+    }
+    cycles += buffer->nFilledLen;
+  }
+  for (int i = 0; i < BUFFERS; i++)
+  {
+    if (!seen[i])
+    {
+      printf("header %d was lost\n", i);
+      return false;
+    }
+  }
+  if (cycles != THREADS * CYCLES)
+  {
+    printf("%u cycles counted on the headers, want %d\n", cycles, THREADS * CYCLES);
+    return false;
+  }
+
+  OMXBufferListStats stats;
+  g_list.GetStats(stats);
+  printf("%d threads: %d headers all back after %d cycles, %.0f ns per cycle, %u retries\n",
+         THREADS, BUFFERS, THREADS * CYCLES, (double)elapsed / (THREADS * CYCLES), stats.contended);
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  if (!CheckSingle() || !CheckThreads())
+    return 1;
+  return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ *      Copyright (C) 2005-2008 Team XBMC
+ *      http://www.xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// Per packet handoff cost of OMXPacketQueue against the mutex guarded deque
+// with a condition broadcast per packet that the player threads used before.
+// One producer and one consumer thread, as between the main loop and a
+// player thread. "burst" keeps the queue busy, "single" hands over one
+// packet at a time so every pop finds the queue empty and goes through Wait.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <deque>
+
+#include "OMXPacketQueue.h"
+
+// only what the queue looks at
+struct OMXPacket
+{
+  int    size;
+  double duration;
+};
+
+int OMXPacketSize(const OMXPacket *pkt)
+{
+  return pkt->size;
+}
+
+double OMXPacketDuration(const OMXPacket *pkt)
+{
+  return pkt->duration;
+}
+
+// the packets are owned by the benchmark, nothing is freed
+void OMXPacketFree(OMXPacket *pkt)
+{
+}
+
+static int64_t CurrentHostCounter(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return( ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec );
+}
+
+// the queue as OMXPlayerVideo and OMXPlayerAudio had it
+class LockedQueue
+{
+public:
+  LockedQueue() : m_cached_size(0), m_abort(false)
+  {
+    pthread_mutex_init(&m_lock, NULL);
+    pthread_cond_init(&m_cond, NULL);
+  }
+  ~LockedQueue()
+  {
+    pthread_cond_destroy(&m_cond);
+    pthread_mutex_destroy(&m_lock);
+  }
+  bool Push(OMXPacket *pkt)
+  {
+    pthread_mutex_lock(&m_lock);
+    m_packets.push_back(pkt);
+    m_cached_size += pkt->size;
+    pthread_cond_broadcast(&m_cond);
+    pthread_mutex_unlock(&m_lock);
+    return true;
+  }
+  bool Pop(OMXPacket **pkt)
+  {
+    pthread_mutex_lock(&m_lock);
+    while(m_packets.empty() && !m_abort)
+      pthread_cond_wait(&m_cond, &m_lock);
+    bool ret = !m_packets.empty();
+    if(ret)
+    {
+      *pkt = m_packets.front();
+      m_packets.pop_front();
+      m_cached_size -= (*pkt)->size;
+    }
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+  }
+  bool Empty()
+  {
+    pthread_mutex_lock(&m_lock);
+    bool ret = m_packets.empty();
+    pthread_mutex_unlock(&m_lock);
+    return ret;
+  }
+private:
+  std::deque<OMXPacket *> m_packets;
+  unsigned int            m_cached_size;
+  bool                    m_abort;
+  pthread_mutex_t         m_lock;
+  pthread_cond_t          m_cond;
+};
+
+// the ring, popped the way the player threads do it
+class RingQueue
+{
+public:
+  bool Push(OMXPacket *pkt)
+  {
+    while(!m_queue.Push(pkt))
+      sched_yield();
+    return true;
+  }
+  bool Pop(OMXPacket **pkt)
+  {
+    while(true)
+    {
+      m_queue.Wait();
+      if(m_queue.Pop(pkt))
+        return true;
+    }
+  }
+  bool Empty() { return m_queue.Empty(); };
+private:
+  OMXPacketQueue m_queue;
+};
+
+#define BENCH_PACKETS 16
+
+struct BenchArgs
+{
+  void      *queue;
+  OMXPacket *packets;
+  int       count;
+};
+
+template<class Q>
+static void *Consume(void *arg)
+{
+  BenchArgs *args = (BenchArgs *)arg;
+  Q *queue = (Q *)args->queue;
+  OMXPacket *pkt = NULL;
+  size_t bytes = 0;
+
+  for(int i = 0; i < args->count; i++)
+  {
+    queue->Pop(&pkt);
+    bytes += pkt->size;
+  }
+
+  return (void *)bytes;
+}
+
+// returns nanoseconds per packet
+template<class Q>
+static double Run(int count, bool single)
+{
+  Q queue;
+  OMXPacket packets[BENCH_PACKETS];
+  memset(packets, 0, sizeof(packets));
+  for(int i = 0; i < BENCH_PACKETS; i++)
+  {
+    packets[i].size     = 4096 + i;
+    packets[i].duration = 40000;
+  }
+
+  BenchArgs args = { &queue, packets, count };
+  pthread_t consumer;
+
+  int64_t start = CurrentHostCounter();
+  pthread_create(&consumer, NULL, Consume<Q>, &args);
+
+  for(int i = 0; i < count; i++)
+  {
+    queue.Push(&packets[i % BENCH_PACKETS]);
+    if(single)
+    {
+      while(!queue.Empty())
+        sched_yield();
+    }
+  }
+
+  pthread_join(consumer, NULL);
+  return (double)(CurrentHostCounter() - start) / count;
+}
+
+int main(int argc, char *argv[])
+{
+  int count = argc > 1 ? atoi(argv[1]) : 2000000;
+  if(count <= 0)
+    count = 2000000;
+
+  printf("%d packets, ns per packet\n", count);
+  printf("%-8s %10s %10s\n", "", "deque", "ring");
+  printf("%-8s %10.1f %10.1f\n", "burst", Run<LockedQueue>(count, false), Run<RingQueue>(count, false));
+  count /= 10;
+  printf("%-8s %10.1f %10.1f\n", "single", Run<LockedQueue>(count, true), Run<RingQueue>(count, true));
+
+  return 0;
+}